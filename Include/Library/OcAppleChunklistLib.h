@@ -14,6 +14,7 @@
 #define APPLE_CHUNKLIST_LIB_H
 
 #include <IndustryStandard/AppleChunklist.h>
+#include <Library/OcCryptoLib.h>
 
 //
 // Chunklist context.
@@ -23,8 +24,22 @@ typedef struct OC_APPLE_CHUNKLIST_CONTEXT_ {
   UINTN                   FileSize;
   APPLE_CHUNKLIST_CHUNK   *Chunks;
   APPLE_CHUNKLIST_SIG     *Signature;
+  //
+  // Signed data hash, i.e. of everything preceding the signature.
+  //
+  UINT8                   Hash[SHA256_DIGEST_SIZE];
 } OC_APPLE_CHUNKLIST_CONTEXT;
 
+//
+// Incremental chunklist verification context.
+//
+typedef struct OC_APPLE_CHUNKLIST_STREAM_ {
+  OC_APPLE_CHUNKLIST_CONTEXT  *Chunklist;
+  UINT64                      ChunkIndex;
+  UINT32                      ChunkOffset;
+  SHA256_CONTEXT              Hash;
+} OC_APPLE_CHUNKLIST_STREAM;
+
 //
 // Chunklist functions.
 //
@@ -68,4 +83,136 @@ OcAppleChunklistVerifyData (
   IN UINTN                      Length
   );
 
+/**
+  Verifies the chunklist signature, which covers the header and chunks.
+
+  @param[in] Context            The Context to verify.
+  @param[in] PublicKey          The public key to verify against, or NULL
+                                to try every key in the Apple key database.
+
+  @retval EFI_SUCCESS           The signature was verified successfully.
+  @retval EFI_SECURITY_VIOLATION The signature failed verification.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleChunklistVerifySignature (
+  IN OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN CONST RSA_PUBLIC_KEY        *PublicKey  OPTIONAL
+  );
+
+/**
+  Verifies consecutive chunks against a chunklist context.
+
+  @param[in] Context            The Context to verify against.
+  @param[in] FirstChunk         Index of the first chunk to verify.
+  @param[in] NumChunks          Number of chunks to verify.
+  @param[in] Buffer             A pointer to a buffer starting with the data of FirstChunk.
+  @param[in] Length             The length of the buffer specified in Buffer.
+
+  @retval EFI_SUCCESS           The data was verified successfully.
+  @retval EFI_INVALID_PARAMETER The chunks are not in the chunklist.
+  @retval EFI_END_OF_FILE       The end of Buffer was reached.
+  @retval EFI_COMPROMISED_DATA  The data failed verification.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleChunklistVerifyChunks (
+  IN OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN UINT64                      FirstChunk,
+  IN UINT64                      NumChunks,
+  IN CONST VOID                  *Buffer,
+  IN UINTN                       Length
+  );
+
+/**
+  Returns the data range of consecutive chunks, e.g. to read them for
+  OcAppleChunklistVerifyChunks.
+
+  @param[in]  Context           The Context to look up.
+  @param[in]  FirstChunk        Index of the first chunk.
+  @param[in]  NumChunks         Number of chunks.
+  @param[out] Offset            Offset of the first chunk data.
+  @param[out] Length            Length of the data of all chunks.
+
+  @retval EFI_SUCCESS           The range was returned successfully.
+  @retval EFI_INVALID_PARAMETER The chunks are not in the chunklist.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleChunklistGetChunkRange (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN  UINT64                      FirstChunk,
+  IN  UINT64                      NumChunks,
+  OUT UINT64                      *Offset,
+  OUT UINT64                      *Length
+  );
+
+/**
+  Returns the chunks covering a data range.
+
+  @param[in]  Context           The Context to look up.
+  @param[in]  Offset            Offset of the data range.
+  @param[in]  Length            Length of the data range.
+  @param[out] FirstChunk        Index of the first chunk.
+  @param[out] NumChunks         Number of chunks.
+
+  @retval EFI_SUCCESS           The chunks were returned successfully.
+  @retval EFI_INVALID_PARAMETER The range is empty or not covered by the chunklist.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleChunklistFindChunks (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN  UINT64                      Offset,
+  IN  UINT64                      Length,
+  OUT UINT64                      *FirstChunk,
+  OUT UINT64                      *NumChunks
+  );
+
+/**
+  Initializes incremental verification of data against a chunklist context.
+
+  @param[in]  Context           The Context to verify against.
+  @param[out] Stream            The Stream to initialize.
+**/
+VOID
+EFIAPI
+OcAppleChunklistStreamInit (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  OUT OC_APPLE_CHUNKLIST_STREAM   *Stream
+  );
+
+/**
+  Verifies the next piece of data of any size, chunks are verified as soon
+  as they are complete.  Data past the last chunk is ignored.
+
+  @param[in,out] Stream         The Stream to update.
+  @param[in]     Buffer         A pointer to a buffer containing the next data.
+  @param[in]     Length         The length of the buffer specified in Buffer.
+
+  @retval EFI_SUCCESS           The completed chunks were verified successfully.
+  @retval EFI_COMPROMISED_DATA  The data failed verification.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleChunklistStreamUpdate (
+  IN OUT OC_APPLE_CHUNKLIST_STREAM  *Stream,
+  IN     CONST VOID                 *Buffer,
+  IN     UINTN                      Length
+  );
+
+/**
+  Completes incremental verification.
+
+  @param[in,out] Stream         The Stream to complete.
+
+  @retval EFI_SUCCESS           All chunks were verified successfully.
+  @retval EFI_END_OF_FILE       The data ended before the last chunk.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleChunklistStreamFinal (
+  IN OUT OC_APPLE_CHUNKLIST_STREAM  *Stream
+  );
+
 #endif // APPLE_CHUNKLIST_LIB_H
@@ -20,6 +20,9 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define APPLE_DXE_IMAGE_VERIFICATION_H
 
 #include <IndustryStandard/PeImage.h>
+#include <Protocol/SimpleFileSystem.h>
+#include <Library/OcAppleKeysLib.h>
+#include <Library/OcCryptoLib.h>
 
 #define APPLE_SIGNATURE_SECENTRY_SIZE 8
 
@@ -46,11 +49,53 @@ typedef struct APPLE_PE_COFF_LOADER_IMAGE_CONTEXT_ {
 // Signature context
 //
 typedef struct APPLE_SIGNATURE_CONTEXT_ {
-  UINT8                            PublicKey[256];
   UINT8                            PublicKeyHash[32];
   UINT8                            Signature[256];
 } APPLE_SIGNATURE_CONTEXT;
 
+//
+// Verifier state reused for verifying multiple images in a row without
+// allocations.  Keys is a key database sorted by hash.
+//
+typedef struct APPLE_PE_IMAGE_VERIFIER_ {
+  CONST APPLE_PK_ENTRY                *Keys;
+  UINTN                               NumKeys;
+  APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  PeContext;
+  APPLE_SIGNATURE_CONTEXT             SignatureContext;
+  UINT64                              WorkBuf64[RSA_WORKBUF64_SIZE];
+} APPLE_PE_IMAGE_VERIFIER;
+
+//
+// Authenticated ranges of a PE image in file order: DOS header, PE header
+// up to the checksum, the rest of the headers up to the security directory
+// entry and everything after it up to the signature.
+//
+#define APPLE_PE_IMAGE_HASH_RANGES 4
+
+typedef struct APPLE_PE_IMAGE_HASH_RANGE_ {
+  UINTN                            Start;
+  UINTN                            End;
+} APPLE_PE_IMAGE_HASH_RANGE;
+
+//
+// Incremental verification context for an image being read into memory.
+// Authenticated ranges are hashed as soon as their data arrives, so the
+// digest is ready when the last byte is read.
+//
+typedef struct APPLE_PE_IMAGE_STREAM_ {
+  APPLE_PE_IMAGE_VERIFIER          *Verifier;
+  UINT8                            *Image;
+  UINTN                            ImageSize;
+  UINTN                            Received;
+  UINTN                            HeaderSize;
+  BOOLEAN                          HeadersParsed;
+  BOOLEAN                          HashReady;
+  EFI_STATUS                       Status;
+  UINTN                            RangeIndex;
+  APPLE_PE_IMAGE_HASH_RANGE        Ranges[APPLE_PE_IMAGE_HASH_RANGES];
+  SHA256_CONTEXT                   Hash;
+} APPLE_PE_IMAGE_STREAM;
+
 //
 // Function prototypes
 //
@@ -87,6 +132,108 @@ GetApplePeImageSha256 (
   APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context
   );
 
+/**
+  Initialise verifier state.
+
+  @param[out] Verifier  Verifier to initialise.
+  @param[in]  Keys      Key database sorted by hash, PkDataBase when NULL.
+  @param[in]  NumKeys   Number of entries in Keys, ignored when Keys is NULL.
+**/
+VOID
+InitializeApplePeImageVerifier (
+  OUT APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  IN  CONST APPLE_PK_ENTRY     *Keys OPTIONAL,
+  IN  UINTN                    NumKeys
+  );
+
+/**
+  Verify Apple signature of a PE image with a previously initialised
+  verifier.  The image is sanitised in place and ImageSize is updated to
+  its real size.
+
+  @param[in,out] Verifier   Verifier state.
+  @param[in,out] PeImage    Image to verify.
+  @param[in,out] ImageSize  Image size.
+
+  @retval EFI_SUCCESS  Image signature is valid.
+**/
+EFI_STATUS
+VerifyApplePeImage (
+  IN OUT APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  IN OUT VOID                     *PeImage,
+  IN OUT UINTN                    *ImageSize
+  );
+
+/**
+  Initialise incremental verification of an image read into a buffer.
+
+  @param[in]  Verifier   Verifier state, used until the stream is final.
+  @param[out] Stream     Stream to initialise.
+  @param[in]  PeImage    Buffer the image is read into.
+  @param[in]  ImageSize  Image size.
+
+  @retval EFI_SUCCESS            The stream was initialised.
+  @retval EFI_INVALID_PARAMETER  ImageSize is 0.
+**/
+EFI_STATUS
+ApplePeImageStreamInit (
+  IN  APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  OUT APPLE_PE_IMAGE_STREAM    *Stream,
+  IN  VOID                     *PeImage,
+  IN  UINTN                    ImageSize
+  );
+
+/**
+  Account for the next Length bytes read into the image buffer right
+  after the previous ones, authenticated data among them is hashed.
+
+  @param[in,out] Stream  Stream to update.
+  @param[in]     Length  Number of bytes read.
+
+  @retval EFI_SUCCESS  The data was accepted.
+  @retval other        The image is malformed, reading can be stopped.
+**/
+EFI_STATUS
+ApplePeImageStreamUpdate (
+  IN OUT APPLE_PE_IMAGE_STREAM  *Stream,
+  IN     UINTN                  Length
+  );
+
+/**
+  Complete incremental verification.  The image is sanitised in place.
+
+  @param[in,out] Stream     Stream to complete.
+  @param[out]    ImageSize  Real image size.
+
+  @retval EFI_SUCCESS            Image signature is valid.
+  @retval EFI_END_OF_FILE        The image was not read completely.
+  @retval EFI_INVALID_PARAMETER  The image headers are malformed.
+**/
+EFI_STATUS
+ApplePeImageStreamFinal (
+  IN OUT APPLE_PE_IMAGE_STREAM  *Stream,
+  OUT    UINTN                  *ImageSize
+  );
+
+/**
+  Read an image from a file and verify its Apple signature, hashing it
+  while it is read.
+
+  @param[in,out] Verifier   Verifier state.
+  @param[in]     File       File to read.
+  @param[out]    PeImage    Image allocated on success, to be freed by the caller.
+  @param[out]    ImageSize  Real image size.
+
+  @retval EFI_SUCCESS  Image signature is valid.
+**/
+EFI_STATUS
+VerifyApplePeImageFile (
+  IN OUT APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  IN     EFI_FILE_PROTOCOL        *File,
+  OUT    VOID                     **PeImage,
+  OUT    UINTN                    *ImageSize
+  );
+
 EFI_STATUS
 VerifyApplePeImageSignature (
   IN OUT VOID                                *PeImage,
@@ -47,6 +47,37 @@
 //
 #define PRELINK_INFO_RESERVE_SIZE (5U * 1024U * 1024U)
 
+/**
+  Process one item of independent work.
+
+  @param[in] Context  Work context.
+  @param[in] Index    Item index.
+**/
+typedef
+VOID
+(*PRELINKED_PARALLEL_WORKER) (
+  IN VOID    *Context,
+  IN UINT32  Index
+  );
+
+/**
+  Call Worker for every item index below NumItems, possibly concurrently,
+  and return once all items are processed.
+
+  @param[in] ParallelContext  PRELINKED_CONTEXT ParallelForContext.
+  @param[in] NumItems         Number of items.
+  @param[in] Worker           Item worker.
+  @param[in] WorkerContext    Item worker context.
+**/
+typedef
+VOID
+(*PRELINKED_PARALLEL_FOR) (
+  IN VOID                       *ParallelContext,
+  IN UINT32                     NumItems,
+  IN PRELINKED_PARALLEL_WORKER  Worker,
+  IN VOID                       *WorkerContext
+  );
+
 //
 // Prelinked context used for kernel modification.
 //
@@ -65,6 +96,19 @@ typedef struct {
   //
   UINT32                   PrelinkedAllocSize;
   //
+  // Allow growing prelinkedkernel when PrelinkedAllocSize is exhausted.
+  // Prelinked is then replaced by a larger pool allocation and the original
+  // one is freed, so the caller must use and free the updated Prelinked.
+  // Cached kexts are moved to the new buffer, but patcher context copies made
+  // by PatcherInitContextFromPrelinked become invalid on growth.
+  //
+  BOOLEAN                  PrelinkedGrowable;
+  //
+  // Incremented every time Prelinked is replaced on growth.  Patcher context
+  // copies made for an older generation are rejected by patcher functions.
+  //
+  UINT32                   PrelinkedGeneration;
+  //
   // Current last virtual address (kext source files and plist are put here).
   //
   UINT64                   PrelinkedLastAddress;
@@ -122,8 +166,64 @@ typedef struct {
   // Used for caching prelinked kexts.
   //
   LIST_ENTRY               PrelinkedKexts;
+  //
+  // Exported symbol cache matching prelinkedkernel UUID, may be NULL.
+  // Freed upon context destruction as one of pooled buffers.
+  //
+  CONST VOID               *SymbolCache;
+  //
+  // Number of dependency symbol tables built (or restored from SymbolCache).
+  //
+  UINT32                   LinkedSymbolTableBuilds;
+  //
+  // Number of dependency symbol table builds spared by reusing scanned kexts.
+  //
+  UINT32                   LinkedSymbolTableReuses;
+  //
+  // Executor for independent work during batch injection, optional.
+  // Host tools may set it to use multiple threads, work is done serially otherwise.
+  //
+  PRELINKED_PARALLEL_FOR   ParallelFor;
+  //
+  // Context passed to ParallelFor.
+  //
+  VOID                     *ParallelForContext;
 } PRELINKED_CONTEXT;
 
+//
+// Kext injection request for batch injection.
+//
+typedef struct {
+  //
+  // Kext bundle path (e.g. /L/E/mykext.kext).
+  //
+  CONST CHAR8              *BundlePath;
+  //
+  // Kext Info.plist.
+  //
+  CONST CHAR8              *InfoPlist;
+  //
+  // Kext Info.plist size.
+  //
+  UINT32                   InfoPlistSize;
+  //
+  // Kext executable path (e.g. Contents/MacOS/mykext), optional.
+  //
+  CONST CHAR8              *ExecutablePath;
+  //
+  // Kext executable, optional.
+  //
+  CONST UINT8              *Executable;
+  //
+  // Kext executable size, optional.
+  //
+  UINT32                   ExecutableSize;
+  //
+  // Injection status, set by PrelinkedInjectKexts.
+  //
+  EFI_STATUS               Status;
+} PRELINKED_KEXT_REQUEST;
+
 //
 // Kernel and kext patching context.
 //
@@ -140,6 +240,14 @@ typedef struct {
   // Virtual kmod_info_t address.
   //
   UINT64                   VirtualKmod;
+  //
+  // Prelinked context the patcher context references, NULL for buffers.
+  //
+  CONST PRELINKED_CONTEXT  *Prelinked;
+  //
+  // PrelinkedGeneration of Prelinked the patcher context was made for.
+  //
+  UINT32                   PrelinkedGeneration;
 } PATCHER_CONTEXT;
 
 //
@@ -178,8 +286,81 @@ typedef struct {
   // Skip count or 0 to start from 1 match.
   //
   UINT32       Skip;
+  //
+  // Search size limit from base, 0 for the rest of the binary, or
+  // PATCHER_LIMIT_SYMBOL for the extent of the base symbol.
+  //
+  UINT32       Limit;
 } PATCHER_GENERIC_PATCH;
 
+//
+// Limit patch search to base symbol, i.e. up to the next symbol address.
+//
+#define PATCHER_LIMIT_SYMBOL  MAX_UINT32
+
+//
+// Kext patch request for grouped patch application.
+//
+typedef struct {
+  //
+  // Kext bundle identifier.
+  //
+  CONST CHAR8            *Identifier;
+  //
+  // Patch description.
+  //
+  PATCHER_GENERIC_PATCH  *Patch;
+  //
+  // Patch status, set by PatcherApplyGenericPatches.
+  //
+  EFI_STATUS             Status;
+} PATCHER_PATCH_REQUEST;
+
+//
+// Kernel preparation phases measured for timing report.
+// Phases may nest, e.g. kext injection includes dependency scanning.
+// Kernel read does not include decompression.
+// Linking phases only account runs, which did not fail.
+//
+typedef enum KERNEL_TIMING_PHASE_ {
+  KernelTimingRead,
+  KernelTimingDecompress,
+  KernelTimingInfoParse,
+  KernelTimingInjectKext,
+  KernelTimingDependencies,
+  KernelTimingSymbolResolve,
+  KernelTimingVtablePatch,
+  KernelTimingRelocate,
+  KernelTimingApplyPatch,
+  KernelTimingInjectComplete,
+  KernelTimingPhaseMax
+} KERNEL_TIMING_PHASE;
+
+//
+// Accumulated timing of one phase.
+//
+typedef struct {
+  //
+  // Total performance counter ticks spent in the phase.
+  //
+  UINT64       Ticks;
+  //
+  // Longest single run of the phase in ticks.
+  //
+  UINT64       MaxTicks;
+  //
+  // Number of phase runs.
+  //
+  UINT32       Count;
+} KERNEL_TIMING_ENTRY;
+
+//
+// Timing report for all phases since last reset.
+//
+typedef struct {
+  KERNEL_TIMING_ENTRY  Phases[KernelTimingPhaseMax];
+} KERNEL_TIMING_REPORT;
+
 /**
   Read Apple kernel for target architecture (possibly decompressing)
   into pool allocated buffer.
@@ -204,7 +385,8 @@ ReadAppleKernel (
 /**
   Construct prelinked context for later modification.
   Must be freed with PrelinkedContextFree on success.
-  Note, that PrelinkedAllocSize never changes, and is to be estimated.
+  Note, that PrelinkedAllocSize never changes unless PrelinkedGrowable is set,
+  and is to be estimated, e.g. with PrelinkedReserveKextsSize.
 
   @param[in,out] Context             Prelinked context.
   @param[in,out] Prelinked           Unpacked prelinked buffer (Mach-O image).
@@ -285,6 +467,24 @@ PrelinkedReserveKextSize (
   IN     UINT32       ExecutableSize OPTIONAL
   );
 
+/**
+  Calculate reserve size required to inject a batch of kexts, including
+  executables and prelinked info growth. The result is meant to be passed
+  to ReadAppleKernel before the kernel is read.
+
+  @param[out] ReservedSize  Required reserve size.
+  @param[in]  Requests      Kext injection requests.
+  @param[in]  NumRequests   Number of kext injection requests.
+
+  @return  EFI_SUCCESS on success.
+**/
+EFI_STATUS
+PrelinkedReserveKextsSize (
+     OUT UINT32                        *ReservedSize,
+  IN     CONST PRELINKED_KEXT_REQUEST  *Requests,
+  IN     UINT32                        NumRequests
+  );
+
 /**
   Perform kext injection.
 
@@ -309,8 +509,31 @@ PrelinkedInjectKext (
   IN     UINT32             ExecutableSize OPTIONAL
   );
 
+/**
+  Perform batch kext injection. Kexts are injected in dependency order, so
+  that kexts depending on other kexts from the same batch are linked after
+  them, and dependencies shared between kexts are scanned only once.
+  Kexts depending on failed or cyclic requests are not injected.
+  Dependency symbol tables are built through ParallelFor when it is set,
+  while injection itself stays serial for a deterministic result.
+
+  @param[in,out] Context      Prelinked context.
+  @param[in,out] Requests     Kext injection requests, Status is updated.
+  @param[in]     NumRequests  Number of kext injection requests.
+
+  @return  EFI_SUCCESS when all kexts were injected.
+**/
+EFI_STATUS
+PrelinkedInjectKexts (
+  IN OUT PRELINKED_CONTEXT       *Context,
+  IN OUT PRELINKED_KEXT_REQUEST  *Requests,
+  IN     UINT32                  NumRequests
+  );
+
 /**
   Link executable within current prelink context.
+  Lookup indices built for Executable are kept, MachoFreeContext must be
+  called on it afterwards.
 
   @param[in,out] Context         Prelinked context.
   @param[in,out] Executable      Kext executable copied to prelinked.
@@ -328,8 +551,62 @@ PrelinkedLinkExecutable (
   IN     UINT64             LoadAddress
   );
 
+/**
+  Attach exported symbol cache to prelinked context.  The cache is only
+  accepted when it was exported for the same kernel UUID, and on success it
+  is freed with PrelinkedContextFree.
+
+  @param[in,out] Context    Prelinked context.
+  @param[in]     Cache      Pool allocated symbol cache.
+  @param[in]     CacheSize  Symbol cache size.
+
+  @return  EFI_SUCCESS on success.
+**/
+EFI_STATUS
+PrelinkedAttachSymbolCache (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     VOID               *Cache,
+  IN     UINT32             CacheSize
+  );
+
+/**
+  Read exported symbol cache (e.g. from ESP) and attach it to prelinked context.
+
+  @param[in,out] Context     Prelinked context.
+  @param[in]     FileSystem  File system containing the cache.
+  @param[in]     FilePath    Symbol cache path.
+
+  @return  EFI_SUCCESS on success.
+**/
+EFI_STATUS
+PrelinkedLoadSymbolCache (
+  IN OUT PRELINKED_CONTEXT                *Context,
+  IN     EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem,
+  IN     CONST CHAR16                     *FilePath
+  );
+
+/**
+  Export symbol tables built for prelinked kexts in this context into
+  a symbol cache bound to prelinkedkernel UUID.
+
+  @param[in,out] Context    Prelinked context.
+  @param[out]    Cache      Pool allocated symbol cache.
+  @param[out]    CacheSize  Symbol cache size.
+
+  @return  EFI_SUCCESS on success.
+**/
+EFI_STATUS
+PrelinkedExportSymbolCache (
+  IN OUT PRELINKED_CONTEXT  *Context,
+     OUT VOID               **Cache,
+     OUT UINT32             *CacheSize
+  );
+
 /**
   Initialize patcher from prelinked context for kext patching.
+  The copy references prelinked buffer and lookup indices the cached kext has
+  built so far, other lookups scan the symbol table linearly.  It is rejected
+  with EFI_INVALID_PARAMETER after prelinked buffer growth.
 
   @param[in,out] Context         Patcher context.
   @param[in,out] Prelinked       Prelinked context.
@@ -344,8 +621,30 @@ PatcherInitContextFromPrelinked (
   IN     CONST CHAR8        *Name
   );
 
+/**
+  Get patcher context of a kext cached by prelinked context.
+  Unlike PatcherInitContextFromPrelinked no copy is made, so lookup indices
+  built by patching are kept for further patches of the same kext.
+  The context is owned by Prelinked and is valid until PrelinkedContextFree,
+  prelinked buffer growth moves it to the new buffer.
+
+  @param[in,out] Prelinked       Prelinked context.
+  @param[in]     Name            Kext bundle identifier.
+  @param[out]    Context         Cached patcher context.
+
+  @return  EFI_SUCCESS on success.
+**/
+EFI_STATUS
+PatcherGetContextFromPrelinked (
+  IN OUT PRELINKED_CONTEXT  *Prelinked,
+  IN     CONST CHAR8        *Name,
+  OUT    PATCHER_CONTEXT    **Context
+  );
+
 /**
   Initialize patcher from buffer for e.g. kernel patching.
+  MachoFreeContext must be called on Context->MachContext once patching is
+  done to free the symbol index built by PatcherGetSymbolAddress.
 
   @param[in,out] Context         Patcher context.
   @param[in,out] Buffer          Kernel buffer (could be prelinked).
@@ -390,6 +689,24 @@ PatcherApplyGenericPatch (
   IN     PATCHER_GENERIC_PATCH  *Patch
   );
 
+/**
+  Apply generic patches to prelinked kexts. Patches are grouped by kext,
+  so that every kext is looked up once and all its patches are applied
+  against one cached patcher context in request order.
+
+  @param[in,out] Prelinked       Prelinked context.
+  @param[in,out] Requests        Patch requests, Status is updated.
+  @param[in]     NumRequests     Number of patch requests.
+
+  @return  EFI_SUCCESS when all patches were applied.
+**/
+EFI_STATUS
+PatcherApplyGenericPatches (
+  IN OUT PRELINKED_CONTEXT      *Prelinked,
+  IN OUT PATCHER_PATCH_REQUEST  *Requests,
+  IN     UINT32                 NumRequests
+  );
+
 /**
   Block kext from loading.
 
@@ -402,5 +719,31 @@ PatcherBlockKext (
   IN OUT PATCHER_CONTEXT        *Context
   );
 
+/**
+  Reset accumulated kernel preparation timings.
+**/
+VOID
+KernelTimingReset (
+  VOID
+  );
+
+/**
+  Retrieve kernel preparation timings accumulated since last reset.
+
+  @param[out] Report  Timing report.
+**/
+VOID
+KernelTimingGetReport (
+  OUT KERNEL_TIMING_REPORT  *Report
+  );
+
+/**
+  Print kernel preparation timings accumulated since last reset.
+**/
+VOID
+KernelTimingPrintReport (
+  VOID
+  );
+
 #endif // OC_APPLE_KERNEL_LIB_H
 
@@ -0,0 +1,52 @@
+/** @file
+
+OcAppleKeysLib
+
+Copyright (c) 2018, savvas
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef OC_APPLE_KEYS_LIB_H
+#define OC_APPLE_KEYS_LIB_H
+
+#define NUM_OF_PK 2
+
+//
+// Apple public keys with their SHA-256 hashes.  Keys are pre-processed
+// for Montgomery multiplication and can be cast to RSA_PUBLIC_KEY.
+// PkDataBase is sorted by Hash in ascending byte order.
+//
+typedef struct APPLE_PK_ENTRY_ {
+  UINT8 Hash[32];
+  UINT8 PublicKey[520];
+} APPLE_PK_ENTRY;
+
+extern APPLE_PK_ENTRY PkDataBase[NUM_OF_PK];
+
+/**
+  Find a public key by its SHA-256 hash in a key database.
+
+  @param[in] Keys     Key database sorted by Hash.
+  @param[in] NumKeys  Number of entries in Keys.
+  @param[in] Hash     SHA-256 hash of the public key to find.
+
+  @return  Matching entry or NULL when the key is unknown.
+**/
+CONST APPLE_PK_ENTRY *
+FindApplePublicKey (
+  IN CONST APPLE_PK_ENTRY  *Keys,
+  IN UINTN                 NumKeys,
+  IN CONST UINT8           *Hash
+  );
+
+#endif // OC_APPLE_KEYS_LIB_H
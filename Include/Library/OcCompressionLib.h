@@ -75,4 +75,44 @@ DecompressLZVN (
   IN  UINTN        SrcLen
   );
 
+/**
+  Compress buffer with LZVN algorithm.
+
+  @param[out]  Dst         Destination buffer.
+  @param[in]   DstLen      Destination buffer size.
+  @param[in]   Src         Source buffer.
+  @param[in]   SrcLen      Source buffer size.
+
+  @return  CompressedLen on success otherwise 0.
+**/
+UINTN
+CompressLZVN (
+  OUT UINT8        *Dst,
+  IN  UINTN        DstLen,
+  IN  CONST UINT8  *Src,
+  IN  UINTN        SrcLen
+  );
+
+/**
+  Maximum CompressLZVN output size for Length bytes of input.  A literal
+  run takes up to 2 extra bytes per 271 literals and every match saves at
+  least 1 byte, so at worst 16 literals followed by a 4 byte match grow
+  by 1 byte.  The end of stream marker takes 8 bytes.
+**/
+#define OC_LZVN_MAX_COMPRESSED_LENGTH(Length) ((Length) + (Length) / 16 + 16)
+
+/**
+  Calculate Adler-32 checksum used in compressed kernel headers.
+
+  @param[in]   Buffer      Source buffer.
+  @param[in]   Length      Source buffer size.
+
+  @return  Adler-32 checksum.
+**/
+UINT32
+Adler32 (
+  IN UINT8   *Buffer,
+  IN INT32   Length
+  );
+
 #endif // OC_COMPRESSION_LIB_H
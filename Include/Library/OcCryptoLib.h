@@ -20,17 +20,11 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define OC_CRYPTO_LIB_H
 
 //
-// Default to 2048-bit key length for RSA.
+// Default to supporting RSA keys up to 4096 bits, 2048 and 3072-bit keys
+// are supported as well.  Lower to reduce stack usage.
 //
-#ifndef CONFIG_RSA_KEY_SIZE
-#define CONFIG_RSA_KEY_SIZE 2048
-#endif
-
-//
-// Default to 128-bit key length for AES.
-//
-#ifndef CONFIG_AES_KEY_SIZE
-#define CONFIG_AES_KEY_SIZE 16
+#ifndef CONFIG_RSA_MAX_KEY_SIZE
+#define CONFIG_RSA_MAX_KEY_SIZE 4096
 #endif
 
 //
@@ -41,42 +35,62 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define SHA256_DIGEST_SIZE  32
 
 //
-// Derived parameters.
+// Derived parameters, RSA sizes are the largest supported.
 //
-#define RSANUMBYTES ((CONFIG_RSA_KEY_SIZE) / 8)
+#define RSANUMBYTES ((CONFIG_RSA_MAX_KEY_SIZE) / 8)
 #define RSANUMWORDS (RSANUMBYTES / sizeof (UINT32))
+#define RSA_WORKBUF64_SIZE ((RSANUMBYTES * 3) / sizeof (UINT64))
 #define AES_BLOCK_SIZE 16
 
 //
-// Support all AES key sizes.
+// AES key sizes, any of them can be chosen per context.  Expanded keys
+// are sized for the largest one.
 //
-#if CONFIG_AES_KEY_SIZE == 32
+#define AES_128_KEY_SIZE 16
+#define AES_192_KEY_SIZE 24
+#define AES_256_KEY_SIZE 32
 #define AES_KEY_EXP_SIZE 240
-#elif CONFIG_AES_KEY_SIZE == 24
-#define AES_KEY_EXP_SIZE 208
-#elif CONFIG_AES_KEY_SIZE == 16
-#define AES_KEY_EXP_SIZE 176
-#else
-#error "Only AES-128, AES-192, and AES-256 are supported!"
+
+#if CONFIG_RSA_MAX_KEY_SIZE != 2048 && CONFIG_RSA_MAX_KEY_SIZE != 3072 && CONFIG_RSA_MAX_KEY_SIZE != 4096
+#error "Only RSA-2048, RSA-3072, and RSA-4096 are supported!"
 #endif
 
 //
-// For now abort on anything but 2048, but we can support 1024 and 4096 at least.
+// Pre-processed RSA public key.  Data contains the modulus N followed by
+// R^2 mod N, both of Size little endian 32-bit words.  N0Inv is -1 / N[0]
+// mod 2^32.
 //
-#if CONFIG_RSA_KEY_SIZE != 2048
-#error "Only RSA-2048 is supported"
-#endif
-
 typedef struct RSA_PUBLIC_KEY_ {
   UINT32  Size;
   UINT32  N0Inv;
-  UINT32  N[RSANUMWORDS];
-  UINT32  Rr[RSANUMWORDS];
+  UINT32  Data[];
 } RSA_PUBLIC_KEY;
 
+//
+// Size of a pre-processed RSA public key in bytes.
+//
+#define RSA_PUBLIC_KEY_SIZE(Bits) (sizeof (RSA_PUBLIC_KEY) + 2 * ((Bits) / 8))
+
+//
+// AES implementations, AesBackendAuto selects the fastest one supported
+// by the CPU.
+//
+typedef enum AES_BACKEND_ {
+  AesBackendAuto,
+  AesBackendGeneric,
+  AesBackendAesNi
+} AES_BACKEND;
+
+//
+// InvRoundKey holds the decryption round keys of the equivalent inverse
+// cipher, i.e. RoundKey in reverse order with InvMixColumns applied.
+// Rounds is 10, 12 or 14 depending on the key size.
+//
 typedef struct AES_CONTEXT_ {
-  UINT8 RoundKey[AES_KEY_EXP_SIZE];
-  UINT8 Iv[AES_BLOCK_SIZE];
+  UINT8   RoundKey[AES_KEY_EXP_SIZE];
+  UINT8   InvRoundKey[AES_KEY_EXP_SIZE];
+  UINT8   Iv[AES_BLOCK_SIZE];
+  UINT32  Rounds;
 } AES_CONTEXT;
 
 typedef struct MD5_CONTEXT_ {
@@ -94,6 +108,18 @@ typedef struct SHA1_CONTEXT_ {
   UINT32  K[4];
 } SHA1_CONTEXT;
 
+//
+// SHA-256 implementations, Sha256BackendAuto selects the fastest one
+// supported by the CPU.
+//
+typedef enum SHA256_BACKEND_ {
+  Sha256BackendAuto,
+  Sha256BackendGeneric,
+  Sha256BackendSsse3,
+  Sha256BackendAvx2,
+  Sha256BackendShaNi
+} SHA256_BACKEND;
+
 typedef struct SHA256_CONTEXT_ {
   UINT8   Data[64];
   UINT32  DataLen;
@@ -104,18 +130,30 @@ typedef struct SHA256_CONTEXT_ {
 //
 // Functions prototypes
 //
+
+//
+// Workbuf64 must hold at least 3 * Key->Size 32-bit words, i.e.
+// RSA_WORKBUF64_SIZE 64-bit words.  It is typed UINT64 so that it is
+// suitably aligned for 64-bit limb arithmetic.
+//
 BOOLEAN
 RsaVerify (
   RSA_PUBLIC_KEY  *Key,
   UINT8           *Signature,
+  UINTN           SignatureSize,
   UINT8           *Sha256,
-  UINT32          *Workbuf32
+  UINT64          *Workbuf64
   );
 
-VOID
+//
+// KeySize must be one of AES_128_KEY_SIZE, AES_192_KEY_SIZE or
+// AES_256_KEY_SIZE, returns FALSE otherwise.
+//
+BOOLEAN
 AesInitCtxIv (
   AES_CONTEXT  *Context,
   CONST UINT8  *Key,
+  UINT32       KeySize,
   CONST UINT8  *Iv
   );
 
@@ -159,6 +197,20 @@ AesCtrXcryptBuffer (
   UINT32       Len
   );
 
+//
+// Select AES implementation used by all contexts, returns FALSE when
+// it is not supported by the CPU.  Automatic selection happens otherwise.
+//
+BOOLEAN
+AesSetBackend (
+  AES_BACKEND  Backend
+  );
+
+AES_BACKEND
+AesGetBackend (
+  VOID
+  );
+
 VOID
 Md5Init (
   MD5_CONTEXT  *Context
@@ -234,4 +286,33 @@ Sha256 (
   UINTN  Len
   );
 
+//
+// Hash Count independent messages into Count consecutive digests.  Groups
+// of up to SHA256_MULTI_BUFFER_LANES messages are hashed in lockstep when
+// the backend allows, which is fastest for messages of equal length.
+//
+#define SHA256_MULTI_BUFFER_LANES  8
+
+VOID
+Sha256MultiBuffer (
+  UINT8        *Hashes,
+  CONST UINT8  **Data,
+  CONST UINTN  *Lengths,
+  UINTN        Count
+  );
+
+//
+// Select SHA-256 implementation used by all contexts, returns FALSE when
+// it is not supported by the CPU.  Automatic selection happens otherwise.
+//
+BOOLEAN
+Sha256SetBackend (
+  SHA256_BACKEND  Backend
+  );
+
+SHA256_BACKEND
+Sha256GetBackend (
+  VOID
+  );
+
 #endif //OC_CRYPTO_LIB_H
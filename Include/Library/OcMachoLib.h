@@ -17,20 +17,90 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include <IndustryStandard/AppleMachoImage.h>
 
+///
+/// Maximum number of segments indexed by the Mach-O Context.  Binaries with
+/// more segments fall back to walking the Load Commands past the last one.
+///
+#define MACHO_MAX_INDEXED_SEGMENTS  32
+
+///
+/// C++ symbol classes reported by MachoGetCxxSymbolFlags64.
+///
+#define MACHO_CXX_SYMBOL_CXX                BIT0
+#define MACHO_CXX_SYMBOL_VTABLE             BIT1
+#define MACHO_CXX_SYMBOL_METACLASS_POINTER  BIT2
+#define MACHO_CXX_SYMBOL_SMCP               BIT3
+#define MACHO_CXX_SYMBOL_PURE_VIRTUAL       BIT4
+#define MACHO_CXX_SYMBOL_PADSLOT            BIT5
+
+///
+/// C++ classification of a symbol cached by the Mach-O Context.
+///
+typedef struct {
+  ///
+  /// Combination of MACHO_CXX_SYMBOL_* flags.
+  ///
+  UINT32 Flags;
+  ///
+  /// Length of the class name embedded in the name of VTables, Metaclass
+  /// Pointers and Super Metaclass Pointers.
+  ///
+  UINT32 ClassNameLength;
+} MACHO_CXX_SYMBOL_INFO;
+
 ///
 /// Context used to refer to a Mach-O.  This struct is exposed for reference
 /// only.  Members are not guaranteed to be sane.
 ///
 typedef struct {
-  MACH_HEADER_64        *MachHeader;
-  UINT32                FileSize;
-  MACH_SYMTAB_COMMAND   *Symtab;
-  MACH_NLIST_64         *SymbolTable;
-  CHAR8                 *StringTable;
-  MACH_DYSYMTAB_COMMAND *DySymtab;
-  MACH_NLIST_64         *IndirectSymbolTable;
-  MACH_RELOCATION_INFO  *LocalRelocations;
-  MACH_RELOCATION_INFO  *ExternRelocations;
+  MACH_HEADER_64          *MachHeader;
+  UINT32                  FileSize;
+  MACH_SYMTAB_COMMAND     *Symtab;
+  MACH_NLIST_64           *SymbolTable;
+  CHAR8                   *StringTable;
+  MACH_DYSYMTAB_COMMAND   *DySymtab;
+  MACH_NLIST_64           *IndirectSymbolTable;
+  MACH_RELOCATION_INFO    *LocalRelocations;
+  MACH_RELOCATION_INFO    *ExternRelocations;
+  //
+  // Load Command index built by MachoInitializeContext.
+  //
+  MACH_UUID_COMMAND       *UuidCommand;
+  MACH_SYMTAB_COMMAND     *SymtabCommand;
+  MACH_DYSYMTAB_COMMAND   *DySymtabCommand;
+  UINT32                  NumSegments;
+  BOOLEAN                 SegmentsTruncated;
+  MACH_SEGMENT_COMMAND_64 *Segments[MACHO_MAX_INDEXED_SEGMENTS];
+  //
+  // Address-sorted section table built on first MachoGetSectionByAddress64,
+  // NULL when sections are searched linearly.
+  //
+  BOOLEAN                 SectionsSorted;
+  UINT32                  NumSortedSections;
+  MACH_SECTION_64         **SortedSections;
+  //
+  // Name-sorted symbol indices built on first symbol lookup by name.
+  //
+  BOOLEAN                 SymbolsByNameBuilt;
+  UINT32                  NumSymbolsByName;
+  UINT32                  *SymbolsByName;
+  //
+  // Address-sorted section symbol indices built on first extent query.
+  //
+  BOOLEAN                 SymbolsByAddressBuilt;
+  UINT32                  NumSymbolsByAddress;
+  UINT32                  *SymbolsByAddress;
+  //
+  // Address-sorted extern relocation indices built on first lookup.
+  //
+  BOOLEAN                 RelocationsByAddressBuilt;
+  UINT32                  NumRelocationsByAddress;
+  UINT32                  *RelocationsByAddress;
+  //
+  // Per-symbol C++ classification built on first classification query.
+  //
+  BOOLEAN                 CxxSymbolsBuilt;
+  MACHO_CXX_SYMBOL_INFO   *CxxSymbols;
 } OC_MACHO_CONTEXT;
 
 /**
@@ -50,6 +120,36 @@ MachoInitializeContext (
   IN  UINT32            FileSize
   );
 
+/**
+  Frees the lookup indices allocated for a Mach-O Context.  The Context must
+  not be a copy of another Context sharing its indices.
+
+  @param[in,out] Context  Mach-O Context to free.
+
+**/
+VOID
+MachoFreeContext (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  );
+
+/**
+  Moves a Mach-O Context to an identical copy of its file, e.g. after the
+  buffer holding it has been reallocated, or indexes the Load Commands
+  again after they have been moved in place.  Lookup indices built so far
+  do not reference Load Commands and are kept.
+
+  @param[in,out] Context   Mach-O Context to move.
+  @param[in]     FileData  Pointer to the copy of the file's data.
+
+  @return  Whether Context has been moved.  Context is unchanged otherwise.
+
+**/
+BOOLEAN
+MachoRebaseContext (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     VOID              *FileData
+  );
+
 /**
   Returns the Mach-O Header structure.
 
@@ -197,6 +297,8 @@ MachoGetSectionByIndex64 (
 
 /**
   Retrieves a section by its address.
+  The first call sorts the sections of Context by address, callers modifying
+  section addresses afterwards must reinitialise Context.
 
   @param[in,out] Context  Context of the Mach-O.
   @param[in]     Address  Address of the section to retrieve.
@@ -258,6 +360,23 @@ MachoGetLocalDefinedSymbolByName (
   IN     CONST CHAR8       *Name
   );
 
+/**
+  Retrieves the first symbol by the name of Name.
+  The first call sorts the symbols of Context by name, the index is freed by
+  MachoFreeContext.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Name     Name of the symbol to locate.
+
+  @retval NULL  NULL is returned on failure.
+
+**/
+MACH_NLIST_64 *
+MachoGetSymbolByName64 (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     CONST CHAR8       *Name
+  );
+
 /**
   Retrieves a symbol by its index.
 
@@ -367,6 +486,26 @@ MachoSymbolGetFileOffset64 (
   OUT    UINT32                *FileOffset
   );
 
+/**
+  Retrieves the extent of the code or data Symbol points to, i.e. the
+  distance to the next symbol address or to the end of the section.
+  The address index used is freed by MachoFreeContext.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Symbol   Section symbol to retrieve the extent of.
+  @param[out]    Size     Pointer the extent size is returned into.
+                          If FALSE is returned, the output is undefined.
+
+  @retval FALSE is returned on failure.
+
+**/
+BOOLEAN
+MachoGetSymbolExtent64 (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol,
+  OUT    UINT64               *Size
+  );
+
 /**
   Returns whether Name is pure virtual.
 
@@ -554,6 +693,42 @@ MachoSymbolNameIsCxx (
   IN CONST CHAR8  *Name
   );
 
+/**
+  Retrieves the C++ classification of Symbol.  The first call classifies all
+  symbols of Context, the result is freed by MachoFreeContext.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Symbol   The symbol to classify.
+
+  @returns  A combination of MACHO_CXX_SYMBOL_* flags.
+
+**/
+UINT32
+MachoGetCxxSymbolFlags64 (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol
+  );
+
+/**
+  Retrieves the class name of a VTable, Metaclass Pointer or Super Metaclass
+  Pointer symbol from the classification of Context.
+
+  @param[in,out] Context        Context of the Mach-O.
+  @param[in]     Symbol         The symbol to get the class name of.
+  @param[in]     ClassNameSize  The size of ClassName.
+  @param[out]    ClassName      The output buffer for the class name.
+
+  @returns  Whether the name has been retrieved successfully.
+
+**/
+BOOLEAN
+MachoGetClassNameFromSymbol64 (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol,
+  IN     UINTN                ClassNameSize,
+  OUT    CHAR8                *ClassName
+  );
+
 /**
   Returns the number of VTable entires in VtableData.
 
@@ -29,6 +29,9 @@ typedef struct {
 
   TODO: edk2 now has its implementation in BaseLib, review it and use once it appears in UDK.
 
+  Whitespace characters are skipped. DecodedData may point to EncodedData
+  to decode in place, as decoded data never overtakes the encoded input.
+
   @param[in] EncodedData        A pointer to the data to convert.
   @param[in] EncodedLength      The length of data to convert.
   @param[in] DecodedData        A pointer to location to store the decoded data.
@@ -309,6 +309,24 @@ PlistDataValue (
   UINT32    *Size
   );
 
+//
+// Decodes data content in place, avoiding a separate output buffer.
+// Returns FALSE for invalid type, malformed data, or nodes taking part in
+// references, which may only be decoded with PlistDataValue.
+//
+// @param Buffer pointer to decoded data within the document buffer.
+// @param Size decoded data size.
+// @warn Node content is consumed and is empty for subsequent calls, also
+//       when data is malformed.
+// @warn Only valid for nodes of documents made by XmlDocumentParse.
+//
+BOOLEAN
+PlistDataValueInPlace (
+  XML_NODE  *Node,
+  UINT8     **Buffer,
+  UINT32    *Size
+  );
+
 //
 // @return boolean value for valid type or FALSE.
 //
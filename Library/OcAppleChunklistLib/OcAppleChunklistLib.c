@@ -15,6 +15,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/OcAppleChunklistLib.h>
+#include <Library/OcAppleKeysLib.h>
 #include <Library/OcCryptoLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/UefiLib.h>
@@ -64,33 +65,153 @@ OcAppleChunklistInitializeContext (
   }
 
   //
-  // Ensure that chunks and signature reside within Buffer.
+  // Ensure that chunks and signature reside within Buffer, and that chunks
+  // precede the signature to be signed.
   //
   if (OcOverflowMulAddUN (sizeof (APPLE_CHUNKLIST_CHUNK), ChunklistHeader->ChunkCount, (UINTN) Context->Chunks, &DataEnd)
-    || DataEnd > (UINTN) Buffer + Length
+    || DataEnd > (UINTN) Context->Signature
     || OcOverflowAddUN (sizeof (APPLE_CHUNKLIST_SIG), (UINTN) Context->Signature, &DataEnd)
     || DataEnd > (UINTN) Buffer + Length) {
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // Hash signed data once, it may be verified against several keys.
+  //
+  Sha256 (Context->Hash, (UINT8 *) Buffer, (UINTN) ChunklistHeader->SigOffset);
+
   return EFI_SUCCESS;
 }
 
 EFI_STATUS
 EFIAPI
-OcAppleChunklistVerifyData (
+OcAppleChunklistVerifySignature (
   IN OC_APPLE_CHUNKLIST_CONTEXT  *Context,
-  IN  VOID                       *Buffer,
-  IN  UINTN                      Length
+  IN CONST RSA_PUBLIC_KEY        *PublicKey  OPTIONAL
+  )
+{
+  UINT64  WorkBuf64[RSA_WORKBUF64_SIZE];
+  UINTN   Index;
+
+  ASSERT (Context != NULL);
+  ASSERT (Context->Signature != NULL);
+
+  //
+  // Keys are pre-processed, so every attempt is a single exponentiation.
+  //
+  if (PublicKey != NULL) {
+    if (RsaVerify ((RSA_PUBLIC_KEY *) PublicKey, Context->Signature->Signature, sizeof (Context->Signature->Signature), Context->Hash, WorkBuf64)) {
+      return EFI_SUCCESS;
+    }
+
+    return EFI_SECURITY_VIOLATION;
+  }
+
+  for (Index = 0; Index < NUM_OF_PK; Index++) {
+    if (RsaVerify ((RSA_PUBLIC_KEY *) PkDataBase[Index].PublicKey, Context->Signature->Signature, sizeof (Context->Signature->Signature), Context->Hash, WorkBuf64)) {
+      DEBUG ((DEBUG_INFO, "AppleChunklistVerifySignature(): Verified with key %u\n", (UINT32) Index));
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_SECURITY_VIOLATION;
+}
+
+/**
+  Verify up to MaxChunks consecutive chunks starting at Index, which are
+  entirely contained in Buffer.  Chunks are hashed in batches.
+
+  @param[in]  Context      The Context to verify against.
+  @param[in]  Index        First chunk index, Buffer starts with its data.
+  @param[in]  MaxChunks    Maximum number of chunks to verify.
+  @param[in]  Buffer       Chunk data.
+  @param[in]  Length       Length of Buffer.
+  @param[out] NumVerified  Number of chunks verified.
+  @param[out] Consumed     Number of bytes of Buffer verified.
+
+  @retval EFI_SUCCESS           Every chunk contained in Buffer was verified.
+  @retval EFI_COMPROMISED_DATA  A chunk failed verification.
+**/
+STATIC
+EFI_STATUS
+InternalChunklistVerifyChunks (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN  UINT64                      Index,
+  IN  UINT64                      MaxChunks,
+  IN  CONST UINT8                 *Buffer,
+  IN  UINTN                       Length,
+  OUT UINT64                      *NumVerified,
+  OUT UINTN                       *Consumed
   )
 {
-  UINT64                 Index;
   UINTN                  RemainingLength;
-  UINT8                  *BufferCurrent;
-  UINT8                  ChunkHash[SHA256_DIGEST_SIZE];
+  CONST UINT8            *BufferCurrent;
+  UINT8                  ChunkHashes[SHA256_MULTI_BUFFER_LANES][SHA256_DIGEST_SIZE];
+  CONST UINT8            *ChunkData[SHA256_MULTI_BUFFER_LANES];
+  UINTN                  ChunkLengths[SHA256_MULTI_BUFFER_LANES];
+  UINTN                  NumChunks;
+  UINTN                  BatchIndex;
+  BOOLEAN                Truncated;
   UINT64                 ChunkCount;
   APPLE_CHUNKLIST_CHUNK  *CurrentChunk;
 
+  RemainingLength = Length;
+  BufferCurrent   = Buffer;
+  ChunkCount      = Context->Header->ChunkCount;
+  CurrentChunk    = &Context->Chunks[Index];
+  *NumVerified    = 0;
+  Truncated       = FALSE;
+
+  while (*NumVerified < MaxChunks && !Truncated) {
+    //
+    // Collect a batch of chunks to hash together, chunks are independent.
+    // Ensure length of every chunk is valid.
+    //
+    for (NumChunks = 0; NumChunks < SHA256_MULTI_BUFFER_LANES && *NumVerified + NumChunks < MaxChunks; NumChunks++) {
+      if (RemainingLength < CurrentChunk[NumChunks].Length) {
+        Truncated = TRUE;
+        break;
+      }
+
+      ChunkData[NumChunks]    = BufferCurrent;
+      ChunkLengths[NumChunks] = CurrentChunk[NumChunks].Length;
+      BufferCurrent   += CurrentChunk[NumChunks].Length;
+      RemainingLength -= CurrentChunk[NumChunks].Length;
+    }
+
+    //
+    // Calculate checksums of data and ensure they match in chunk order.
+    //
+    Sha256MultiBuffer (&ChunkHashes[0][0], ChunkData, ChunkLengths, NumChunks);
+    for (BatchIndex = 0; BatchIndex < NumChunks; BatchIndex++) {
+      DEBUG ((DEBUG_INFO, "AppleChunklistVerifyData(): Validating chunk %lu of %lu\n",
+        Index + *NumVerified + BatchIndex, ChunkCount));
+      if (CompareMem (ChunkHashes[BatchIndex], CurrentChunk[BatchIndex].Checksum, SHA256_DIGEST_SIZE) != 0) {
+        *NumVerified += BatchIndex;
+        *Consumed     = (UINTN) (ChunkData[BatchIndex] - Buffer);
+        return EFI_COMPROMISED_DATA;
+      }
+    }
+
+    //
+    // Move to next batch.
+    //
+    *NumVerified += NumChunks;
+    CurrentChunk += NumChunks;
+  }
+
+  *Consumed = Length - RemainingLength;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+OcAppleChunklistVerifyData (
+  IN OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN  VOID                       *Buffer,
+  IN  UINTN                      Length
+  )
+{
   ASSERT (Context != NULL);
   ASSERT (Buffer != NULL);
   ASSERT (Length > 0);
@@ -99,35 +220,267 @@ OcAppleChunklistVerifyData (
   ASSERT (Context->Chunks != NULL);
   ASSERT (Context->Signature != NULL);
 
-  RemainingLength = Length;
-  BufferCurrent   = (UINT8 *) Buffer;
-  ChunkCount      = Context->Header->ChunkCount;
-  CurrentChunk    = &Context->Chunks[0];
+  return OcAppleChunklistVerifyChunks (
+    Context,
+    0,
+    Context->Header->ChunkCount,
+    Buffer,
+    Length
+    );
+}
 
-  for (Index = 0; Index < ChunkCount; Index++) {
-    //
-    // Ensure length of chunk is valid.
-    //
-    if (RemainingLength < CurrentChunk->Length) {
-      return EFI_END_OF_FILE;
+EFI_STATUS
+EFIAPI
+OcAppleChunklistVerifyChunks (
+  IN OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN UINT64                      FirstChunk,
+  IN UINT64                      NumChunks,
+  IN CONST VOID                  *Buffer,
+  IN UINTN                       Length
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      NumVerified;
+  UINTN       Consumed;
+
+  ASSERT (Context != NULL);
+  ASSERT (Buffer != NULL || Length == 0);
+
+  if (FirstChunk > Context->Header->ChunkCount
+    || NumChunks > Context->Header->ChunkCount - FirstChunk) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = InternalChunklistVerifyChunks (
+    Context,
+    FirstChunk,
+    NumChunks,
+    Buffer,
+    Length,
+    &NumVerified,
+    &Consumed
+    );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (NumVerified < NumChunks) {
+    return EFI_END_OF_FILE;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+OcAppleChunklistGetChunkRange (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN  UINT64                      FirstChunk,
+  IN  UINT64                      NumChunks,
+  OUT UINT64                      *Offset,
+  OUT UINT64                      *Length
+  )
+{
+  UINT64  Index;
+
+  ASSERT (Context != NULL);
+  ASSERT (Offset != NULL);
+  ASSERT (Length != NULL);
+
+  if (FirstChunk > Context->Header->ChunkCount
+    || NumChunks > Context->Header->ChunkCount - FirstChunk) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Chunk lengths are 32-bit, so 64-bit sums cannot overflow.
+  //
+  *Offset = 0;
+  for (Index = 0; Index < FirstChunk; Index++) {
+    *Offset += Context->Chunks[Index].Length;
+  }
+
+  *Length = 0;
+  for (; Index < FirstChunk + NumChunks; Index++) {
+    *Length += Context->Chunks[Index].Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+OcAppleChunklistFindChunks (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN  UINT64                      Offset,
+  IN  UINT64                      Length,
+  OUT UINT64                      *FirstChunk,
+  OUT UINT64                      *NumChunks
+  )
+{
+  UINT64  Index;
+  UINT64  ChunkStart;
+  UINT64  ChunkEnd;
+  UINT64  RangeEnd;
+
+  ASSERT (Context != NULL);
+  ASSERT (FirstChunk != NULL);
+  ASSERT (NumChunks != NULL);
+
+  if (Length == 0 || OcOverflowAddU64 (Offset, Length, &RangeEnd)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ChunkStart = 0;
+  *NumChunks = 0;
+
+  for (Index = 0; Index < Context->Header->ChunkCount; Index++) {
+    ChunkEnd = ChunkStart + Context->Chunks[Index].Length;
+
+    if (*NumChunks == 0 && ChunkEnd > Offset) {
+      *FirstChunk = Index;
+      *NumChunks  = 1;
+    } else if (*NumChunks > 0) {
+      ++*NumChunks;
     }
 
-    //
-    // Calculate checksum of data and ensure they match.
-    //
-    DEBUG ((DEBUG_INFO, "AppleChunklistVerifyData(): Validating chunk %lu of %lu\n",
-      Index, ChunkCount));
-    Sha256 (ChunkHash, BufferCurrent, CurrentChunk->Length);
-    if (CompareMem (ChunkHash, CurrentChunk->Checksum, SHA256_DIGEST_SIZE) != 0) {
-      return EFI_COMPROMISED_DATA;
+    if (*NumChunks > 0 && ChunkEnd >= RangeEnd) {
+      return EFI_SUCCESS;
+    }
+
+    ChunkStart = ChunkEnd;
+  }
+
+  //
+  // The range is not covered by the chunklist.
+  //
+  return EFI_INVALID_PARAMETER;
+}
+
+VOID
+EFIAPI
+OcAppleChunklistStreamInit (
+  IN  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  OUT OC_APPLE_CHUNKLIST_STREAM   *Stream
+  )
+{
+  ASSERT (Context != NULL);
+  ASSERT (Stream != NULL);
+
+  ZeroMem (Stream, sizeof (*Stream));
+  Stream->Chunklist = Context;
+}
+
+EFI_STATUS
+EFIAPI
+OcAppleChunklistStreamUpdate (
+  IN OUT OC_APPLE_CHUNKLIST_STREAM  *Stream,
+  IN     CONST VOID                 *Buffer,
+  IN     UINTN                      Length
+  )
+{
+  EFI_STATUS             Status;
+  CONST UINT8            *BufferCurrent;
+  UINT64                 ChunkCount;
+  UINT64                 NumVerified;
+  UINTN                  Consumed;
+  UINTN                  Size;
+  UINT8                  ChunkHash[SHA256_DIGEST_SIZE];
+  APPLE_CHUNKLIST_CHUNK  *CurrentChunk;
+
+  ASSERT (Stream != NULL);
+  ASSERT (Buffer != NULL || Length == 0);
+
+  BufferCurrent = (CONST UINT8 *) Buffer;
+  ChunkCount    = Stream->Chunklist->Header->ChunkCount;
+
+  while (Length > 0 && Stream->ChunkIndex < ChunkCount) {
+    if (Stream->ChunkOffset == 0) {
+      //
+      // Chunks entirely contained in Buffer need no intermediate state.
+      //
+      Status = InternalChunklistVerifyChunks (
+        Stream->Chunklist,
+        Stream->ChunkIndex,
+        ChunkCount - Stream->ChunkIndex,
+        BufferCurrent,
+        Length,
+        &NumVerified,
+        &Consumed
+        );
+      Stream->ChunkIndex += NumVerified;
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      BufferCurrent += Consumed;
+      Length        -= Consumed;
+
+      if (Length == 0 || Stream->ChunkIndex == ChunkCount) {
+        break;
+      }
+
+      Sha256Init (&Stream->Hash);
     }
 
     //
-    // Move to next chunk.
+    // Hash the beginning of a chunk crossing Buffer end, or the rest of it.
     //
-    BufferCurrent   += CurrentChunk->Length;
-    RemainingLength -= CurrentChunk->Length;
-    CurrentChunk++;
+    CurrentChunk = &Stream->Chunklist->Chunks[Stream->ChunkIndex];
+    Size         = MIN (Length, CurrentChunk->Length - Stream->ChunkOffset);
+    Sha256Update (&Stream->Hash, BufferCurrent, Size);
+    Stream->ChunkOffset += (UINT32) Size;
+    BufferCurrent       += Size;
+    Length              -= Size;
+
+    if (Stream->ChunkOffset == CurrentChunk->Length) {
+      DEBUG ((DEBUG_INFO, "AppleChunklistStreamUpdate(): Validating chunk %lu of %lu\n",
+        Stream->ChunkIndex, ChunkCount));
+      Sha256Final (&Stream->Hash, ChunkHash);
+      if (CompareMem (ChunkHash, CurrentChunk->Checksum, SHA256_DIGEST_SIZE) != 0) {
+        return EFI_COMPROMISED_DATA;
+      }
+
+      Stream->ChunkIndex++;
+      Stream->ChunkOffset = 0;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+OcAppleChunklistStreamFinal (
+  IN OUT OC_APPLE_CHUNKLIST_STREAM  *Stream
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      ChunkCount;
+
+  ASSERT (Stream != NULL);
+
+  ChunkCount = Stream->Chunklist->Header->ChunkCount;
+
+  //
+  // Only empty chunks may remain.
+  //
+  if (Stream->ChunkOffset == 0 && Stream->ChunkIndex < ChunkCount) {
+    Status = OcAppleChunklistVerifyChunks (
+      Stream->Chunklist,
+      Stream->ChunkIndex,
+      ChunkCount - Stream->ChunkIndex,
+      NULL,
+      0
+      );
+    if (!EFI_ERROR (Status)) {
+      Stream->ChunkIndex = ChunkCount;
+    }
+    return Status;
+  }
+
+  if (Stream->ChunkIndex < ChunkCount) {
+    return EFI_END_OF_FILE;
   }
 
   return EFI_SUCCESS;
@@ -32,12 +32,18 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/PrintLib.h>
 #include <Library/UefiLib.h>
 #include <Library/OcCryptoLib.h>
+#include <Library/OcFileLib.h>
 #include <Library/OcAppleImageVerificationLib.h>
+#include <Library/OcAppleKeysLib.h>
 #include <Library/OcGuardLib.h>
 #include <Protocol/DebugSupport.h>
 #include <IndustryStandard/PeImage.h>
 #include <Guid/AppleCertificate.h>
-#include "ApplePublicKeyDb.h"
+
+//
+// File read size for verifying images while they are read.
+//
+#define APPLE_PE_IMAGE_READ_SIZE BASE_128KB
 
 UINT16
 GetPeHeaderMagicValue (
@@ -404,8 +410,6 @@ GetApplePeImageSignature (
   UINT32                      Result                    = 0;
   APPLE_EFI_CERTIFICATE       *Cert                     = NULL;
   APPLE_EFI_CERTIFICATE_INFO  *CertInfo                 = NULL;
-  UINT8                       PkLe[256];
-  UINT8                       SigLe[256];
   //
   // Check SecDir extistence
   //
@@ -475,23 +479,17 @@ GetApplePeImageSignature (
       return EFI_UNSUPPORTED;
     }
 
-    //
-    // Extract PublicKey and Signature
-    //
-    CopyMem (PkLe, Cert->CertData.PublicKey, 256);
-    CopyMem (SigLe, Cert->CertData.Signature, 256);
-
     //
     // Calc public key hash and add in sig context
     //
-    Sha256 (SignatureContext->PublicKeyHash, PkLe, 256);
+    Sha256 (SignatureContext->PublicKeyHash, Cert->CertData.PublicKey, 256);
 
     //
-    // Convert to big endian and add in sig context
+    // Convert Signature to big endian and add in sig context, the public key
+    // is taken from the key database by its hash.
     //
     for (Index = 0; Index < 256; Index++) {
-      SignatureContext->PublicKey[256 - 1 - Index] = PkLe[Index];
-      SignatureContext->Signature[256 - 1 - Index] = SigLe[Index];
+      SignatureContext->Signature[256 - 1 - Index] = Cert->CertData.Signature[Index];
     }
 
     Status = EFI_SUCCESS;
@@ -548,36 +546,31 @@ SanitizeApplePeImage (
       (UINT8 *) Image + *RealImageSize,
       ImageSize - *RealImageSize
       );
-    //
-    // Reallocate file buffer
-    //
-    Image = ReallocatePool (
-              ImageSize,
-              *RealImageSize,
-              Image
-              );
   }
 }
 
+/**
+  Get authenticated ranges of a PE image with a built PE context.
+**/
+STATIC
 EFI_STATUS
-GetApplePeImageSha256 (
+InternalGetApplePeImageHashRanges (
   VOID                                *Image,
-  APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context
+  APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context,
+  APPLE_PE_IMAGE_HASH_RANGE           *Ranges
   )
 {
-  UINT64                   HashSize           = 0;
-  UINT8                    *HashBase          = NULL;
-  SHA256_CONTEXT           HashContext;
+  UINTN                    Index;
 
-  //
-  // Initialise a SHA hash context
-  //
-  Sha256Init (&HashContext);
+  if (Context->SecDir == NULL) {
+    return EFI_UNSUPPORTED;
+  }
 
   //
   // Hash DOS header and skip DOS stub
   //
-  Sha256Update (&HashContext, Image, sizeof (EFI_IMAGE_DOS_HEADER));
+  Ranges[0].Start = 0;
+  Ranges[0].End   = sizeof (EFI_IMAGE_DOS_HEADER);
 
   /**
     Measuring PE/COFF Image Header;
@@ -585,58 +578,103 @@ GetApplePeImageSha256 (
     Calculate the distance from the base of the image header to the image checksum address
     Hash the image header from its base to beginning of the image checksum
   **/
-
-  HashBase = (UINT8 *) Image + ((EFI_IMAGE_DOS_HEADER *) Image)->e_lfanew;
-  HashSize = (UINT8 *) Context->OptHdrChecksum - HashBase;
-  Sha256Update (&HashContext, HashBase, HashSize);
+  Ranges[1].Start = ((EFI_IMAGE_DOS_HEADER *) Image)->e_lfanew;
+  Ranges[1].End   = (UINT8 *) Context->OptHdrChecksum - (UINT8 *) Image;
 
   //
   // Hash everything from the end of the checksum to the start of the Cert Directory.
   //
-  HashBase = (UINT8 *) Context->OptHdrChecksum + sizeof (UINT32);
-  HashSize = (UINT8 *) Context->SecDir - HashBase;
-  Sha256Update (&HashContext, HashBase, HashSize);
+  Ranges[2].Start = Ranges[1].End + sizeof (UINT32);
+  Ranges[2].End   = (UINT8 *) Context->SecDir - (UINT8 *) Image;
 
   //
   // Hash from the end of SecDirEntry till SecDir data
   //
-  HashBase = (UINT8 *) Context->RelocDir;
-  HashSize = (UINT8 *) Image + Context->SecDir->VirtualAddress - HashBase;
-  Sha256Update (&HashContext, HashBase, HashSize);
+  Ranges[3].Start = Ranges[2].End + sizeof (EFI_IMAGE_DATA_DIRECTORY);
+  Ranges[3].End   = Context->SecDir->VirtualAddress;
+
+  for (Index = 0; Index < APPLE_PE_IMAGE_HASH_RANGES; Index++) {
+    if (Ranges[Index].Start > Ranges[Index].End
+      || (Index > 0 && Ranges[Index - 1].End > Ranges[Index].Start)) {
+      DEBUG ((DEBUG_WARN, "Malformed authenticated ranges\n"));
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+GetApplePeImageSha256 (
+  VOID                                *Image,
+  APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      Index;
+  APPLE_PE_IMAGE_HASH_RANGE  Ranges[APPLE_PE_IMAGE_HASH_RANGES];
+  SHA256_CONTEXT             HashContext;
+
+  Status = InternalGetApplePeImageHashRanges (Image, Context, Ranges);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Initialise a SHA hash context
+  //
+  Sha256Init (&HashContext);
+
+  for (Index = 0; Index < APPLE_PE_IMAGE_HASH_RANGES; Index++) {
+    Sha256Update (
+      &HashContext,
+      (UINT8 *) Image + Ranges[Index].Start,
+      Ranges[Index].End - Ranges[Index].Start
+      );
+  }
 
   Sha256Final (&HashContext, Context->PeImageHash);
   return EFI_SUCCESS;
 }
 
+/**
+  Verify Apple signature of a PE image with a built PE context, HashReady
+  is set when Context already contains the image hash.
+**/
+STATIC
 EFI_STATUS
-VerifyApplePeImageSignature (
+InternalVerifyApplePeImage (
+  IN OUT APPLE_PE_IMAGE_VERIFIER             *Verifier,
   IN OUT VOID                                *PeImage,
   IN OUT UINTN                               *ImageSize,
-  IN OUT APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context OPTIONAL
+  IN OUT APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context,
+  IN     BOOLEAN                             HashReady
   )
 {
-  UINT32                   WorkBuf32[RSANUMWORDS * 3];
-  UINTN                    Index                       = 0;
-  APPLE_SIGNATURE_CONTEXT  *SignatureContext           = NULL;
-  RSA_PUBLIC_KEY           *Pk                         = NULL;
+  APPLE_SIGNATURE_CONTEXT  *SignatureContext;
+  CONST APPLE_PK_ENTRY     *Pk;
+  UINTN                    RealImageSize;
+
+  SignatureContext = &Verifier->SignatureContext;
 
   //
-  // Build context if not present
+  // Sanitizing trims the image to the end of the certificate, which must
+  // therefore exist and fit within the image.
   //
-  if (Context == NULL) {
-    Context = AllocateZeroPool (sizeof (APPLE_PE_COFF_LOADER_IMAGE_CONTEXT));
-    if (Context == NULL) {
-      DEBUG ((DEBUG_WARN, "Pe context allocation failure\n"));
-      return EFI_OUT_OF_RESOURCES;
-    }
-    //
-    // Build PE context
-    //
-    if (EFI_ERROR (BuildPeContext (PeImage, *ImageSize, Context))) {
-      DEBUG ((DEBUG_WARN, "Malformed ApplePeImage\n"));
-      FreePool (Context);
-      return EFI_INVALID_PARAMETER;
-    }
+  if (Context->SecDir == NULL) {
+    DEBUG ((DEBUG_WARN, "AppleSignature not present!\n"));
+    return EFI_UNSUPPORTED;
+  }
+
+  if (OcOverflowTriAddUN (
+        Context->SecDir->VirtualAddress,
+        Context->SecDir->Size,
+        sizeof (APPLE_EFI_CERTIFICATE),
+        &RealImageSize
+        )
+    || RealImageSize > *ImageSize) {
+    DEBUG ((DEBUG_WARN, "AppleSignature out of image bounds!\n"));
+    return EFI_UNSUPPORTED;
   }
 
   //
@@ -645,65 +683,341 @@ VerifyApplePeImageSignature (
   SanitizeApplePeImage (PeImage, ImageSize, Context);
 
   //
-  // Allocate signature context
+  // Extract AppleSignature from PEImage
   //
-  SignatureContext = AllocateZeroPool (sizeof (APPLE_SIGNATURE_CONTEXT));
-  if (SignatureContext == NULL) {
-    DEBUG ((DEBUG_WARN, "Signature context allocation failure\n"));
-    return EFI_OUT_OF_RESOURCES;
+  if (EFI_ERROR (GetApplePeImageSignature (PeImage, *ImageSize, Context, SignatureContext))) {
+    DEBUG ((DEBUG_WARN, "AppleSignature broken or not present!\n"));
+    return EFI_UNSUPPORTED;
   }
 
   //
-  // Extract AppleSignature from PEImage
+  // Verify existence in DataBase before hashing the image
   //
-  if (EFI_ERROR (GetApplePeImageSignature (PeImage, *ImageSize, Context, SignatureContext))) {
-    DEBUG ((DEBUG_WARN, "AppleSignature broken or not present!\n"));
-    FreePool (SignatureContext);
-    FreePool (Context);
+  Pk = FindApplePublicKey (Verifier->Keys, Verifier->NumKeys, SignatureContext->PublicKeyHash);
+  if (Pk == NULL) {
+    DEBUG ((DEBUG_WARN, "Unknown publickey or malformed certificate\n"));
     return EFI_UNSUPPORTED;
   }
 
   //
-  // Calcucate PeImage hash
+  // Calcucate PeImage hash unless it was calculated while reading
   //
-  if (EFI_ERROR (GetApplePeImageSha256 (PeImage, Context))) {
+  if (!HashReady && EFI_ERROR (GetApplePeImageSha256 (PeImage, Context))) {
     DEBUG ((DEBUG_WARN, "Couldn't calcuate hash of PeImage\n"));
-    FreePool (SignatureContext);
-    FreePool (Context);
     return EFI_INVALID_PARAMETER;
   }
 
   //
-  // Verify existence in DataBase
+  // Verify signature
+  //
+  if (RsaVerify ((RSA_PUBLIC_KEY *) Pk->PublicKey, SignatureContext->Signature, sizeof (SignatureContext->Signature), Context->PeImageHash, Verifier->WorkBuf64)) {
+    DEBUG ((DEBUG_INFO, "Signature verified!\n"));
+    return EFI_SUCCESS;
+  }
+
+  return EFI_SECURITY_VIOLATION;
+}
+
+VOID
+InitializeApplePeImageVerifier (
+  OUT APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  IN  CONST APPLE_PK_ENTRY     *Keys OPTIONAL,
+  IN  UINTN                    NumKeys
+  )
+{
+  if (Keys == NULL) {
+    Keys    = PkDataBase;
+    NumKeys = NUM_OF_PK;
+  }
+
+  Verifier->Keys    = Keys;
+  Verifier->NumKeys = NumKeys;
+}
+
+EFI_STATUS
+VerifyApplePeImage (
+  IN OUT APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  IN OUT VOID                     *PeImage,
+  IN OUT UINTN                    *ImageSize
+  )
+{
+  //
+  // Build PE context, previous image state must not leak into it
   //
-  for (Index = 0; Index < NUM_OF_PK; Index++) {
-    if (CompareMem (PkDataBase[Index].Hash, SignatureContext->PublicKeyHash, 32) == 0) {
-      //
-      // PublicKey valid. Extract prepared publickey from database
-      //
-      Pk = (RSA_PUBLIC_KEY *) PkDataBase[Index].PublicKey;
+  ZeroMem (&Verifier->PeContext, sizeof (Verifier->PeContext));
+  if (EFI_ERROR (BuildPeContext (PeImage, *ImageSize, &Verifier->PeContext))) {
+    DEBUG ((DEBUG_WARN, "Malformed ApplePeImage\n"));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return InternalVerifyApplePeImage (Verifier, PeImage, ImageSize, &Verifier->PeContext, FALSE);
+}
+
+/**
+  Parse image headers once enough of them is read.  The size of the headers
+  is only known after reading their beginning, so HeaderSize grows until all
+  of them are read.  Everything is parsed when the image is read completely.
+**/
+STATIC
+VOID
+InternalApplePeImageStreamHeaders (
+  IN OUT APPLE_PE_IMAGE_STREAM  *Stream
+  )
+{
+  EFI_IMAGE_DOS_HEADER             *DosHdr;
+  EFI_IMAGE_OPTIONAL_HEADER_UNION  *PeHdr;
+  UINTN                            HeaderSize;
+
+  if (Stream->Received < Stream->ImageSize) {
+    if (Stream->Received < Stream->HeaderSize) {
+      return;
+    }
+
+    DosHdr     = (EFI_IMAGE_DOS_HEADER *) Stream->Image;
+    PeHdr      = (EFI_IMAGE_OPTIONAL_HEADER_UNION *) Stream->Image;
+    HeaderSize = sizeof (EFI_IMAGE_OPTIONAL_HEADER_UNION);
+
+    if (DosHdr->e_magic == EFI_IMAGE_DOS_SIGNATURE) {
+      if (DosHdr->e_lfanew > Stream->ImageSize) {
+        Stream->HeaderSize = Stream->ImageSize;
+        return;
+      }
+
+      HeaderSize += DosHdr->e_lfanew;
+      if (Stream->Received < HeaderSize) {
+        Stream->HeaderSize = HeaderSize;
+        return;
+      }
+
+      PeHdr = (EFI_IMAGE_OPTIONAL_HEADER_UNION *) (Stream->Image + DosHdr->e_lfanew);
+    }
+
+    if (GetPeHeaderMagicValue (PeHdr) == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+      HeaderSize = MAX (HeaderSize, PeHdr->Pe32.OptionalHeader.SizeOfHeaders);
+    } else {
+      HeaderSize = MAX (HeaderSize, PeHdr->Pe32Plus.OptionalHeader.SizeOfHeaders);
+    }
+
+    if (Stream->Received < HeaderSize) {
+      Stream->HeaderSize = HeaderSize;
+      return;
     }
   }
 
-  if (Pk == NULL) {
-    DEBUG ((DEBUG_WARN, "Unknown publickey or malformed certificate\n"));
-    FreePool (SignatureContext);
-    FreePool (Context);
-    return EFI_UNSUPPORTED;
+  Stream->HeadersParsed = TRUE;
+
+  if (EFI_ERROR (BuildPeContext (Stream->Image, Stream->ImageSize, &Stream->Verifier->PeContext))) {
+    DEBUG ((DEBUG_WARN, "Malformed ApplePeImage\n"));
+    Stream->Status = EFI_INVALID_PARAMETER;
+    return;
+  }
+
+  Stream->Status = InternalGetApplePeImageHashRanges (
+                     Stream->Image,
+                     &Stream->Verifier->PeContext,
+                     Stream->Ranges
+                     );
+}
+
+/**
+  Hash authenticated data read since the previous call.
+**/
+STATIC
+VOID
+InternalApplePeImageStreamHash (
+  IN OUT APPLE_PE_IMAGE_STREAM  *Stream,
+  IN     UINTN                  Hashed
+  )
+{
+  APPLE_PE_IMAGE_HASH_RANGE  *Range;
+  UINTN                      Start;
+  UINTN                      End;
+
+  while (Stream->RangeIndex < APPLE_PE_IMAGE_HASH_RANGES) {
+    Range = &Stream->Ranges[Stream->RangeIndex];
+    Start = MAX (Range->Start, Hashed);
+    End   = MIN (Range->End, Stream->Received);
+    if (Start < End) {
+      Sha256Update (&Stream->Hash, Stream->Image + Start, End - Start);
+    }
+
+    if (End < Range->End) {
+      return;
+    }
+
+    Stream->RangeIndex++;
+  }
+
+  Sha256Final (&Stream->Hash, Stream->Verifier->PeContext.PeImageHash);
+  Stream->HashReady = TRUE;
+}
+
+EFI_STATUS
+ApplePeImageStreamInit (
+  IN  APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  OUT APPLE_PE_IMAGE_STREAM    *Stream,
+  IN  VOID                     *PeImage,
+  IN  UINTN                    ImageSize
+  )
+{
+  ZeroMem (Stream, sizeof (*Stream));
+  ZeroMem (&Verifier->PeContext, sizeof (Verifier->PeContext));
+
+  Stream->Verifier   = Verifier;
+  Stream->Image      = PeImage;
+  Stream->ImageSize  = ImageSize;
+  Stream->HeaderSize = MAX (sizeof (EFI_IMAGE_DOS_HEADER), sizeof (EFI_IMAGE_OPTIONAL_HEADER_UNION));
+  Stream->Status     = EFI_SUCCESS;
+
+  Sha256Init (&Stream->Hash);
+
+  if (ImageSize == 0) {
+    Stream->Status = EFI_INVALID_PARAMETER;
+  }
+
+  return Stream->Status;
+}
+
+EFI_STATUS
+ApplePeImageStreamUpdate (
+  IN OUT APPLE_PE_IMAGE_STREAM  *Stream,
+  IN     UINTN                  Length
+  )
+{
+  UINTN  Hashed;
+
+  if (Length > Stream->ImageSize - Stream->Received) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Hashed            = Stream->Received;
+  Stream->Received += Length;
+
+  if (!Stream->HeadersParsed) {
+    InternalApplePeImageStreamHeaders (Stream);
+    //
+    // Headers were not authenticated before being parsed.
+    //
+    Hashed = 0;
+  }
+
+  if (Stream->HeadersParsed && !EFI_ERROR (Stream->Status) && !Stream->HashReady) {
+    InternalApplePeImageStreamHash (Stream, Hashed);
+  }
+
+  return Stream->Status;
+}
+
+EFI_STATUS
+ApplePeImageStreamFinal (
+  IN OUT APPLE_PE_IMAGE_STREAM  *Stream,
+  OUT    UINTN                  *ImageSize
+  )
+{
+  if (Stream->Received != Stream->ImageSize) {
+    return EFI_END_OF_FILE;
+  }
+
+  if (EFI_ERROR (Stream->Status)) {
+    return Stream->Status;
   }
 
   //
-  // Verify signature
+  // Headers are always parsed once the image is read completely, unless
+  // there was nothing to read.
   //
-  if (RsaVerify (Pk, SignatureContext->Signature, Context->PeImageHash, WorkBuf32) == 1 ) {
-    DEBUG ((DEBUG_INFO, "Signature verified!\n"));
-    FreePool (SignatureContext);
-    FreePool (Context);
-    return EFI_SUCCESS;
+  if (!Stream->HeadersParsed) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  FreePool (SignatureContext);
-  FreePool (Context);
+  *ImageSize = Stream->ImageSize;
 
-  return EFI_SECURITY_VIOLATION;
+  return InternalVerifyApplePeImage (
+    Stream->Verifier,
+    Stream->Image,
+    ImageSize,
+    &Stream->Verifier->PeContext,
+    Stream->HashReady
+    );
+}
+
+EFI_STATUS
+VerifyApplePeImageFile (
+  IN OUT APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  IN     EFI_FILE_PROTOCOL        *File,
+  OUT    VOID                     **PeImage,
+  OUT    UINTN                    *ImageSize
+  )
+{
+  EFI_STATUS             Status;
+  APPLE_PE_IMAGE_STREAM  Stream;
+  UINT8                  *Image;
+  UINT32                 Size;
+  UINT32                 Offset;
+  UINT32                 ReadSize;
+
+  *PeImage = NULL;
+
+  Status = ReadFileSize (File, &Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Size == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Image = AllocatePool (Size);
+  if (Image == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = ApplePeImageStreamInit (Verifier, &Stream, Image, Size);
+  if (EFI_ERROR (Status)) {
+    FreePool (Image);
+    return Status;
+  }
+
+  //
+  // Read in pieces small enough for the data to still be cached when hashed.
+  //
+  for (Offset = 0; Offset < Size; Offset += ReadSize) {
+    ReadSize = MIN (Size - Offset, APPLE_PE_IMAGE_READ_SIZE);
+    Status   = ReadFileData (File, Offset, ReadSize, Image + Offset);
+    if (!EFI_ERROR (Status)) {
+      Status = ApplePeImageStreamUpdate (&Stream, ReadSize);
+    }
+
+    if (EFI_ERROR (Status)) {
+      FreePool (Image);
+      return Status;
+    }
+  }
+
+  Status = ApplePeImageStreamFinal (&Stream, ImageSize);
+  if (EFI_ERROR (Status)) {
+    FreePool (Image);
+    return Status;
+  }
+
+  *PeImage = Image;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+VerifyApplePeImageSignature (
+  IN OUT VOID                                *PeImage,
+  IN OUT UINTN                               *ImageSize,
+  IN OUT APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  *Context OPTIONAL
+  )
+{
+  APPLE_PE_IMAGE_VERIFIER  Verifier;
+
+  InitializeApplePeImageVerifier (&Verifier, NULL, 0);
+
+  if (Context == NULL) {
+    return VerifyApplePeImage (&Verifier, PeImage, ImageSize);
+  }
+
+  return InternalVerifyApplePeImage (&Verifier, PeImage, ImageSize, Context, FALSE);
 }
@@ -53,7 +53,6 @@ InternalFillSymbolTable64 (
   UINT32              NumCxxSymbols;
   UINT32              Index;
   CONST MACH_NLIST_64 *Symbol;
-  CONST CHAR8         *Name;
   BOOLEAN             Result;
 
   ASSERT (MachoContext != NULL);
@@ -67,8 +66,8 @@ InternalFillSymbolTable64 (
 
   for (Index = 0; Index < NumSymbols; ++Index) {
     Symbol = &Symbols[Index];
-    Name   = MachoGetSymbolName64 (MachoContext, Symbol);
-    Result = MachoSymbolNameIsCxx (Name);
+    Result = (MachoGetCxxSymbolFlags64 (MachoContext, Symbol)
+                & MACHO_CXX_SYMBOL_CXX) != 0;
 
     if (!Result) {
       WalkerBottom->StringIndex = Symbol->UnifiedName.StringIndex;
@@ -24,6 +24,8 @@
 #include <Library/OcMachoLib.h>
 #include <Library/OcGuardLib.h>
 
+#include "PrelinkedInternal.h"
+
 //
 // Pick a reasonable maximum to fit.
 //
@@ -142,6 +144,7 @@ ParseCompressedHeader (
   UINT32            CompressedSize;
   UINT32            DecompressedSize;
   UINT32            DecompressedHash;
+  UINT64            Start;
 
   CompHeader       = (MACH_COMP_HEADER *) *Buffer;
   CompressionType  = CompHeader->Compression;
@@ -178,12 +181,16 @@ ParseCompressedHeader (
     return KernelSize;
   }
 
+  Start = InternalKernelTimingStart ();
+
   if (CompressionType == MACH_COMPRESSED_BINARY_INVERT_LZVN) {
     KernelSize = (UINT32) DecompressLZVN (*Buffer, DecompressedSize, CompressedBuffer, CompressedSize);
   } else if (CompressionType == MACH_COMPRESSED_BINARY_INVERT_LZSS) {
     KernelSize = (UINT32) DecompressLZSS (*Buffer, DecompressedSize, CompressedBuffer, CompressedSize);
   }
 
+  InternalKernelTimingStop (KernelTimingDecompress, Start);
+
   if (KernelSize != DecompressedSize) {
     KernelSize = 0;
   }
@@ -322,6 +329,11 @@ ReadAppleKernel (
   )
 {
   EFI_STATUS  Status;
+  UINT64      Start;
+  UINT64      DecompressTicks;
+
+  Start           = InternalKernelTimingStart ();
+  DecompressTicks = InternalKernelTimingGetTicks (KernelTimingDecompress);
 
   *KernelSize    = 0;
   *AllocatedSize = KERNEL_HEADER_SIZE;
@@ -344,5 +356,11 @@ ReadAppleKernel (
     FreePool (*Kernel);
   }
 
+  //
+  // Decompression is accounted separately, exclude it from reading.
+  //
+  Start += InternalKernelTimingGetTicks (KernelTimingDecompress) - DecompressTicks;
+  InternalKernelTimingStop (KernelTimingRead, Start);
+
   return Status;
 }
@@ -0,0 +1,117 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/OcAppleKernelLib.h>
+#include <Library/OcTimerLib.h>
+
+#include "PrelinkedInternal.h"
+
+STATIC KERNEL_TIMING_REPORT  mKernelTiming;
+
+//
+// Must match KERNEL_TIMING_PHASE order.
+//
+STATIC CONST CHAR8 *mKernelTimingPhaseNames[KernelTimingPhaseMax] = {
+  "Kernel read",
+  "Kernel decompress",
+  "Prelinked info parse",
+  "Kext inject",
+  "Dependency scan",
+  "Symbol resolve",
+  "Vtable patch",
+  "Relocate",
+  "Patch apply",
+  "Inject complete"
+};
+
+UINT64
+InternalKernelTimingStart (
+  VOID
+  )
+{
+  return GetPerformanceCounter ();
+}
+
+VOID
+InternalKernelTimingStop (
+  IN KERNEL_TIMING_PHASE  Phase,
+  IN UINT64               Start
+  )
+{
+  KERNEL_TIMING_ENTRY  *Entry;
+  UINT64               Ticks;
+
+  ASSERT (Phase < KernelTimingPhaseMax);
+
+  Ticks = GetPerformanceCounter () - Start;
+  Entry = &mKernelTiming.Phases[Phase];
+
+  Entry->Ticks += Ticks;
+  Entry->MaxTicks = MAX (Entry->MaxTicks, Ticks);
+  ++Entry->Count;
+}
+
+UINT64
+InternalKernelTimingGetTicks (
+  IN KERNEL_TIMING_PHASE  Phase
+  )
+{
+  ASSERT (Phase < KernelTimingPhaseMax);
+
+  return mKernelTiming.Phases[Phase].Ticks;
+}
+
+VOID
+KernelTimingReset (
+  VOID
+  )
+{
+  ZeroMem (&mKernelTiming, sizeof (mKernelTiming));
+}
+
+VOID
+KernelTimingGetReport (
+  OUT KERNEL_TIMING_REPORT  *Report
+  )
+{
+  CopyMem (Report, &mKernelTiming, sizeof (*Report));
+}
+
+VOID
+KernelTimingPrintReport (
+  VOID
+  )
+{
+  UINT32               Index;
+  KERNEL_TIMING_ENTRY  *Entry;
+
+  for (Index = 0; Index < KernelTimingPhaseMax; ++Index) {
+    Entry = &mKernelTiming.Phases[Index];
+    if (Entry->Count == 0) {
+      continue;
+    }
+
+    DEBUG ((
+      DEBUG_INFO,
+      "%a - %u runs, %Lu us total, %Lu us max\n",
+      mKernelTimingPhaseNames[Index],
+      Entry->Count,
+      DivU64x32 (GetTimeInNanoSecond (Entry->Ticks), 1000),
+      DivU64x32 (GetTimeInNanoSecond (Entry->MaxTicks), 1000)
+      ));
+  }
+}
@@ -26,6 +26,24 @@
 
 #include "PrelinkedInternal.h"
 
+/**
+  Check whether patcher context references the current prelinked buffer.
+  Context copies made before prelinked growth reference freed memory.
+
+  @param[in] Context  Patcher context.
+
+  @return  TRUE if the context may be used.
+**/
+STATIC
+BOOLEAN
+InternalPatcherContextIsValid (
+  IN CONST PATCHER_CONTEXT  *Context
+  )
+{
+  return Context->Prelinked == NULL
+    || Context->PrelinkedGeneration == Context->Prelinked->PrelinkedGeneration;
+}
+
 EFI_STATUS
 PatcherInitContextFromPrelinked (
   IN OUT PATCHER_CONTEXT    *Context,
@@ -41,6 +59,36 @@ PatcherInitContextFromPrelinked (
   }
 
   CopyMem (Context, &Kext->Context, sizeof (*Context));
+
+  //
+  // The copy shares the lookup indices the cached kext has built so far, and
+  // must not allocate its own as nothing would free them.  Lookups lacking
+  // a shared index fall back to linear symbol table scans.
+  //
+  Context->MachContext.SymbolsByNameBuilt        = TRUE;
+  Context->MachContext.SymbolsByAddressBuilt     = TRUE;
+  Context->MachContext.RelocationsByAddressBuilt = TRUE;
+  Context->MachContext.CxxSymbolsBuilt           = TRUE;
+  Context->MachContext.SectionsSorted            = TRUE;
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+PatcherGetContextFromPrelinked (
+  IN OUT PRELINKED_CONTEXT  *Prelinked,
+  IN     CONST CHAR8        *Name,
+  OUT    PATCHER_CONTEXT    **Context
+  )
+{
+  PRELINKED_KEXT  *Kext;
+
+  Kext = InternalCachedPrelinkedKext (Prelinked, Name);
+  if (Kext == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Context = &Kext->Context;
   return EFI_SUCCESS;
 }
 
@@ -53,6 +101,9 @@ PatcherInitContextFromBuffer (
 {
   MACH_SEGMENT_COMMAND_64  *Segment;
 
+  Context->Prelinked           = NULL;
+  Context->PrelinkedGeneration = 0;
+
   if (!MachoInitializeContext (&Context->MachContext, Buffer, BufferSize)) {
     return EFI_INVALID_PARAMETER;
   }
@@ -79,24 +130,15 @@ PatcherGetSymbolAddress (
   )
 {
   MACH_NLIST_64  *Symbol;
-  CONST CHAR8    *SymbolName;
   UINT32         Offset;
-  UINT32         Index;
 
-  Index = 0;
-  while (TRUE) {
-    Symbol = MachoGetSymbolByIndex64 (&Context->MachContext, Index);
-    if (Symbol == NULL) {
-      return EFI_NOT_FOUND;
-    }
-
-    SymbolName = MachoGetSymbolName64 (&Context->MachContext, Symbol);
-
-    if (SymbolName && AsciiStrCmp (Name, SymbolName) == 0) {
-      break;
-    }
+  if (!InternalPatcherContextIsValid (Context)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-    Index++;
+  Symbol = MachoGetSymbolByName64 (&Context->MachContext, Name);
+  if (Symbol == NULL) {
+    return EFI_NOT_FOUND;
   }
 
   if (!MachoSymbolGetFileOffset64 (&Context->MachContext, Symbol, &Offset)) {
@@ -107,26 +149,51 @@ PatcherGetSymbolAddress (
   return EFI_SUCCESS;
 }
 
+STATIC
 EFI_STATUS
-PatcherApplyGenericPatch (
+InternalApplyGenericPatch (
   IN OUT PATCHER_CONTEXT        *Context,
   IN     PATCHER_GENERIC_PATCH  *Patch
   )
 {
-  EFI_STATUS  Status;
-  UINT8       *Base;
-  UINT32      Size;
-  UINT32      ReplaceCount;
+  MACH_NLIST_64  *Symbol;
+  UINT8          *Base;
+  UINT32         Offset;
+  UINT32         Size;
+  UINT64         Extent;
+  UINT32         ReplaceCount;
 
-  Base = (UINT8 *) MachoGetMachHeader64 (&Context->MachContext);
-  Size = MachoGetFileSize (&Context->MachContext);
+  Base   = (UINT8 *) MachoGetMachHeader64 (&Context->MachContext);
+  Size   = MachoGetFileSize (&Context->MachContext);
+  Symbol = NULL;
   if (Patch->Base != NULL) {
-    Status = PatcherGetSymbolAddress (Context, Patch->Base, &Base);
-    if (EFI_ERROR (Status)) {
-      return Status;
+    Symbol = MachoGetSymbolByName64 (&Context->MachContext, Patch->Base);
+    if (Symbol == NULL) {
+      return EFI_NOT_FOUND;
+    }
+
+    if (!MachoSymbolGetFileOffset64 (&Context->MachContext, Symbol, &Offset)
+      || Offset > Size) {
+      return EFI_INVALID_PARAMETER;
     }
 
-    Size -= (UINT32) (Base - (UINT8 *) MachoGetMachHeader64 (&Context->MachContext));
+    Base += Offset;
+    Size -= Offset;
+  }
+
+  if (Patch->Limit == PATCHER_LIMIT_SYMBOL) {
+    //
+    // Most symbolic patches target a single function, which ends where
+    // the next symbol starts.
+    //
+    if (Symbol == NULL
+      || !MachoGetSymbolExtent64 (&Context->MachContext, Symbol, &Extent)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Size = (UINT32) MIN (Size, Extent);
+  } else if (Patch->Limit != 0) {
+    Size = MIN (Size, Patch->Limit);
   }
 
   if (Patch->Find == NULL) {
@@ -157,6 +224,90 @@ PatcherApplyGenericPatch (
   return EFI_NOT_FOUND;
 }
 
+EFI_STATUS
+PatcherApplyGenericPatch (
+  IN OUT PATCHER_CONTEXT        *Context,
+  IN     PATCHER_GENERIC_PATCH  *Patch
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      Start;
+
+  if (!InternalPatcherContextIsValid (Context)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Start  = InternalKernelTimingStart ();
+  Status = InternalApplyGenericPatch (Context, Patch);
+  InternalKernelTimingStop (KernelTimingApplyPatch, Start);
+
+  return Status;
+}
+
+EFI_STATUS
+PatcherApplyGenericPatches (
+  IN OUT PRELINKED_CONTEXT      *Prelinked,
+  IN OUT PATCHER_PATCH_REQUEST  *Requests,
+  IN     UINT32                 NumRequests
+  )
+{
+  EFI_STATUS       Status;
+  EFI_STATUS       Result;
+  PATCHER_CONTEXT  *Patcher;
+  UINT32           Index;
+  UINT32           Index2;
+
+  for (Index = 0; Index < NumRequests; ++Index) {
+    Requests[Index].Status = EFI_NOT_READY;
+  }
+
+  Result = EFI_SUCCESS;
+
+  for (Index = 0; Index < NumRequests; ++Index) {
+    if (Requests[Index].Status != EFI_NOT_READY) {
+      continue;
+    }
+
+    Status = PatcherGetContextFromPrelinked (
+      Prelinked,
+      Requests[Index].Identifier,
+      &Patcher
+      );
+
+    //
+    // Apply this and all further patches of the same kext.
+    //
+    for (Index2 = Index; Index2 < NumRequests; ++Index2) {
+      if (Requests[Index2].Status != EFI_NOT_READY
+        || AsciiStrCmp (Requests[Index2].Identifier, Requests[Index].Identifier) != 0) {
+        continue;
+      }
+
+      if (!EFI_ERROR (Status)) {
+        Requests[Index2].Status = PatcherApplyGenericPatch (Patcher, Requests[Index2].Patch);
+      } else {
+        Requests[Index2].Status = Status;
+      }
+
+      if (EFI_ERROR (Requests[Index2].Status)) {
+        DEBUG ((
+          DEBUG_WARN,
+          "Failed to apply patch %u to %a - %r\n",
+          Index2,
+          Requests[Index2].Identifier,
+          Requests[Index2].Status
+          ));
+
+        if (!EFI_ERROR (Result)) {
+          Result = Requests[Index2].Status;
+        }
+      }
+    }
+  }
+
+  return Result;
+}
+
 EFI_STATUS
 PatcherBlockKext (
   IN OUT PATCHER_CONTEXT        *Context
@@ -167,6 +318,10 @@ PatcherBlockKext (
   KMOD_INFO_64_V1  *KmodInfo;
   UINT8            *PatchAddr;
 
+  if (!InternalPatcherContextIsValid (Context)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
   //
   // Kernel has 0 kmod.
   //
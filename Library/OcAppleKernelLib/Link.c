@@ -347,6 +347,7 @@ InternalCalculateTargetsIntel64 (
   UINT64                TargetAddress;
   MACH_NLIST_64         *Symbol;
   CONST CHAR8           *Name;
+  UINT32                Flags;
   MACH_SECTION_64       *Section;
   UINT64                PairAddress;
   UINT64                PairDummy;
@@ -396,11 +397,12 @@ InternalCalculateTargetsIntel64 (
     // vtable means that there is an OSObject-dervied class that is missing
     // its OSDeclare/OSDefine macros.
     //
-    if (MachoSymbolNameIsPadslot (Name)) {
+    Flags = MachoGetCxxSymbolFlags64 (MachoContext, Symbol);
+    if ((Flags & MACHO_CXX_SYMBOL_PADSLOT) != 0) {
       return FALSE;
     }
 
-    if ((Vtable != NULL) && MachoSymbolNameIsVtable64 (Name)) {
+    if ((Vtable != NULL) && ((Flags & MACHO_CXX_SYMBOL_VTABLE) != 0)) {
       VtablesWalker = Vtables;
 
       while (TRUE) {
@@ -1041,6 +1043,8 @@ InternalPrelinkKext64 (
   UINT32                     SegmentOffset;
   UINT32                     SegmentSize;
 
+  UINT64                     Start;
+
   ASSERT (MachoContext != NULL);
   ASSERT (LinkAddress != 0);
   ASSERT (DependencyData != NULL);
@@ -1057,9 +1061,18 @@ InternalPrelinkKext64 (
     return FALSE;
   }
   //
-  // Strip superfluous Load Commands.
+  // Strip superfluous Load Commands.  This moves the remaining ones, so the
+  // command index and __LINKEDIT reference are retrieved again.
   //
   InternalStripLoadCommands64 (MachHeader);
+  if (!MachoRebaseContext (MachoContext, MachHeader)) {
+    return FALSE;
+  }
+
+  LinkEditSegment = MachoGetSegmentByName64 (MachoContext, "__LINKEDIT");
+  if (LinkEditSegment == NULL) {
+    return FALSE;
+  }
   //
   // Retrieve the symbol tables required for most following operations.
   //
@@ -1077,6 +1090,7 @@ InternalPrelinkKext64 (
   //
   // Solve indirect symbols.
   //
+  Start              = InternalKernelTimingStart ();
   WeakTestValue      = 0;
   NumIndirectSymbols = MachoGetIndirectSymbolTable (
                          MachoContext,
@@ -1125,11 +1139,14 @@ InternalPrelinkKext64 (
       return FALSE;
     }
   }
+
+  InternalKernelTimingStop (KernelTimingSymbolResolve, Start);
   //
   // Create and patch the KEXT's VTables.
   // ScratchMemory is at least as big as __LINKEDIT, so it can store all
   // symbols.
   //
+  Start     = InternalKernelTimingStart ();
   PatchData = (OC_VTABLE_PATCH_ARRAY *)ScratchMemory;
   Result = InternalPrepareVtableCreationNonPrelinked64 (
              MachoContext,
@@ -1219,9 +1236,12 @@ InternalPrelinkKext64 (
   }
 
   Vtables->Link.ForwardLink = NULL;
+
+  InternalKernelTimingStop (KernelTimingVtablePatch, Start);
   //
   // Relocate local and external symbols.
   //
+  Start = InternalKernelTimingStart ();
   for (Index = 0; Index < NumLocalSymbols; ++Index) {
     Result = MachoRelocateSymbol64 (
                MachoContext,
@@ -1323,6 +1343,8 @@ InternalPrelinkKext64 (
     return FALSE;
   }
   NumRelocations += NumRelocations2;
+
+  InternalKernelTimingStop (KernelTimingRelocate, Start);
   //
   // Expose the external Symbol Table if requested.
   //
@@ -1423,8 +1445,9 @@ InternalPrelinkKext64 (
       MachHeader->Flags = MACH_HEADER_FLAG_NO_UNDEFINED_REFERENCES;
       //
       // Reinitialize the Mach-O context to account for the changed __LINKEDIT
-      // segment and file size.
+      // segment and file size.  Built lookup indices refer to the old layout.
       //
+      MachoFreeContext (MachoContext);
       MachoInitializeContext (
         MachoContext,
         MachHeader,
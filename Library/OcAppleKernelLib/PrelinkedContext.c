@@ -142,6 +142,7 @@ PrelinkedContextInit (
   CONST CHAR8  *PrelinkedInfoRootKey;
   UINT32       PrelinkedInfoRootIndex;
   UINT32       PrelinkedInfoRootCount;
+  UINT64       Start;
 
   ZeroMem (Context, sizeof (*Context));
 
@@ -218,7 +219,9 @@ PrelinkedContextInit (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  Start = InternalKernelTimingStart ();
   Context->PrelinkedInfoDocument = XmlDocumentParse (Context->PrelinkedInfo, (UINT32)Context->PrelinkedInfoSection->Size, TRUE);
+  InternalKernelTimingStop (KernelTimingInfoParse, Start);
   if (Context->PrelinkedInfoDocument == NULL) {
     PrelinkedContextFree (Context);
     return EFI_INVALID_PARAMETER;
@@ -279,6 +282,11 @@ PrelinkedContextFree (
     Context->PooledBuffers = NULL;
   }
 
+  //
+  // Symbol cache is one of pooled buffers.
+  //
+  Context->SymbolCache = NULL;
+
   while (!IsListEmpty (&Context->PrelinkedKexts)) {
     Link = GetFirstNode (&Context->PrelinkedKexts);
     Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
@@ -287,6 +295,8 @@ PrelinkedContextFree (
   }
 
   ZeroMem (&Context->PrelinkedKexts, sizeof (Context->PrelinkedKexts));
+
+  MachoFreeContext (&Context->PrelinkedMachContext);
 }
 
 EFI_STATUS
@@ -370,11 +380,127 @@ PrelinkedInjectPrepare (
   return EFI_SUCCESS;
 }
 
+/**
+  Ensure that prelinkedkernel can hold RequiredSize bytes, growing it when
+  allowed. Growth is done by page granularity with some extra room to avoid
+  repeated copies, and without the need to read the kernel again.
+  The buffer is still allocated from pool, as the caller frees Prelinked
+  the same way it was allocated originally.
+
+  @param[in,out] Context       Prelinked context.
+  @param[in]     RequiredSize  Required prelinkedkernel size.
+
+  @return  EFI_SUCCESS on success.
+**/
+STATIC
 EFI_STATUS
-PrelinkedInjectComplete (
+InternalGrowPrelinked (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     UINT32             RequiredSize
+  )
+{
+  UINT8           *NewPrelinked;
+  UINT8           *OldPrelinked;
+  UINT32          NewAllocSize;
+  LIST_ENTRY      *Link;
+  PRELINKED_KEXT  *Kext;
+
+  if (RequiredSize <= Context->PrelinkedAllocSize) {
+    return EFI_SUCCESS;
+  }
+
+  if (!Context->PrelinkedGrowable) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  if (OcOverflowAddU32 (Context->PrelinkedAllocSize, Context->PrelinkedAllocSize / 4, &NewAllocSize)) {
+    NewAllocSize = RequiredSize;
+  }
+
+  NewAllocSize = MAX (NewAllocSize, RequiredSize);
+  if (NewAllocSize > MAX_UINT32 - EFI_PAGE_SIZE) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  NewAllocSize = PRELINKED_ALIGN (NewAllocSize);
+
+  NewPrelinked = AllocatePool (NewAllocSize);
+  if (NewPrelinked == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (NewPrelinked, Context->Prelinked, Context->PrelinkedSize);
+
+  if (!MachoRebaseContext (&Context->PrelinkedMachContext, NewPrelinked)) {
+    //
+    // Cannot happen for a copy of valid image.
+    //
+    ASSERT (FALSE);
+    FreePool (NewPrelinked);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Rebase segment references into the new buffer.
+  //
+  Context->PrelinkedInfoSegment = (MACH_SEGMENT_COMMAND_64 *) (
+    NewPrelinked + ((UINT8 *) Context->PrelinkedInfoSegment - Context->Prelinked)
+    );
+  Context->PrelinkedInfoSection = (MACH_SECTION_64 *) (
+    NewPrelinked + ((UINT8 *) Context->PrelinkedInfoSection - Context->Prelinked)
+    );
+  Context->PrelinkedTextSegment = (MACH_SEGMENT_COMMAND_64 *) (
+    NewPrelinked + ((UINT8 *) Context->PrelinkedTextSegment - Context->Prelinked)
+    );
+  Context->PrelinkedTextSection = (MACH_SECTION_64 *) (
+    NewPrelinked + ((UINT8 *) Context->PrelinkedTextSection - Context->Prelinked)
+    );
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Prelinked grown from %u to %u bytes for %u bytes\n",
+    Context->PrelinkedAllocSize,
+    NewAllocSize,
+    RequiredSize
+    ));
+
+  OldPrelinked                = Context->Prelinked;
+  Context->Prelinked          = NewPrelinked;
+  Context->PrelinkedAllocSize = NewAllocSize;
+
+  //
+  // Patcher contexts copied from cached kexts still reference the old buffer.
+  //
+  ++Context->PrelinkedGeneration;
+
+  //
+  // Cached kexts move along with the buffer, so that their patcher contexts
+  // stay valid.
+  //
+  for (Link = GetFirstNode (&Context->PrelinkedKexts);
+    !IsNull (&Context->PrelinkedKexts, Link);
+    Link = GetNextNode (&Context->PrelinkedKexts, Link)) {
+    Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
+    if (!InternalRebasePrelinkedKext (Kext, OldPrelinked, Context)) {
+      //
+      // Cannot happen for a copy of valid image, stale generation rejects it.
+      //
+      ASSERT (FALSE);
+    }
+  }
+
+  FreePool (OldPrelinked);
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+InternalInjectComplete (
   IN OUT PRELINKED_CONTEXT  *Context
   )
 {
+  EFI_STATUS  Status;
   CHAR8       *ExportedInfo;
   UINT32      ExportedInfoSize;
   UINT32      NewSize;
@@ -389,12 +515,17 @@ PrelinkedInjectComplete (
   //
   ExportedInfoSize++;
 
-  if (OcOverflowAddU32 (Context->PrelinkedSize, PRELINKED_ALIGN (ExportedInfoSize), &NewSize)
-    || NewSize > Context->PrelinkedAllocSize) {
+  if (OcOverflowAddU32 (Context->PrelinkedSize, PRELINKED_ALIGN (ExportedInfoSize), &NewSize)) {
     FreePool (ExportedInfo);
     return EFI_BUFFER_TOO_SMALL;
   }
 
+  Status = InternalGrowPrelinked (Context, NewSize);
+  if (EFI_ERROR (Status)) {
+    FreePool (ExportedInfo);
+    return Status;
+  }
+
   Context->PrelinkedInfoSegment->VirtualAddress = Context->PrelinkedLastAddress;
   Context->PrelinkedInfoSegment->Size           = ExportedInfoSize;
   Context->PrelinkedInfoSegment->FileOffset     = Context->PrelinkedSize;
@@ -422,6 +553,21 @@ PrelinkedInjectComplete (
   return EFI_SUCCESS;
 }
 
+EFI_STATUS
+PrelinkedInjectComplete (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      Start;
+
+  Start  = InternalKernelTimingStart ();
+  Status = InternalInjectComplete (Context);
+  InternalKernelTimingStop (KernelTimingInjectComplete, Start);
+
+  return Status;
+}
+
 EFI_STATUS
 PrelinkedReserveKextSize (
   IN OUT UINT32       *ReservedSize,
@@ -445,7 +591,38 @@ PrelinkedReserveKextSize (
 }
 
 EFI_STATUS
-PrelinkedInjectKext (
+PrelinkedReserveKextsSize (
+     OUT UINT32                        *ReservedSize,
+  IN     CONST PRELINKED_KEXT_REQUEST  *Requests,
+  IN     UINT32                        NumRequests
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+
+  //
+  // Prelinked info is dropped and exported again at the end, so only its
+  // growth needs space. Reserve one more page for its alignment.
+  //
+  *ReservedSize = EFI_PAGE_SIZE;
+
+  for (Index = 0; Index < NumRequests; ++Index) {
+    Status = PrelinkedReserveKextSize (
+      ReservedSize,
+      Requests[Index].InfoPlistSize,
+      Requests[Index].Executable != NULL ? Requests[Index].ExecutableSize : 0
+      );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+InternalInjectKext (
   IN OUT PRELINKED_CONTEXT  *Context,
   IN     CONST CHAR8        *BundlePath,
   IN     CONST CHAR8        *InfoPlist,
@@ -476,11 +653,15 @@ PrelinkedInjectKext (
   //
   if (Executable != NULL) {
     AlignedExecutableSize = PRELINKED_ALIGN (ExecutableSize);
-    if (OcOverflowAddU32 (Context->PrelinkedSize, AlignedExecutableSize, &NewPrelinkedSize)
-      || NewPrelinkedSize > Context->PrelinkedAllocSize) {
+    if (OcOverflowAddU32 (Context->PrelinkedSize, AlignedExecutableSize, &NewPrelinkedSize)) {
       return EFI_BUFFER_TOO_SMALL;
     }
 
+    Status = InternalGrowPrelinked (Context, NewPrelinkedSize);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
     CopyMem (
       &Context->Prelinked[Context->PrelinkedSize],
       Executable,
@@ -498,6 +679,7 @@ PrelinkedInjectKext (
 
     KmodAddress = PrelinkedFindKmodAddress (&ExecutableContext, Context->PrelinkedLastLoadAddress, ExecutableSize);
     if (KmodAddress == 0) {
+      MachoFreeContext (&ExecutableContext);
       return EFI_INVALID_PARAMETER;
     }
   }
@@ -507,17 +689,26 @@ PrelinkedInjectKext (
   //
   TmpInfoPlist = AllocateCopyPool (InfoPlistSize, InfoPlist);
   if (TmpInfoPlist == NULL) {
+    if (Executable != NULL) {
+      MachoFreeContext (&ExecutableContext);
+    }
     return EFI_OUT_OF_RESOURCES;
   }
 
   InfoPlistDocument = XmlDocumentParse (TmpInfoPlist, InfoPlistSize, FALSE);
   if (InfoPlistDocument == NULL) {
+    if (Executable != NULL) {
+      MachoFreeContext (&ExecutableContext);
+    }
     FreePool (TmpInfoPlist);
     return EFI_INVALID_PARAMETER;
   }
 
   InfoPlistRoot = PlistNodeCast (PlistDocumentRoot (InfoPlistDocument), PLIST_NODE_TYPE_DICT);
   if (InfoPlistRoot == NULL) {
+    if (Executable != NULL) {
+      MachoFreeContext (&ExecutableContext);
+    }
     XmlDocumentFree (InfoPlistDocument);
     FreePool (TmpInfoPlist);
     return EFI_INVALID_PARAMETER;
@@ -544,6 +735,9 @@ PrelinkedInjectKext (
   }
 
   if (Failed) {
+    if (Executable != NULL) {
+      MachoFreeContext (&ExecutableContext);
+    }
     XmlDocumentFree (InfoPlistDocument);
     FreePool (TmpInfoPlist);
     return EFI_OUT_OF_RESOURCES;
@@ -557,6 +751,8 @@ PrelinkedInjectKext (
       Context->PrelinkedLastAddress
       );
 
+    MachoFreeContext (&ExecutableContext);
+
     if (EFI_ERROR (Status)) {
       XmlDocumentFree (InfoPlistDocument);
       FreePool (TmpInfoPlist);
@@ -600,3 +796,255 @@ PrelinkedInjectKext (
 
   return EFI_SUCCESS;
 }
+
+EFI_STATUS
+PrelinkedInjectKext (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     CONST CHAR8        *BundlePath,
+  IN     CONST CHAR8        *InfoPlist,
+  IN     UINT32             InfoPlistSize,
+  IN     CONST CHAR8        *ExecutablePath OPTIONAL,
+  IN     CONST UINT8        *Executable OPTIONAL,
+  IN     UINT32             ExecutableSize OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      Start;
+
+  Start  = InternalKernelTimingStart ();
+  Status = InternalInjectKext (
+    Context,
+    BundlePath,
+    InfoPlist,
+    InfoPlistSize,
+    ExecutablePath,
+    Executable,
+    ExecutableSize
+    );
+  InternalKernelTimingStop (KernelTimingInjectKext, Start);
+
+  return Status;
+}
+
+STATIC
+VOID
+InternalParseKextRequest (
+  IN     PRELINKED_KEXT_REQUEST       *Request,
+  IN OUT PRELINKED_KEXT_REQUEST_NODE  *Node
+  )
+{
+  XML_NODE     *InfoPlistRoot;
+  UINT32       FieldIndex;
+  UINT32       FieldCount;
+  CONST CHAR8  *KextPlistKey;
+  XML_NODE     *KextPlistValue;
+
+  Node->InfoPlist = AllocateCopyPool (Request->InfoPlistSize, Request->InfoPlist);
+  if (Node->InfoPlist == NULL) {
+    return;
+  }
+
+  Node->InfoPlistDocument = XmlDocumentParse (Node->InfoPlist, Request->InfoPlistSize, FALSE);
+  if (Node->InfoPlistDocument == NULL) {
+    return;
+  }
+
+  InfoPlistRoot = PlistNodeCast (PlistDocumentRoot (Node->InfoPlistDocument), PLIST_NODE_TYPE_DICT);
+  if (InfoPlistRoot == NULL) {
+    return;
+  }
+
+  FieldCount = PlistDictChildren (InfoPlistRoot);
+  for (FieldIndex = 0; FieldIndex < FieldCount; ++FieldIndex) {
+    KextPlistKey = PlistKeyValue (PlistDictChild (InfoPlistRoot, FieldIndex, &KextPlistValue));
+    if (KextPlistKey == NULL) {
+      continue;
+    }
+
+    if (Node->Identifier == NULL && AsciiStrCmp (KextPlistKey, INFO_BUNDLE_IDENTIFIER_KEY) == 0) {
+      if (PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_STRING) != NULL) {
+        Node->Identifier = XmlNodeContent (KextPlistValue);
+      }
+    } else if (Node->BundleLibraries == NULL && AsciiStrCmp (KextPlistKey, INFO_BUNDLE_LIBRARIES_KEY) == 0) {
+      Node->BundleLibraries = PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_DICT);
+    }
+
+    if (Node->Identifier != NULL && Node->BundleLibraries != NULL) {
+      break;
+    }
+  }
+}
+
+STATIC
+EFI_STATUS
+InternalGetKextRequestDependencyStatus (
+  IN PRELINKED_KEXT_REQUEST       *Requests,
+  IN PRELINKED_KEXT_REQUEST_NODE  *Nodes,
+  IN UINT32                       NumRequests,
+  IN UINT32                       Index
+  )
+{
+  UINT32       FieldIndex;
+  UINT32       FieldCount;
+  UINT32       DependencyIndex;
+  CONST CHAR8  *DependencyId;
+
+  if (Nodes[Index].BundleLibraries == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  FieldCount = PlistDictChildren (Nodes[Index].BundleLibraries);
+  for (FieldIndex = 0; FieldIndex < FieldCount; ++FieldIndex) {
+    DependencyId = PlistKeyValue (PlistDictChild (Nodes[Index].BundleLibraries, FieldIndex, NULL));
+    if (DependencyId == NULL) {
+      continue;
+    }
+
+    for (DependencyIndex = 0; DependencyIndex < NumRequests; ++DependencyIndex) {
+      if (DependencyIndex == Index
+        || Nodes[DependencyIndex].Identifier == NULL
+        || AsciiStrCmp (DependencyId, Nodes[DependencyIndex].Identifier) != 0) {
+        continue;
+      }
+
+      //
+      // Dependency from this batch must be injected first.
+      //
+      if (!Nodes[DependencyIndex].Processed) {
+        return EFI_NOT_READY;
+      }
+
+      if (EFI_ERROR (Requests[DependencyIndex].Status)) {
+        return EFI_NOT_FOUND;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+PrelinkedInjectKexts (
+  IN OUT PRELINKED_CONTEXT       *Context,
+  IN OUT PRELINKED_KEXT_REQUEST  *Requests,
+  IN     UINT32                  NumRequests
+  )
+{
+  EFI_STATUS                   Status;
+  EFI_STATUS                   Result;
+  PRELINKED_KEXT_REQUEST_NODE  *Nodes;
+  UINT32                       Index;
+  UINT32                       Builds;
+  UINT32                       Reuses;
+  UINT64                       Start;
+  BOOLEAN                      OneInjected;
+  BOOLEAN                      OneNotReady;
+
+  if (NumRequests == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Nodes = AllocateZeroPool (NumRequests * sizeof (*Nodes));
+  if (Nodes == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < NumRequests; ++Index) {
+    Requests[Index].Status = EFI_NOT_READY;
+    InternalParseKextRequest (&Requests[Index], &Nodes[Index]);
+  }
+
+  Builds = Context->LinkedSymbolTableBuilds;
+  Reuses = Context->LinkedSymbolTableReuses;
+
+  //
+  // Inject kexts with already processed dependencies on every pass,
+  // which results in topological order of the dependency graph.
+  //
+  do {
+    OneInjected = FALSE;
+    OneNotReady = FALSE;
+
+    Start  = InternalKernelTimingStart ();
+    Status = InternalPrepareDependencies (Context, Nodes, NumRequests);
+    InternalKernelTimingStop (KernelTimingDependencies, Start);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Failed to prepare batch dependencies - %r\n", Status));
+    }
+
+    for (Index = 0; Index < NumRequests; ++Index) {
+      if (Nodes[Index].Processed) {
+        continue;
+      }
+
+      Status = InternalGetKextRequestDependencyStatus (Requests, Nodes, NumRequests, Index);
+      if (Status == EFI_NOT_READY) {
+        OneNotReady = TRUE;
+        continue;
+      }
+
+      if (!EFI_ERROR (Status)) {
+        Status = PrelinkedInjectKext (
+          Context,
+          Requests[Index].BundlePath,
+          Requests[Index].InfoPlist,
+          Requests[Index].InfoPlistSize,
+          Requests[Index].ExecutablePath,
+          Requests[Index].Executable,
+          Requests[Index].ExecutableSize
+          );
+      }
+
+      DEBUG ((
+        EFI_ERROR (Status) ? DEBUG_WARN : DEBUG_VERBOSE,
+        "Batch injection of %a - %r\n",
+        Requests[Index].BundlePath,
+        Status
+        ));
+
+      Requests[Index].Status = Status;
+      Nodes[Index].Processed = TRUE;
+      OneInjected            = TRUE;
+    }
+    //
+    // Continue while the loop makes progress and there are still kexts to
+    // inject.
+    //
+  } while (OneInjected && OneNotReady);
+
+  Result = EFI_SUCCESS;
+
+  for (Index = 0; Index < NumRequests; ++Index) {
+    //
+    // Remaining kexts form dependency cycles.
+    //
+    if (!Nodes[Index].Processed) {
+      DEBUG ((DEBUG_WARN, "Dependency cycle in %a\n", Requests[Index].BundlePath));
+      Requests[Index].Status = EFI_INVALID_PARAMETER;
+    }
+
+    if (EFI_ERROR (Requests[Index].Status) && !EFI_ERROR (Result)) {
+      Result = Requests[Index].Status;
+    }
+
+    if (Nodes[Index].InfoPlistDocument != NULL) {
+      XmlDocumentFree (Nodes[Index].InfoPlistDocument);
+    }
+
+    if (Nodes[Index].InfoPlist != NULL) {
+      FreePool (Nodes[Index].InfoPlist);
+    }
+  }
+
+  FreePool (Nodes);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Injected %u kexts with %u symbol table builds, %u builds saved\n",
+    NumRequests,
+    Context->LinkedSymbolTableBuilds - Builds,
+    Context->LinkedSymbolTableReuses - Reuses
+    ));
+
+  return Result;
+}
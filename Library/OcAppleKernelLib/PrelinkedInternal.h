@@ -22,11 +22,6 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/OcMachoLib.h>
 #include <Library/OcXmlLib.h>
 
-//
-// Some sane maximum value.
-//
-#define MAX_KEXT_DEPEDENCIES 12
-
 typedef struct PRELINKED_KEXT_ PRELINKED_KEXT;
 
 typedef struct {
@@ -59,10 +54,24 @@ struct PRELINKED_KEXT_ {
   //
   CONST CHAR8              *CompatibleVersion;
   //
-  // Scanned dependencies (PRELINKED_KEXT) from BundleLibraries.
-  // Not resolved by default. See InternalScanPrelinkedKext for fields below.
+  // Scanned dependencies (PRELINKED_KEXT) from BundleLibraries, allocated
+  // from pool. Not resolved by default. See InternalScanPrelinkedKext for
+  // fields below.
+  //
+  PRELINKED_KEXT           **Dependencies;
+  //
+  // Number of scanned dependencies.
+  //
+  UINT32                   NumberOfDependencies;
   //
-  PRELINKED_KEXT           *Dependencies[MAX_KEXT_DEPEDENCIES];
+  // Dependency resolution state, used to detect dependency cycles.
+  //
+  BOOLEAN                  DependenciesResolving;
+  BOOLEAN                  DependenciesResolved;
+  //
+  // Linked symbol tables of all dependencies are built.
+  //
+  BOOLEAN                  DependenciesScanned;
   //
   // Linkedit segment reference.
   //
@@ -91,6 +100,11 @@ struct PRELINKED_KEXT_ {
   // The number of C++ symbols at the end of LinkedSymbolTable.
   //
   UINT32                   LinkedNumberOfCxxSymbols;
+  //
+  // LinkedSymbolTable was built ahead by InternalPrepareDependencies and is
+  // not used yet, so its first use is no reuse.
+  //
+  BOOLEAN                  LinkedSymbolTablePrebuilt;
 };
 
 //
@@ -98,6 +112,42 @@ struct PRELINKED_KEXT_ {
 //
 #define PRELINKED_KEXT_SIGNATURE  SIGNATURE_32 ('P', 'K', 'X', 'T')
 
+//
+// Exported symbol cache signature and format version.
+//
+#define PRELINKED_SYMBOL_CACHE_SIGNATURE  SIGNATURE_32 ('O', 'C', 'S', 'C')
+#define PRELINKED_SYMBOL_CACHE_VERSION    3
+
+//
+// Exported symbol cache header, followed by NumKexts kext entries sorted by
+// identifier, symbol arrays, and identifier strings.  All offsets are
+// relative to the header.
+//
+typedef struct {
+  UINT32 Signature;
+  UINT32 Version;
+  UINT32 Size;
+  UINT32 NumKexts;
+  UINT8  KernelUuid[16];
+} PRELINKED_SYMBOL_CACHE_HEADER;
+
+typedef struct {
+  UINT32 IdentifierOffset;    ///< CFBundleIdentifier string.
+  UINT32 SymbolsOffset;       ///< PRELINKED_SYMBOL_CACHE_SYMBOL array.
+  UINT32 NumberOfSymbols;     ///< Must match kext symbol table.
+  UINT32 NumberOfCxxSymbols;  ///< C++ symbols at the end of the array.
+  UINT32 StringTableSize;     ///< Must match kext string table.
+  UINT32 Reserved;
+  UINT64 LoadAddress;         ///< Must match kext load address.
+  UINT8  KextUuid[16];        ///< Must match kext LC_UUID.
+} PRELINKED_SYMBOL_CACHE_KEXT;
+
+typedef struct {
+  UINT64 Value;
+  UINT32 StringIndex;
+  UINT32 Reserved;
+} PRELINKED_SYMBOL_CACHE_SYMBOL;
+
 /**
   Gets the next element in a linked list of PRELINKED_KEXT.
 
@@ -111,6 +161,50 @@ struct PRELINKED_KEXT_ {
     PRELINKED_KEXT_SIGNATURE                \
     ))
 
+//
+// Dependency graph node of PRELINKED_KEXT_REQUEST used by PrelinkedInjectKexts.
+//
+typedef struct {
+  //
+  // Info.plist copy for XML_DOCUMENT.
+  //
+  CHAR8                    *InfoPlist;
+  //
+  // Parsed instance of InfoPlist.
+  //
+  XML_DOCUMENT             *InfoPlistDocument;
+  //
+  // Kext bundle identifier, may be NULL for invalid Info.plist.
+  //
+  CONST CHAR8              *Identifier;
+  //
+  // Kext bundle libraries (OSBundleLibraries), optional.
+  //
+  XML_NODE                 *BundleLibraries;
+  //
+  // Request was already processed, see PRELINKED_KEXT_REQUEST Status.
+  //
+  BOOLEAN                  Processed;
+} PRELINKED_KEXT_REQUEST_NODE;
+
+//
+// Linked symbol table builds processed by PRELINKED_PARALLEL_FOR.
+//
+typedef struct {
+  //
+  // Prelinked context, only read by the workers.
+  //
+  PRELINKED_CONTEXT        *Context;
+  //
+  // Kexts to build linked symbol tables for.
+  //
+  PRELINKED_KEXT           **Kexts;
+  //
+  // Build status for every kext.
+  //
+  EFI_STATUS               *Statuses;
+} PRELINKED_SYMBOL_TABLE_WORK;
+
 /**
   Creates new PRELINKED_KEXT from OC_MACHO_CONTEXT.
 **/
@@ -128,6 +222,17 @@ InternalFreePrelinkedKext (
   IN PRELINKED_KEXT  *Kext
   );
 
+/**
+  Moves cached PRELINKED_KEXT to grown PRELINKED_CONTEXT buffer.
+  OldPrelinked must still be allocated.  Lookup indices are kept.
+**/
+BOOLEAN
+InternalRebasePrelinkedKext (
+  IN OUT PRELINKED_KEXT     *Kext,
+  IN     CONST UINT8        *OldPrelinked,
+  IN     PRELINKED_CONTEXT  *Prelinked
+  );
+
 /**
   Gets cached PRELINKED_KEXT from PRELINKED_CONTEXT.
 **/
@@ -146,6 +251,26 @@ InternalScanPrelinkedKext (
   IN OUT PRELINKED_CONTEXT  *Context
   );
 
+/**
+  Resolve dependencies of pending batch requests and build linked symbol
+  tables of all resolved dependencies, concurrently when supported.
+**/
+EFI_STATUS
+InternalPrepareDependencies (
+  IN OUT PRELINKED_CONTEXT            *Context,
+  IN     PRELINKED_KEXT_REQUEST_NODE  *Nodes,
+  IN     UINT32                       NumNodes
+  );
+
+/**
+  Restore linked symbol table of PRELINKED_KEXT from attached symbol cache.
+**/
+EFI_STATUS
+InternalRestoreLinkedSymbolTable (
+  IN     PRELINKED_CONTEXT  *Context,
+  IN OUT PRELINKED_KEXT     *Kext
+  );
+
 
 #define KXLD_WEAK_TEST_SYMBOL  "_gOSKextUnresolved"
 
@@ -502,4 +627,39 @@ InternalPrelinkKext64 (
   OUT    VOID                     *ScratchMemory
   );
 
+/**
+  Start measuring kernel preparation phase.
+
+  @return  Phase start timestamp for InternalKernelTimingStop.
+**/
+UINT64
+InternalKernelTimingStart (
+  VOID
+  );
+
+/**
+  Account kernel preparation phase run started at Start.
+  Must not be called concurrently.
+
+  @param[in] Phase  Measured phase.
+  @param[in] Start  Timestamp returned by InternalKernelTimingStart.
+**/
+VOID
+InternalKernelTimingStop (
+  IN KERNEL_TIMING_PHASE  Phase,
+  IN UINT64               Start
+  );
+
+/**
+  Get ticks accounted to kernel preparation phase so far.
+
+  @param[in] Phase  Measured phase.
+
+  @return  Total ticks of Phase.
+**/
+UINT64
+InternalKernelTimingGetTicks (
+  IN KERNEL_TIMING_PHASE  Phase
+  );
+
 #endif // PRELINKED_INTERNAL_H
@@ -158,6 +158,11 @@ InternalCreatePrelinkedKext (
   NewKext->Context.VirtualBase  = VirtualBase;
   NewKext->Context.VirtualKmod  = VirtualKmod;
 
+  if (Prelinked != NULL) {
+    NewKext->Context.Prelinked           = Prelinked;
+    NewKext->Context.PrelinkedGeneration = Prelinked->PrelinkedGeneration;
+  }
+
   return NewKext;
 }
 
@@ -198,18 +203,116 @@ InternalScanCurrentPrelinkedKext (
   return EFI_SUCCESS;
 }
 
+/**
+  Builds linked symbol table of PRELINKED_KEXT. Only Kext memory is modified,
+  so different kexts may be processed concurrently.
+
+  @param[in,out] Kext     Kext to build linked symbol table for.
+  @param[in]     Context  Prelinked context.
+
+  @return  EFI_ALREADY_STARTED when the table is already built.
+**/
 STATIC
 EFI_STATUS
-InternalScanBuildLinkedSymbolTable (
-  IN OUT PRELINKED_KEXT  *Kext
+InternalBuildLinkedSymbolTable (
+  IN OUT PRELINKED_KEXT     *Kext,
+  IN     PRELINKED_CONTEXT  *Context
   )
 {
+  EFI_STATUS             Status;
+  PRELINKED_KEXT_SYMBOL  *SymbolTable;
+  PRELINKED_KEXT_SYMBOL  *WalkerBottom;
+  PRELINKED_KEXT_SYMBOL  *WalkerTop;
+  CONST MACH_NLIST_64    *Symbol;
+  UINT32                 Index;
+  UINT32                 NumCxxSymbols;
+
   if (Kext->LinkedSymbolTable != NULL) {
     return EFI_ALREADY_STARTED;
   }
 
-  //TODO: port InternalFillSymbolTable64.
-  return EFI_UNSUPPORTED;
+  Status = InternalScanCurrentPrelinkedKext (Kext);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Symbol cache for this kernel spares classifying every symbol.
+  //
+  Status = InternalRestoreLinkedSymbolTable (Context, Kext);
+  if (Status != EFI_NOT_FOUND) {
+    return Status;
+  }
+
+  SymbolTable = AllocatePool (Kext->NumberOfSymbols * sizeof (*SymbolTable));
+  if (SymbolTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Matches InternalFillSymbolTable64, C++ symbols are put at the top.
+  //
+  WalkerBottom  = &SymbolTable[0];
+  WalkerTop     = &SymbolTable[Kext->NumberOfSymbols - 1];
+  NumCxxSymbols = 0;
+
+  for (Index = 0; Index < Kext->NumberOfSymbols; ++Index) {
+    Symbol = &Kext->SymbolTable[Index];
+    if ((MachoGetCxxSymbolFlags64 (&Kext->Context.MachContext, Symbol)
+      & MACHO_CXX_SYMBOL_CXX) == 0) {
+      WalkerBottom->StringIndex = Symbol->UnifiedName.StringIndex;
+      WalkerBottom->Value       = Symbol->Value;
+      ++WalkerBottom;
+    } else {
+      WalkerTop->StringIndex = Symbol->UnifiedName.StringIndex;
+      WalkerTop->Value       = Symbol->Value;
+      --WalkerTop;
+
+      ++NumCxxSymbols;
+    }
+  }
+
+  Kext->LinkedSymbolTable        = SymbolTable;
+  Kext->LinkedNumberOfSymbols    = Kext->NumberOfSymbols;
+  Kext->LinkedNumberOfCxxSymbols = NumCxxSymbols;
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+InternalScanBuildLinkedSymbolTable (
+  IN OUT PRELINKED_KEXT     *Kext,
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = InternalBuildLinkedSymbolTable (Kext, Context);
+  if (Status == EFI_ALREADY_STARTED) {
+    if (Kext->LinkedSymbolTablePrebuilt) {
+      Kext->LinkedSymbolTablePrebuilt = FALSE;
+    } else {
+      ++Context->LinkedSymbolTableReuses;
+    }
+  } else if (!EFI_ERROR (Status)) {
+    ++Context->LinkedSymbolTableBuilds;
+  }
+
+  return Status;
+}
+
+STATIC
+VOID
+InternalBuildLinkedSymbolTableWorker (
+  IN VOID    *Context,
+  IN UINT32  Index
+  )
+{
+  PRELINKED_SYMBOL_TABLE_WORK  *Work;
+
+  Work = (PRELINKED_SYMBOL_TABLE_WORK *) Context;
+  Work->Statuses[Index] = InternalBuildLinkedSymbolTable (Work->Kexts[Index], Work->Context);
 }
 
 PRELINKED_KEXT *
@@ -239,9 +342,43 @@ InternalFreePrelinkedKext (
     Kext->LinkedSymbolTable = NULL;
   }
 
+  if (Kext->Dependencies != NULL) {
+    FreePool (Kext->Dependencies);
+    Kext->Dependencies = NULL;
+  }
+
+  MachoFreeContext (&Kext->Context.MachContext);
+
   FreePool (Kext);
 }
 
+BOOLEAN
+InternalRebasePrelinkedKext (
+  IN OUT PRELINKED_KEXT     *Kext,
+  IN     CONST UINT8        *OldPrelinked,
+  IN     PRELINKED_CONTEXT  *Prelinked
+  )
+{
+  UINTN  Offset;
+
+  Offset = (UINTN) ((UINT8 *) MachoGetMachHeader64 (&Kext->Context.MachContext) - OldPrelinked);
+  if (!MachoRebaseContext (&Kext->Context.MachContext, &Prelinked->Prelinked[Offset])) {
+    return FALSE;
+  }
+
+  //
+  // Symbol table references are scanned again on demand.
+  //
+  Kext->LinkEditSegment = NULL;
+  Kext->StringTable     = NULL;
+  Kext->SymbolTable     = NULL;
+  Kext->NumberOfSymbols = 0;
+
+  Kext->Context.PrelinkedGeneration = Prelinked->PrelinkedGeneration;
+
+  return TRUE;
+}
+
 PRELINKED_KEXT *
 InternalCachedPrelinkedKext (
   IN OUT PRELINKED_CONTEXT  *Prelinked,
@@ -293,8 +430,18 @@ InternalCachedPrelinkedKext (
   return NewKext;
 }
 
+/**
+  Resolves dependencies of PRELINKED_KEXT recursively without building
+  their linked symbol tables.
+
+  @param[in,out] Kext     Kext to resolve dependencies for.
+  @param[in,out] Context  Prelinked context.
+
+  @return  EFI_ALREADY_STARTED when dependencies are already resolved.
+**/
+STATIC
 EFI_STATUS
-InternalScanPrelinkedKext (
+InternalResolvePrelinkedKext (
   IN OUT PRELINKED_KEXT     *Kext,
   IN OUT PRELINKED_CONTEXT  *Context
   )
@@ -302,15 +449,22 @@ InternalScanPrelinkedKext (
   EFI_STATUS      Status;
   UINT32          FieldCount;
   UINT32          FieldIndex;
-  UINT32          DependencyIndex;
   CONST CHAR8     *DependencyId;
   PRELINKED_KEXT  *DependencyKext;
 
-  if (Kext->Dependencies[0] != NULL) {
+  if (Kext->DependenciesResolved) {
     return EFI_ALREADY_STARTED;
   }
 
+  //
+  // Reaching a kext that is still being resolved means a dependency cycle.
+  //
+  if (Kext->DependenciesResolving) {
+    return EFI_INVALID_PARAMETER;
+  }
+
   if (Kext->BundleLibraries == NULL) {
+    Kext->DependenciesResolved = TRUE;
     return EFI_SUCCESS;
   }
 
@@ -319,8 +473,26 @@ InternalScanPrelinkedKext (
     return Status;
   }
 
-  DependencyIndex = 0;
+  //
+  // Drop the results of an earlier failed resolution.
+  //
+  if (Kext->Dependencies != NULL) {
+    FreePool (Kext->Dependencies);
+    Kext->Dependencies = NULL;
+  }
+
+  Kext->NumberOfDependencies = 0;
+
   FieldCount = PlistDictChildren (Kext->BundleLibraries);
+  if (FieldCount > 0) {
+    Kext->Dependencies = AllocatePool (FieldCount * sizeof (*Kext->Dependencies));
+    if (Kext->Dependencies == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  Kext->DependenciesResolving = TRUE;
+
   for (FieldIndex = 0; FieldIndex < FieldCount; ++FieldIndex) {
     DependencyId = PlistKeyValue (PlistDictChild (Kext->BundleLibraries, FieldIndex, NULL));
     if (DependencyId == NULL) {
@@ -329,26 +501,164 @@ InternalScanPrelinkedKext (
 
     DependencyKext = InternalCachedPrelinkedKext (Context, DependencyId);
     if (DependencyKext == NULL) {
+      Kext->DependenciesResolving = FALSE;
       return EFI_NOT_FOUND;
     }
 
-    if (DependencyIndex >= ARRAY_SIZE (Kext->Dependencies)) {
-      return EFI_OUT_OF_RESOURCES;
+    Status = InternalResolvePrelinkedKext (DependencyKext, Context);
+    if (EFI_ERROR (Status) && Status != EFI_ALREADY_STARTED) {
+      Kext->DependenciesResolving = FALSE;
+      return Status;
     }
 
-    Status = InternalScanPrelinkedKext (DependencyKext, Context);
+    Kext->Dependencies[Kext->NumberOfDependencies] = DependencyKext;
+    ++Kext->NumberOfDependencies;
+  }
+
+  Kext->DependenciesResolving = FALSE;
+  Kext->DependenciesResolved  = TRUE;
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+InternalScanPrelinkedKext (
+  IN OUT PRELINKED_KEXT     *Kext,
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+
+  if (Kext->DependenciesScanned) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  Status = InternalResolvePrelinkedKext (Kext, Context);
+  if (EFI_ERROR (Status) && Status != EFI_ALREADY_STARTED) {
+    return Status;
+  }
+
+  //
+  // Resolved dependency graph has no cycles.
+  //
+  for (Index = 0; Index < Kext->NumberOfDependencies; ++Index) {
+    Status = InternalScanPrelinkedKext (Kext->Dependencies[Index], Context);
     if (EFI_ERROR (Status) && Status != EFI_ALREADY_STARTED) {
       return Status;
     }
 
-    Status = InternalScanBuildLinkedSymbolTable (DependencyKext);
+    Status = InternalScanBuildLinkedSymbolTable (Kext->Dependencies[Index], Context);
     if (EFI_ERROR (Status) && Status != EFI_ALREADY_STARTED) {
       return Status;
     }
+  }
+
+  Kext->DependenciesScanned = TRUE;
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+InternalPrepareDependencies (
+  IN OUT PRELINKED_CONTEXT            *Context,
+  IN     PRELINKED_KEXT_REQUEST_NODE  *Nodes,
+  IN     UINT32                       NumNodes
+  )
+{
+  PRELINKED_SYMBOL_TABLE_WORK  Work;
+  PRELINKED_KEXT               *Kext;
+  LIST_ENTRY                   *Link;
+  UINT32                       NumKexts;
+  UINT32                       Index;
+  UINT32                       FieldIndex;
+  UINT32                       FieldCount;
+  CONST CHAR8                  *DependencyId;
+
+  //
+  // Resolving modifies PRELINKED_CONTEXT and is done serially. Dependencies
+  // injected within the same batch are not found until they are injected.
+  //
+  for (Index = 0; Index < NumNodes; ++Index) {
+    if (Nodes[Index].Processed || Nodes[Index].BundleLibraries == NULL) {
+      continue;
+    }
+
+    FieldCount = PlistDictChildren (Nodes[Index].BundleLibraries);
+    for (FieldIndex = 0; FieldIndex < FieldCount; ++FieldIndex) {
+      DependencyId = PlistKeyValue (PlistDictChild (Nodes[Index].BundleLibraries, FieldIndex, NULL));
+      if (DependencyId == NULL) {
+        continue;
+      }
 
-    Kext->Dependencies[DependencyIndex] = DependencyKext;
-    ++DependencyIndex;
+      Kext = InternalCachedPrelinkedKext (Context, DependencyId);
+      if (Kext != NULL) {
+        //
+        // Errors are reported when linking the dependent kext.
+        //
+        InternalResolvePrelinkedKext (Kext, Context);
+      }
+    }
   }
 
+  NumKexts = 0;
+  for (Link = GetFirstNode (&Context->PrelinkedKexts);
+    !IsNull (&Context->PrelinkedKexts, Link);
+    Link = GetNextNode (&Context->PrelinkedKexts, Link)) {
+    Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
+    if (Kext->DependenciesResolved && Kext->LinkedSymbolTable == NULL) {
+      ++NumKexts;
+    }
+  }
+
+  if (NumKexts == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Work.Context  = Context;
+  Work.Kexts    = AllocatePool (NumKexts * (sizeof (*Work.Kexts) + sizeof (*Work.Statuses)));
+  if (Work.Kexts == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Work.Statuses = (EFI_STATUS *) &Work.Kexts[NumKexts];
+
+  Index = 0;
+  for (Link = GetFirstNode (&Context->PrelinkedKexts);
+    !IsNull (&Context->PrelinkedKexts, Link);
+    Link = GetNextNode (&Context->PrelinkedKexts, Link)) {
+    Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
+    if (Kext->DependenciesResolved && Kext->LinkedSymbolTable == NULL) {
+      Work.Kexts[Index] = Kext;
+      ++Index;
+    }
+  }
+
+  //
+  // Building linked symbol tables only touches memory of the kext itself,
+  // so every dependency may be built independently.
+  //
+  if (Context->ParallelFor != NULL) {
+    Context->ParallelFor (
+      Context->ParallelForContext,
+      NumKexts,
+      InternalBuildLinkedSymbolTableWorker,
+      &Work
+      );
+  } else {
+    for (Index = 0; Index < NumKexts; ++Index) {
+      InternalBuildLinkedSymbolTableWorker (&Work, Index);
+    }
+  }
+
+  for (Index = 0; Index < NumKexts; ++Index) {
+    if (!EFI_ERROR (Work.Statuses[Index])) {
+      Work.Kexts[Index]->LinkedSymbolTablePrebuilt = TRUE;
+      ++Context->LinkedSymbolTableBuilds;
+    }
+  }
+
+  FreePool (Work.Kexts);
+
   return EFI_SUCCESS;
 }
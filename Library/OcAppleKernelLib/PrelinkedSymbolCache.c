@@ -0,0 +1,479 @@
+/** @file
+  Exported symbol table cache for prelinked kexts.
+
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcAppleKernelLib.h>
+#include <Library/OcFileLib.h>
+#include <Library/OcGuardLib.h>
+#include <Library/OcMachoLib.h>
+
+#include "PrelinkedInternal.h"
+
+/**
+  Retrieves the UUID of the kernel in the prelinked context.
+
+  @param[in,out] Context  Prelinked context.
+
+  @return  Kernel UUID or NULL.
+**/
+STATIC
+CONST UINT8 *
+InternalGetKernelUuid (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  MACH_UUID_COMMAND  *UuidCommand;
+
+  UuidCommand = MachoGetUuid64 (&Context->PrelinkedMachContext);
+  if (UuidCommand == NULL) {
+    return NULL;
+  }
+
+  return UuidCommand->Uuid;
+}
+
+/**
+  Retrieves the UUID of a kext.  Cached symbol values are absolute, so
+  they are only valid for the very same kext binary.
+
+  @param[in,out] Kext  Kext to retrieve the UUID of.
+
+  @return  Kext UUID or NULL.
+**/
+STATIC
+CONST UINT8 *
+InternalGetKextUuid (
+  IN OUT PRELINKED_KEXT  *Kext
+  )
+{
+  MACH_UUID_COMMAND  *UuidCommand;
+
+  UuidCommand = MachoGetUuid64 (&Kext->Context.MachContext);
+  if (UuidCommand == NULL) {
+    return NULL;
+  }
+
+  return UuidCommand->Uuid;
+}
+
+/**
+  Retrieves the identifier of a cached kext.
+
+  @param[in] Cache  Validated symbol cache.
+  @param[in] Kext   Kext entry in Cache.
+
+  @return  Kext identifier.
+**/
+STATIC
+CONST CHAR8 *
+InternalGetCachedKextIdentifier (
+  IN CONST PRELINKED_SYMBOL_CACHE_HEADER  *Cache,
+  IN CONST PRELINKED_SYMBOL_CACHE_KEXT    *Kext
+  )
+{
+  return (CONST CHAR8 *) Cache + Kext->IdentifierOffset;
+}
+
+/**
+  Validates symbol cache layout and kernel binding.
+
+  @param[in,out] Context    Prelinked context.
+  @param[in]     Cache      Symbol cache.
+  @param[in]     CacheSize  Symbol cache size.
+
+  @return  EFI_SUCCESS on success.
+**/
+STATIC
+EFI_STATUS
+InternalValidateSymbolCache (
+  IN OUT PRELINKED_CONTEXT                    *Context,
+  IN     CONST PRELINKED_SYMBOL_CACHE_HEADER  *Cache,
+  IN     UINT32                               CacheSize
+  )
+{
+  CONST UINT8                        *KernelUuid;
+  CONST PRELINKED_SYMBOL_CACHE_KEXT  *Kexts;
+  CONST CHAR8                        *Identifier;
+  CONST CHAR8                        *PrevIdentifier;
+  UINT32                             Index;
+  UINT32                             TableSize;
+  UINT32                             SymbolsEnd;
+
+  if (CacheSize < sizeof (*Cache)
+    || !OC_ALIGNED (Cache)
+    || Cache->Signature != PRELINKED_SYMBOL_CACHE_SIGNATURE
+    || Cache->Version != PRELINKED_SYMBOL_CACHE_VERSION
+    || Cache->Size != CacheSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  KernelUuid = InternalGetKernelUuid (Context);
+  if (KernelUuid == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (CompareMem (Cache->KernelUuid, KernelUuid, sizeof (Cache->KernelUuid)) != 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (OcOverflowMulAddU32 (Cache->NumKexts, sizeof (*Kexts), sizeof (*Cache), &TableSize)
+    || TableSize > CacheSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Kexts          = (CONST PRELINKED_SYMBOL_CACHE_KEXT *) (Cache + 1);
+  PrevIdentifier = NULL;
+
+  for (Index = 0; Index < Cache->NumKexts; ++Index) {
+    if (Kexts[Index].IdentifierOffset < TableSize
+      || Kexts[Index].IdentifierOffset >= CacheSize
+      || Kexts[Index].NumberOfCxxSymbols > Kexts[Index].NumberOfSymbols
+      || Kexts[Index].SymbolsOffset < TableSize
+      || !OC_TYPE_ALIGNED (PRELINKED_SYMBOL_CACHE_SYMBOL, Kexts[Index].SymbolsOffset)
+      || OcOverflowMulAddU32 (
+           Kexts[Index].NumberOfSymbols,
+           sizeof (PRELINKED_SYMBOL_CACHE_SYMBOL),
+           Kexts[Index].SymbolsOffset,
+           &SymbolsEnd
+           )
+      || SymbolsEnd > CacheSize) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Identifier = InternalGetCachedKextIdentifier (Cache, &Kexts[Index]);
+    if (AsciiStrnLenS (Identifier, CacheSize - Kexts[Index].IdentifierOffset)
+      == CacheSize - Kexts[Index].IdentifierOffset) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    //
+    // Lookup relies on strictly ascending identifiers.
+    //
+    if (PrevIdentifier != NULL && AsciiStrCmp (PrevIdentifier, Identifier) >= 0) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    PrevIdentifier = Identifier;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+PrelinkedAttachSymbolCache (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     VOID               *Cache,
+  IN     UINT32             CacheSize
+  )
+{
+  EFI_STATUS  Status;
+
+  ASSERT (Context != NULL);
+  ASSERT (Cache != NULL);
+
+  if (Context->SymbolCache != NULL) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  Status = InternalValidateSymbolCache (Context, Cache, CacheSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = PrelinkedDependencyInsert (Context, Cache);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Context->SymbolCache = Cache;
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+PrelinkedLoadSymbolCache (
+  IN OUT PRELINKED_CONTEXT                *Context,
+  IN     EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem,
+  IN     CONST CHAR16                     *FilePath
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Cache;
+  UINTN       CacheSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (FileSystem != NULL);
+  ASSERT (FilePath != NULL);
+
+  Cache = ReadFile (FileSystem, FilePath, &CacheSize);
+  if (Cache == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (CacheSize > MAX_UINT32) {
+    FreePool (Cache);
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = PrelinkedAttachSymbolCache (Context, Cache, (UINT32) CacheSize);
+  if (EFI_ERROR (Status)) {
+    FreePool (Cache);
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+PrelinkedExportSymbolCache (
+  IN OUT PRELINKED_CONTEXT  *Context,
+     OUT VOID               **Cache,
+     OUT UINT32             *CacheSize
+  )
+{
+  CONST UINT8                    *KernelUuid;
+  LIST_ENTRY                     *Link;
+  PRELINKED_KEXT                 *Kext;
+  PRELINKED_KEXT                 **SortedKexts;
+  UINT32                         NumKexts;
+  UINT32                         Index;
+  UINT32                         SortIndex;
+  UINT32                         Size;
+  UINT32                         SymbolsOffset;
+  UINT32                         IdentifierOffset;
+  UINT32                         IdentifierSize;
+  UINT32                         SymbolIndex;
+  CONST UINT8                    *KextUuid;
+  PRELINKED_SYMBOL_CACHE_HEADER  *Header;
+  PRELINKED_SYMBOL_CACHE_KEXT    *CachedKexts;
+  PRELINKED_SYMBOL_CACHE_SYMBOL  *CachedSymbols;
+
+  ASSERT (Context != NULL);
+  ASSERT (Cache != NULL);
+  ASSERT (CacheSize != NULL);
+
+  KernelUuid = InternalGetKernelUuid (Context);
+  if (KernelUuid == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  NumKexts = 0;
+  for (
+    Link = GetFirstNode (&Context->PrelinkedKexts);
+    !IsNull (&Context->PrelinkedKexts, Link);
+    Link = GetNextNode (&Context->PrelinkedKexts, Link)
+    ) {
+    if (GET_PRELINKED_KEXT_FROM_LINK (Link)->LinkedSymbolTable != NULL) {
+      ++NumKexts;
+    }
+  }
+
+  if (NumKexts == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  SortedKexts = AllocatePool (NumKexts * sizeof (*SortedKexts));
+  if (SortedKexts == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Order kexts by identifier for binary search upon lookup.
+  // Identifiers in PrelinkedKexts are unique.
+  //
+  Index = 0;
+  for (
+    Link = GetFirstNode (&Context->PrelinkedKexts);
+    !IsNull (&Context->PrelinkedKexts, Link);
+    Link = GetNextNode (&Context->PrelinkedKexts, Link)
+    ) {
+    Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
+    if (Kext->LinkedSymbolTable == NULL) {
+      continue;
+    }
+
+    for (SortIndex = Index; SortIndex > 0; --SortIndex) {
+      if (AsciiStrCmp (SortedKexts[SortIndex - 1]->Identifier, Kext->Identifier) <= 0) {
+        break;
+      }
+      SortedKexts[SortIndex] = SortedKexts[SortIndex - 1];
+    }
+
+    SortedKexts[SortIndex] = Kext;
+    ++Index;
+  }
+
+  //
+  // Symbols follow the kext table and are naturally aligned,
+  // identifiers are appended at the end.
+  //
+  Size = sizeof (*Header) + NumKexts * sizeof (*CachedKexts);
+  for (Index = 0; Index < NumKexts; ++Index) {
+    IdentifierSize = (UINT32) AsciiStrSize (SortedKexts[Index]->Identifier);
+    if (OcOverflowTriAddU32 (
+          Size,
+          SortedKexts[Index]->LinkedNumberOfSymbols * sizeof (*CachedSymbols),
+          IdentifierSize,
+          &Size
+          )) {
+      FreePool (SortedKexts);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  Header = AllocateZeroPool (Size);
+  if (Header == NULL) {
+    FreePool (SortedKexts);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Header->Signature = PRELINKED_SYMBOL_CACHE_SIGNATURE;
+  Header->Version   = PRELINKED_SYMBOL_CACHE_VERSION;
+  Header->Size      = Size;
+  Header->NumKexts  = NumKexts;
+  CopyMem (Header->KernelUuid, KernelUuid, sizeof (Header->KernelUuid));
+
+  CachedKexts      = (PRELINKED_SYMBOL_CACHE_KEXT *) (Header + 1);
+  SymbolsOffset    = sizeof (*Header) + NumKexts * sizeof (*CachedKexts);
+  IdentifierOffset = SymbolsOffset;
+  for (Index = 0; Index < NumKexts; ++Index) {
+    IdentifierOffset += SortedKexts[Index]->LinkedNumberOfSymbols * sizeof (*CachedSymbols);
+  }
+
+  for (Index = 0; Index < NumKexts; ++Index) {
+    Kext = SortedKexts[Index];
+
+    CachedKexts[Index].IdentifierOffset   = IdentifierOffset;
+    CachedKexts[Index].SymbolsOffset      = SymbolsOffset;
+    CachedKexts[Index].NumberOfSymbols    = Kext->LinkedNumberOfSymbols;
+    CachedKexts[Index].NumberOfCxxSymbols = Kext->LinkedNumberOfCxxSymbols;
+    CachedKexts[Index].StringTableSize    = Kext->Context.MachContext.Symtab->StringsSize;
+    CachedKexts[Index].LoadAddress        = Kext->Context.VirtualBase;
+
+    KextUuid = InternalGetKextUuid (Kext);
+    if (KextUuid != NULL) {
+      CopyMem (CachedKexts[Index].KextUuid, KextUuid, sizeof (CachedKexts[Index].KextUuid));
+    }
+
+    CachedSymbols = (PRELINKED_SYMBOL_CACHE_SYMBOL *) ((UINT8 *) Header + SymbolsOffset);
+    for (SymbolIndex = 0; SymbolIndex < Kext->LinkedNumberOfSymbols; ++SymbolIndex) {
+      CachedSymbols[SymbolIndex].Value       = Kext->LinkedSymbolTable[SymbolIndex].Value;
+      CachedSymbols[SymbolIndex].StringIndex = Kext->LinkedSymbolTable[SymbolIndex].StringIndex;
+    }
+
+    IdentifierSize = (UINT32) AsciiStrSize (Kext->Identifier);
+    CopyMem ((UINT8 *) Header + IdentifierOffset, Kext->Identifier, IdentifierSize);
+
+    SymbolsOffset    += Kext->LinkedNumberOfSymbols * sizeof (*CachedSymbols);
+    IdentifierOffset += IdentifierSize;
+  }
+
+  FreePool (SortedKexts);
+
+  *Cache     = Header;
+  *CacheSize = Size;
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+InternalRestoreLinkedSymbolTable (
+  IN     PRELINKED_CONTEXT  *Context,
+  IN OUT PRELINKED_KEXT     *Kext
+  )
+{
+  CONST PRELINKED_SYMBOL_CACHE_HEADER  *Cache;
+  CONST PRELINKED_SYMBOL_CACHE_KEXT    *Kexts;
+  CONST PRELINKED_SYMBOL_CACHE_KEXT    *CachedKext;
+  CONST PRELINKED_SYMBOL_CACHE_SYMBOL  *CachedSymbols;
+  PRELINKED_KEXT_SYMBOL                *SymbolTable;
+  UINT32                               Low;
+  UINT32                               High;
+  UINT32                               Middle;
+  UINT32                               Index;
+  INTN                                 Result;
+  CONST UINT8                          *KextUuid;
+
+  Cache = Context->SymbolCache;
+  if (Cache == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Kexts      = (CONST PRELINKED_SYMBOL_CACHE_KEXT *) (Cache + 1);
+  CachedKext = NULL;
+  Low        = 0;
+  High       = Cache->NumKexts;
+
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    Result = AsciiStrCmp (
+      Kext->Identifier,
+      InternalGetCachedKextIdentifier (Cache, &Kexts[Middle])
+      );
+    if (Result == 0) {
+      CachedKext = &Kexts[Middle];
+      break;
+    } else if (Result < 0) {
+      High = Middle;
+    } else {
+      Low = Middle + 1;
+    }
+  }
+
+  //
+  // Kext binaries and their load addresses may differ for the same kernel,
+  // only accept tables of the very same kext.
+  //
+  if (CachedKext == NULL
+    || CachedKext->NumberOfSymbols != Kext->NumberOfSymbols
+    || CachedKext->StringTableSize != Kext->Context.MachContext.Symtab->StringsSize
+    || CachedKext->LoadAddress != Kext->Context.VirtualBase) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Entries of kexts without UUID are left zeroed and never match.
+  //
+  KextUuid = InternalGetKextUuid (Kext);
+  if (KextUuid == NULL
+    || CompareMem (CachedKext->KextUuid, KextUuid, sizeof (CachedKext->KextUuid)) != 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  SymbolTable = AllocatePool (CachedKext->NumberOfSymbols * sizeof (*SymbolTable));
+  if (SymbolTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CachedSymbols = (CONST PRELINKED_SYMBOL_CACHE_SYMBOL *) ((CONST UINT8 *) Cache + CachedKext->SymbolsOffset);
+  for (Index = 0; Index < CachedKext->NumberOfSymbols; ++Index) {
+    if (CachedSymbols[Index].StringIndex >= CachedKext->StringTableSize) {
+      FreePool (SymbolTable);
+      return EFI_NOT_FOUND;
+    }
+
+    SymbolTable[Index].StringIndex = CachedSymbols[Index].StringIndex;
+    SymbolTable[Index].Value       = CachedSymbols[Index].Value;
+  }
+
+  Kext->LinkedSymbolTable        = SymbolTable;
+  Kext->LinkedNumberOfSymbols    = CachedKext->NumberOfSymbols;
+  Kext->LinkedNumberOfCxxSymbols = CachedKext->NumberOfCxxSymbols;
+
+  return EFI_SUCCESS;
+}
@@ -108,11 +108,17 @@ InternalPrelinkKextsWorker (
 
   VtableExport = (OC_VTABLE_EXPORT_ARRAY *)ScratchMemory;
 
+  //
+  // Lookup indices of every Mach-O Context are freed once it is processed.
+  //
+  ZeroMem (&MachoContext, sizeof (MachoContext));
+
   for (
     DependencyEntry = GetFirstNode (Dependencies);
     !IsNull (DependencyEntry, Dependencies);
     DependencyEntry = GetNextNode (Dependencies, DependencyEntry),
-    InternalDestructDependencyArrays (&DependencyData)
+    InternalDestructDependencyArrays (&DependencyData),
+    MachoFreeContext (&MachoContext)
     ) {
     DependencyInfo = OC_DEP_INFO_FROM_LINK (DependencyEntry);
     CurrentData    = &DependencyInfo->Data;
@@ -179,6 +185,7 @@ InternalPrelinkKextsWorker (
                         + (NumSymbols * sizeof (*OcSymbolTable->Symbols))
                       );
     if (OcSymbolTable == NULL) {
+      MachoFreeContext (&MachoContext);
       FreePool (ScratchMemory);
       return FALSE;
     }
@@ -244,6 +251,7 @@ InternalPrelinkKextsWorker (
 
     Vtables = AllocatePool (sizeof (*Vtables) + VtablesSize);
     if (Vtables == NULL) {
+      MachoFreeContext (&MachoContext);
       FreePool (OcSymbolTable);
       FreePool (ScratchMemory);
       return FALSE;
@@ -354,20 +362,28 @@ PrelinkedLinkExecutable (
 {
   EFI_STATUS                Status;
   PRELINKED_KEXT            *Kext;
+  UINT64                    Start;
 
   Kext = InternalNewPrelinkedKext (Executable, PlistRoot);
   if (Kext == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
+  Start  = InternalKernelTimingStart ();
   Status = InternalScanPrelinkedKext (Kext, Context);
+  InternalKernelTimingStop (KernelTimingDependencies, Start);
+
+  //
+  // Lookup indices built for the kext are owned by the caller's Executable.
+  //
+  CopyMem (Executable, &Kext->Context.MachContext, sizeof (*Executable));
+  ZeroMem (&Kext->Context.MachContext, sizeof (Kext->Context.MachContext));
+  InternalFreePrelinkedKext (Kext);
+
   if (EFI_ERROR (Status)) {
-    InternalFreePrelinkedKext (Kext);
     return Status;
   }
 
-  InternalFreePrelinkedKext (Kext);
-
   return EFI_UNSUPPORTED;
 
   /*if (Request.Private.Info != NULL) {
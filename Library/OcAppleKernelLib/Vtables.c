@@ -213,7 +213,7 @@ InternalPrepareCreateVtablesPrelinked64 (
 
   CONST MACH_NLIST_64 *SymbolTable;
   CONST MACH_NLIST_64 *Symbol;
-  CONST CHAR8         *Name;
+  UINT32              Flags;
   UINT32              NumSymbols;
   UINT32              Index;
   BOOLEAN             Result;
@@ -235,8 +235,8 @@ InternalPrepareCreateVtablesPrelinked64 (
                  );
   for (Index = 0; Index < NumSymbols; ++Index) {
     Symbol = &SymbolTable[Index];
-    Name = MachoGetSymbolName64 (MachoContext, Symbol);
-    if (MachoSymbolNameIsVtable64 (Name)) {
+    Flags  = MachoGetCxxSymbolFlags64 (MachoContext, Symbol);
+    if ((Flags & MACHO_CXX_SYMBOL_VTABLE) != 0) {
       Result = MachoIsSymbolValueInRange64 (
                  MachoContext,
                  VtableExport->Symbols[Index]
@@ -307,6 +307,7 @@ InternalPatchVtableSymbol (
   )
 {
   CONST CHAR8 *Name;
+  UINT32      Flags;
   INTN        Result;
   BOOLEAN     Success;
   CONST CHAR8 *ClassName;
@@ -346,7 +347,8 @@ InternalPatchVtableSymbol (
   // The pure virtual function symbol is special case, as the pure
   // virtual property itself overrides the parent's implementation.
   //
-  if (MachoSymbolNameIsPureVirtual (Name)) {
+  Flags = MachoGetCxxSymbolFlags64 (MachoContext, Symbol);
+  if ((Flags & MACHO_CXX_SYMBOL_PURE_VIRTUAL) != 0) {
     return MachoIsSymbolValueInRange64 (MachoContext, Symbol);
   }
   //
@@ -558,6 +560,7 @@ InternalPrepareVtableCreationNonPrelinked64 (
   BOOLEAN              Result;
   CONST MACH_NLIST_64  *Smcp;
   CONST CHAR8          *Name;
+  UINT32               Flags;
   CONST MACH_NLIST_64  *VtableSymbol;
   CONST MACH_NLIST_64  *MetaVtableSymbol;
 
@@ -567,9 +570,10 @@ InternalPrepareVtableCreationNonPrelinked64 (
   NumTables = 0;
 
   for (Index = 0; Index < NumSymbols; ++Index) {
-    Smcp = &SymbolTable[Index];
-    Name = MachoGetSymbolName64 (MachoContext, Smcp);
-    if (MachoSymbolNameIsSmcp64 (MachoContext, Name)) {
+    Smcp  = &SymbolTable[Index];
+    Flags = MachoGetCxxSymbolFlags64 (MachoContext, Smcp);
+    if ((Flags & MACHO_CXX_SYMBOL_SMCP) != 0) {
+      Name = MachoGetSymbolName64 (MachoContext, Smcp);
       //
       // We walk over the super metaclass pointer symbols because classes
       // with them are the only ones that need patching.  Then we double the
@@ -612,7 +616,6 @@ InternalCreateVtablesNonPrelinked64 (
   UINT32               NumPatched;
   BOOLEAN              Result;
   CONST MACH_NLIST_64  *Smcp;
-  CONST CHAR8          *Name;
   UINT32               VtableOffset;
   CONST MACH_NLIST_64  *VtableSymbol;
   CONST MACH_NLIST_64  *MetaVtableSymbol;
@@ -640,22 +643,24 @@ InternalCreateVtablesNonPrelinked64 (
 
     for (Index = 0; Index < PatchData->NumEntries; ++Index) {
       Smcp = PatchData->Entries[Index].Smcp;
-      Name = MachoGetSymbolName64 (MachoContext, Smcp);
       //
       // We walk over the super metaclass pointer symbols because classes
       // with them are the only ones that need patching.  Then we double the
       // number of vtables we're expecting, because every pointer will have a
       // class vtable and a MetaClass vtable.
       //
-      ASSERT (MachoSymbolNameIsSmcp64 (MachoContext, Name));
+      ASSERT (
+        (MachoGetCxxSymbolFlags64 (MachoContext, Smcp)
+          & MACHO_CXX_SYMBOL_SMCP) != 0
+        );
       VtableSymbol     = PatchData->Entries[Index].Vtable;
       MetaVtableSymbol = PatchData->Entries[Index].MetaVtable;
       //
       // Get the class name from the smc pointer 
       //
-      Result = MachoGetClassNameFromSuperMetaClassPointer (
+      Result = MachoGetClassNameFromSymbol64 (
                  MachoContext,
-                 Name,
+                 Smcp,
                  sizeof (ClassName),
                  ClassName
                  );
@@ -686,9 +691,14 @@ InternalCreateVtablesNonPrelinked64 (
       //
       // Get the super class name from the super metaclass
       //
-      Result = MachoGetClassNameFromMetaClassPointer (
+      if ((MachoGetCxxSymbolFlags64 (MachoContext, MetaClass)
+            & MACHO_CXX_SYMBOL_METACLASS_POINTER) == 0) {
+        return FALSE;
+      }
+
+      Result = MachoGetClassNameFromSymbol64 (
                  MachoContext,
-                 MachoGetSymbolName64 (MachoContext, MetaClass),
+                 MetaClass,
                  sizeof (SuperClassName),
                  SuperClassName
                  );
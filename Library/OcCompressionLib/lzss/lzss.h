@@ -29,6 +29,7 @@ typedef INT32 int32_t;
 
 #define compress_lzss CompressLZSS
 #define decompress_lzss DecompressLZSS
+#define local_adler32 Adler32
 
 #define bzero(Dst, Size) ZeroMem ((Dst), (Size))
 #define malloc(Size) AllocatePool (Size)
@@ -0,0 +1,295 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+//
+// LZVN greedy encoder producing streams accepted by lzvn_decode.
+//
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcCompressionLib.h>
+
+#define LZVN_HASH_BITS        14U
+#define LZVN_MIN_MATCH        4U
+#define LZVN_MAX_DISTANCE     0xFFFFU
+#define LZVN_SMALL_DISTANCE   1536U
+#define LZVN_MEDIUM_DISTANCE  BIT14
+#define LZVN_MEDIUM_MATCH     34U
+#define LZVN_MAX_CHUNK        271U
+#define LZVN_EOS_SIZE         8U
+
+typedef struct {
+  UINT8  *Dst;
+  UINT8  *DstEnd;
+  UINTN  PrevDistance;
+} LZVN_ENCODER;
+
+STATIC
+UINT32
+InternalLzvnHash (
+  IN CONST UINT8  *Src
+  )
+{
+  UINT32  Value;
+
+  CopyMem (&Value, Src, sizeof (Value));
+  return (Value * 2654435761U) >> (32U - LZVN_HASH_BITS);
+}
+
+/**
+  Emit literals with sml_l and lrg_l opcodes.
+**/
+STATIC
+BOOLEAN
+InternalLzvnEmitLiterals (
+  IN OUT LZVN_ENCODER  *Encoder,
+  IN     CONST UINT8   *Literals,
+  IN     UINTN         Length
+  )
+{
+  UINTN  Chunk;
+
+  while (Length > 0) {
+    Chunk = MIN (Length, LZVN_MAX_CHUNK);
+    if ((UINTN) (Encoder->DstEnd - Encoder->Dst) < Chunk + 2) {
+      return FALSE;
+    }
+
+    if (Chunk < 16) {
+      *Encoder->Dst++ = (UINT8) (0xE0U | Chunk);
+    } else {
+      *Encoder->Dst++ = 0xE0U;
+      *Encoder->Dst++ = (UINT8) (Chunk - 16);
+    }
+
+    CopyMem (Encoder->Dst, Literals, Chunk);
+    Encoder->Dst += Chunk;
+    Literals     += Chunk;
+    Length       -= Chunk;
+  }
+
+  return TRUE;
+}
+
+/**
+  Emit match continuation with previous distance via sml_m and lrg_m opcodes.
+**/
+STATIC
+BOOLEAN
+InternalLzvnEmitMatchTail (
+  IN OUT LZVN_ENCODER  *Encoder,
+  IN     UINTN         Length
+  )
+{
+  UINTN  Chunk;
+
+  while (Length > 0) {
+    Chunk = MIN (Length, LZVN_MAX_CHUNK);
+    if ((UINTN) (Encoder->DstEnd - Encoder->Dst) < 2) {
+      return FALSE;
+    }
+
+    if (Chunk < 16) {
+      *Encoder->Dst++ = (UINT8) (0xF0U | Chunk);
+    } else {
+      *Encoder->Dst++ = 0xF0U;
+      *Encoder->Dst++ = (UINT8) (Chunk - 16);
+    }
+
+    Length -= Chunk;
+  }
+
+  return TRUE;
+}
+
+/**
+  Emit Length literals followed by a match of MatchLength bytes at Distance.
+  MatchLength must be at least 3.
+**/
+STATIC
+BOOLEAN
+InternalLzvnEmit (
+  IN OUT LZVN_ENCODER  *Encoder,
+  IN     CONST UINT8   *Literals,
+  IN     UINTN         Length,
+  IN     UINTN         MatchLength,
+  IN     UINTN         Distance
+  )
+{
+  UINTN  Match;
+
+  //
+  // Only up to 3 literals fit into match opcodes.
+  //
+  if (Length > 3) {
+    if (!InternalLzvnEmitLiterals (Encoder, Literals, Length)) {
+      return FALSE;
+    }
+
+    Literals += Length;
+    Length    = 0;
+  }
+
+  //
+  // Match length in the opcode is limited so that it does not collide
+  // with other opcodes, the rest is emitted with previous distance.
+  //
+  Match        = MIN (MatchLength, 10 - 2 * Length);
+  MatchLength -= Match;
+  Match       -= 3;
+
+  if ((UINTN) (Encoder->DstEnd - Encoder->Dst) < 3 + Length) {
+    return FALSE;
+  }
+
+  if (Distance == Encoder->PrevDistance) {
+    if (Length == 0) {
+      //
+      // sml_m
+      //
+      *Encoder->Dst++ = (UINT8) (0xF0U + Match + 3);
+    } else {
+      //
+      // pre_d
+      //
+      *Encoder->Dst++ = (UINT8) ((Length << 6U) | (Match << 3U) | 6U);
+    }
+  } else if (Distance < LZVN_SMALL_DISTANCE) {
+    //
+    // sml_d
+    //
+    *Encoder->Dst++ = (UINT8) ((Length << 6U) | (Match << 3U) | (Distance >> 8U));
+    *Encoder->Dst++ = (UINT8) Distance;
+  } else if (Distance >= LZVN_MEDIUM_DISTANCE
+    || MatchLength == 0
+    || Match + 3 + MatchLength > LZVN_MEDIUM_MATCH) {
+    //
+    // lrg_d
+    //
+    *Encoder->Dst++ = (UINT8) ((Length << 6U) | (Match << 3U) | 7U);
+    *Encoder->Dst++ = (UINT8) Distance;
+    *Encoder->Dst++ = (UINT8) (Distance >> 8U);
+  } else {
+    //
+    // med_d fits the whole match.
+    //
+    Match      += MatchLength;
+    MatchLength = 0;
+    *Encoder->Dst++ = (UINT8) (0xA0U | (Match >> 2U) | (Length << 3U));
+    *Encoder->Dst++ = (UINT8) ((Distance << 2U) | (Match & 3U));
+    *Encoder->Dst++ = (UINT8) (Distance >> 6U);
+  }
+
+  CopyMem (Encoder->Dst, Literals, Length);
+  Encoder->Dst += Length;
+
+  Encoder->PrevDistance = Distance;
+
+  return InternalLzvnEmitMatchTail (Encoder, MatchLength);
+}
+
+UINTN
+CompressLZVN (
+  OUT UINT8        *Dst,
+  IN  UINTN        DstLen,
+  IN  CONST UINT8  *Src,
+  IN  UINTN        SrcLen
+  )
+{
+  LZVN_ENCODER  Encoder;
+  UINT32        *Table;
+  UINT32        Hash;
+  UINTN         Position;
+  UINTN         Literal;
+  UINTN         Candidate;
+  UINTN         MatchLength;
+  UINTN         Index;
+
+  if (DstLen > OC_COMPRESSION_MAX_LENGTH || SrcLen > OC_COMPRESSION_MAX_LENGTH) {
+    return 0;
+  }
+
+  //
+  // Positions are stored incremented by one, zero means no entry.
+  //
+  Table = AllocateZeroPool ((1U << LZVN_HASH_BITS) * sizeof (*Table));
+  if (Table == NULL) {
+    return 0;
+  }
+
+  Encoder.Dst          = Dst;
+  Encoder.DstEnd       = Dst + DstLen;
+  Encoder.PrevDistance = 0;
+
+  Position = 0;
+  Literal  = 0;
+
+  while (Position + LZVN_MIN_MATCH <= SrcLen) {
+    Hash            = InternalLzvnHash (&Src[Position]);
+    Candidate       = Table[Hash];
+    Table[Hash]     = (UINT32) (Position + 1);
+
+    if (Candidate == 0
+      || Position - (Candidate - 1) > LZVN_MAX_DISTANCE
+      || CompareMem (&Src[Candidate - 1], &Src[Position], LZVN_MIN_MATCH) != 0) {
+      ++Position;
+      continue;
+    }
+
+    --Candidate;
+
+    MatchLength = LZVN_MIN_MATCH;
+    while (Position + MatchLength < SrcLen
+      && Src[Candidate + MatchLength] == Src[Position + MatchLength]) {
+      ++MatchLength;
+    }
+
+    if (!InternalLzvnEmit (
+      &Encoder,
+      &Src[Literal],
+      Position - Literal,
+      MatchLength,
+      Position - Candidate
+      )) {
+      FreePool (Table);
+      return 0;
+    }
+
+    //
+    // Remember positions covered by the match for further lookups.
+    //
+    for (Index = Position + 1; Index < Position + MatchLength && Index + LZVN_MIN_MATCH <= SrcLen; ++Index) {
+      Table[InternalLzvnHash (&Src[Index])] = (UINT32) (Index + 1);
+    }
+
+    Position += MatchLength;
+    Literal   = Position;
+  }
+
+  FreePool (Table);
+
+  if (!InternalLzvnEmitLiterals (&Encoder, &Src[Literal], SrcLen - Literal)
+    || (UINTN) (Encoder.DstEnd - Encoder.Dst) < LZVN_EOS_SIZE) {
+    return 0;
+  }
+
+  //
+  // End of stream opcode followed by padding.
+  //
+  ZeroMem (Encoder.Dst, LZVN_EOS_SIZE);
+  *Encoder.Dst  = 0x06U;
+  Encoder.Dst  += LZVN_EOS_SIZE;
+
+  return (UINTN) (Encoder.Dst - Dst);
+}
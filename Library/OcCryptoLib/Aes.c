@@ -52,6 +52,10 @@ For more information, please refer to <http://unlicense.org/>
 This is an implementation of the AES algorithm, specifically CTR and CBC mode.
 Block size can be chosen in OcCryptoLib.h.
 
+The key schedule is derived from tiny-AES, the generic cipher uses 32-bit
+lookup tables combining SubBytes, ShiftRows and MixColumns, and AES-NI is
+used on X64 CPUs supporting it.
+
 The implementation is verified against the test vectors in:
   National Institute of Standards and Technology Special Publication 800-38A 2001 ED
 
@@ -62,31 +66,19 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
 
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/OcCryptoLib.h>
 
+#include "OcCryptoLibInternal.h"
+
 //
 // The number of columns comprising a state in AES (Nb). This is a CONSTant in AES. Value=4
-// The number of 32 bit words in a key (Nk).
-// The number of rounds in AES Cipher (Nr).
+// The number of 32 bit words in a key (Nk) and the number of rounds in AES Cipher (Nr)
+// depend on the key size of the context.
 //
 
 #define Nb 4
-#if CONFIG_AES_KEY_SIZE == 32
-#define Nk 8
-#define Nr 14
-#elif CONFIG_AES_KEY_SIZE == 24
-#define Nk 6
-#define Nr 12
-#elif CONFIG_AES_KEY_SIZE == 16
-#define Nk 4
-#define Nr 10
-#endif
-
-//
-// state - array holding the intermediate results during decryption.
-//
-typedef UINT8 AES_INTERNAL_STATE[4][4];
 
 //
 // The lookup-tables are marked CONST so they can be placed in read-only storage instead of RAM
@@ -132,6 +124,81 @@ STATIC CONST UINT8 RsBox[256] = {
   0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
 };
 
+//
+// Round lookup tables in little endian column order.  mAesTe[X] is column
+// (2, 1, 1, 3) * Sbox[X] and mAesTd[X] is column (14, 9, 13, 11) * RsBox[X],
+// rotating them by 8 * N bits gives the tables for row N.
+//
+STATIC CONST UINT32 mAesTe[256] = {
+  0xA56363C6, 0x847C7CF8, 0x997777EE, 0x8D7B7BF6, 0x0DF2F2FF, 0xBD6B6BD6, 0xB16F6FDE, 0x54C5C591,
+  0x50303060, 0x03010102, 0xA96767CE, 0x7D2B2B56, 0x19FEFEE7, 0x62D7D7B5, 0xE6ABAB4D, 0x9A7676EC,
+  0x45CACA8F, 0x9D82821F, 0x40C9C989, 0x877D7DFA, 0x15FAFAEF, 0xEB5959B2, 0xC947478E, 0x0BF0F0FB,
+  0xECADAD41, 0x67D4D4B3, 0xFDA2A25F, 0xEAAFAF45, 0xBF9C9C23, 0xF7A4A453, 0x967272E4, 0x5BC0C09B,
+  0xC2B7B775, 0x1CFDFDE1, 0xAE93933D, 0x6A26264C, 0x5A36366C, 0x413F3F7E, 0x02F7F7F5, 0x4FCCCC83,
+  0x5C343468, 0xF4A5A551, 0x34E5E5D1, 0x08F1F1F9, 0x937171E2, 0x73D8D8AB, 0x53313162, 0x3F15152A,
+  0x0C040408, 0x52C7C795, 0x65232346, 0x5EC3C39D, 0x28181830, 0xA1969637, 0x0F05050A, 0xB59A9A2F,
+  0x0907070E, 0x36121224, 0x9B80801B, 0x3DE2E2DF, 0x26EBEBCD, 0x6927274E, 0xCDB2B27F, 0x9F7575EA,
+  0x1B090912, 0x9E83831D, 0x742C2C58, 0x2E1A1A34, 0x2D1B1B36, 0xB26E6EDC, 0xEE5A5AB4, 0xFBA0A05B,
+  0xF65252A4, 0x4D3B3B76, 0x61D6D6B7, 0xCEB3B37D, 0x7B292952, 0x3EE3E3DD, 0x712F2F5E, 0x97848413,
+  0xF55353A6, 0x68D1D1B9, 0x00000000, 0x2CEDEDC1, 0x60202040, 0x1FFCFCE3, 0xC8B1B179, 0xED5B5BB6,
+  0xBE6A6AD4, 0x46CBCB8D, 0xD9BEBE67, 0x4B393972, 0xDE4A4A94, 0xD44C4C98, 0xE85858B0, 0x4ACFCF85,
+  0x6BD0D0BB, 0x2AEFEFC5, 0xE5AAAA4F, 0x16FBFBED, 0xC5434386, 0xD74D4D9A, 0x55333366, 0x94858511,
+  0xCF45458A, 0x10F9F9E9, 0x06020204, 0x817F7FFE, 0xF05050A0, 0x443C3C78, 0xBA9F9F25, 0xE3A8A84B,
+  0xF35151A2, 0xFEA3A35D, 0xC0404080, 0x8A8F8F05, 0xAD92923F, 0xBC9D9D21, 0x48383870, 0x04F5F5F1,
+  0xDFBCBC63, 0xC1B6B677, 0x75DADAAF, 0x63212142, 0x30101020, 0x1AFFFFE5, 0x0EF3F3FD, 0x6DD2D2BF,
+  0x4CCDCD81, 0x140C0C18, 0x35131326, 0x2FECECC3, 0xE15F5FBE, 0xA2979735, 0xCC444488, 0x3917172E,
+  0x57C4C493, 0xF2A7A755, 0x827E7EFC, 0x473D3D7A, 0xAC6464C8, 0xE75D5DBA, 0x2B191932, 0x957373E6,
+  0xA06060C0, 0x98818119, 0xD14F4F9E, 0x7FDCDCA3, 0x66222244, 0x7E2A2A54, 0xAB90903B, 0x8388880B,
+  0xCA46468C, 0x29EEEEC7, 0xD3B8B86B, 0x3C141428, 0x79DEDEA7, 0xE25E5EBC, 0x1D0B0B16, 0x76DBDBAD,
+  0x3BE0E0DB, 0x56323264, 0x4E3A3A74, 0x1E0A0A14, 0xDB494992, 0x0A06060C, 0x6C242448, 0xE45C5CB8,
+  0x5DC2C29F, 0x6ED3D3BD, 0xEFACAC43, 0xA66262C4, 0xA8919139, 0xA4959531, 0x37E4E4D3, 0x8B7979F2,
+  0x32E7E7D5, 0x43C8C88B, 0x5937376E, 0xB76D6DDA, 0x8C8D8D01, 0x64D5D5B1, 0xD24E4E9C, 0xE0A9A949,
+  0xB46C6CD8, 0xFA5656AC, 0x07F4F4F3, 0x25EAEACF, 0xAF6565CA, 0x8E7A7AF4, 0xE9AEAE47, 0x18080810,
+  0xD5BABA6F, 0x887878F0, 0x6F25254A, 0x722E2E5C, 0x241C1C38, 0xF1A6A657, 0xC7B4B473, 0x51C6C697,
+  0x23E8E8CB, 0x7CDDDDA1, 0x9C7474E8, 0x211F1F3E, 0xDD4B4B96, 0xDCBDBD61, 0x868B8B0D, 0x858A8A0F,
+  0x907070E0, 0x423E3E7C, 0xC4B5B571, 0xAA6666CC, 0xD8484890, 0x05030306, 0x01F6F6F7, 0x120E0E1C,
+  0xA36161C2, 0x5F35356A, 0xF95757AE, 0xD0B9B969, 0x91868617, 0x58C1C199, 0x271D1D3A, 0xB99E9E27,
+  0x38E1E1D9, 0x13F8F8EB, 0xB398982B, 0x33111122, 0xBB6969D2, 0x70D9D9A9, 0x898E8E07, 0xA7949433,
+  0xB69B9B2D, 0x221E1E3C, 0x92878715, 0x20E9E9C9, 0x49CECE87, 0xFF5555AA, 0x78282850, 0x7ADFDFA5,
+  0x8F8C8C03, 0xF8A1A159, 0x80898909, 0x170D0D1A, 0xDABFBF65, 0x31E6E6D7, 0xC6424284, 0xB86868D0,
+  0xC3414182, 0xB0999929, 0x772D2D5A, 0x110F0F1E, 0xCBB0B07B, 0xFC5454A8, 0xD6BBBB6D, 0x3A16162C
+};
+
+STATIC CONST UINT32 mAesTd[256] = {
+  0x50A7F451, 0x5365417E, 0xC3A4171A, 0x965E273A, 0xCB6BAB3B, 0xF1459D1F, 0xAB58FAAC, 0x9303E34B,
+  0x55FA3020, 0xF66D76AD, 0x9176CC88, 0x254C02F5, 0xFCD7E54F, 0xD7CB2AC5, 0x80443526, 0x8FA362B5,
+  0x495AB1DE, 0x671BBA25, 0x980EEA45, 0xE1C0FE5D, 0x02752FC3, 0x12F04C81, 0xA397468D, 0xC6F9D36B,
+  0xE75F8F03, 0x959C9215, 0xEB7A6DBF, 0xDA595295, 0x2D83BED4, 0xD3217458, 0x2969E049, 0x44C8C98E,
+  0x6A89C275, 0x78798EF4, 0x6B3E5899, 0xDD71B927, 0xB64FE1BE, 0x17AD88F0, 0x66AC20C9, 0xB43ACE7D,
+  0x184ADF63, 0x82311AE5, 0x60335197, 0x457F5362, 0xE07764B1, 0x84AE6BBB, 0x1CA081FE, 0x942B08F9,
+  0x58684870, 0x19FD458F, 0x876CDE94, 0xB7F87B52, 0x23D373AB, 0xE2024B72, 0x578F1FE3, 0x2AAB5566,
+  0x0728EBB2, 0x03C2B52F, 0x9A7BC586, 0xA50837D3, 0xF2872830, 0xB2A5BF23, 0xBA6A0302, 0x5C8216ED,
+  0x2B1CCF8A, 0x92B479A7, 0xF0F207F3, 0xA1E2694E, 0xCDF4DA65, 0xD5BE0506, 0x1F6234D1, 0x8AFEA6C4,
+  0x9D532E34, 0xA055F3A2, 0x32E18A05, 0x75EBF6A4, 0x39EC830B, 0xAAEF6040, 0x069F715E, 0x51106EBD,
+  0xF98A213E, 0x3D06DD96, 0xAE053EDD, 0x46BDE64D, 0xB58D5491, 0x055DC471, 0x6FD40604, 0xFF155060,
+  0x24FB9819, 0x97E9BDD6, 0xCC434089, 0x779ED967, 0xBD42E8B0, 0x888B8907, 0x385B19E7, 0xDBEEC879,
+  0x470A7CA1, 0xE90F427C, 0xC91E84F8, 0x00000000, 0x83868009, 0x48ED2B32, 0xAC70111E, 0x4E725A6C,
+  0xFBFF0EFD, 0x5638850F, 0x1ED5AE3D, 0x27392D36, 0x64D90F0A, 0x21A65C68, 0xD1545B9B, 0x3A2E3624,
+  0xB1670A0C, 0x0FE75793, 0xD296EEB4, 0x9E919B1B, 0x4FC5C080, 0xA220DC61, 0x694B775A, 0x161A121C,
+  0x0ABA93E2, 0xE52AA0C0, 0x43E0223C, 0x1D171B12, 0x0B0D090E, 0xADC78BF2, 0xB9A8B62D, 0xC8A91E14,
+  0x8519F157, 0x4C0775AF, 0xBBDD99EE, 0xFD607FA3, 0x9F2601F7, 0xBCF5725C, 0xC53B6644, 0x347EFB5B,
+  0x7629438B, 0xDCC623CB, 0x68FCEDB6, 0x63F1E4B8, 0xCADC31D7, 0x10856342, 0x40229713, 0x2011C684,
+  0x7D244A85, 0xF83DBBD2, 0x1132F9AE, 0x6DA129C7, 0x4B2F9E1D, 0xF330B2DC, 0xEC52860D, 0xD0E3C177,
+  0x6C16B32B, 0x99B970A9, 0xFA489411, 0x2264E947, 0xC48CFCA8, 0x1A3FF0A0, 0xD82C7D56, 0xEF903322,
+  0xC74E4987, 0xC1D138D9, 0xFEA2CA8C, 0x360BD498, 0xCF81F5A6, 0x28DE7AA5, 0x268EB7DA, 0xA4BFAD3F,
+  0xE49D3A2C, 0x0D927850, 0x9BCC5F6A, 0x62467E54, 0xC2138DF6, 0xE8B8D890, 0x5EF7392E, 0xF5AFC382,
+  0xBE805D9F, 0x7C93D069, 0xA92DD56F, 0xB31225CF, 0x3B99ACC8, 0xA77D1810, 0x6E639CE8, 0x7BBB3BDB,
+  0x097826CD, 0xF418596E, 0x01B79AEC, 0xA89A4F83, 0x656E95E6, 0x7EE6FFAA, 0x08CFBC21, 0xE6E815EF,
+  0xD99BE7BA, 0xCE366F4A, 0xD4099FEA, 0xD67CB029, 0xAFB2A431, 0x31233F2A, 0x3094A5C6, 0xC066A235,
+  0x37BC4E74, 0xA6CA82FC, 0xB0D090E0, 0x15D8A733, 0x4A9804F1, 0xF7DAEC41, 0x0E50CD7F, 0x2FF69117,
+  0x8DD64D76, 0x4DB0EF43, 0x544DAACC, 0xDF0496E4, 0xE3B5D19E, 0x1B886A4C, 0xB81F2CC1, 0x7F516546,
+  0x04EA5E9D, 0x5D358C01, 0x737487FA, 0x2E410BFB, 0x5A1D67B3, 0x52D2DB92, 0x335610E9, 0x1347D66D,
+  0x8C61D79A, 0x7A0CA137, 0x8E14F859, 0x893C13EB, 0xEE27A9CE, 0x35C961B7, 0xEDE51CE1, 0x3CB1477A,
+  0x59DFD29C, 0x3F73F255, 0x79CE1418, 0xBF37C773, 0xEACDF753, 0x5BAAFD5F, 0x146F3DDF, 0x86DB4478,
+  0x81F3AFCA, 0x3EC468B9, 0x2C342438, 0x5F40A3C2, 0x72C31D16, 0x0C25E2BC, 0x8B493C28, 0x41950DFF,
+  0x7101A839, 0xDEB30C08, 0x9CE4B4D8, 0x90C15664, 0x6184CB7B, 0x70B632D5, 0x745C6C48, 0x4257B8D0
+};
+
 //
 // The round CONSTant word array, Rcon[i], contains the values given by
 // x to the power (i-1) being powers of x (x is denoted as {02}) in the field GF(2^8)
@@ -155,7 +222,6 @@ STATIC CONST UINT8 Rcon[11] = {
 // Private functions:
 //
 #define GetSboxValue(num) (Sbox[(num)])
-#define GetSBoxInvert(num) (RsBox[(num)])
 
 //
 // This function produces Nb(Nr+1) round keys. The round keys are used in each
@@ -165,15 +231,20 @@ STATIC
 VOID
 KeyExpansion (
   UINT8        *RoundKey,
-  CONST UINT8  *Key
+  CONST UINT8  *Key,
+  UINT32       KeySize
   )
 {
   UINT32 Index, J, K;
+  UINT32 Nk, Nr;
   //
   // Used for the column/row operations
   //
   UINT8 TempA[4];
 
+  Nk = KeySize / 4;
+  Nr = Nk + 6;
+
   //
   // The first round key is the key itself.
   //
@@ -234,8 +305,7 @@ KeyExpansion (
       TempA[0] = TempA[0] ^ Rcon[Index / Nk];
     }
 
-#if CONFIG_AES_KEY_SIZE == 32
-    if (Index % Nk == 4)
+    if (Nk > 6 && Index % Nk == 4)
     {
       //
       // Function Subword()
@@ -247,7 +317,6 @@ KeyExpansion (
         TempA[3] = GetSboxValue (TempA[3]);
       }
     }
-#endif
 
     J = Index * 4; K = (Index - Nk) * 4;
     RoundKey[J + 0] = RoundKey[K + 0] ^ TempA[0];
@@ -257,347 +326,483 @@ KeyExpansion (
   }
 }
 
+
+//
+// Load and store little endian words regardless of alignment.
+//
+#define AES_LOAD32(P) \
+  ((UINT32) (P)[0] | ((UINT32) (P)[1] << 8U) | ((UINT32) (P)[2] << 16U) | ((UINT32) (P)[3] << 24U))
+
+#define AES_STORE32(P, W)               \
+  do {                                  \
+    (P)[0] = (UINT8) (W);               \
+    (P)[1] = (UINT8) ((W) >> 8U);       \
+    (P)[2] = (UINT8) ((W) >> 16U);      \
+    (P)[3] = (UINT8) ((W) >> 24U);      \
+  } while (0)
+
+#define AES_ROTL(W, N) (((W) << (N)) | ((W) >> (32U - (N))))
+
+//
+// Output column of a full encryption round, B, C, D are the next columns
+// as chosen by ShiftRows.
+//
+#define AES_TE(A, B, C, D)                          \
+  (mAesTe[(A) & 0xFFU]                              \
+    ^ AES_ROTL (mAesTe[((B) >> 8U) & 0xFFU], 8U)    \
+    ^ AES_ROTL (mAesTe[((C) >> 16U) & 0xFFU], 16U)  \
+    ^ AES_ROTL (mAesTe[(D) >> 24U], 24U))
+
+#define AES_TD(A, B, C, D)                          \
+  (mAesTd[(A) & 0xFFU]                              \
+    ^ AES_ROTL (mAesTd[((B) >> 8U) & 0xFFU], 8U)    \
+    ^ AES_ROTL (mAesTd[((C) >> 16U) & 0xFFU], 16U)  \
+    ^ AES_ROTL (mAesTd[(D) >> 24U], 24U))
+
+//
+// Output column of the last round, which has no MixColumns.
+//
+#define AES_SB(Box, A, B, C, D)                     \
+  ((UINT32) Box[(A) & 0xFFU]                        \
+    | ((UINT32) Box[((B) >> 8U) & 0xFFU] << 8U)     \
+    | ((UINT32) Box[((C) >> 16U) & 0xFFU] << 16U)   \
+    | ((UINT32) Box[(D) >> 24U] << 24U))
+
+//
+// This function produces the decryption round keys of the equivalent
+// inverse cipher from the encryption round keys.
+//
+STATIC
 VOID
-AesInitCtxIv (
-  AES_CONTEXT  *Context,
-  CONST UINT8  *Key,
-  CONST UINT8  *Iv
+InvKeyExpansion (
+  UINT8        *InvRoundKey,
+  CONST UINT8  *RoundKey,
+  UINT32       Rounds
   )
 {
-  KeyExpansion (Context->RoundKey, Key);
-  CopyMem (Context->Iv, Iv, AES_BLOCK_SIZE);
+  UINT32  Round;
+  UINT32  Index;
+  UINT32  Word;
+
+  for (Round = 0; Round <= Rounds; ++Round) {
+    for (Index = 0; Index < Nb; ++Index) {
+      Word = AES_LOAD32 (&RoundKey[((Rounds - Round) * Nb + Index) * 4]);
+
+      //
+      // InvMixColumns is a decryption round without InvSubBytes, which
+      // Td tables undo by indexing with SubBytes output.
+      //
+      if (Round > 0 && Round < Rounds) {
+        Word = AES_TD (
+          (UINT32) Sbox[Word & 0xFFU],
+          (UINT32) Sbox[(Word >> 8U) & 0xFFU] << 8U,
+          (UINT32) Sbox[(Word >> 16U) & 0xFFU] << 16U,
+          (UINT32) Sbox[Word >> 24U] << 24U
+          );
+      }
+
+      AES_STORE32 (&InvRoundKey[(Round * Nb + Index) * 4], Word);
+    }
+  }
 }
 
+STATIC
 VOID
-AesCtxSetIv (
-  AES_CONTEXT  *Context,
-  CONST UINT8  *Iv
+InternalAesLoadRoundKey (
+  OUT UINT32       *Rk,
+  IN  CONST UINT8  *RoundKey,
+  IN  UINT32       Rounds
   )
 {
-  CopyMem (Context->Iv, Iv, AES_BLOCK_SIZE);
+  UINT32  Index;
+
+  for (Index = 0; Index < Nb * (Rounds + 1); ++Index) {
+    Rk[Index] = AES_LOAD32 (&RoundKey[Index * 4]);
+  }
 }
 
 //
-// This function adds the round key to state.
-// The round key is added to the state by an XOR function.
+// Full rounds from columns S to columns T with round key N.
+//
+#define AES_ENC_ROUND(N, S, T)                                  \
+  do {                                                          \
+    T##0 = AES_TE (S##0, S##1, S##2, S##3) ^ Rk[(N) * Nb + 0];  \
+    T##1 = AES_TE (S##1, S##2, S##3, S##0) ^ Rk[(N) * Nb + 1];  \
+    T##2 = AES_TE (S##2, S##3, S##0, S##1) ^ Rk[(N) * Nb + 2];  \
+    T##3 = AES_TE (S##3, S##0, S##1, S##2) ^ Rk[(N) * Nb + 3];  \
+  } while (0)
+
+#define AES_DEC_ROUND(N, S, T)                                  \
+  do {                                                          \
+    T##0 = AES_TD (S##0, S##3, S##2, S##1) ^ Dk[(N) * Nb + 0];  \
+    T##1 = AES_TD (S##1, S##0, S##3, S##2) ^ Dk[(N) * Nb + 1];  \
+    T##2 = AES_TD (S##2, S##1, S##0, S##3) ^ Dk[(N) * Nb + 2];  \
+    T##3 = AES_TD (S##3, S##2, S##1, S##0) ^ Dk[(N) * Nb + 3];  \
+  } while (0)
+
+//
+// Cipher encrypts a block of 4 columns in place.  Rounds are unrolled,
+// and the extra ones of longer keys disappear when Rounds is constant.
 //
 STATIC
 VOID
-AddRoundKey (
-  UINT8               Round,
-  AES_INTERNAL_STATE  *State,
-  CONST UINT8         *RoundKey
+Cipher (
+  IN OUT UINT32        *State,
+  IN     CONST UINT32  *Rk,
+  IN     UINT32        Rounds
   )
 {
-  UINT8  I, J;
+  UINT32  S0, S1, S2, S3;
+  UINT32  T0, T1, T2, T3;
+
+  S0 = State[0] ^ Rk[0];
+  S1 = State[1] ^ Rk[1];
+  S2 = State[2] ^ Rk[2];
+  S3 = State[3] ^ Rk[3];
+
+  AES_ENC_ROUND (1, S, T);
+  AES_ENC_ROUND (2, T, S);
+  AES_ENC_ROUND (3, S, T);
+  AES_ENC_ROUND (4, T, S);
+  AES_ENC_ROUND (5, S, T);
+  AES_ENC_ROUND (6, T, S);
+  AES_ENC_ROUND (7, S, T);
+  AES_ENC_ROUND (8, T, S);
+  AES_ENC_ROUND (9, S, T);
+
+  if (Rounds > 10) {
+    AES_ENC_ROUND (10, T, S);
+    AES_ENC_ROUND (11, S, T);
+  }
 
-  for (I = 0; I < 4; ++I)
-  {
-    for (J = 0; J < 4; ++J)
-    {
-      (*State)[I][J] ^= RoundKey[(Round * Nb * 4) + (I * Nb) + J];
-    }
+  if (Rounds > 12) {
+    AES_ENC_ROUND (12, T, S);
+    AES_ENC_ROUND (13, S, T);
   }
+
+  Rk += Rounds * Nb;
+  State[0] = AES_SB (Sbox, T0, T1, T2, T3) ^ Rk[0];
+  State[1] = AES_SB (Sbox, T1, T2, T3, T0) ^ Rk[1];
+  State[2] = AES_SB (Sbox, T2, T3, T0, T1) ^ Rk[2];
+  State[3] = AES_SB (Sbox, T3, T0, T1, T2) ^ Rk[3];
 }
 
 //
-// The SubBytes Function Substitutes the values in the
-// state matrix with values in an S-box.
+// InvCipher decrypts a block of 4 columns in place with the decryption
+// round keys.
 //
-STATIC 
+STATIC
 VOID
-SubBytes (
-  AES_INTERNAL_STATE  *State
+InvCipher (
+  IN OUT UINT32        *State,
+  IN     CONST UINT32  *Dk,
+  IN     UINT32        Rounds
   )
 {
-  UINT8  I, J;
+  UINT32  S0, S1, S2, S3;
+  UINT32  T0, T1, T2, T3;
+
+  S0 = State[0] ^ Dk[0];
+  S1 = State[1] ^ Dk[1];
+  S2 = State[2] ^ Dk[2];
+  S3 = State[3] ^ Dk[3];
+
+  AES_DEC_ROUND (1, S, T);
+  AES_DEC_ROUND (2, T, S);
+  AES_DEC_ROUND (3, S, T);
+  AES_DEC_ROUND (4, T, S);
+  AES_DEC_ROUND (5, S, T);
+  AES_DEC_ROUND (6, T, S);
+  AES_DEC_ROUND (7, S, T);
+  AES_DEC_ROUND (8, T, S);
+  AES_DEC_ROUND (9, S, T);
+
+  if (Rounds > 10) {
+    AES_DEC_ROUND (10, T, S);
+    AES_DEC_ROUND (11, S, T);
+  }
 
-  for (I = 0; I < 4; ++I)
-  {
-    for (J = 0; J < 4; ++J)
-    {
-      (*State)[J][I] = GetSboxValue((*State)[J][I]);
-    }
+  if (Rounds > 12) {
+    AES_DEC_ROUND (12, T, S);
+    AES_DEC_ROUND (13, S, T);
   }
+
+  Dk += Rounds * Nb;
+  State[0] = AES_SB (RsBox, T0, T3, T2, T1) ^ Dk[0];
+  State[1] = AES_SB (RsBox, T1, T0, T3, T2) ^ Dk[1];
+  State[2] = AES_SB (RsBox, T2, T1, T0, T3) ^ Dk[2];
+  State[3] = AES_SB (RsBox, T3, T2, T1, T0) ^ Dk[3];
 }
 
-//
-// The ShiftRows() function shifts the rows in the state to the left.
-// Each row is shifted with different offset.
-// Offset = Row number. So the first row is not shifted.
-//
-STATIC 
+STATIC
 VOID
-ShiftRows (
-  AES_INTERNAL_STATE  *State
+InternalAesCbcEncryptRounds (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks,
+  IN     UINT32       Rounds
   )
 {
-  UINT8  Temp;
+  UINT32  Rk[Nb * (AES_MAX_ROUNDS + 1)];
+  UINT32  State[Nb];
+  UINT32  Index;
 
-  //
-  // Rotate first row 1 columns to left
-  //
-  Temp           = (*State)[0][1];
-  (*State)[0][1] = (*State)[1][1];
-  (*State)[1][1] = (*State)[2][1];
-  (*State)[2][1] = (*State)[3][1];
-  (*State)[3][1] = Temp;
+  InternalAesLoadRoundKey (Rk, Context->RoundKey, Rounds);
 
-  //
-  // Rotate second row 2 columns to left
-  //
-  Temp           = (*State)[0][2];
-  (*State)[0][2] = (*State)[2][2];
-  (*State)[2][2] = Temp;
+  for (Index = 0; Index < Nb; ++Index) {
+    State[Index] = AES_LOAD32 (&Context->Iv[Index * 4]);
+  }
+
+  while (NumBlocks > 0) {
+    for (Index = 0; Index < Nb; ++Index) {
+      State[Index] ^= AES_LOAD32 (&Data[Index * 4]);
+    }
 
-  Temp           = (*State)[1][2];
-  (*State)[1][2] = (*State)[3][2];
-  (*State)[3][2] = Temp;
+    Cipher (State, Rk, Rounds);
+
+    for (Index = 0; Index < Nb; ++Index) {
+      AES_STORE32 (&Data[Index * 4], State[Index]);
+    }
+
+    Data += AES_BLOCK_SIZE;
+    --NumBlocks;
+  }
 
   //
-  // Rotate third row 3 columns to left
+  // Store Iv in Context for next call
   //
-  Temp           = (*State)[0][3];
-  (*State)[0][3] = (*State)[3][3];
-  (*State)[3][3] = (*State)[2][3];
-  (*State)[2][3] = (*State)[1][3];
-  (*State)[1][3] = Temp;
-}
-
-STATIC 
-UINT8
-XTime (
-  UINT8 X
-  )
-{
-  return (UINT8) (((UINT32) X << 1u) ^ ((((UINT32) X >> 7u) & 1u) * 0x1bu));
+  for (Index = 0; Index < Nb; ++Index) {
+    AES_STORE32 (&Context->Iv[Index * 4], State[Index]);
+  }
 }
 
-//
-// MixColumns function mixes the columns of the state matrix
-//
-STATIC 
+STATIC
 VOID
-MixColumns (
-  AES_INTERNAL_STATE  *State
+InternalAesCbcDecryptRounds (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks,
+  IN     UINT32       Rounds
   )
 {
-  UINT8  I, Tmp, Tm, T;
+  UINT32  Dk[Nb * (AES_MAX_ROUNDS + 1)];
+  UINT32  State[Nb];
+  UINT32  Iv[Nb];
+  UINT32  NextIv[Nb];
+  UINT32  Index;
 
-  for (I = 0; I < 4; ++I)
-  {
-    T   = (*State)[I][0];
-    Tmp = (UINT8) ((UINT32) ((*State) [I][0]) ^ (UINT32) ((*State) [I][1])
-          ^ (UINT32) ((*State) [I][2]) ^ (UINT32) ((*State) [I][3]));
-    Tm  = (*State) [I][0] ^ (*State) [I][1];
-    Tm = XTime (Tm);
-    (*State) [I][0] ^= Tm ^ Tmp;
-    Tm  = (*State)[I][1] ^ (*State)[I][2];
-    Tm = XTime (Tm);
-    (*State) [I][1] ^= Tm ^ Tmp;
-    Tm  = (*State) [I][2] ^ (*State) [I][3];
-    Tm = XTime (Tm);
-    (*State) [I][2] ^= Tm ^ Tmp;
-    Tm  = (*State)[I][3] ^ T ;
-    Tm = XTime (Tm);
-    (*State) [I][3] ^= Tm ^ Tmp ;
+  InternalAesLoadRoundKey (Dk, Context->InvRoundKey, Rounds);
+
+  for (Index = 0; Index < Nb; ++Index) {
+    Iv[Index] = AES_LOAD32 (&Context->Iv[Index * 4]);
   }
-}
 
-//
-// Multiply is used to multiply numbers in the field GF(2^8)
-// Note: The last call to XTime() is unneeded, but often ends up generating a smaller binary
-//       The compiler seems to be able to vectorize the operation better this way.
-//       See https://github.com/kokke/tiny-AES-c/pull/34
-//
-#define Multiply(x, y)                                    \
-      (   (((y) & 1u) * (x)) ^                            \
-      (((y)>>1u & 1u) * XTime(x)) ^                       \
-      (((y)>>2u & 1u) * XTime(XTime(x))) ^                \
-      (((y)>>3u & 1u) * XTime(XTime(XTime(x)))) ^         \
-      (((y)>>4u & 1u) * XTime(XTime(XTime(XTime(x))))))   \
+  while (NumBlocks > 0) {
+    for (Index = 0; Index < Nb; ++Index) {
+      NextIv[Index] = State[Index] = AES_LOAD32 (&Data[Index * 4]);
+    }
 
-//
-// MixColumns function mixes the columns of the state matrix.
-// The method used to multiply may be difficult to understand for the inexperienced.
-// Please use the references to gain more information.
-//
-STATIC 
-VOID
-InvMixColumns (
-  AES_INTERNAL_STATE  *State
-  )
-{
-  UINT8  I, A, B, C, D;
+    InvCipher (State, Dk, Rounds);
 
-  for (I = 0; I < 4; ++I)
-  {
-    A = (*State) [I][0];
-    B = (*State) [I][1];
-    C = (*State) [I][2];
-    D = (*State) [I][3];
-
-    (*State)[I][0] = (UINT8) ((UINT32) Multiply(A, 0x0eu) ^ (UINT32) Multiply(B, 0x0bu)
-                     ^ (UINT32) Multiply(C, 0x0du) ^ (UINT32) Multiply(D, 0x09u));
-    (*State)[I][1] = (UINT8) ((UINT32) Multiply(A, 0x09u) ^ (UINT32) Multiply(B, 0x0eu)
-                     ^ (UINT32) Multiply(C, 0x0bu) ^ (UINT32) Multiply(D, 0x0du));
-    (*State)[I][2] = (UINT8) ((UINT32) Multiply(A, 0x0du) ^ (UINT32) Multiply(B, 0x09u)
-                     ^ (UINT32) Multiply(C, 0x0eu) ^ (UINT32) Multiply(D, 0x0bu));
-    (*State)[I][3] = (UINT8) ((UINT32) Multiply(A, 0x0bu) ^ (UINT32) Multiply(B, 0x0du)
-                     ^ (UINT32) Multiply(C, 0x09u) ^ (UINT32) Multiply(D, 0x0eu));
+    for (Index = 0; Index < Nb; ++Index) {
+      AES_STORE32 (&Data[Index * 4], State[Index] ^ Iv[Index]);
+      Iv[Index] = NextIv[Index];
+    }
+
+    Data += AES_BLOCK_SIZE;
+    --NumBlocks;
+  }
+
+  for (Index = 0; Index < Nb; ++Index) {
+    AES_STORE32 (&Context->Iv[Index * 4], Iv[Index]);
   }
 }
 
-//
-// The SubBytes Function Substitutes the values in the
-// state matrix with values in an S-box.
-//
 STATIC
 VOID
-InvSubBytes (
-  AES_INTERNAL_STATE  *State
+InternalAesCtrXcryptRounds (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks,
+  IN     UINT32       Rounds
   )
 {
-  UINT8  I, J;
+  UINT32  Rk[Nb * (AES_MAX_ROUNDS + 1)];
+  UINT32  State[Nb];
+  UINT32  Index;
+  INT32   Bi;
 
-  for (I = 0; I < 4; ++I)
-  {
-    for (J = 0; J < 4; ++J)
-    {
-      (*State)[J][I] = GetSBoxInvert ((*State)[J][I]);
+  InternalAesLoadRoundKey (Rk, Context->RoundKey, Rounds);
+
+  while (NumBlocks > 0) {
+    for (Index = 0; Index < Nb; ++Index) {
+      State[Index] = AES_LOAD32 (&Context->Iv[Index * 4]);
+    }
+
+    Cipher (State, Rk, Rounds);
+
+    for (Index = 0; Index < Nb; ++Index) {
+      AES_STORE32 (&Data[Index * 4], AES_LOAD32 (&Data[Index * 4]) ^ State[Index]);
+    }
+
+    //
+    // Increment Iv and handle overflow
+    //
+    for (Bi = (AES_BLOCK_SIZE - 1); Bi >= 0; --Bi) {
+      if (++Context->Iv[Bi] != 0) {
+        break;
+      }
     }
+
+    Data += AES_BLOCK_SIZE;
+    --NumBlocks;
   }
 }
 
 STATIC
+OC_CRYPTO_FLATTEN
 VOID
-InvShiftRows (
-  AES_INTERNAL_STATE  *State
+InternalAesCbcEncryptGeneric (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
   )
 {
-  UINT8  Temp;
-
-  //
-  // Rotate first row 1 columns to right
-  //
-  Temp = (*State)[3][1];
-  (*State)[3][1] = (*State)[2][1];
-  (*State)[2][1] = (*State)[1][1];
-  (*State)[1][1] = (*State)[0][1];
-  (*State)[0][1] = Temp;
-
-  //
-  // Rotate second row 2 columns to right
-  //
-  Temp = (*State)[0][2];
-  (*State)[0][2] = (*State)[2][2];
-  (*State)[2][2] = Temp;
+  AES_DISPATCH_ROUNDS (InternalAesCbcEncryptRounds, Context, Data, NumBlocks);
+}
 
-  Temp = (*State)[1][2];
-  (*State)[1][2] = (*State)[3][2];
-  (*State)[3][2] = Temp;
+STATIC
+OC_CRYPTO_FLATTEN
+VOID
+InternalAesCbcDecryptGeneric (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  AES_DISPATCH_ROUNDS (InternalAesCbcDecryptRounds, Context, Data, NumBlocks);
+}
 
-  //
-  // Rotate third row 3 columns to right
-  //
-  Temp = (*State)[0][3];
-  (*State)[0][3] = (*State)[1][3];
-  (*State)[1][3] = (*State)[2][3];
-  (*State)[2][3] = (*State)[3][3];
-  (*State)[3][3] = Temp;
+STATIC
+OC_CRYPTO_FLATTEN
+VOID
+InternalAesCtrXcryptGeneric (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  AES_DISPATCH_ROUNDS (InternalAesCtrXcryptRounds, Context, Data, NumBlocks);
 }
 
 //
-// Cipher is the main function that encrypts the PlainText.
+// Selected implementation, chosen on first use unless set by AesSetBackend.
 //
+STATIC AES_MODE     mAesCbcEncrypt;
+STATIC AES_MODE     mAesCbcDecrypt;
+STATIC AES_MODE     mAesCtrXcrypt;
+STATIC AES_BACKEND  mAesBackend;
+
+/**
+  Return whether the CPU supports AES backend.
+**/
 STATIC
-VOID
-Cipher (
-  AES_INTERNAL_STATE  *State,
-  UINT8               *RoundKey
+BOOLEAN
+InternalAesIsSupported (
+  IN AES_BACKEND  Backend
   )
 {
-  UINT8  Round;
+#if defined (MDE_CPU_X64)
+  UINT32  RegEcx;
 
-  //
-  // Add the First round key to the state before starting the rounds.
-  //
-  AddRoundKey(0, State, RoundKey);
+  if (Backend == AesBackendAesNi) {
+    //
+    // Counter byte swapping needs SSSE3, which every AES-NI CPU has.
+    //
+    AsmCpuid (1, NULL, NULL, &RegEcx, NULL);
+    return (RegEcx & (BIT9 | BIT25)) == (BIT9 | BIT25);
+  }
+#endif
 
-  //
-  // There will be Nr rounds.
-  // The first Nr-1 rounds are identical.
-  // These Nr-1 rounds are executed in the loop below.
-  //
-  for (Round = 1; Round < Nr; ++Round)
-  {
-    SubBytes (State);
-    ShiftRows (State);
-    MixColumns (State);
-    AddRoundKey (Round, State, RoundKey);
+  return Backend == AesBackendGeneric;
+}
+
+BOOLEAN
+AesSetBackend (
+  AES_BACKEND  Backend
+  )
+{
+  if (Backend == AesBackendAuto) {
+    //
+    // Backends are ordered by speed, generic one is always supported.
+    //
+    Backend = AesBackendAesNi;
+    while (!InternalAesIsSupported (Backend)) {
+      Backend = (AES_BACKEND) (Backend - 1);
+    }
+  } else if (!InternalAesIsSupported (Backend)) {
+    return FALSE;
   }
 
-  //
-  // The last round is given below.
-  // The MixColumns function is not here in the last round.
-  //
-  SubBytes (State);
-  ShiftRows (State);
-  AddRoundKey (Nr, State, RoundKey);
+  switch (Backend) {
+#if defined (MDE_CPU_X64)
+    case AesBackendAesNi:
+      mAesCbcEncrypt = InternalAesCbcEncryptAesNi;
+      mAesCbcDecrypt = InternalAesCbcDecryptAesNi;
+      mAesCtrXcrypt  = InternalAesCtrXcryptAesNi;
+      break;
+#endif
+    default:
+      mAesCbcEncrypt = InternalAesCbcEncryptGeneric;
+      mAesCbcDecrypt = InternalAesCbcDecryptGeneric;
+      mAesCtrXcrypt  = InternalAesCtrXcryptGeneric;
+      break;
+  }
+
+  mAesBackend = Backend;
+  return TRUE;
 }
 
-STATIC
-VOID
-InvCipher (
-  AES_INTERNAL_STATE  *State,
-  UINT8               *RoundKey
+AES_BACKEND
+AesGetBackend (
+  VOID
   )
 {
-  UINT8  Round;
+  if (mAesCbcEncrypt == NULL) {
+    AesSetBackend (AesBackendAuto);
+  }
 
-  //
-  // Add the First round key to the state before starting the rounds.
-  //
-  AddRoundKey (Nr, State, RoundKey);
+  return mAesBackend;
+}
 
-  //
-  // There will be Nr rounds.
-  // The first Nr-1 rounds are identical.
-  // These Nr-1 rounds are executed in the loop below.
-  //
-  for (Round = (Nr - 1); Round > 0; --Round)
-  {
-    InvShiftRows (State);
-    InvSubBytes (State);
-    AddRoundKey (Round, State, RoundKey);
-    InvMixColumns (State);
+BOOLEAN
+AesInitCtxIv (
+  AES_CONTEXT  *Context,
+  CONST UINT8  *Key,
+  UINT32       KeySize,
+  CONST UINT8  *Iv
+  )
+{
+  if (KeySize != AES_128_KEY_SIZE
+    && KeySize != AES_192_KEY_SIZE
+    && KeySize != AES_256_KEY_SIZE) {
+    return FALSE;
   }
 
-  //
-  // The last round is given below.
-  // The MixColumns function is not here in the last round.
-  //
-  InvShiftRows (State);
-  InvSubBytes (State);
-  AddRoundKey (0, State, RoundKey);
+  Context->Rounds = KeySize / 4 + 6;
+  KeyExpansion (Context->RoundKey, Key, KeySize);
+  InvKeyExpansion (Context->InvRoundKey, Context->RoundKey, Context->Rounds);
+  CopyMem (Context->Iv, Iv, AES_BLOCK_SIZE);
+  return TRUE;
 }
 
-STATIC
 VOID
-XorWithIv (
-  UINT8       *Buf,
-  CONST UINT8 *Iv
+AesSetCtxIv (
+  AES_CONTEXT  *Context,
+  CONST UINT8  *Iv
   )
 {
-  UINT8  I;
-
-  //
-  // The block in AES is always 128bit no matter the key size
-  //
-  for (I = 0; I < AES_BLOCK_SIZE; ++I)
-  {
-    Buf[I] ^= Iv[I];
-  }
+  CopyMem (Context->Iv, Iv, AES_BLOCK_SIZE);
 }
 
 //
@@ -611,21 +816,11 @@ AesCbcEncryptBuffer (
   UINT32       Len
   )
 {
-  UINT32  I;
-  UINT8   *Iv = Context->Iv;
-
-  for (I = 0; I < Len; I += AES_BLOCK_SIZE)
-  {
-    XorWithIv (Data, Iv);
-    Cipher ((AES_INTERNAL_STATE *) Data, Context->RoundKey);
-    Iv = Data;
-    Data += AES_BLOCK_SIZE;
+  if (mAesCbcEncrypt == NULL) {
+    AesSetBackend (AesBackendAuto);
   }
 
-  //
-  // Store Iv in Context for next call
-  //
-  CopyMem (Context->Iv, Iv, AES_BLOCK_SIZE);
+  mAesCbcEncrypt (Context, Data, Len / AES_BLOCK_SIZE);
 }
 
 VOID
@@ -635,18 +830,11 @@ AESCbcDecryptBuffer (
   UINT32       Len
   )
 {
-  UINT32  I;
-  UINT8   StoreNextIv[AES_BLOCK_SIZE];
-
-  for (I = 0; I < Len; I += AES_BLOCK_SIZE)
-  {
-    CopyMem (StoreNextIv, Data, AES_BLOCK_SIZE);
-    InvCipher ((AES_INTERNAL_STATE *) Data, Context->RoundKey);
-    XorWithIv (Data, Context->Iv);
-    CopyMem (Context->Iv, StoreNextIv, AES_BLOCK_SIZE);
-    Data += AES_BLOCK_SIZE;
+  if (mAesCbcDecrypt == NULL) {
+    AesSetBackend (AesBackendAuto);
   }
 
+  mAesCbcDecrypt (Context, Data, Len / AES_BLOCK_SIZE);
 }
 
 //
@@ -660,42 +848,27 @@ AesCtrXcryptBuffer (
   UINT32       Len
   )
 {
-  UINT8  Buffer[AES_BLOCK_SIZE];
-  UINT32 I;
-  INT32  Bi;
+  UINT8   Buffer[AES_BLOCK_SIZE];
+  UINT32  NumBlocks;
+  UINT32  Remainder;
 
-  for (I = 0, Bi = AES_BLOCK_SIZE; I < Len; ++I, ++Bi)
-  {
-    //
-    // We need to regen xor compliment in buffer
-    //
-    if (Bi == AES_BLOCK_SIZE)
-    {
+  if (mAesCtrXcrypt == NULL) {
+    AesSetBackend (AesBackendAuto);
+  }
 
-      CopyMem (Buffer, Context->Iv, AES_BLOCK_SIZE);
-      Cipher ((AES_INTERNAL_STATE *) Buffer, Context->RoundKey);
+  NumBlocks = Len / AES_BLOCK_SIZE;
+  Remainder = Len % AES_BLOCK_SIZE;
 
-      //
-      // Increment Iv and handle overflow
-      //
-      for (Bi = (AES_BLOCK_SIZE - 1); Bi >= 0; --Bi)
-      {
-        //
-        // Inc will owerflow
-        //
-        if (Context->Iv[Bi] == 255)
-        {
-          Context->Iv[Bi] = 0;
-          continue;
-        }
-
-        Context->Iv[Bi] += 1;
-        break;
-      }
-
-      Bi = 0;
-    }
+  mAesCtrXcrypt (Context, Data, NumBlocks);
 
-    Data[I] = (Data[I] ^ Buffer[Bi]);
+  //
+  // Trailing partial block uses the start of the next key stream block.
+  //
+  if (Remainder > 0) {
+    Data += NumBlocks * AES_BLOCK_SIZE;
+    ZeroMem (Buffer, sizeof (Buffer));
+    CopyMem (Buffer, Data, Remainder);
+    mAesCtrXcrypt (Context, Buffer, 1);
+    CopyMem (Data, Buffer, Remainder);
   }
 }
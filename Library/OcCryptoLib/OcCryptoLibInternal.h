@@ -0,0 +1,185 @@
+/** @file
+
+OcCryptoLib
+
+Copyright (c) 2019, vit9696
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef OC_CRYPTO_LIB_INTERNAL_H
+#define OC_CRYPTO_LIB_INTERNAL_H
+
+//
+// Enable instruction set extensions for a single function, so that the
+// rest of the library stays buildable for any X64 CPU.  MSVC permits
+// intrinsics without this.
+//
+#if defined (__GNUC__) || defined (__clang__)
+#define OC_CRYPTO_TARGET(Features) __attribute__ ((target (Features)))
+#else
+#define OC_CRYPTO_TARGET(Features)
+#endif
+
+//
+// Inline every call made by a function, so that constant arguments are
+// propagated through its callees.
+//
+#if defined (__GNUC__) || defined (__clang__)
+#define OC_CRYPTO_FLATTEN __attribute__ ((flatten))
+#else
+#define OC_CRYPTO_FLATTEN
+#endif
+
+#define SHA256_BLOCK_SIZE  64
+
+#define AES_MAX_ROUNDS  14
+
+//
+// Call Function with the round count of Context as a constant.  Callers
+// are flattened, so that every key size gets its own specialised copy.
+//
+#define AES_DISPATCH_ROUNDS(Function, Context, Data, NumBlocks)  \
+  do {                                                         \
+    switch ((Context)->Rounds) {                               \
+      case 10:                                                 \
+        Function ((Context), (Data), (NumBlocks), 10);         \
+        break;                                                 \
+      case 12:                                                 \
+        Function ((Context), (Data), (NumBlocks), 12);         \
+        break;                                                 \
+      default:                                                 \
+        Function ((Context), (Data), (NumBlocks), 14);         \
+        break;                                                 \
+    }                                                          \
+  } while (0)
+
+//
+// Process NumBlocks 16-byte blocks of Data in place, updating Context->Iv.
+//
+typedef
+VOID
+(*AES_MODE) (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  );
+
+//
+// Transform NumBlocks consecutive 64-byte blocks of Data into State.
+//
+typedef
+VOID
+(*SHA256_TRANSFORM) (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  );
+
+//
+// Transform NumBlocks blocks of every lane in Data into word-major State,
+// i.e. State[Word * Lanes + Lane].
+//
+typedef
+VOID
+(*SHA256_MULTI_TRANSFORM) (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  **Data,
+  IN     UINTN        NumBlocks
+  );
+
+//
+// SHA-256 round constants.
+//
+extern CONST UINT32 gSha256K[64];
+
+/**
+  Perform 64 SHA-256 rounds on State.
+
+  @param[in,out] State  SHA-256 state.
+  @param[in]     Wk     Message schedule with round constants added.
+**/
+VOID
+InternalSha256Rounds (
+  IN OUT UINT32        *State,
+  IN     CONST UINT32  *Wk
+  );
+
+#if defined (MDE_CPU_X64)
+
+/**
+  Return whether the CPU and the firmware or OS enable AVX state.
+**/
+BOOLEAN
+InternalCpuHasAvxState (
+  VOID
+  );
+
+VOID
+InternalSha256TransformSsse3 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalSha256TransformAvx2 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalSha256TransformShaNi (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalSha256TransformSsse3x4 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  **Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalSha256TransformAvx2x8 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  **Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalAesCbcEncryptAesNi (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalAesCbcDecryptAesNi (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  );
+
+VOID
+InternalAesCtrXcryptAesNi (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  );
+
+#endif
+
+#endif // OC_CRYPTO_LIB_INTERNAL_H
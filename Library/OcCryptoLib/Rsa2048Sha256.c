@@ -25,9 +25,12 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
   for computation.
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/OcCryptoLib.h>
 
+#include "OcCryptoLibInternal.h"
+
 /**
   PKCS#1 padding (from the RSA PKCS#1 v2.1 standard)
 
@@ -42,7 +45,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
   PS: octet string consisting of {Length(RSA Key) - Length(T) - 3} 0xFF
  **/
-#define PKCS_PAD_SIZE (RSANUMBYTES - SHA256_DIGEST_SIZE)
+#define PKCS_PAD_SIZE(NumBytes) ((NumBytes) - SHA256_DIGEST_SIZE)
 
 STATIC  UINT8 mSha256Tail[] = {
   0x00, 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60,
@@ -80,22 +83,113 @@ Mulaa32 (
   return Ret;
 }
 
+//
+// Montgomery arithmetic works on limbs of the native word size, halving
+// the number of multiply-accumulate steps on X64.  Key values are stored
+// as little endian 32-bit words with no alignment guarantee, so they are
+// loaded into aligned limb arrays before use.
+//
+#if defined (MDE_CPU_X64)
+typedef UINT64 RSA_LIMB;
+#define RSA_READ_LIMB(Ptr) ReadUnaligned64 ((CONST UINT64 *) (Ptr))
+#if defined (_MSC_VER)
+UINT64 _umul128 (UINT64 A, UINT64 B, UINT64 *High);
+#pragma intrinsic (_umul128)
+#endif
+#else
+typedef UINT32 RSA_LIMB;
+#define RSA_READ_LIMB(Ptr) ReadUnaligned32 ((CONST UINT32 *) (Ptr))
+#endif
+
+#define RSA_NUM_LIMBS(NumBytes) ((NumBytes) / sizeof (RSA_LIMB))
+
+//
+// Return low limb of A * B + C + D, which cannot overflow double limb.
+//
+STATIC
+RSA_LIMB
+MulaaLimb (
+  IN  RSA_LIMB  A,
+  IN  RSA_LIMB  B,
+  IN  RSA_LIMB  C,
+  IN  RSA_LIMB  D,
+  OUT RSA_LIMB  *High
+  )
+{
+#if defined (MDE_CPU_X64) && defined (_MSC_VER)
+  UINT64  Low;
+  UINT64  Hi;
+
+  Low = _umul128 (A, B, &Hi);
+  Low += C;
+  Hi  += Low < C;
+  Low += D;
+  Hi  += Low < D;
+  *High = Hi;
+  return Low;
+#elif defined (MDE_CPU_X64)
+  unsigned __int128  Ret;
+
+  Ret   = (unsigned __int128) A * B + C + D;
+  *High = (UINT64) (Ret >> 64U);
+  return (UINT64) Ret;
+#else
+  UINT64  Ret;
+
+  Ret   = Mulaa32 (A, B, C, D);
+  *High = (UINT32) (Ret >> 32U);
+  return (UINT32) Ret;
+#endif
+}
+
+//
+// Return -N^-1 mod limb base.
+//
+STATIC
+RSA_LIMB
+GetN0Inv (
+  RSA_PUBLIC_KEY  *Key,
+  CONST RSA_LIMB  *N
+  )
+{
+#if defined (MDE_CPU_X64)
+  UINT64  Inv;
+
+  //
+  // Lift N^-1 mod 2^32 to 2^64 with a Newton iteration.
+  //
+  Inv = (UINT32) (0U - Key->N0Inv);
+  Inv *= 2 - N[0] * Inv;
+  return 0 - Inv;
+#else
+  (VOID) N;
+  return Key->N0Inv;
+#endif
+}
+
 //
 //  A[] -= Mod
 //
 STATIC
 VOID
 SubMod (
-  RSA_PUBLIC_KEY  *Key,
-  UINT32          *A
+  CONST RSA_LIMB  *N,
+  UINT32          NumLimbs,
+  RSA_LIMB        *A
   )
 {
-  INT64  B     = 0;
-  UINT32 Index = 0;
-  for (Index = 0; Index < RSANUMWORDS; ++Index) {
-    B += (UINT64) A[Index] - Key->N[Index];
-    A[Index] = (UINT32) B;
-    B >>= 32;
+  RSA_LIMB  Borrow;
+  RSA_LIMB  NewBorrow;
+  RSA_LIMB  Diff;
+  UINT32    Index;
+
+  Borrow = 0;
+  for (Index = 0; Index < NumLimbs; ++Index) {
+    Diff      = A[Index] - N[Index];
+    NewBorrow = A[Index] < N[Index];
+    NewBorrow |= Diff < Borrow;
+    A[Index]  = Diff - Borrow;
+    Borrow    = NewBorrow;
   }
 }
 
@@ -105,17 +199,18 @@ SubMod (
 STATIC
 INT32
 GeMod (
-  RSA_PUBLIC_KEY  *Key,
-  CONST UINT32    *A
+  CONST RSA_LIMB  *N,
+  UINT32          NumLimbs,
+  CONST RSA_LIMB  *A
   )
 {
   UINT32 Index = 0;
 
-  for (Index = RSANUMWORDS; Index;) {
+  for (Index = NumLimbs; Index;) {
     --Index;
-    if (A[Index] < Key->N[Index])
+    if (A[Index] < N[Index])
       return 0;
-    if (A[Index] > Key->N[Index])
+    if (A[Index] > N[Index])
       return 1;
   }
   return 1;
@@ -127,30 +222,33 @@ GeMod (
 STATIC
 VOID
 MontMulAdd (
-  RSA_PUBLIC_KEY  *Key,
-  UINT32          *C,
-  UINT32          Aa,
-  UINT32          *Bb
+  CONST RSA_LIMB  *N,
+  UINT32          NumLimbs,
+  RSA_LIMB        N0Inv,
+  RSA_LIMB        *C,
+  RSA_LIMB        Aa,
+  CONST RSA_LIMB  *Bb
   )
 {
-  UINT64 A,B;
-  UINT32 D0, Index;
-
-  A = Mula32 (Aa, Bb[0], C[0]);
-  D0 = (UINT32) A * Key->N0Inv;
-  B = Mula32 (D0, Key->N[0], (UINT32) A);
-
-  for (Index = 1; Index < RSANUMWORDS; ++Index) {
-    A = Mulaa32 (Aa, Bb[Index], C[Index], (UINT32) (A >> 32));
-    B = Mulaa32 (D0, Key->N[Index], (UINT32) A, (UINT32) (B >> 32));
-    C[Index - 1] = (UINT32) B;
+  RSA_LIMB  A;
+  RSA_LIMB  CarryA;
+  RSA_LIMB  CarryB;
+  RSA_LIMB  D0;
+  UINT32    Index;
+
+  A  = MulaaLimb (Aa, Bb[0], C[0], 0, &CarryA);
+  D0 = A * N0Inv;
+  MulaaLimb (D0, N[0], A, 0, &CarryB);
+
+  for (Index = 1; Index < NumLimbs; ++Index) {
+    A = MulaaLimb (Aa, Bb[Index], C[Index], CarryA, &CarryA);
+    C[Index - 1] = MulaaLimb (D0, N[Index], A, CarryB, &CarryB);
   }
 
-  A = (A >> 32) + (B >> 32);
-  C[Index - 1] = (UINT32) A;
+  C[Index - 1] = CarryA + CarryB;
 
-  if (A >> 32) {
-    SubMod (Key, C);
+  if (C[Index - 1] < CarryA) {
+    SubMod (N, NumLimbs, C);
   }
 }
 
@@ -160,18 +258,20 @@ MontMulAdd (
 STATIC
 VOID
 MontMul (
-  RSA_PUBLIC_KEY  *Key,
-  UINT32          *C,
-  UINT32          *A,
-  UINT32          *B
+  CONST RSA_LIMB  *N,
+  UINT32          NumLimbs,
+  RSA_LIMB        N0Inv,
+  RSA_LIMB        *C,
+  CONST RSA_LIMB  *A,
+  CONST RSA_LIMB  *B
   )
 {
   UINT32 Index;
 
-  ZeroMem (C, RSANUMBYTES);
+  ZeroMem (C, NumLimbs * sizeof (RSA_LIMB));
 
-  for (Index = 0; Index < RSANUMWORDS; ++Index)
-    MontMulAdd (Key, C, A[Index], B);
+  for (Index = 0; Index < NumLimbs; ++Index)
+    MontMulAdd (N, NumLimbs, N0Inv, C, A[Index], B);
 }
 
 /**
@@ -179,28 +279,47 @@ MontMul (
   Exponent depends on the configuration (65537 (default), or 3).
 
   @param Key        Key to use in signing
+  @param NumBytes   Key size in bytes, must match Key
   @param InOut      Input and output big-endian byte array
-  @param Workbuf32  Work buffer; caller must verify this is
-                    3 x RSANUMWORDS elements long.
+  @param Workbuf64  Work buffer; caller must verify this is
+                    3 x Key->Size 32-bit words long.
  **/
 STATIC
 VOID
 ModPow (
   RSA_PUBLIC_KEY  *Key,
+  UINT32          NumBytes,
   UINT8           *InOut,
-  UINT32          *Workbuf32
+  UINT64          *Workbuf64
   )
 {
-  UINT32 *A     = NULL;
-  UINT32 *Ar    = NULL;
-  UINT32 *Aar   = NULL;
-  UINT32 *Aaa   = NULL;
-  INT32  Index  = 0;
-  UINT32 Tmp    = 0;
+  RSA_LIMB       N[RSA_NUM_LIMBS (RSANUMBYTES)];
+  RSA_LIMB       Rr[RSA_NUM_LIMBS (RSANUMBYTES)];
+  RSA_LIMB       N0Inv  = 0;
+  RSA_LIMB       *A     = NULL;
+  RSA_LIMB       *Ar    = NULL;
+  RSA_LIMB       *Aar   = NULL;
+  RSA_LIMB       *Aaa   = NULL;
+  INT32          Index  = 0;
+  UINT32         Byte   = 0;
+  RSA_LIMB       Tmp    = 0;
+  UINT32         NumLimbs;
+
+  NumLimbs = (UINT32) RSA_NUM_LIMBS (NumBytes);
+
+  //
+  // Load N and R^2 mod N into aligned limbs, key data may be unaligned.
+  //
+  for (Index = 0; Index < (INT32) NumLimbs; ++Index) {
+    N[Index]  = RSA_READ_LIMB (&Key->Data[Index * (sizeof (RSA_LIMB) / sizeof (UINT32))]);
+    Rr[Index] = RSA_READ_LIMB (&Key->Data[Key->Size + Index * (sizeof (RSA_LIMB) / sizeof (UINT32))]);
+  }
+
+  N0Inv = GetN0Inv (Key, N);
 
-  A = Workbuf32;
-  Ar = A + RSANUMWORDS;
-  Aar = Ar + RSANUMWORDS;
+  A = (RSA_LIMB *) Workbuf64;
+  Ar = A + NumLimbs;
+  Aar = Ar + NumLimbs;
 
   //
   // Re-use location
@@ -208,54 +327,100 @@ ModPow (
   Aaa = Aar;
 
   //
-  // Convert from big endian byte array to little endian word array
+  // Convert from big endian byte array to little endian limb array
   //
-  for (Index = 0; Index < (INT32) RSANUMWORDS; ++Index) {
-    Tmp =
-      (InOut[((RSANUMWORDS - 1 - Index) * 4) + 0] << 24) |
-      (InOut[((RSANUMWORDS - 1 - Index) * 4) + 1] << 16) |
-      (InOut[((RSANUMWORDS - 1 - Index) * 4) + 2] << 8) |
-      (InOut[((RSANUMWORDS - 1 - Index) * 4) + 3] << 0);
+  for (Index = 0; Index < (INT32) NumLimbs; ++Index) {
+    Tmp = 0;
+    for (Byte = 0; Byte < sizeof (RSA_LIMB); ++Byte) {
+      Tmp = (Tmp << 8U) | InOut[(NumLimbs - 1 - Index) * sizeof (RSA_LIMB) + Byte];
+    }
     A[Index] = Tmp;
   }
 
-  MontMul (Key, Ar, A, Key->Rr);
+  MontMul (N, NumLimbs, N0Inv, Ar, A, Rr);
   //
   // Exponent 65537
   //
   for (Index = 0; Index < 16; Index += 2) {
-    MontMul (Key, Aar, Ar, Ar);
-    MontMul (Key, Ar, Aar, Aar);
+    MontMul (N, NumLimbs, N0Inv, Aar, Ar, Ar);
+    MontMul (N, NumLimbs, N0Inv, Ar, Aar, Aar);
   }
-  MontMul (Key, Aaa, Ar, A);
+  MontMul (N, NumLimbs, N0Inv, Aaa, Ar, A);
 
-  if (GeMod (Key, Aaa)){
-    SubMod (Key, Aaa);
+  if (GeMod (N, NumLimbs, Aaa)){
+    SubMod (N, NumLimbs, Aaa);
   }
 
   //
   // Convert to bigendian byte array
   //
-  for (Index = (INT32) RSANUMWORDS - 1; Index >= 0; --Index) {
+  for (Index = (INT32) NumLimbs - 1; Index >= 0; --Index) {
     Tmp = Aaa[Index];
 
-    *InOut++ = (UINT8) (Tmp >> 24);
-    *InOut++ = (UINT8) (Tmp >> 16);
-    *InOut++ = (UINT8) (Tmp >>  8);
-    *InOut++ = (UINT8) (Tmp >>  0);
+    for (Byte = sizeof (RSA_LIMB); Byte > 0; --Byte) {
+      *InOut++ = (UINT8) (Tmp >> ((Byte - 1) * 8U));
+    }
   }
 }
 
+//
+// ModPow specialised for every supported key size, with the Montgomery
+// arithmetic inlined so that loop bounds are constant.
+//
+#if CONFIG_RSA_MAX_KEY_SIZE >= 2048
+STATIC
+OC_CRYPTO_FLATTEN
+VOID
+ModPow2048 (
+  RSA_PUBLIC_KEY  *Key,
+  UINT8           *InOut,
+  UINT64          *Workbuf64
+  )
+{
+  ModPow (Key, 2048 / 8, InOut, Workbuf64);
+}
+#endif
+
+#if CONFIG_RSA_MAX_KEY_SIZE >= 3072
+STATIC
+OC_CRYPTO_FLATTEN
+VOID
+ModPow3072 (
+  RSA_PUBLIC_KEY  *Key,
+  UINT8           *InOut,
+  UINT64          *Workbuf64
+  )
+{
+  ModPow (Key, 3072 / 8, InOut, Workbuf64);
+}
+#endif
+
+#if CONFIG_RSA_MAX_KEY_SIZE >= 4096
+STATIC
+OC_CRYPTO_FLATTEN
+VOID
+ModPow4096 (
+  RSA_PUBLIC_KEY  *Key,
+  UINT8           *InOut,
+  UINT64          *Workbuf64
+  )
+{
+  ModPow (Key, 4096 / 8, InOut, Workbuf64);
+}
+#endif
+
 /**
  * Check PKCS#1 padding bytes
  *
- * @param sig  Signature to verify
+ * @param sig       Signature to verify
+ * @param NumBytes  Signature size
  * @return 0 if the padding is correct.
  */
 STATIC
 INT32
 CheckPadding (
-  UINT8  *Sig
+  UINT8   *Sig,
+  UINT32  NumBytes
   )
 {
   UINT8   *Ptr   = NULL;
@@ -271,7 +436,7 @@ CheckPadding (
   //
   // Then 0xff bytes until the tail
   //
-  for (Index = 0; Index < PKCS_PAD_SIZE - sizeof (mSha256Tail) - 2; Index++)
+  for (Index = 0; Index < PKCS_PAD_SIZE (NumBytes) - sizeof (mSha256Tail) - 2; Index++)
     Result |= *Ptr++ ^ 0xff;
   //
   // Check the tail
@@ -284,44 +449,70 @@ CheckPadding (
   Verify a SHA256WithRSA PKCS#1 v1.5 signature against an expected
   SHA256 hash.
 
-  @param Key         RSA public key
-  @param Signature   RSA signature
-  @param Sha256      SHA-256 digest of the content to verify
-  @param Workbuf32   Work buffer; caller must verify this is
-                     3 x RSANUMWORDS elements long.
+  @param Key            RSA public key
+  @param Signature      RSA signature
+  @param SignatureSize  RSA signature size, must match key size
+  @param Sha256         SHA-256 digest of the content to verify
+  @param Workbuf64      Work buffer; caller must verify this is
+                        3 x Key->Size 32-bit words long.
   @return FALSE on failure, TRUE on success.
  **/
 BOOLEAN
 RsaVerify (
   RSA_PUBLIC_KEY  *Key,
   UINT8           *Signature,
+  UINTN           SignatureSize,
   UINT8           *Sha256,
-  UINT32          *Workbuf32
+  UINT64          *Workbuf64
   )
 {
-  UINT8 Buf[RSANUMBYTES];
+  UINT8   Buf[RSANUMBYTES];
+  UINT32  NumBytes;
+
+  NumBytes = Key->Size * sizeof (UINT32);
+  if (SignatureSize != NumBytes) {
+    return FALSE;
+  }
 
   //
   // Copy input to local workspace
   //
-  CopyMem (Buf, Signature, RSANUMBYTES);
+  CopyMem (Buf, Signature, NumBytes);
 
   //
-  // In-place exponentiation
+  // In-place exponentiation.
   //
-  ModPow (Key, Buf, Workbuf32);
+  switch (NumBytes) {
+#if CONFIG_RSA_MAX_KEY_SIZE >= 2048
+    case 2048 / 8:
+      ModPow2048 (Key, Buf, Workbuf64);
+      break;
+#endif
+#if CONFIG_RSA_MAX_KEY_SIZE >= 3072
+    case 3072 / 8:
+      ModPow3072 (Key, Buf, Workbuf64);
+      break;
+#endif
+#if CONFIG_RSA_MAX_KEY_SIZE >= 4096
+    case 4096 / 8:
+      ModPow4096 (Key, Buf, Workbuf64);
+      break;
+#endif
+    default:
+      return FALSE;
+  }
 
   //
   // Check the PKCS#1 padding
   //
-  if (CheckPadding (Buf) != 0) {
+  if (CheckPadding (Buf, NumBytes) != 0) {
     return FALSE;
   }
 
   //
   // Check the digest
   //
-  if (CompareMem (Buf + PKCS_PAD_SIZE, Sha256, SHA256_DIGEST_SIZE) != 0) {
+  if (CompareMem (Buf + PKCS_PAD_SIZE (NumBytes), Sha256, SHA256_DIGEST_SIZE) != 0) {
     return FALSE;
   }
 
@@ -30,9 +30,12 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
               This implementation uses little endian byte order.
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/OcCryptoLib.h>
 
+#include "OcCryptoLibInternal.h"
+
 #define ROTLEFT(a, b) (((a) << (b)) | ((a) >> (32-(b))))
 #define ROTRIGHT(a, b) (((a) >> (b)) | ((a) << (32-(b))))
 #define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
@@ -42,7 +45,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define SIG0(x) (ROTRIGHT(x, 7)  ^ ROTRIGHT(x, 18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x, 17) ^ ROTRIGHT(x, 19) ^ ((x) >> 10))
 
-STATIC CONST UINT32 K[64] = {
+CONST UINT32 gSha256K[64] = {
   0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
   0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
   0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
@@ -53,31 +56,38 @@ STATIC CONST UINT32 K[64] = {
   0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
 };
 
+//
+// Selected transform, chosen on first use unless set by Sha256SetBackend.
+//
+STATIC SHA256_TRANSFORM  mSha256Transform;
+STATIC SHA256_BACKEND    mSha256Backend;
+
+//
+// Multi-buffer transform of the selected backend, messages are hashed
+// one by one when mSha256MultiLanes is 0.
+//
+STATIC SHA256_MULTI_TRANSFORM  mSha256MultiTransform;
+STATIC UINT32                  mSha256MultiLanes;
+
 VOID
-Sha256Transform (
-  SHA256_CONTEXT  *Context,
-  CONST UINT8     *Data
+InternalSha256Rounds (
+  IN OUT UINT32        *State,
+  IN     CONST UINT32  *Wk
   )
 {
-  UINT32 A, B, C, D, E, F, G, H, Index1, Index2, T1, T2;
-  UINT32 M[64];
+  UINT32 A, B, C, D, E, F, G, H, Index, T1, T2;
 
-  for (Index1 = 0, Index2 = 0; Index1 < 16; Index1++, Index2 += 4)
-    M[Index1] = (Data[Index2] << 24) | (Data[Index2 + 1] << 16) | (Data[Index2 + 2] << 8) | (Data[Index2 + 3]);
-  for ( ; Index1 < 64; Index1++)
-    M[Index1] = SIG1 (M[Index1 - 2]) + M[Index1 - 7] + SIG0 (M[Index1 - 15]) + M[Index1 - 16];
-
-  A = Context->State[0];
-  B = Context->State[1];
-  C = Context->State[2];
-  D = Context->State[3];
-  E = Context->State[4];
-  F = Context->State[5];
-  G = Context->State[6];
-  H = Context->State[7];
-
-  for (Index1 = 0; Index1 < 64; Index1++) {
-    T1 = H + EP1 (E) + CH (E, F, G) + K[Index1] + M[Index1];
+  A = State[0];
+  B = State[1];
+  C = State[2];
+  D = State[3];
+  E = State[4];
+  F = State[5];
+  G = State[6];
+  H = State[7];
+
+  for (Index = 0; Index < 64; Index++) {
+    T1 = H + EP1 (E) + CH (E, F, G) + Wk[Index];
     T2 = EP0 (A) + MAJ (A, B, C);
     H = G;
     G = F;
@@ -89,14 +99,151 @@ Sha256Transform (
     A = T1 + T2;
   }
 
-  Context->State[0] += A;
-  Context->State[1] += B;
-  Context->State[2] += C;
-  Context->State[3] += D;
-  Context->State[4] += E;
-  Context->State[5] += F;
-  Context->State[6] += G;
-  Context->State[7] += H;
+  State[0] += A;
+  State[1] += B;
+  State[2] += C;
+  State[3] += D;
+  State[4] += E;
+  State[5] += F;
+  State[6] += G;
+  State[7] += H;
+}
+
+STATIC
+VOID
+InternalSha256TransformGeneric (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  UINT32 Index1, Index2;
+  UINT32 M[64];
+
+  while (NumBlocks > 0) {
+    for (Index1 = 0, Index2 = 0; Index1 < 16; Index1++, Index2 += 4)
+      M[Index1] = (Data[Index2] << 24) | (Data[Index2 + 1] << 16) | (Data[Index2 + 2] << 8) | (Data[Index2 + 3]);
+    for ( ; Index1 < 64; Index1++)
+      M[Index1] = SIG1 (M[Index1 - 2]) + M[Index1 - 7] + SIG0 (M[Index1 - 15]) + M[Index1 - 16];
+
+    //
+    // Message schedule is complete, round constants can be added in place.
+    //
+    for (Index1 = 0; Index1 < 64; Index1++)
+      M[Index1] += gSha256K[Index1];
+
+    InternalSha256Rounds (State, M);
+
+    Data += SHA256_BLOCK_SIZE;
+    NumBlocks--;
+  }
+}
+
+/**
+  Return whether the CPU supports SHA-256 backend.
+**/
+STATIC
+BOOLEAN
+InternalSha256IsSupported (
+  IN SHA256_BACKEND  Backend
+  )
+{
+#if defined (MDE_CPU_X64)
+  UINT32  MaxLeaf;
+  UINT32  RegEbx;
+  UINT32  RegEcx;
+
+  AsmCpuid (0, &MaxLeaf, NULL, NULL, NULL);
+  AsmCpuid (1, NULL, NULL, &RegEcx, NULL);
+
+  RegEbx = 0;
+  if (MaxLeaf >= 7) {
+    AsmCpuidEx (7, 0, NULL, &RegEbx, NULL, NULL);
+  }
+
+  switch (Backend) {
+    case Sha256BackendShaNi:
+      //
+      // SHA extensions need SSSE3 and SSE4.1 for state shuffling.
+      //
+      return (RegEbx & BIT29) != 0 && (RegEcx & (BIT9 | BIT19)) == (BIT9 | BIT19);
+    case Sha256BackendAvx2:
+      return (RegEbx & BIT5) != 0 && InternalCpuHasAvxState ();
+    case Sha256BackendSsse3:
+      return (RegEcx & BIT9) != 0;
+    default:
+      break;
+  }
+#endif
+
+  return Backend == Sha256BackendGeneric;
+}
+
+BOOLEAN
+Sha256SetBackend (
+  SHA256_BACKEND  Backend
+  )
+{
+  SHA256_TRANSFORM        Transform;
+  SHA256_MULTI_TRANSFORM  MultiTransform;
+  UINT32                  MultiLanes;
+
+  if (Backend == Sha256BackendAuto) {
+    //
+    // Backends are ordered by speed, generic one is always supported.
+    //
+    Backend = Sha256BackendShaNi;
+    while (!InternalSha256IsSupported (Backend)) {
+      Backend = (SHA256_BACKEND) (Backend - 1);
+    }
+  } else if (!InternalSha256IsSupported (Backend)) {
+    return FALSE;
+  }
+
+  //
+  // SHA extensions hash a single message faster than eight AVX2 lanes.
+  //
+  MultiTransform = NULL;
+  MultiLanes     = 0;
+
+  switch (Backend) {
+#if defined (MDE_CPU_X64)
+    case Sha256BackendShaNi:
+      Transform = InternalSha256TransformShaNi;
+      break;
+    case Sha256BackendAvx2:
+      Transform      = InternalSha256TransformAvx2;
+      MultiTransform = InternalSha256TransformAvx2x8;
+      MultiLanes     = 8;
+      break;
+    case Sha256BackendSsse3:
+      Transform      = InternalSha256TransformSsse3;
+      MultiTransform = InternalSha256TransformSsse3x4;
+      MultiLanes     = 4;
+      break;
+#endif
+    default:
+      Transform = InternalSha256TransformGeneric;
+      break;
+  }
+
+  mSha256Transform      = Transform;
+  mSha256MultiTransform = MultiTransform;
+  mSha256MultiLanes     = MultiLanes;
+  mSha256Backend        = Backend;
+  return TRUE;
+}
+
+SHA256_BACKEND
+Sha256GetBackend (
+  VOID
+  )
+{
+  if (mSha256Transform == NULL) {
+    Sha256SetBackend (Sha256BackendAuto);
+  }
+
+  return mSha256Backend;
 }
 
 VOID
@@ -114,6 +261,10 @@ Sha256Init (
   Context->State[5] = 0x9B05688C;
   Context->State[6] = 0x1F83D9AB;
   Context->State[7] = 0X5BE0CD19;
+
+  if (mSha256Transform == NULL) {
+    Sha256SetBackend (Sha256BackendAuto);
+  }
 }
 
 VOID
@@ -123,17 +274,39 @@ Sha256Update (
   UINTN          Len
   )
 {
-  UINT32 Index;
-
-  for (Index = 0; Index < Len; Index++) {
-    Context->Data[Context->DataLen] = Data[Index];
-    Context->DataLen++;
-    if (Context->DataLen == 64) {
-      Sha256Transform (Context, Context->Data);
-      Context->BitLen += 512;
-      Context->DataLen = 0;
+  UINTN  Size;
+  UINTN  NumBlocks;
+
+  //
+  // Complete the buffered block first, then transform whole blocks
+  // directly from Data and buffer the rest.
+  //
+  if (Context->DataLen > 0) {
+    Size = MIN (Len, SHA256_BLOCK_SIZE - Context->DataLen);
+    CopyMem (Context->Data + Context->DataLen, Data, Size);
+    Context->DataLen += (UINT32) Size;
+    Data += Size;
+    Len  -= Size;
+
+    if (Context->DataLen < SHA256_BLOCK_SIZE) {
+      return;
     }
+
+    mSha256Transform (Context->State, Context->Data, 1);
+    Context->BitLen += 512;
+    Context->DataLen = 0;
   }
+
+  NumBlocks = Len / SHA256_BLOCK_SIZE;
+  if (NumBlocks > 0) {
+    mSha256Transform (Context->State, Data, NumBlocks);
+    Context->BitLen += MultU64x32 (NumBlocks, 512);
+    Data += NumBlocks * SHA256_BLOCK_SIZE;
+    Len  -= NumBlocks * SHA256_BLOCK_SIZE;
+  }
+
+  CopyMem (Context->Data, Data, Len);
+  Context->DataLen = (UINT32) Len;
 }
 
 VOID
@@ -155,7 +328,7 @@ Sha256Final (
   } else {
     Context->Data[Index++] = 0x80;
     ZeroMem (Context->Data + Index, 64-Index);
-    Sha256Transform (Context, Context->Data);
+    mSha256Transform (Context->State, Context->Data, 1);
     ZeroMem (Context->Data, 56);
   }
 
@@ -171,7 +344,7 @@ Sha256Final (
   Context->Data[58] = (UINT8) (Context->BitLen >> 40);
   Context->Data[57] = (UINT8) (Context->BitLen >> 48);
   Context->Data[56] = (UINT8) (Context->BitLen >> 56);
-  Sha256Transform (Context, Context->Data);
+  mSha256Transform (Context->State, Context->Data, 1);
 
   //
   // Since this implementation uses little endian byte ordering and SHA uses big endian,
@@ -203,3 +376,79 @@ Sha256 (
   Sha256Final (&Ctx, Hash);
 }
 
+VOID
+Sha256MultiBuffer (
+  UINT8        *Hashes,
+  CONST UINT8  **Data,
+  CONST UINTN  *Lengths,
+  UINTN        Count
+  )
+{
+  SHA256_CONTEXT  Context;
+  CONST UINT8     *Lanes[SHA256_MULTI_BUFFER_LANES];
+  UINT32          State[8 * SHA256_MULTI_BUFFER_LANES];
+  UINT32          InitialState[8];
+  UINTN           NumLanes;
+  UINTN           Group;
+  UINTN           Lane;
+  UINTN           Word;
+  UINTN           NumBlocks;
+  UINTN           Size;
+
+  Sha256Init (&Context);
+  CopyMem (InitialState, Context.State, sizeof (InitialState));
+  NumLanes = mSha256MultiLanes;
+
+  while (Count > 0) {
+    Group = MIN (Count, NumLanes);
+    if (Group < 2) {
+      Sha256 (Hashes, (UINT8 *) Data[0], Lengths[0]);
+      Hashes  += SHA256_DIGEST_SIZE;
+      Data    += 1;
+      Lengths += 1;
+      Count   -= 1;
+      continue;
+    }
+
+    //
+    // Blocks common to all messages are transformed in lockstep, unused
+    // lanes repeat the first message and are discarded.
+    //
+    NumBlocks = MAX_UINTN;
+    for (Lane = 0; Lane < NumLanes; Lane++) {
+      if (Lane < Group) {
+        Lanes[Lane] = Data[Lane];
+        NumBlocks   = MIN (NumBlocks, Lengths[Lane] / SHA256_BLOCK_SIZE);
+      } else {
+        Lanes[Lane] = Data[0];
+      }
+
+      for (Word = 0; Word < 8; Word++) {
+        State[Word * NumLanes + Lane] = InitialState[Word];
+      }
+    }
+
+    if (NumBlocks > 0) {
+      mSha256MultiTransform (State, Lanes, NumBlocks);
+    }
+
+    //
+    // Tails are hashed one by one from the intermediate state.
+    //
+    Size = NumBlocks * SHA256_BLOCK_SIZE;
+    for (Lane = 0; Lane < Group; Lane++) {
+      for (Word = 0; Word < 8; Word++) {
+        Context.State[Word] = State[Word * NumLanes + Lane];
+      }
+      Context.DataLen = 0;
+      Context.BitLen  = MultU64x32 (NumBlocks, 512);
+      Sha256Update (&Context, Data[Lane] + Size, Lengths[Lane] - Size);
+      Sha256Final (&Context, Hashes);
+      Hashes += SHA256_DIGEST_SIZE;
+    }
+
+    Data    += Group;
+    Lengths += Group;
+    Count   -= Group;
+  }
+}
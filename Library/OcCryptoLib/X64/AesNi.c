@@ -0,0 +1,307 @@
+/** @file
+
+OcCryptoLib
+
+Copyright (c) 2019, vit9696
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+//
+// AES modes using AES-NI.  CBC encryption is sequential by definition,
+// while CTR and CBC decryption process 8 independent blocks at a time to
+// hide the latency of AESENC and AESDEC.  Rounds are unrolled and every
+// mode is specialised for each key size.
+//
+
+#include <Library/BaseLib.h>
+#include <Library/OcCryptoLib.h>
+
+#include <immintrin.h>
+
+#include "../OcCryptoLibInternal.h"
+
+#define AES_NI_LANES  8
+
+//
+// Apply Op with round key K to block B0.
+//
+#define AES_NI_1X(Op, K)   \
+  do {                     \
+    B0 = Op (B0, (K));     \
+  } while (0)
+
+//
+// Apply Op with round key K to blocks B0..B7.
+//
+#define AES_NI_8X(Op, K)   \
+  do {                     \
+    B0 = Op (B0, (K));     \
+    B1 = Op (B1, (K));     \
+    B2 = Op (B2, (K));     \
+    B3 = Op (B3, (K));     \
+    B4 = Op (B4, (K));     \
+    B5 = Op (B5, (K));     \
+    B6 = Op (B6, (K));     \
+    B7 = Op (B7, (K));     \
+  } while (0)
+
+//
+// Apply Op with round keys 1 to Rounds - 1 and then OpLast with round
+// key Rounds to the blocks of Apply.  Extra rounds of longer keys
+// disappear when Rounds is constant.
+//
+#define AES_NI_ROUNDS(Apply, Op, OpLast, Keys, Rounds)  \
+  do {                                                 \
+    Apply (Op, (Keys)[1]);                             \
+    Apply (Op, (Keys)[2]);                             \
+    Apply (Op, (Keys)[3]);                             \
+    Apply (Op, (Keys)[4]);                             \
+    Apply (Op, (Keys)[5]);                             \
+    Apply (Op, (Keys)[6]);                             \
+    Apply (Op, (Keys)[7]);                             \
+    Apply (Op, (Keys)[8]);                             \
+    Apply (Op, (Keys)[9]);                             \
+    if ((Rounds) > 10) {                               \
+      Apply (Op, (Keys)[10]);                          \
+      Apply (Op, (Keys)[11]);                          \
+    }                                                  \
+    if ((Rounds) > 12) {                               \
+      Apply (Op, (Keys)[12]);                          \
+      Apply (Op, (Keys)[13]);                          \
+    }                                                  \
+    Apply (OpLast, (Keys)[(Rounds)]);                  \
+  } while (0)
+
+//
+// Store Counter to Out in big endian and increment it, carrying into the
+// high half when the low one wraps to zero.
+//
+#define AES_NI_NEXT_COUNTER(Out)                                        \
+  do {                                                                  \
+    (Out)   = _mm_shuffle_epi8 (Counter, Swap);                         \
+    Counter = _mm_add_epi64 (Counter, One);                             \
+    Carry   = _mm_cmpeq_epi32 (Counter, _mm_setzero_si128 ());          \
+    Carry   = _mm_and_si128 (Carry, _mm_shuffle_epi32 (Carry, 0xB1));   \
+    Counter = _mm_sub_epi64 (Counter, _mm_slli_si128 (Carry, 8));       \
+  } while (0)
+
+OC_CRYPTO_TARGET ("aes")
+STATIC
+VOID
+InternalAesNiLoadRoundKey (
+  OUT __m128i      *Rk,
+  IN  CONST UINT8  *RoundKey,
+  IN  UINT32       Rounds
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index <= Rounds; ++Index) {
+    Rk[Index] = _mm_loadu_si128 ((CONST __m128i *) &RoundKey[Index * AES_BLOCK_SIZE]);
+  }
+}
+
+OC_CRYPTO_TARGET ("aes")
+STATIC
+VOID
+InternalAesCbcEncryptRounds (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks,
+  IN     UINT32       Rounds
+  )
+{
+  __m128i  Rk[AES_MAX_ROUNDS + 1];
+  __m128i  B0;
+
+  InternalAesNiLoadRoundKey (Rk, Context->RoundKey, Rounds);
+
+  B0 = _mm_loadu_si128 ((CONST __m128i *) Context->Iv);
+
+  while (NumBlocks > 0) {
+    B0 = _mm_xor_si128 (B0, _mm_loadu_si128 ((CONST __m128i *) Data));
+    B0 = _mm_xor_si128 (B0, Rk[0]);
+    AES_NI_ROUNDS (AES_NI_1X, _mm_aesenc_si128, _mm_aesenclast_si128, Rk, Rounds);
+    _mm_storeu_si128 ((__m128i *) Data, B0);
+
+    Data += AES_BLOCK_SIZE;
+    --NumBlocks;
+  }
+
+  _mm_storeu_si128 ((__m128i *) Context->Iv, B0);
+}
+
+OC_CRYPTO_TARGET ("aes")
+STATIC
+VOID
+InternalAesCbcDecryptRounds (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks,
+  IN     UINT32       Rounds
+  )
+{
+  __m128i  Dk[AES_MAX_ROUNDS + 1];
+  __m128i  Iv;
+  __m128i  C0, C1, C2, C3, C4, C5, C6, C7;
+  __m128i  B0, B1, B2, B3, B4, B5, B6, B7;
+  __m128i  *Block;
+
+  InternalAesNiLoadRoundKey (Dk, Context->InvRoundKey, Rounds);
+
+  Iv    = _mm_loadu_si128 ((CONST __m128i *) Context->Iv);
+  Block = (__m128i *) Data;
+
+  while (NumBlocks >= AES_NI_LANES) {
+    B0 = C0 = _mm_loadu_si128 (&Block[0]);
+    B1 = C1 = _mm_loadu_si128 (&Block[1]);
+    B2 = C2 = _mm_loadu_si128 (&Block[2]);
+    B3 = C3 = _mm_loadu_si128 (&Block[3]);
+    B4 = C4 = _mm_loadu_si128 (&Block[4]);
+    B5 = C5 = _mm_loadu_si128 (&Block[5]);
+    B6 = C6 = _mm_loadu_si128 (&Block[6]);
+    B7 = C7 = _mm_loadu_si128 (&Block[7]);
+
+    AES_NI_8X (_mm_xor_si128, Dk[0]);
+    AES_NI_ROUNDS (AES_NI_8X, _mm_aesdec_si128, _mm_aesdeclast_si128, Dk, Rounds);
+
+    _mm_storeu_si128 (&Block[0], _mm_xor_si128 (B0, Iv));
+    _mm_storeu_si128 (&Block[1], _mm_xor_si128 (B1, C0));
+    _mm_storeu_si128 (&Block[2], _mm_xor_si128 (B2, C1));
+    _mm_storeu_si128 (&Block[3], _mm_xor_si128 (B3, C2));
+    _mm_storeu_si128 (&Block[4], _mm_xor_si128 (B4, C3));
+    _mm_storeu_si128 (&Block[5], _mm_xor_si128 (B5, C4));
+    _mm_storeu_si128 (&Block[6], _mm_xor_si128 (B6, C5));
+    _mm_storeu_si128 (&Block[7], _mm_xor_si128 (B7, C6));
+    Iv = C7;
+
+    Block     += AES_NI_LANES;
+    NumBlocks -= AES_NI_LANES;
+  }
+
+  while (NumBlocks > 0) {
+    B0 = C0 = _mm_loadu_si128 (Block);
+    B0 = _mm_xor_si128 (B0, Dk[0]);
+    AES_NI_ROUNDS (AES_NI_1X, _mm_aesdec_si128, _mm_aesdeclast_si128, Dk, Rounds);
+    _mm_storeu_si128 (Block, _mm_xor_si128 (B0, Iv));
+    Iv = C0;
+
+    ++Block;
+    --NumBlocks;
+  }
+
+  _mm_storeu_si128 ((__m128i *) Context->Iv, Iv);
+}
+
+OC_CRYPTO_TARGET ("aes,ssse3")
+STATIC
+VOID
+InternalAesCtrXcryptRounds (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks,
+  IN     UINT32       Rounds
+  )
+{
+  __m128i  Rk[AES_MAX_ROUNDS + 1];
+  __m128i  Swap;
+  __m128i  Counter;
+  __m128i  One;
+  __m128i  Carry;
+  __m128i  B0, B1, B2, B3, B4, B5, B6, B7;
+  __m128i  *Block;
+
+  InternalAesNiLoadRoundKey (Rk, Context->RoundKey, Rounds);
+
+  //
+  // Keep the big endian counter as a little endian 128-bit integer.
+  //
+  Swap    = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  Counter = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) Context->Iv), Swap);
+  One     = _mm_set_epi64x (0, 1);
+  Block   = (__m128i *) Data;
+
+  while (NumBlocks >= AES_NI_LANES) {
+    AES_NI_NEXT_COUNTER (B0);
+    AES_NI_NEXT_COUNTER (B1);
+    AES_NI_NEXT_COUNTER (B2);
+    AES_NI_NEXT_COUNTER (B3);
+    AES_NI_NEXT_COUNTER (B4);
+    AES_NI_NEXT_COUNTER (B5);
+    AES_NI_NEXT_COUNTER (B6);
+    AES_NI_NEXT_COUNTER (B7);
+
+    AES_NI_8X (_mm_xor_si128, Rk[0]);
+    AES_NI_ROUNDS (AES_NI_8X, _mm_aesenc_si128, _mm_aesenclast_si128, Rk, Rounds);
+
+    _mm_storeu_si128 (&Block[0], _mm_xor_si128 (B0, _mm_loadu_si128 (&Block[0])));
+    _mm_storeu_si128 (&Block[1], _mm_xor_si128 (B1, _mm_loadu_si128 (&Block[1])));
+    _mm_storeu_si128 (&Block[2], _mm_xor_si128 (B2, _mm_loadu_si128 (&Block[2])));
+    _mm_storeu_si128 (&Block[3], _mm_xor_si128 (B3, _mm_loadu_si128 (&Block[3])));
+    _mm_storeu_si128 (&Block[4], _mm_xor_si128 (B4, _mm_loadu_si128 (&Block[4])));
+    _mm_storeu_si128 (&Block[5], _mm_xor_si128 (B5, _mm_loadu_si128 (&Block[5])));
+    _mm_storeu_si128 (&Block[6], _mm_xor_si128 (B6, _mm_loadu_si128 (&Block[6])));
+    _mm_storeu_si128 (&Block[7], _mm_xor_si128 (B7, _mm_loadu_si128 (&Block[7])));
+
+    Block     += AES_NI_LANES;
+    NumBlocks -= AES_NI_LANES;
+  }
+
+  while (NumBlocks > 0) {
+    AES_NI_NEXT_COUNTER (B0);
+    B0 = _mm_xor_si128 (B0, Rk[0]);
+    AES_NI_ROUNDS (AES_NI_1X, _mm_aesenc_si128, _mm_aesenclast_si128, Rk, Rounds);
+    _mm_storeu_si128 (Block, _mm_xor_si128 (B0, _mm_loadu_si128 (Block)));
+
+    ++Block;
+    --NumBlocks;
+  }
+
+  _mm_storeu_si128 ((__m128i *) Context->Iv, _mm_shuffle_epi8 (Counter, Swap));
+}
+
+OC_CRYPTO_TARGET ("aes")
+OC_CRYPTO_FLATTEN
+VOID
+InternalAesCbcEncryptAesNi (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  AES_DISPATCH_ROUNDS (InternalAesCbcEncryptRounds, Context, Data, NumBlocks);
+}
+
+OC_CRYPTO_TARGET ("aes")
+OC_CRYPTO_FLATTEN
+VOID
+InternalAesCbcDecryptAesNi (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  AES_DISPATCH_ROUNDS (InternalAesCbcDecryptRounds, Context, Data, NumBlocks);
+}
+
+OC_CRYPTO_TARGET ("aes,ssse3")
+OC_CRYPTO_FLATTEN
+VOID
+InternalAesCtrXcryptAesNi (
+  IN OUT AES_CONTEXT  *Context,
+  IN OUT UINT8        *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  AES_DISPATCH_ROUNDS (InternalAesCtrXcryptRounds, Context, Data, NumBlocks);
+}
@@ -0,0 +1,313 @@
+/** @file
+
+OcCryptoLib
+
+Copyright (c) 2019, vit9696
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+//
+// Multi-buffer SHA-256 transforms.  Every vector element carries the same
+// word of a different message, so all rounds run in SIMD without the data
+// dependencies limiting single message transforms.  Message words are
+// loaded one block row per lane and transposed into word vectors.
+//
+
+#include <Library/BaseLib.h>
+#include <Library/OcCryptoLib.h>
+
+#include <immintrin.h>
+
+#include "../OcCryptoLibInternal.h"
+
+#define SHA256_MB_ROTR_4X(X, N) \
+  _mm_or_si128 (_mm_srli_epi32 ((X), (N)), _mm_slli_epi32 ((X), 32 - (N)))
+
+#define SHA256_MB_ROTR_8X(X, N) \
+  _mm256_or_si256 (_mm256_srli_epi32 ((X), (N)), _mm256_slli_epi32 ((X), 32 - (N)))
+
+OC_CRYPTO_TARGET ("ssse3")
+STATIC
+VOID
+InternalSha256LoadWords4x (
+  OUT __m128i      *W,
+  IN  CONST UINT8  **Data,
+  IN  UINTN        Offset
+  )
+{
+  __m128i  Swap;
+  __m128i  R0;
+  __m128i  R1;
+  __m128i  R2;
+  __m128i  R3;
+  __m128i  T0;
+  __m128i  T1;
+  __m128i  T2;
+  __m128i  T3;
+
+  Swap = _mm_set_epi8 (12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+  R0 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) (Data[0] + Offset)), Swap);
+  R1 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) (Data[1] + Offset)), Swap);
+  R2 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) (Data[2] + Offset)), Swap);
+  R3 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) (Data[3] + Offset)), Swap);
+
+  T0 = _mm_unpacklo_epi32 (R0, R1);
+  T1 = _mm_unpacklo_epi32 (R2, R3);
+  T2 = _mm_unpackhi_epi32 (R0, R1);
+  T3 = _mm_unpackhi_epi32 (R2, R3);
+
+  W[0] = _mm_unpacklo_epi64 (T0, T1);
+  W[1] = _mm_unpackhi_epi64 (T0, T1);
+  W[2] = _mm_unpacklo_epi64 (T2, T3);
+  W[3] = _mm_unpackhi_epi64 (T2, T3);
+}
+
+OC_CRYPTO_TARGET ("ssse3")
+VOID
+InternalSha256TransformSsse3x4 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  **Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  CONST UINT8  *Lanes[4];
+  __m128i      S[8];
+  __m128i      W[16];
+  __m128i      A, B, C, D, E, F, G, H;
+  __m128i      T1;
+  __m128i      T2;
+  UINTN        Offset;
+  UINT32       Index;
+
+  for (Index = 0; Index < 4; Index++) {
+    Lanes[Index] = Data[Index];
+  }
+
+  for (Index = 0; Index < 8; Index++) {
+    S[Index] = _mm_loadu_si128 ((CONST __m128i *) &State[Index * 4]);
+  }
+
+  for (Offset = 0; NumBlocks > 0; NumBlocks--, Offset += SHA256_BLOCK_SIZE) {
+    for (Index = 0; Index < 16; Index += 4) {
+      InternalSha256LoadWords4x (&W[Index], Lanes, Offset + Index * sizeof (UINT32));
+    }
+
+    A = S[0];
+    B = S[1];
+    C = S[2];
+    D = S[3];
+    E = S[4];
+    F = S[5];
+    G = S[6];
+    H = S[7];
+
+    for (Index = 0; Index < 64; Index++) {
+      if (Index >= 16) {
+        T1 = W[(Index + 1) & 15];
+        T1 = _mm_xor_si128 (
+          _mm_xor_si128 (SHA256_MB_ROTR_4X (T1, 7), SHA256_MB_ROTR_4X (T1, 18)),
+          _mm_srli_epi32 (T1, 3)
+          );
+        T2 = W[(Index + 14) & 15];
+        T2 = _mm_xor_si128 (
+          _mm_xor_si128 (SHA256_MB_ROTR_4X (T2, 17), SHA256_MB_ROTR_4X (T2, 19)),
+          _mm_srli_epi32 (T2, 10)
+          );
+        W[Index & 15] = _mm_add_epi32 (
+          _mm_add_epi32 (W[Index & 15], T1),
+          _mm_add_epi32 (W[(Index + 9) & 15], T2)
+          );
+      }
+
+      T1 = _mm_add_epi32 (H, _mm_add_epi32 (W[Index & 15], _mm_set1_epi32 ((INT32) gSha256K[Index])));
+      T1 = _mm_add_epi32 (T1, _mm_xor_si128 (_mm_and_si128 (E, F), _mm_andnot_si128 (E, G)));
+      T1 = _mm_add_epi32 (T1, _mm_xor_si128 (
+        _mm_xor_si128 (SHA256_MB_ROTR_4X (E, 6), SHA256_MB_ROTR_4X (E, 11)),
+        SHA256_MB_ROTR_4X (E, 25)
+        ));
+      T2 = _mm_add_epi32 (
+        _mm_xor_si128 (
+          _mm_xor_si128 (SHA256_MB_ROTR_4X (A, 2), SHA256_MB_ROTR_4X (A, 13)),
+          SHA256_MB_ROTR_4X (A, 22)
+          ),
+        _mm_or_si128 (_mm_and_si128 (A, _mm_or_si128 (B, C)), _mm_and_si128 (B, C))
+        );
+
+      H = G;
+      G = F;
+      F = E;
+      E = _mm_add_epi32 (D, T1);
+      D = C;
+      C = B;
+      B = A;
+      A = _mm_add_epi32 (T1, T2);
+    }
+
+    S[0] = _mm_add_epi32 (S[0], A);
+    S[1] = _mm_add_epi32 (S[1], B);
+    S[2] = _mm_add_epi32 (S[2], C);
+    S[3] = _mm_add_epi32 (S[3], D);
+    S[4] = _mm_add_epi32 (S[4], E);
+    S[5] = _mm_add_epi32 (S[5], F);
+    S[6] = _mm_add_epi32 (S[6], G);
+    S[7] = _mm_add_epi32 (S[7], H);
+  }
+
+  for (Index = 0; Index < 8; Index++) {
+    _mm_storeu_si128 ((__m128i *) &State[Index * 4], S[Index]);
+  }
+}
+
+OC_CRYPTO_TARGET ("avx2")
+STATIC
+VOID
+InternalSha256LoadWords8x (
+  OUT __m256i      *W,
+  IN  CONST UINT8  **Data,
+  IN  UINTN        Offset
+  )
+{
+  __m256i  Swap;
+  __m256i  R[8];
+  __m256i  T[8];
+  __m256i  U[8];
+  UINT32   Index;
+
+  Swap = _mm256_set_epi8 (
+    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+    );
+
+  for (Index = 0; Index < 8; Index++) {
+    R[Index] = _mm256_shuffle_epi8 (
+      _mm256_loadu_si256 ((CONST __m256i *) (Data[Index] + Offset)),
+      Swap
+      );
+  }
+
+  //
+  // 8x8 transpose: interleave words within 128-bit halves, then swap halves.
+  //
+  for (Index = 0; Index < 8; Index += 2) {
+    T[Index]     = _mm256_unpacklo_epi32 (R[Index], R[Index + 1]);
+    T[Index + 1] = _mm256_unpackhi_epi32 (R[Index], R[Index + 1]);
+  }
+
+  for (Index = 0; Index < 8; Index += 4) {
+    U[Index]     = _mm256_unpacklo_epi64 (T[Index], T[Index + 2]);
+    U[Index + 1] = _mm256_unpackhi_epi64 (T[Index], T[Index + 2]);
+    U[Index + 2] = _mm256_unpacklo_epi64 (T[Index + 1], T[Index + 3]);
+    U[Index + 3] = _mm256_unpackhi_epi64 (T[Index + 1], T[Index + 3]);
+  }
+
+  for (Index = 0; Index < 4; Index++) {
+    W[Index]     = _mm256_permute2x128_si256 (U[Index], U[Index + 4], 0x20);
+    W[Index + 4] = _mm256_permute2x128_si256 (U[Index], U[Index + 4], 0x31);
+  }
+}
+
+OC_CRYPTO_TARGET ("avx2")
+VOID
+InternalSha256TransformAvx2x8 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  **Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  CONST UINT8  *Lanes[8];
+  __m256i      S[8];
+  __m256i      W[16];
+  __m256i      A, B, C, D, E, F, G, H;
+  __m256i      T1;
+  __m256i      T2;
+  UINTN        Offset;
+  UINT32       Index;
+
+  for (Index = 0; Index < 8; Index++) {
+    Lanes[Index] = Data[Index];
+  }
+
+  for (Index = 0; Index < 8; Index++) {
+    S[Index] = _mm256_loadu_si256 ((CONST __m256i *) &State[Index * 8]);
+  }
+
+  for (Offset = 0; NumBlocks > 0; NumBlocks--, Offset += SHA256_BLOCK_SIZE) {
+    InternalSha256LoadWords8x (&W[0], Lanes, Offset);
+    InternalSha256LoadWords8x (&W[8], Lanes, Offset + 8 * sizeof (UINT32));
+
+    A = S[0];
+    B = S[1];
+    C = S[2];
+    D = S[3];
+    E = S[4];
+    F = S[5];
+    G = S[6];
+    H = S[7];
+
+    for (Index = 0; Index < 64; Index++) {
+      if (Index >= 16) {
+        T1 = W[(Index + 1) & 15];
+        T1 = _mm256_xor_si256 (
+          _mm256_xor_si256 (SHA256_MB_ROTR_8X (T1, 7), SHA256_MB_ROTR_8X (T1, 18)),
+          _mm256_srli_epi32 (T1, 3)
+          );
+        T2 = W[(Index + 14) & 15];
+        T2 = _mm256_xor_si256 (
+          _mm256_xor_si256 (SHA256_MB_ROTR_8X (T2, 17), SHA256_MB_ROTR_8X (T2, 19)),
+          _mm256_srli_epi32 (T2, 10)
+          );
+        W[Index & 15] = _mm256_add_epi32 (
+          _mm256_add_epi32 (W[Index & 15], T1),
+          _mm256_add_epi32 (W[(Index + 9) & 15], T2)
+          );
+      }
+
+      T1 = _mm256_add_epi32 (H, _mm256_add_epi32 (W[Index & 15], _mm256_set1_epi32 ((INT32) gSha256K[Index])));
+      T1 = _mm256_add_epi32 (T1, _mm256_xor_si256 (_mm256_and_si256 (E, F), _mm256_andnot_si256 (E, G)));
+      T1 = _mm256_add_epi32 (T1, _mm256_xor_si256 (
+        _mm256_xor_si256 (SHA256_MB_ROTR_8X (E, 6), SHA256_MB_ROTR_8X (E, 11)),
+        SHA256_MB_ROTR_8X (E, 25)
+        ));
+      T2 = _mm256_add_epi32 (
+        _mm256_xor_si256 (
+          _mm256_xor_si256 (SHA256_MB_ROTR_8X (A, 2), SHA256_MB_ROTR_8X (A, 13)),
+          SHA256_MB_ROTR_8X (A, 22)
+          ),
+        _mm256_or_si256 (_mm256_and_si256 (A, _mm256_or_si256 (B, C)), _mm256_and_si256 (B, C))
+        );
+
+      H = G;
+      G = F;
+      F = E;
+      E = _mm256_add_epi32 (D, T1);
+      D = C;
+      C = B;
+      B = A;
+      A = _mm256_add_epi32 (T1, T2);
+    }
+
+    S[0] = _mm256_add_epi32 (S[0], A);
+    S[1] = _mm256_add_epi32 (S[1], B);
+    S[2] = _mm256_add_epi32 (S[2], C);
+    S[3] = _mm256_add_epi32 (S[3], D);
+    S[4] = _mm256_add_epi32 (S[4], E);
+    S[5] = _mm256_add_epi32 (S[5], F);
+    S[6] = _mm256_add_epi32 (S[6], G);
+    S[7] = _mm256_add_epi32 (S[7], H);
+  }
+
+  for (Index = 0; Index < 8; Index++) {
+    _mm256_storeu_si256 ((__m256i *) &State[Index * 8], S[Index]);
+  }
+}
@@ -0,0 +1,341 @@
+/** @file
+
+OcCryptoLib
+
+Copyright (c) 2019, vit9696
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+//
+// SHA-256 transforms using Intel SHA extensions, and SSSE3 or AVX2 for
+// the message schedule with scalar rounds.  The schedule computes four
+// words at a time: sigma1 of the first two depends on already known
+// words, while sigma1 of the last two depends on the first two.
+// AVX2 schedules two blocks at once, one per 128-bit lane.
+//
+
+#include <Library/BaseLib.h>
+#include <Library/OcCryptoLib.h>
+
+#include <immintrin.h>
+
+#include "../OcCryptoLibInternal.h"
+
+#define SHA256_ROTR_4X(X, N) \
+  _mm_or_si128 (_mm_srli_epi32 ((X), (N)), _mm_slli_epi32 ((X), 32 - (N)))
+
+#define SHA256_ROTR_8X(X, N) \
+  _mm256_or_si256 (_mm256_srli_epi32 ((X), (N)), _mm256_slli_epi32 ((X), 32 - (N)))
+
+OC_CRYPTO_TARGET ("xsave")
+BOOLEAN
+InternalCpuHasAvxState (
+  VOID
+  )
+{
+  UINT32  RegEcx;
+
+  AsmCpuid (1, NULL, NULL, &RegEcx, NULL);
+
+  //
+  // Require OSXSAVE and AVX, then XMM and YMM state enabled in XCR0.
+  //
+  if ((RegEcx & (BIT27 | BIT28)) != (BIT27 | BIT28)) {
+    return FALSE;
+  }
+
+  return (_xgetbv (0) & (BIT1 | BIT2)) == (BIT1 | BIT2);
+}
+
+OC_CRYPTO_TARGET ("ssse3")
+STATIC
+__m128i
+InternalSha256Schedule4x (
+  IN __m128i  X0,
+  IN __m128i  X1,
+  IN __m128i  X2,
+  IN __m128i  X3
+  )
+{
+  __m128i  W;
+  __m128i  T;
+
+  //
+  // X0..X3 hold W[t-16..t-1], W[t-15..t-12] and W[t-7..t-4] are unaligned.
+  //
+  T = _mm_alignr_epi8 (X1, X0, 4);
+  T = _mm_xor_si128 (
+    _mm_xor_si128 (SHA256_ROTR_4X (T, 7), SHA256_ROTR_4X (T, 18)),
+    _mm_srli_epi32 (T, 3)
+    );
+  W = _mm_add_epi32 (_mm_add_epi32 (X0, T), _mm_alignr_epi8 (X3, X2, 4));
+
+  //
+  // sigma1 (0) is 0, so the other half stays unchanged in both steps.
+  //
+  T = _mm_srli_si128 (X3, 8);
+  T = _mm_xor_si128 (
+    _mm_xor_si128 (SHA256_ROTR_4X (T, 17), SHA256_ROTR_4X (T, 19)),
+    _mm_srli_epi32 (T, 10)
+    );
+  W = _mm_add_epi32 (W, T);
+
+  T = _mm_slli_si128 (W, 8);
+  T = _mm_xor_si128 (
+    _mm_xor_si128 (SHA256_ROTR_4X (T, 17), SHA256_ROTR_4X (T, 19)),
+    _mm_srli_epi32 (T, 10)
+    );
+  return _mm_add_epi32 (W, T);
+}
+
+OC_CRYPTO_TARGET ("ssse3")
+VOID
+InternalSha256TransformSsse3 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  UINT32   Wk[64];
+  __m128i  Mask;
+  __m128i  X[4];
+  UINT32   Index;
+
+  Mask = _mm_set_epi8 (12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+  while (NumBlocks > 0) {
+    for (Index = 0; Index < 4; ++Index) {
+      X[Index] = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[Index * 16]), Mask);
+      _mm_storeu_si128 (
+        (__m128i *) &Wk[Index * 4],
+        _mm_add_epi32 (X[Index], _mm_loadu_si128 ((CONST __m128i *) &gSha256K[Index * 4]))
+        );
+    }
+
+    for (Index = 4; Index < 16; ++Index) {
+      X[Index % 4] = InternalSha256Schedule4x (
+        X[Index % 4],
+        X[(Index + 1) % 4],
+        X[(Index + 2) % 4],
+        X[(Index + 3) % 4]
+        );
+      _mm_storeu_si128 (
+        (__m128i *) &Wk[Index * 4],
+        _mm_add_epi32 (X[Index % 4], _mm_loadu_si128 ((CONST __m128i *) &gSha256K[Index * 4]))
+        );
+    }
+
+    InternalSha256Rounds (State, Wk);
+
+    Data += SHA256_BLOCK_SIZE;
+    --NumBlocks;
+  }
+}
+
+OC_CRYPTO_TARGET ("avx2")
+STATIC
+__m256i
+InternalSha256Schedule8x (
+  IN __m256i  X0,
+  IN __m256i  X1,
+  IN __m256i  X2,
+  IN __m256i  X3
+  )
+{
+  __m256i  W;
+  __m256i  T;
+
+  //
+  // Same as InternalSha256Schedule4x, byte shifts operate per lane.
+  //
+  T = _mm256_alignr_epi8 (X1, X0, 4);
+  T = _mm256_xor_si256 (
+    _mm256_xor_si256 (SHA256_ROTR_8X (T, 7), SHA256_ROTR_8X (T, 18)),
+    _mm256_srli_epi32 (T, 3)
+    );
+  W = _mm256_add_epi32 (_mm256_add_epi32 (X0, T), _mm256_alignr_epi8 (X3, X2, 4));
+
+  T = _mm256_srli_si256 (X3, 8);
+  T = _mm256_xor_si256 (
+    _mm256_xor_si256 (SHA256_ROTR_8X (T, 17), SHA256_ROTR_8X (T, 19)),
+    _mm256_srli_epi32 (T, 10)
+    );
+  W = _mm256_add_epi32 (W, T);
+
+  T = _mm256_slli_si256 (W, 8);
+  T = _mm256_xor_si256 (
+    _mm256_xor_si256 (SHA256_ROTR_8X (T, 17), SHA256_ROTR_8X (T, 19)),
+    _mm256_srli_epi32 (T, 10)
+    );
+  return _mm256_add_epi32 (W, T);
+}
+
+OC_CRYPTO_TARGET ("avx2")
+STATIC
+VOID
+InternalSha256StoreWk8x (
+  OUT UINT32        *Wk,
+  IN  __m256i       X,
+  IN  CONST UINT32  *K
+  )
+{
+  X = _mm256_add_epi32 (X, _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((CONST __m128i *) K)));
+  _mm_storeu_si128 ((__m128i *) &Wk[0], _mm256_castsi256_si128 (X));
+  _mm_storeu_si128 ((__m128i *) &Wk[64], _mm256_extracti128_si256 (X, 1));
+}
+
+OC_CRYPTO_TARGET ("avx2")
+VOID
+InternalSha256TransformAvx2 (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  UINT32   Wk[128];
+  __m256i  Mask;
+  __m256i  X[4];
+  UINT32   Index;
+
+  Mask = _mm256_set_epi8 (
+    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+    );
+
+  while (NumBlocks >= 2) {
+    //
+    // First block goes to the low lane, second block to the high lane.
+    //
+    for (Index = 0; Index < 4; ++Index) {
+      X[Index] = _mm256_inserti128_si256 (
+        _mm256_castsi128_si256 (_mm_loadu_si128 ((CONST __m128i *) &Data[Index * 16])),
+        _mm_loadu_si128 ((CONST __m128i *) &Data[SHA256_BLOCK_SIZE + Index * 16]),
+        1
+        );
+      X[Index] = _mm256_shuffle_epi8 (X[Index], Mask);
+      InternalSha256StoreWk8x (&Wk[Index * 4], X[Index], &gSha256K[Index * 4]);
+    }
+
+    for (Index = 4; Index < 16; ++Index) {
+      X[Index % 4] = InternalSha256Schedule8x (
+        X[Index % 4],
+        X[(Index + 1) % 4],
+        X[(Index + 2) % 4],
+        X[(Index + 3) % 4]
+        );
+      InternalSha256StoreWk8x (&Wk[Index * 4], X[Index % 4], &gSha256K[Index * 4]);
+    }
+
+    InternalSha256Rounds (State, &Wk[0]);
+    InternalSha256Rounds (State, &Wk[64]);
+
+    Data      += 2 * SHA256_BLOCK_SIZE;
+    NumBlocks -= 2;
+  }
+
+  if (NumBlocks > 0) {
+    InternalSha256TransformSsse3 (State, Data, NumBlocks);
+  }
+}
+
+//
+// Four SHA-256 rounds with message words M of group G.
+//
+#define SHA256_NI_ROUNDS(G, M)                                                           \
+  do {                                                                                   \
+    Msg    = _mm_add_epi32 ((M), _mm_loadu_si128 ((CONST __m128i *) &gSha256K[4 * (G)])); \
+    State1 = _mm_sha256rnds2_epu32 (State1, State0, Msg);                                \
+    Msg    = _mm_shuffle_epi32 (Msg, 0x0E);                                              \
+    State0 = _mm_sha256rnds2_epu32 (State0, State1, Msg);                                \
+  } while (0)
+
+//
+// Next message words into M0 from previous words in M0, M1, M2, M3.
+//
+#define SHA256_NI_SCHEDULE(M0, M1, M2, M3)                           \
+  (M0) = _mm_sha256msg2_epu32 (                                      \
+    _mm_add_epi32 (_mm_sha256msg1_epu32 ((M0), (M1)), _mm_alignr_epi8 ((M3), (M2), 4)), \
+    (M3)                                                             \
+    )
+
+OC_CRYPTO_TARGET ("sha,sse4.1,ssse3")
+VOID
+InternalSha256TransformShaNi (
+  IN OUT UINT32       *State,
+  IN     CONST UINT8  *Data,
+  IN     UINTN        NumBlocks
+  )
+{
+  __m128i  State0;
+  __m128i  State1;
+  __m128i  SavedState0;
+  __m128i  SavedState1;
+  __m128i  Msg;
+  __m128i  Msg0;
+  __m128i  Msg1;
+  __m128i  Msg2;
+  __m128i  Msg3;
+  __m128i  Tmp;
+  __m128i  Mask;
+  UINT32   Group;
+
+  Mask = _mm_set_epi64x (0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+
+  //
+  // SHA instructions keep state as ABEF and CDGH.
+  //
+  Tmp    = _mm_shuffle_epi32 (_mm_loadu_si128 ((CONST __m128i *) &State[0]), 0xB1);
+  State1 = _mm_shuffle_epi32 (_mm_loadu_si128 ((CONST __m128i *) &State[4]), 0x1B);
+  State0 = _mm_alignr_epi8 (Tmp, State1, 8);
+  State1 = _mm_blend_epi16 (State1, Tmp, 0xF0);
+
+  while (NumBlocks > 0) {
+    SavedState0 = State0;
+    SavedState1 = State1;
+
+    Msg0 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[0]), Mask);
+    Msg1 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[16]), Mask);
+    Msg2 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[32]), Mask);
+    Msg3 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[48]), Mask);
+
+    SHA256_NI_ROUNDS (0, Msg0);
+    SHA256_NI_ROUNDS (1, Msg1);
+    SHA256_NI_ROUNDS (2, Msg2);
+    SHA256_NI_ROUNDS (3, Msg3);
+
+    for (Group = 4; Group < 16; Group += 4) {
+      SHA256_NI_SCHEDULE (Msg0, Msg1, Msg2, Msg3);
+      SHA256_NI_ROUNDS (Group, Msg0);
+      SHA256_NI_SCHEDULE (Msg1, Msg2, Msg3, Msg0);
+      SHA256_NI_ROUNDS (Group + 1, Msg1);
+      SHA256_NI_SCHEDULE (Msg2, Msg3, Msg0, Msg1);
+      SHA256_NI_ROUNDS (Group + 2, Msg2);
+      SHA256_NI_SCHEDULE (Msg3, Msg0, Msg1, Msg2);
+      SHA256_NI_ROUNDS (Group + 3, Msg3);
+    }
+
+    State0 = _mm_add_epi32 (State0, SavedState0);
+    State1 = _mm_add_epi32 (State1, SavedState1);
+
+    Data += SHA256_BLOCK_SIZE;
+    --NumBlocks;
+  }
+
+  Tmp    = _mm_shuffle_epi32 (State0, 0x1B);
+  State1 = _mm_shuffle_epi32 (State1, 0xB1);
+  State0 = _mm_blend_epi16 (Tmp, State1, 0xF0);
+  State1 = _mm_alignr_epi8 (State1, Tmp, 8);
+
+  _mm_storeu_si128 ((__m128i *) &State[0], State0);
+  _mm_storeu_si128 ((__m128i *) &State[4], State1);
+}
@@ -19,10 +19,13 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMachoLib.h>
 #include <Library/OcStringLib.h>
 
+#include "OcMachoLibInternal.h"
+
 #define CXX_PREFIX               "__Z"
 #define VTABLE_PREFIX            CXX_PREFIX "TV"
 #define OSOBJ_PREFIX             CXX_PREFIX "N"
@@ -40,6 +43,9 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define SYM_MAX_NAME_LEN  256U
 
+#define MACHO_CXX_SYMBOL_OSOBJ_CLASS  \
+  (MACHO_CXX_SYMBOL_SMCP | MACHO_CXX_SYMBOL_METACLASS_POINTER)
+
 /**
   Returns whether Name is pure virtual.
 
@@ -516,6 +522,246 @@ MachoSymbolNameIsCxx (
   return AsciiStrnCmp (Name, CXX_PREFIX, L_STR_LEN (CXX_PREFIX)) == 0;
 }
 
+/**
+  Classifies the C++ symbol name Name.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Name     The name to classify.
+  @param[out]    Info     The output buffer for the classification.
+
+**/
+STATIC
+VOID
+InternalClassifyCxxSymbolName (
+  IN OUT OC_MACHO_CONTEXT       *Context,
+  IN     CONST CHAR8            *Name,
+  OUT    MACHO_CXX_SYMBOL_INFO  *Info
+  )
+{
+  UINTN NameLength;
+
+  ASSERT (Name != NULL);
+  ASSERT (Info != NULL);
+
+  Info->Flags           = 0;
+  Info->ClassNameLength = 0;
+
+  if (MachoSymbolNameIsPureVirtual (Name)) {
+    Info->Flags |= MACHO_CXX_SYMBOL_PURE_VIRTUAL;
+  }
+
+  if (MachoSymbolNameIsPadslot (Name)) {
+    Info->Flags |= MACHO_CXX_SYMBOL_PADSLOT;
+  }
+
+  if (!MachoSymbolNameIsCxx (Name)) {
+    return;
+  }
+
+  Info->Flags |= MACHO_CXX_SYMBOL_CXX;
+  NameLength   = AsciiStrLen (Name);
+  //
+  // VTables and OSObject symbols have distinct prefixes.
+  //
+  if (MachoSymbolNameIsVtable64 (Name)) {
+    Info->Flags          |= MACHO_CXX_SYMBOL_VTABLE;
+    Info->ClassNameLength = (UINT32)(NameLength - L_STR_LEN (VTABLE_PREFIX));
+    return;
+  }
+
+  if (MachoSymbolNameIsSmcp64 (Context, Name)) {
+    Info->Flags          |= MACHO_CXX_SYMBOL_SMCP;
+    Info->ClassNameLength = (UINT32)(
+                              NameLength
+                                - L_STR_LEN (OSOBJ_PREFIX)
+                                - L_STR_LEN (SMCP_TOKEN)
+                              );
+  }
+
+  if (MachoSymbolNameIsMetaclassPointer64 (Context, Name)) {
+    Info->Flags          |= MACHO_CXX_SYMBOL_METACLASS_POINTER;
+    Info->ClassNameLength = (UINT32)(
+                              NameLength
+                                - L_STR_LEN (OSOBJ_PREFIX)
+                                - L_STR_LEN (METACLASS_TOKEN)
+                              );
+  }
+}
+
+/**
+  Classifies all symbols of Context, if it has not been attempted yet.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+  @returns  Whether the classification is available.
+
+**/
+STATIC
+BOOLEAN
+InternalClassifyCxxSymbols (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  MACHO_CXX_SYMBOL_INFO *CxxSymbols;
+  UINT32                NumSymbols;
+  UINT32                Index;
+  CONST MACH_NLIST_64   *Symbol;
+
+  ASSERT (Context != NULL);
+
+  if (Context->CxxSymbolsBuilt) {
+    return Context->CxxSymbols != NULL;
+  }
+
+  Context->CxxSymbolsBuilt = TRUE;
+
+  if (!InternalRetrieveSymtabs64 (Context)) {
+    return FALSE;
+  }
+
+  NumSymbols = Context->Symtab->NumSymbols;
+  if (NumSymbols == 0) {
+    return FALSE;
+  }
+
+  CxxSymbols = AllocatePool (NumSymbols * sizeof (*CxxSymbols));
+  if (CxxSymbols == NULL) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < NumSymbols; ++Index) {
+    Symbol = &Context->SymbolTable[Index];
+    if (!InternalSymbolIsSane (Context, Symbol)) {
+      CxxSymbols[Index].Flags           = 0;
+      CxxSymbols[Index].ClassNameLength = 0;
+      continue;
+    }
+
+    InternalClassifyCxxSymbolName (
+      Context,
+      MachoGetSymbolName64 (Context, Symbol),
+      &CxxSymbols[Index]
+      );
+  }
+
+  Context->CxxSymbols = CxxSymbols;
+
+  return TRUE;
+}
+
+/**
+  Retrieves the C++ classification of Symbol.  Symbols outside of the symbol
+  table of Context are classified by name into Buffer.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Symbol   The symbol to classify.
+  @param[out]    Buffer   Scratch buffer for the classification.
+
+  @returns  The classification of Symbol.
+
+**/
+STATIC
+CONST MACHO_CXX_SYMBOL_INFO *
+InternalGetCxxSymbolInfo (
+  IN OUT OC_MACHO_CONTEXT       *Context,
+  IN     CONST MACH_NLIST_64    *Symbol,
+  OUT    MACHO_CXX_SYMBOL_INFO  *Buffer
+  )
+{
+  ASSERT (Context != NULL);
+  ASSERT (Symbol != NULL);
+  ASSERT (Buffer != NULL);
+
+  if (InternalClassifyCxxSymbols (Context)
+   && (Symbol >= &Context->SymbolTable[0])
+   && (Symbol < &Context->SymbolTable[Context->Symtab->NumSymbols])) {
+    return &Context->CxxSymbols[Symbol - Context->SymbolTable];
+  }
+
+  InternalClassifyCxxSymbolName (
+    Context,
+    MachoGetSymbolName64 (Context, Symbol),
+    Buffer
+    );
+
+  return Buffer;
+}
+
+/**
+  Retrieves the C++ classification of Symbol.  The first call classifies all
+  symbols of Context, the result is freed by MachoFreeContext.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Symbol   The symbol to classify.
+
+  @returns  A combination of MACHO_CXX_SYMBOL_* flags.
+
+**/
+UINT32
+MachoGetCxxSymbolFlags64 (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol
+  )
+{
+  MACHO_CXX_SYMBOL_INFO Buffer;
+
+  ASSERT (Context != NULL);
+  ASSERT (Symbol != NULL);
+
+  return InternalGetCxxSymbolInfo (Context, Symbol, &Buffer)->Flags;
+}
+
+/**
+  Retrieves the class name of a VTable, Metaclass Pointer or Super Metaclass
+  Pointer symbol from the classification of Context.
+
+  @param[in,out] Context        Context of the Mach-O.
+  @param[in]     Symbol         The symbol to get the class name of.
+  @param[in]     ClassNameSize  The size of ClassName.
+  @param[out]    ClassName      The output buffer for the class name.
+
+  @returns  Whether the name has been retrieved successfully.
+
+**/
+BOOLEAN
+MachoGetClassNameFromSymbol64 (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol,
+  IN     UINTN                ClassNameSize,
+  OUT    CHAR8                *ClassName
+  )
+{
+  MACHO_CXX_SYMBOL_INFO       Buffer;
+  CONST MACHO_CXX_SYMBOL_INFO *Info;
+  CONST CHAR8                 *Name;
+  UINTN                       PrefixSize;
+  UINTN                       OutputSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (Symbol != NULL);
+  ASSERT (ClassNameSize > 0);
+  ASSERT (ClassName != NULL);
+
+  Info = InternalGetCxxSymbolInfo (Context, Symbol, &Buffer);
+
+  if ((Info->Flags & MACHO_CXX_SYMBOL_VTABLE) != 0) {
+    PrefixSize = L_STR_LEN (VTABLE_PREFIX);
+  } else if ((Info->Flags & MACHO_CXX_SYMBOL_OSOBJ_CLASS) != 0) {
+    PrefixSize = L_STR_LEN (OSOBJ_PREFIX);
+  } else {
+    return FALSE;
+  }
+
+  ASSERT (Info->ClassNameLength < ClassNameSize);
+
+  Name       = MachoGetSymbolName64 (Context, Symbol);
+  OutputSize = MIN (Info->ClassNameLength, (ClassNameSize - 1));
+  CopyMem (ClassName, &Name[PrefixSize], OutputSize);
+  ClassName[OutputSize] = '\0';
+
+  return TRUE;
+}
+
 /**
   Returns the number of VTable entires in VtableData.
 
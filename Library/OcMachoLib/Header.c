@@ -19,6 +19,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMachoLib.h>
 
@@ -58,6 +59,121 @@ MachoGetFileSize (
   return Context->FileSize;
 }
 
+/**
+  Returns whether the Load Command layout of Segment is sane.  These values
+  are not modified after the Mach-O Context has been initialized.
+
+  @param[in] Segment  Segment to verify.
+
+**/
+STATIC
+BOOLEAN
+InternalSegmentCommandIsSane (
+  IN CONST MACH_SEGMENT_COMMAND_64  *Segment
+  )
+{
+  BOOLEAN Result;
+  UINTN   TopOfSections;
+
+  ASSERT (Segment != NULL);
+
+  if (!OC_ALIGNED (Segment)
+   || (Segment->CommandType != MACH_LOAD_COMMAND_SEGMENT_64)
+   || (Segment->CommandSize < sizeof (*Segment))) {
+    return FALSE;
+  }
+
+  Result = OcOverflowMulAddUN (
+             Segment->NumSections,
+             sizeof (*Segment->Sections),
+             (UINTN) Segment->Sections,
+             &TopOfSections
+             );
+  if (Result || (((UINTN) Segment + Segment->CommandSize) < TopOfSections)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Indexes the Load Commands used by this library so that they can be looked
+  up without walking the Load Commands.  Only the first UUID, SYMTAB and
+  DYSYMTAB commands are recorded, and segments are recorded up to the first
+  malformed one.  Values that may be modified by the caller, such as segment
+  file offsets, are verified when the command is returned.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+**/
+STATIC
+VOID
+InternalInitializeCommandIndex (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  MACH_HEADER_64          *MachHeader;
+  MACH_LOAD_COMMAND       *Command;
+  UINT32                  Index;
+  BOOLEAN                 SegmentsDone;
+  MACH_SEGMENT_COMMAND_64 *Segment;
+
+  ASSERT (Context != NULL);
+
+  MachHeader   = Context->MachHeader;
+  SegmentsDone = FALSE;
+
+  for (
+    Index = 0, Command = MachHeader->Commands;
+    Index < MachHeader->NumCommands;
+    ++Index, Command = NEXT_MACH_LOAD_COMMAND (Command)
+    ) {
+    switch (Command->CommandType) {
+      case MACH_LOAD_COMMAND_SEGMENT_64:
+        if (SegmentsDone) {
+          break;
+        }
+
+        Segment = (MACH_SEGMENT_COMMAND_64 *) Command;
+        if (!InternalSegmentCommandIsSane (Segment)) {
+          SegmentsDone = TRUE;
+          break;
+        }
+
+        if (Context->NumSegments == ARRAY_SIZE (Context->Segments)) {
+          Context->SegmentsTruncated = TRUE;
+          SegmentsDone               = TRUE;
+          break;
+        }
+
+        Context->Segments[Context->NumSegments] = Segment;
+        ++Context->NumSegments;
+        break;
+
+      case MACH_LOAD_COMMAND_UUID:
+        if (Context->UuidCommand == NULL) {
+          Context->UuidCommand = (MACH_UUID_COMMAND *) Command;
+        }
+        break;
+
+      case MACH_LOAD_COMMAND_SYMTAB:
+        if (Context->SymtabCommand == NULL) {
+          Context->SymtabCommand = (MACH_SYMTAB_COMMAND *) Command;
+        }
+        break;
+
+      case MACH_LOAD_COMMAND_DYSYMTAB:
+        if (Context->DySymtabCommand == NULL) {
+          Context->DySymtabCommand = (MACH_DYSYMTAB_COMMAND *) Command;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
 /**
   Initializes a Mach-O Context.
 
@@ -156,6 +272,113 @@ MachoInitializeContext (
   Context->MachHeader = MachHeader;
   Context->FileSize   = FileSize;
 
+  InternalInitializeCommandIndex (Context);
+
+  return TRUE;
+}
+
+/**
+  Frees the lookup indices allocated for a Mach-O Context.  The Context must
+  not be a copy of another Context sharing its indices.
+
+  @param[in,out] Context  Mach-O Context to free.
+
+**/
+VOID
+MachoFreeContext (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  ASSERT (Context != NULL);
+
+  if (Context->SymbolsByName != NULL) {
+    FreePool (Context->SymbolsByName);
+    Context->SymbolsByName = NULL;
+  }
+
+  Context->SymbolsByNameBuilt = FALSE;
+  Context->NumSymbolsByName   = 0;
+
+  if (Context->SymbolsByAddress != NULL) {
+    FreePool (Context->SymbolsByAddress);
+    Context->SymbolsByAddress = NULL;
+  }
+
+  Context->SymbolsByAddressBuilt = FALSE;
+  Context->NumSymbolsByAddress   = 0;
+
+  if (Context->RelocationsByAddress != NULL) {
+    FreePool (Context->RelocationsByAddress);
+    Context->RelocationsByAddress = NULL;
+  }
+
+  Context->RelocationsByAddressBuilt = FALSE;
+  Context->NumRelocationsByAddress   = 0;
+
+  if (Context->CxxSymbols != NULL) {
+    FreePool (Context->CxxSymbols);
+    Context->CxxSymbols = NULL;
+  }
+
+  Context->CxxSymbolsBuilt = FALSE;
+
+  if (Context->SortedSections != NULL) {
+    FreePool (Context->SortedSections);
+    Context->SortedSections = NULL;
+  }
+
+  Context->SectionsSorted    = FALSE;
+  Context->NumSortedSections = 0;
+}
+
+/**
+  Moves a Mach-O Context to an identical copy of its file, e.g. after the
+  buffer holding it has been reallocated, or indexes the Load Commands
+  again after they have been moved in place.  Lookup indices built so far
+  do not reference Load Commands and are kept.
+
+  @param[in,out] Context   Mach-O Context to move.
+  @param[in]     FileData  Pointer to the copy of the file's data.
+
+  @return  Whether Context has been moved.  Context is unchanged otherwise.
+
+**/
+BOOLEAN
+MachoRebaseContext (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     VOID              *FileData
+  )
+{
+  OC_MACHO_CONTEXT  Previous;
+
+  ASSERT (Context != NULL);
+  ASSERT (FileData != NULL);
+
+  CopyMem (&Previous, Context, sizeof (Previous));
+
+  if (!MachoInitializeContext (Context, FileData, Previous.FileSize)) {
+    return FALSE;
+  }
+
+  Context->SymbolsByNameBuilt        = Previous.SymbolsByNameBuilt;
+  Context->NumSymbolsByName          = Previous.NumSymbolsByName;
+  Context->SymbolsByName             = Previous.SymbolsByName;
+  Context->SymbolsByAddressBuilt     = Previous.SymbolsByAddressBuilt;
+  Context->NumSymbolsByAddress       = Previous.NumSymbolsByAddress;
+  Context->SymbolsByAddress          = Previous.SymbolsByAddress;
+  Context->RelocationsByAddressBuilt = Previous.RelocationsByAddressBuilt;
+  Context->NumRelocationsByAddress   = Previous.NumRelocationsByAddress;
+  Context->RelocationsByAddress      = Previous.RelocationsByAddress;
+  Context->CxxSymbolsBuilt           = Previous.CxxSymbolsBuilt;
+  Context->CxxSymbols                = Previous.CxxSymbols;
+
+  //
+  // The section table references Load Commands and is built again on demand.
+  //
+  if (Previous.SortedSections != NULL) {
+    FreePool (Previous.SortedSections);
+  }
+
   return TRUE;
 }
 
@@ -266,13 +489,7 @@ MachoGetUuid64 (
 
   ASSERT (Context != NULL);
 
-  UuidCommand = (MACH_UUID_COMMAND *)(
-                  InternalGetNextCommand64 (
-                    Context,
-                    MACH_LOAD_COMMAND_UUID,
-                    NULL
-                    )
-                  );
+  UuidCommand = Context->UuidCommand;
 
   if ((UuidCommand != NULL)
    && OC_ALIGNED (UuidCommand)
@@ -505,7 +722,7 @@ MachoGetNextSegment64 (
   UINTN                   TopOfCommands;
   BOOLEAN                 Result;
   UINT64                  TopOfSegment;
-  UINTN                   TopOfSections;
+  UINT32                  Index;
 
   ASSERT (Context != NULL);
 
@@ -519,28 +736,36 @@ MachoGetNextSegment64 (
       ((UINTN) Segment >= (UINTN) &MachHeader->Commands[0])
         && ((UINTN) Segment < TopOfCommands)
       );
-  }
 
-  NextSegment = (MACH_SEGMENT_COMMAND_64 *)(
-                  InternalGetNextCommand64 (
-                    Context,
-                    MACH_LOAD_COMMAND_SEGMENT_64,
-                    (MACH_LOAD_COMMAND *) Segment
-                    )
-                  );
-  if ((NextSegment == NULL)
-   || !OC_ALIGNED (NextSegment)
-   || (NextSegment->CommandSize < sizeof (*NextSegment))) {
-    return NULL;
+    for (Index = 0; Index < Context->NumSegments; ++Index) {
+      if (Context->Segments[Index] == Segment) {
+        break;
+      }
+    }
+
+    ++Index;
+  } else {
+    Index = 0;
   }
 
-  Result = OcOverflowMulAddUN (
-             NextSegment->NumSections,
-             sizeof (*NextSegment->Sections),
-             (UINTN) NextSegment->Sections,
-             &TopOfSections
-             );
-  if (Result || (((UINTN) NextSegment + NextSegment->CommandSize) < TopOfSections)) {
+  if (Index < Context->NumSegments) {
+    NextSegment = Context->Segments[Index];
+  } else if (Context->SegmentsTruncated || Index > Context->NumSegments) {
+    //
+    // Segments past the index are retrieved by walking the Load Commands.
+    //
+    NextSegment = (MACH_SEGMENT_COMMAND_64 *)(
+                    InternalGetNextCommand64 (
+                      Context,
+                      MACH_LOAD_COMMAND_SEGMENT_64,
+                      (MACH_LOAD_COMMAND *) Segment
+                      )
+                    );
+    if ((NextSegment == NULL)
+     || !InternalSegmentCommandIsSane (NextSegment)) {
+      return NULL;
+    }
+  } else {
     return NULL;
   }
 
@@ -651,6 +876,138 @@ MachoGetSectionByIndex64 (
   return NULL;
 }
 
+/**
+  Returns whether Section lies within Segment, as sections are only found
+  within the segment containing the address.
+
+  @param[in] Segment  Segment containing Section.
+  @param[in] Section  Section to verify.
+
+**/
+STATIC
+BOOLEAN
+InternalSectionIsInSegment (
+  IN CONST MACH_SEGMENT_COMMAND_64  *Segment,
+  IN CONST MACH_SECTION_64          *Section
+  )
+{
+  UINT64  TopOfSegment;
+  UINT64  TopOfSection;
+
+  if (OcOverflowAddU64 (Segment->VirtualAddress, Segment->Size, &TopOfSegment)
+   || OcOverflowAddU64 (Section->Address, Section->Size, &TopOfSection)) {
+    return FALSE;
+  }
+
+  return (Section->Address >= Segment->VirtualAddress)
+      && (TopOfSection <= TopOfSegment);
+}
+
+/**
+  Builds the address-sorted section table of Context.  The table is not built
+  when sections overlap or exceed their segments, as the first match in Load
+  Command order is returned then.  The table is freed by MachoFreeContext.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+**/
+STATIC
+VOID
+InternalInitializeSortedSections (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  MACH_SEGMENT_COMMAND_64 *Segment;
+  MACH_SECTION_64         *Section;
+  MACH_SECTION_64         **SortedSections;
+  UINT32                  NumSections;
+  UINT32                  Index;
+
+  ASSERT (Context != NULL);
+
+  Context->SectionsSorted = TRUE;
+
+  NumSections = 0;
+
+  for (
+    Segment = MachoGetNextSegment64 (Context, NULL);
+    Segment != NULL;
+    Segment = MachoGetNextSegment64 (Context, Segment)
+    ) {
+    for (
+      Section = MachoGetNextSection64 (Context, Segment, NULL);
+      Section != NULL;
+      Section = MachoGetNextSection64 (Context, Segment, Section)
+      ) {
+      //
+      // Empty sections can never contain an address.
+      //
+      if (Section->Size == 0) {
+        continue;
+      }
+
+      if (!InternalSectionIsInSegment (Segment, Section)) {
+        return;
+      }
+
+      ++NumSections;
+    }
+  }
+
+  if (NumSections == 0) {
+    return;
+  }
+
+  SortedSections = AllocatePool (NumSections * sizeof (*SortedSections));
+  if (SortedSections == NULL) {
+    return;
+  }
+
+  NumSections = 0;
+
+  for (
+    Segment = MachoGetNextSegment64 (Context, NULL);
+    Segment != NULL;
+    Segment = MachoGetNextSegment64 (Context, Segment)
+    ) {
+    for (
+      Section = MachoGetNextSection64 (Context, Segment, NULL);
+      Section != NULL;
+      Section = MachoGetNextSection64 (Context, Segment, Section)
+      ) {
+      if (Section->Size == 0) {
+        continue;
+      }
+      //
+      // Sections are usually ordered by address already.
+      //
+      for (
+        Index = NumSections;
+        (Index > 0) && (SortedSections[Index - 1]->Address > Section->Address);
+        --Index
+        ) {
+        SortedSections[Index] = SortedSections[Index - 1];
+      }
+
+      SortedSections[Index] = Section;
+      ++NumSections;
+    }
+  }
+  //
+  // Section bounds were verified above, so the distance cannot wrap.
+  //
+  for (Index = 1; Index < NumSections; ++Index) {
+    if ((SortedSections[Index]->Address - SortedSections[Index - 1]->Address)
+      < SortedSections[Index - 1]->Size) {
+      FreePool (SortedSections);
+      return;
+    }
+  }
+
+  Context->NumSortedSections = NumSections;
+  Context->SortedSections    = SortedSections;
+}
+
 /**
   Retrieves a section by its address.
 
@@ -670,9 +1027,36 @@ MachoGetSectionByAddress64 (
   MACH_SECTION_64         *Section;
   UINT64                  TopOfSegment;
   UINT64                  TopOfSection;
+  UINT32                  Low;
+  UINT32                  High;
+  UINT32                  Middle;
 
   ASSERT (Context != NULL);
 
+  if (!Context->SectionsSorted) {
+    InternalInitializeSortedSections (Context);
+  }
+
+  if (Context->SortedSections != NULL) {
+    Low  = 0;
+    High = Context->NumSortedSections;
+
+    while (Low < High) {
+      Middle  = Low + (High - Low) / 2;
+      Section = Context->SortedSections[Middle];
+
+      if (Address < Section->Address) {
+        High = Middle;
+      } else if ((Address - Section->Address) >= Section->Size) {
+        Low = Middle + 1;
+      } else {
+        return Section;
+      }
+    }
+
+    return NULL;
+  }
+
   for (
     Segment = MachoGetNextSegment64 (Context, NULL);
     Segment != NULL;
@@ -732,13 +1116,7 @@ InternalRetrieveSymtabs64 (
   //
   // Retrieve SYMTAB.
   //
-  Symtab = (MACH_SYMTAB_COMMAND *)(
-             InternalGetNextCommand64 (
-               Context,
-               MACH_LOAD_COMMAND_SYMTAB,
-               NULL
-               )
-             );
+  Symtab = Context->SymtabCommand;
   if ((Symtab == NULL)
    || !OC_ALIGNED (Symtab)
    || (Symtab->CommandSize != sizeof (*Symtab))) {
@@ -780,13 +1158,7 @@ InternalRetrieveSymtabs64 (
   //
   // Retrieve DYSYMTAB.
   //
-  DySymtab = (MACH_DYSYMTAB_COMMAND *)(
-               InternalGetNextCommand64 (
-                 Context,
-                 MACH_LOAD_COMMAND_DYSYMTAB,
-                 NULL
-                 )
-               );
+  DySymtab = Context->DySymtabCommand;
   if ((DySymtab == NULL)
    || !OC_ALIGNED (DySymtab) 
    || (DySymtab->CommandSize != sizeof (*DySymtab))) {
@@ -45,6 +45,40 @@ InternalGetExternalRelocationByOffset (
   IN     UINT64            Address
   );
 
+/**
+  Compares two entries of an index by their table indices.
+
+  @param[in] Context  Context of the Mach-O.
+  @param[in] First    Table index of the first entry.
+  @param[in] Second   Table index of the second entry.
+
+  @returns  The comparison result in AsciiStrCmp notation.
+**/
+typedef
+INTN
+(*INTERNAL_INDEX_COMPARE) (
+  IN CONST OC_MACHO_CONTEXT  *Context,
+  IN UINT32                  First,
+  IN UINT32                  Second
+  );
+
+/**
+  Sorts table indices in place.  Heap sort is used as it needs no additional
+  memory.  Compare must provide a total order for the result to be stable.
+
+  @param[in]     Context  Context of the Mach-O.
+  @param[in,out] Indices  Table indices to sort.
+  @param[in]     Count    Number of entries in Indices.
+  @param[in]     Compare  Comparison function for the entries.
+**/
+VOID
+InternalSortIndices (
+  IN     CONST OC_MACHO_CONTEXT  *Context,
+  IN OUT UINT32                  *Indices,
+  IN     UINT32                  Count,
+  IN     INTERNAL_INDEX_COMPARE  Compare
+  );
+
 /**
   Check symbol validity.
 
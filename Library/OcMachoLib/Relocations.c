@@ -17,6 +17,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <IndustryStandard/AppleMachoImage.h>
 
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcMachoLib.h>
 
 #include "OcMachoLibInternal.h"
@@ -65,8 +66,120 @@ MachoPreserveRelocationIntel64 (
   return (Type == MachX8664RelocUnsigned);
 }
 
+/**
+  Compares two extern Relocations by address, Relocations with equal
+  addresses are ordered by index.
+
+  @param[in] Context  Context of the Mach-O.
+  @param[in] First    Index of the first Relocation.
+  @param[in] Second   Index of the second Relocation.
+
+  @returns  The comparison result in AsciiStrCmp notation.
+
+**/
+STATIC
+INTN
+InternalCompareRelocationsByAddress (
+  IN CONST OC_MACHO_CONTEXT  *Context,
+  IN UINT32                  First,
+  IN UINT32                  Second
+  )
+{
+  UINT64 FirstAddress;
+  UINT64 SecondAddress;
+
+  FirstAddress  = (UINT64)Context->ExternRelocations[First].Address;
+  SecondAddress = (UINT64)Context->ExternRelocations[Second].Address;
+
+  if (FirstAddress != SecondAddress) {
+    return (FirstAddress < SecondAddress) ? -1 : 1;
+  }
+
+  return (First < Second) ? -1 : (First > Second);
+}
+
+/**
+  Builds the address-sorted index of the extern Relocations of Context that
+  may be returned by InternalGetExternalRelocationByOffset, if it has not
+  been attempted yet.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+  @returns  Whether the index is available.
+
+**/
+STATIC
+BOOLEAN
+InternalBuildRelocationsByAddress (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  UINT32               *Indices;
+  UINT32               NumRelocations;
+  UINT32               Index;
+  UINT32               Count;
+  MACH_RELOCATION_INFO *Relocation;
+
+  ASSERT (Context != NULL);
+
+  if (Context->RelocationsByAddressBuilt) {
+    return Context->RelocationsByAddress != NULL;
+  }
+
+  Context->RelocationsByAddressBuilt = TRUE;
+
+  NumRelocations = Context->DySymtab->NumExternalRelocations;
+  if (NumRelocations == 0) {
+    return FALSE;
+  }
+
+  Indices = AllocatePool (NumRelocations * sizeof (*Indices));
+  if (Indices == NULL) {
+    return FALSE;
+  }
+  //
+  // Skip the same Relocations as the linear scan.
+  //
+  Count = 0;
+  for (Index = 0; Index < NumRelocations; ++Index) {
+    Relocation = &Context->ExternRelocations[Index];
+    if (((UINT32)Relocation->Address & MACH_RELOC_SCATTERED) != 0) {
+      continue;
+    }
+
+    if ((Relocation->Extern == 0)
+     && (Relocation->Address == MACH_RELOC_ABSOLUTE)) {
+      continue;
+    }
+
+    Indices[Count] = Index;
+    ++Count;
+
+    if (MachoRelocationIsPairIntel64 ((UINT8)Relocation->Type)) {
+      if (Index == (MAX_UINT32 - 1)) {
+        break;
+      }
+      ++Index;
+    }
+  }
+
+  InternalSortIndices (
+    Context,
+    Indices,
+    Count,
+    InternalCompareRelocationsByAddress
+    );
+
+  Context->RelocationsByAddress    = Indices;
+  Context->NumRelocationsByAddress = Count;
+
+  return TRUE;
+}
+
 /**
   Retrieves an extern Relocation by the address it targets.
+  The first call sorts the extern Relocations of Context by address, the
+  index is freed by MachoFreeContext.
 
   @param[in,out] Context  Context of the Mach-O.
   @param[in]     Address  The address to search for.
@@ -82,6 +195,9 @@ InternalGetExternalRelocationByOffset (
 {
   UINT32               Index;
   MACH_RELOCATION_INFO *Relocation;
+  UINT32               Low;
+  UINT32               High;
+  UINT32               Middle;
 
   ASSERT (Context != NULL);
   //
@@ -94,6 +210,32 @@ InternalGetExternalRelocationByOffset (
   ASSERT (Context->DySymtab != NULL);
   ASSERT (Context->ExternRelocations != NULL);
 
+  if (InternalBuildRelocationsByAddress (Context)) {
+    //
+    // Find the first Relocation targeting Address.
+    //
+    Low  = 0;
+    High = Context->NumRelocationsByAddress;
+    while (Low < High) {
+      Middle     = Low + (High - Low) / 2;
+      Relocation = &Context->ExternRelocations[Context->RelocationsByAddress[Middle]];
+      if ((UINT64)Relocation->Address < Address) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+
+    if (Low < Context->NumRelocationsByAddress) {
+      Relocation = &Context->ExternRelocations[Context->RelocationsByAddress[Low]];
+      if ((UINT64)Relocation->Address == Address) {
+        return Relocation;
+      }
+    }
+
+    return NULL;
+  }
+
   for (Index = 0; Index < Context->DySymtab->NumExternalRelocations; ++Index) {
     Relocation = &Context->ExternRelocations[Index];
     //
@@ -18,6 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMachoLib.h>
 
@@ -320,12 +321,167 @@ MachoGetSymbolByExternRelocationOffset64 (
   return NULL;
 }
 
+/**
+  Compares two symbols by name, equally named symbols are ordered by index.
+
+  @param[in] Context  Context of the Mach-O.
+  @param[in] First    Index of the first symbol.
+  @param[in] Second   Index of the second symbol.
+
+  @returns  The comparison result in AsciiStrCmp notation.
+
+**/
+STATIC
+INTN
+InternalCompareSymbolsByName (
+  IN CONST OC_MACHO_CONTEXT  *Context,
+  IN UINT32                  First,
+  IN UINT32                  Second
+  )
+{
+  INTN Result;
+
+  Result = AsciiStrCmp (
+             Context->StringTable + Context->SymbolTable[First].UnifiedName.StringIndex,
+             Context->StringTable + Context->SymbolTable[Second].UnifiedName.StringIndex
+             );
+  if (Result != 0) {
+    return Result;
+  }
+
+  return (First < Second) ? -1 : (First > Second);
+}
+
+/**
+  Restores the heap property below Root for InternalSortIndices.
+
+  @param[in]     Context  Context of the Mach-O.
+  @param[in,out] Indices  Indices forming the heap.
+  @param[in]     Root     Index of the root entry to sift down.
+  @param[in]     Count    Number of entries in the heap.
+  @param[in]     Compare  Comparison function for the entries.
+
+**/
+STATIC
+VOID
+InternalSiftIndices (
+  IN     CONST OC_MACHO_CONTEXT  *Context,
+  IN OUT UINT32                  *Indices,
+  IN     UINT32                  Root,
+  IN     UINT32                  Count,
+  IN     INTERNAL_INDEX_COMPARE  Compare
+  )
+{
+  UINT32 Child;
+  UINT32 Swap;
+
+  while (Root < Count / 2) {
+    Child = 2 * Root + 1;
+    if ((Child + 1 < Count)
+     && (Compare (Context, Indices[Child], Indices[Child + 1]) < 0)) {
+      ++Child;
+    }
+
+    if (Compare (Context, Indices[Root], Indices[Child]) >= 0) {
+      return;
+    }
+
+    Swap           = Indices[Root];
+    Indices[Root]  = Indices[Child];
+    Indices[Child] = Swap;
+    Root           = Child;
+  }
+}
+
+VOID
+InternalSortIndices (
+  IN     CONST OC_MACHO_CONTEXT  *Context,
+  IN OUT UINT32                  *Indices,
+  IN     UINT32                  Count,
+  IN     INTERNAL_INDEX_COMPARE  Compare
+  )
+{
+  UINT32 Index;
+  UINT32 Swap;
+
+  for (Index = Count / 2; Index > 0; --Index) {
+    InternalSiftIndices (Context, Indices, Index - 1, Count, Compare);
+  }
+
+  for (Index = Count; Index > 1; --Index) {
+    Swap               = Indices[0];
+    Indices[0]         = Indices[Index - 1];
+    Indices[Index - 1] = Swap;
+    InternalSiftIndices (Context, Indices, 0, Index - 1, Compare);
+  }
+}
+
+/**
+  Builds the name-sorted index of the sane symbols of Context, if it has not
+  been attempted yet.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+  @returns  Whether the index is available.
+
+**/
+STATIC
+BOOLEAN
+InternalBuildSymbolsByName (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  UINT32  *Indices;
+  UINT32  NumSymbols;
+  UINT32  Index;
+  UINT32  Count;
+
+  ASSERT (Context != NULL);
+
+  if (Context->SymbolsByNameBuilt) {
+    return Context->SymbolsByName != NULL;
+  }
+
+  Context->SymbolsByNameBuilt = TRUE;
+
+  if (!InternalRetrieveSymtabs64 (Context)
+   || (Context->Symtab->NumSymbols == 0)) {
+    return FALSE;
+  }
+
+  NumSymbols = Context->Symtab->NumSymbols;
+  Indices    = AllocatePool (NumSymbols * sizeof (*Indices));
+  if (Indices == NULL) {
+    return FALSE;
+  }
+
+  Count = 0;
+  for (Index = 0; Index < NumSymbols; ++Index) {
+    if (InternalSymbolIsSane (Context, &Context->SymbolTable[Index])) {
+      Indices[Count] = Index;
+      ++Count;
+    }
+  }
+
+  InternalSortIndices (
+    Context,
+    Indices,
+    Count,
+    InternalCompareSymbolsByName
+    );
+
+  Context->SymbolsByName    = Indices;
+  Context->NumSymbolsByName = Count;
+
+  return TRUE;
+}
+
 /**
   Retrieves a symbol by its name.
 
   @param[in] Context          Context of the Mach-O.
-  @param[in] SymbolTable      Symbol Table of the Mach-O.
-  @param[in] NumberOfSymbols  Number of symbols in SymbolTable.
+  @param[in] FirstSymbol      Index of the first symbol to consider.
+  @param[in] NumberOfSymbols  Number of symbols to consider.
   @param[in] Name             Name of the symbol to locate.
 
   @retval NULL  NULL is returned on failure.
@@ -335,23 +491,61 @@ STATIC
 MACH_NLIST_64 *
 InternalGetSymbolByName (
   IN OUT OC_MACHO_CONTEXT  *Context,
-  IN     MACH_NLIST_64     *SymbolTable,
+  IN     UINT32            FirstSymbol,
   IN     UINT32            NumberOfSymbols,
   IN     CONST CHAR8       *Name
   )
 {
-  UINT32       Index;
-  CONST CHAR8  *TmpName;
+  MACH_NLIST_64  *SymbolTable;
+  UINT32         Index;
+  UINT32         Low;
+  UINT32         High;
+  UINT32         Middle;
+  CONST CHAR8    *TmpName;
 
-  ASSERT (SymbolTable != NULL);
+  ASSERT (Context->SymbolTable != NULL);
   ASSERT (Name != NULL);
 
-  for (Index = 0; Index < NumberOfSymbols; ++Index) {
-    if (!InternalSymbolIsSane (Context, &SymbolTable[Index])) {
-      continue;
+  SymbolTable = Context->SymbolTable;
+
+  if (!InternalBuildSymbolsByName (Context)) {
+    for (Index = FirstSymbol; Index - FirstSymbol < NumberOfSymbols; ++Index) {
+      if (!InternalSymbolIsSane (Context, &SymbolTable[Index])) {
+        continue;
+      }
+      TmpName = MachoGetSymbolName64 (Context, &SymbolTable[Index]);
+      if (TmpName != NULL && AsciiStrCmp (Name, TmpName) == 0) {
+        return &SymbolTable[Index];
+      }
     }
-    TmpName = MachoGetSymbolName64 (Context, &SymbolTable[Index]);
-    if (TmpName != NULL && AsciiStrCmp (Name, TmpName) == 0) {
+
+    return NULL;
+  }
+  //
+  // Find the first symbol named Name, equally named symbols follow ordered by
+  // their index.
+  //
+  Low  = 0;
+  High = Context->NumSymbolsByName;
+  while (Low < High) {
+    Middle  = Low + (High - Low) / 2;
+    TmpName = Context->StringTable
+      + SymbolTable[Context->SymbolsByName[Middle]].UnifiedName.StringIndex;
+    if (AsciiStrCmp (TmpName, Name) < 0) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  for (; Low < Context->NumSymbolsByName; ++Low) {
+    Index   = Context->SymbolsByName[Low];
+    TmpName = Context->StringTable + SymbolTable[Index].UnifiedName.StringIndex;
+    if (AsciiStrCmp (TmpName, Name) != 0) {
+      break;
+    }
+
+    if (Index - FirstSymbol < NumberOfSymbols) {
       return &SymbolTable[Index];
     }
   }
@@ -359,6 +553,36 @@ InternalGetSymbolByName (
   return NULL;
 }
 
+/**
+  Retrieves the first symbol by the name of Name.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Name     Name of the symbol to locate.
+
+  @retval NULL  NULL is returned on failure.
+
+**/
+MACH_NLIST_64 *
+MachoGetSymbolByName64 (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     CONST CHAR8       *Name
+  )
+{
+  ASSERT (Context != NULL);
+  ASSERT (Name != NULL);
+
+  if (!InternalRetrieveSymtabs64 (Context)) {
+    return NULL;
+  }
+
+  return InternalGetSymbolByName (
+           Context,
+           0,
+           Context->Symtab->NumSymbols,
+           Name
+           );
+}
+
 /**
   Retrieves a locally defined symbol by its name.
 
@@ -372,7 +596,6 @@ MachoGetLocalDefinedSymbolByName (
   IN     CONST CHAR8       *Name
   )
 {
-  MACH_NLIST_64               *SymbolTable;
   CONST MACH_DYSYMTAB_COMMAND *DySymtab;
   MACH_NLIST_64               *Symbol;
 
@@ -383,21 +606,20 @@ MachoGetLocalDefinedSymbolByName (
     return NULL;
   }
 
-  SymbolTable  = Context->SymbolTable;
-  DySymtab     = Context->DySymtab;
-  ASSERT (SymbolTable != NULL);
+  DySymtab = Context->DySymtab;
+  ASSERT (Context->SymbolTable != NULL);
   ASSERT (DySymtab != NULL);
 
   Symbol = InternalGetSymbolByName (
              Context,
-             &SymbolTable[DySymtab->LocalSymbolsIndex],
+             DySymtab->LocalSymbolsIndex,
              DySymtab->NumLocalSymbols,
              Name
              );
   if (Symbol == NULL) {
     Symbol = InternalGetSymbolByName (
                Context,
-               &SymbolTable[DySymtab->ExternalSymbolsIndex],
+               DySymtab->ExternalSymbolsIndex,
                DySymtab->NumExternalSymbols,
                Name
                );
@@ -526,3 +748,199 @@ MachoSymbolGetFileOffset64 (
   *FileOffset = (Section->Offset + (UINT32)Offset);
   return TRUE;
 }
+
+/**
+  Returns whether Symbol marks the start of code or data within a section.
+
+  @param[in] Symbol  Symbol to evaluate.
+
+**/
+STATIC
+BOOLEAN
+InternalSymbolIsBound (
+  IN CONST MACH_NLIST_64  *Symbol
+  )
+{
+  return ((Symbol->Type & MACH_N_TYPE_STAB) == 0)
+      && ((Symbol->Type & MACH_N_TYPE_TYPE) == MACH_N_TYPE_SECT);
+}
+
+/**
+  Compares two symbols by value, equal values are ordered by index.
+
+  @param[in] Context  Context of the Mach-O.
+  @param[in] First    Index of the first symbol.
+  @param[in] Second   Index of the second symbol.
+
+  @returns  The comparison result in AsciiStrCmp notation.
+
+**/
+STATIC
+INTN
+InternalCompareSymbolsByAddress (
+  IN CONST OC_MACHO_CONTEXT  *Context,
+  IN UINT32                  First,
+  IN UINT32                  Second
+  )
+{
+  UINT64 FirstValue;
+  UINT64 SecondValue;
+
+  FirstValue  = Context->SymbolTable[First].Value;
+  SecondValue = Context->SymbolTable[Second].Value;
+  if (FirstValue != SecondValue) {
+    return (FirstValue < SecondValue) ? -1 : 1;
+  }
+
+  return (First < Second) ? -1 : (First > Second);
+}
+
+/**
+  Builds the address-sorted index of the sane section symbols of Context, if
+  it has not been attempted yet.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+  @returns  Whether the index is available.
+
+**/
+STATIC
+BOOLEAN
+InternalBuildSymbolsByAddress (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  UINT32  *Indices;
+  UINT32  NumSymbols;
+  UINT32  Index;
+  UINT32  Count;
+
+  ASSERT (Context != NULL);
+
+  if (Context->SymbolsByAddressBuilt) {
+    return Context->SymbolsByAddress != NULL;
+  }
+
+  Context->SymbolsByAddressBuilt = TRUE;
+
+  if (!InternalRetrieveSymtabs64 (Context)
+   || (Context->Symtab->NumSymbols == 0)) {
+    return FALSE;
+  }
+
+  NumSymbols = Context->Symtab->NumSymbols;
+  Indices    = AllocatePool (NumSymbols * sizeof (*Indices));
+  if (Indices == NULL) {
+    return FALSE;
+  }
+
+  Count = 0;
+  for (Index = 0; Index < NumSymbols; ++Index) {
+    if (InternalSymbolIsBound (&Context->SymbolTable[Index])
+     && InternalSymbolIsSane (Context, &Context->SymbolTable[Index])) {
+      Indices[Count] = Index;
+      ++Count;
+    }
+  }
+
+  InternalSortIndices (
+    Context,
+    Indices,
+    Count,
+    InternalCompareSymbolsByAddress
+    );
+
+  Context->SymbolsByAddress    = Indices;
+  Context->NumSymbolsByAddress = Count;
+
+  return TRUE;
+}
+
+/**
+  Retrieves the extent of the code or data Symbol points to, i.e. the
+  distance to the next symbol address or to the end of the section.
+  The address index used is freed by MachoFreeContext.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Symbol   Section symbol to retrieve the extent of.
+  @param[out]    Size     Pointer the extent size is returned into.
+                          If FALSE is returned, the output is undefined.
+
+  @retval FALSE is returned on failure.
+
+**/
+BOOLEAN
+MachoGetSymbolExtent64 (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol,
+  OUT    UINT64               *Size
+  )
+{
+  MACH_SECTION_64 *Section;
+  MACH_NLIST_64   *SymbolTable;
+  UINT64          End;
+  UINT64          Value;
+  UINT32          Index;
+  UINT32          Low;
+  UINT32          High;
+  UINT32          Middle;
+
+  ASSERT (Context != NULL);
+  ASSERT (Symbol != NULL);
+  ASSERT (Size != NULL);
+
+  if (!InternalSymbolIsBound (Symbol)
+   || (Symbol->Section == NO_SECT)
+   || !InternalRetrieveSymtabs64 (Context)) {
+    return FALSE;
+  }
+
+  Section = MachoGetSectionByIndex64 (Context, Symbol->Section - 1);
+  if ((Section == NULL)
+   || (Symbol->Value < Section->Address)
+   || OcOverflowAddU64 (Section->Address, Section->Size, &End)
+   || (Symbol->Value > End)) {
+    return FALSE;
+  }
+
+  SymbolTable = Context->SymbolTable;
+
+  if (!InternalBuildSymbolsByAddress (Context)) {
+    for (Index = 0; Index < Context->Symtab->NumSymbols; ++Index) {
+      Value = SymbolTable[Index].Value;
+      if ((Value > Symbol->Value)
+       && (Value < End)
+       && InternalSymbolIsBound (&SymbolTable[Index])
+       && InternalSymbolIsSane (Context, &SymbolTable[Index])) {
+        End = Value;
+      }
+    }
+
+    *Size = End - Symbol->Value;
+    return TRUE;
+  }
+  //
+  // Find the first symbol past Symbol, symbols sharing its address are
+  // aliases and do not end it.
+  //
+  Low  = 0;
+  High = Context->NumSymbolsByAddress;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (SymbolTable[Context->SymbolsByAddress[Middle]].Value <= Symbol->Value) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if (Low < Context->NumSymbolsByAddress) {
+    Value = SymbolTable[Context->SymbolsByAddress[Low]].Value;
+    if (Value < End) {
+      End = Value;
+    }
+  }
+
+  *Size = End - Symbol->Value;
+  return TRUE;
+}
@@ -29,7 +29,9 @@
 //
 // Additional modifications include permitting tabulation and other whitespace
 // characters to appear in the encoded data. The intention of those is to support
-// Base64 data from property lists.
+// Base64 data from property lists. Whole 4-character quanta without
+// whitespace are decoded at once, and decoding may be performed in place
+// (DecodedData == EncodedData), since output never overtakes input.
 //
 
 #define WHITESPACE 64
@@ -60,13 +62,38 @@ OcBase64Decode (
   )
 {
   CONST CHAR8 *End = EncodedData + EncodedLength;
+  CONST CHAR8 *BlockEnd = EncodedLength >= 4 ? End - 3 : EncodedData;
   CHAR8 Iter = 0;
   UINT32 Buf = 0;
   UINTN Len = 0;
-  
+  UINT8 C0, C1, C2, C3;
+
   while (EncodedData < End) {
+    //
+    // Fast path: four valid characters on a quantum boundary give three bytes at once.
+    // Output never overtakes input here, which makes in-place decoding safe.
+    //
+    if (Iter == 0 && EncodedData < BlockEnd) {
+      C0 = D[(UINT8)EncodedData[0]];
+      C1 = D[(UINT8)EncodedData[1]];
+      C2 = D[(UINT8)EncodedData[2]];
+      C3 = D[(UINT8)EncodedData[3]];
+      if ((C0 | C1 | C2 | C3) < WHITESPACE) {
+        if (*DecodedLength - Len < 3) return RETURN_BUFFER_TOO_SMALL; /* buffer overflow */
+        Buf = (UINT32)C0 << 18U | (UINT32)C1 << 12U | (UINT32)C2 << 6U | C3;
+        DecodedData[0] = (Buf >> 16U) & 255U;
+        DecodedData[1] = (Buf >> 8U) & 255U;
+        DecodedData[2] = Buf & 255U;
+        DecodedData += 3;
+        EncodedData += 4;
+        Len += 3;
+        Buf = 0;
+        continue;
+      }
+    }
+
     UINT8 C = D[(UINT8)(*EncodedData++)];
-    
+
     switch (C) {
       case WHITESPACE:
         continue;       /* skip whitespace */
@@ -85,10 +112,10 @@ OcBase64Decode (
           *(DecodedData++) = (Buf >> 8U) & 255U;
           *(DecodedData++) = Buf & 255U;
           Buf = 0; Iter = 0;
-        }   
+        }
     }
   }
- 
+
   if (Iter == 3) {
     if ((Len += 2) > *DecodedLength) return RETURN_BUFFER_TOO_SMALL; /* buffer overflow */
     *(DecodedData++) = (Buf >> 10U) & 255U;
@@ -18,6 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include <Library/OcSerializeLib.h>
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 
 OC_SCHEMA *
@@ -153,11 +154,44 @@ ParseSerializedBlob (
   OC_SCHEMA_INFO  *Info
   )
 {
-  BOOLEAN  Result;
-  VOID     *Field;
-  UINT32   Size;
-  VOID     *BlobMemory;
-  UINT32   *BlobSize;
+  BOOLEAN      Result;
+  VOID         *Field;
+  UINT32       Size;
+  VOID         *BlobMemory;
+  UINT32       *BlobSize;
+  UINT8        *Data;
+  CONST CHAR8  *Content;
+
+  Field = OC_SCHEMA_FIELD (Serialized, VOID, Info->Blob.Field);
+
+  //
+  // Data is decoded in place first to allocate exactly the decoded size
+  // and avoid decoding base64 twice.
+  //
+  if (Info->Blob.Type != OC_SCHEMA_BLOB_STRING) {
+    Content = XmlNodeContent (Node);
+
+    if (PlistDataValueInPlace (Node, &Data, &Size)) {
+      BlobMemory = OcBlobAllocate (Field, Size, NULL);
+      if (BlobMemory == NULL) {
+        DEBUG ((DEBUG_INFO, "Failed to allocate %u bytes %a field of type %u\n",
+          Size, XmlNodeName (Node), Info->Blob.Type));
+        return;
+      }
+
+      CopyMem (BlobMemory, Data, Size);
+      return;
+    }
+
+    //
+    // Consumed content means malformed data rather than an unsupported node,
+    // and there is nothing left to retry with.
+    //
+    if (Content != NULL && XmlNodeContent (Node) == NULL) {
+      DEBUG ((DEBUG_INFO, "Failed to parse %a field of type %u\n", XmlNodeName (Node), Info->Blob.Type));
+      return;
+    }
+  }
 
   Result = FALSE;
 
@@ -179,7 +213,6 @@ ParseSerializedBlob (
     return;
   }
 
-  Field  = OC_SCHEMA_FIELD (Serialized, VOID, Info->Blob.Field);
   BlobMemory = OcBlobAllocate (Field, Size, &BlobSize);
 
   if (BlobMemory == NULL) {
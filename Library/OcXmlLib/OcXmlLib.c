@@ -1481,6 +1481,55 @@ PlistDataValue (
   return FALSE;
 }
 
+BOOLEAN
+PlistDataValueInPlace (
+  XML_NODE  *Node,
+  UINT8     **Buffer,
+  UINT32    *Size
+  )
+{
+  CHAR8          *Content;
+  UINTN          Length;
+  RETURN_STATUS  Result;
+
+  if (PlistNodeCast (Node, PLIST_NODE_TYPE_DATA) == NULL) {
+    return FALSE;
+  }
+
+  //
+  // Referenced nodes may be read again via their references.
+  //
+  if (Node->Real != NULL || Node->Attributes != NULL) {
+    return FALSE;
+  }
+
+  if (Node->Content == NULL) {
+    *Buffer = NULL;
+    *Size   = 0;
+    return TRUE;
+  }
+
+  //
+  // Parsed content always resides in the mutable document buffer.
+  //
+  Content = (CHAR8 *) Node->Content;
+  Length  = AsciiStrLen (Content);
+  Result  = OcBase64Decode (Content, Length, (UINT8 *) Content, &Length);
+
+  //
+  // Content is no longer a valid string either way.
+  //
+  Node->Content = NULL;
+
+  if (!RETURN_ERROR (Result) && (UINT32) Length == Length) {
+    *Buffer = (UINT8 *) Content;
+    *Size   = (UINT32) Length;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
 BOOLEAN
 PlistBooleanValue (
   XML_NODE  *Node,
@@ -1552,6 +1601,7 @@ PlistMetaDataValue (
   if (PlistNodeCast (Node, PLIST_NODE_TYPE_DATA) != NULL) {
     Content = XmlNodeContent (Node);
     if (Content != NULL) {
+      Length = *Size;
       Result = OcBase64Decode (Content, AsciiStrLen (Content), Buffer, &Length);
 
       if (!RETURN_ERROR (Result) && (UINT32) Length == Length) {
@@ -13141,6 +13141,35 @@ KernelPatch = {
   .Skip    = 0
 };
 
+//
+// Bounded searches for the return written by KernelPatch.
+//
+STATIC
+PATCHER_GENERIC_PATCH
+KernelSymbolLimitPatch = {
+  .Base    = "_IOLog",
+  .Find    = DisableKernelLog,
+  .Mask    = NULL,
+  .Replace = DisableKernelLog,
+  .Size    = sizeof (DisableKernelLog),
+  .Count   = 1,
+  .Skip    = 0,
+  .Limit   = PATCHER_LIMIT_SYMBOL
+};
+
+STATIC
+PATCHER_GENERIC_PATCH
+KernelByteLimitPatch = {
+  .Base    = "_IOLog",
+  .Find    = DisableKernelLog,
+  .Mask    = NULL,
+  .Replace = DisableKernelLog,
+  .Size    = sizeof (DisableKernelLog),
+  .Count   = 1,
+  .Skip    = 0,
+  .Limit   = sizeof (DisableKernelLog)
+};
+
 STATIC
 VOID
 ApplyKextPatches (
@@ -13310,6 +13339,22 @@ ApplyKernelPatches (
     } else {
       DEBUG ((DEBUG_WARN, "Patch success kernel\n"));
     }
+
+    Status = PatcherApplyGenericPatch (&Patcher, &KernelSymbolLimitPatch);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Failed to apply symbol limited patch kernel - %r\n", Status));
+    } else {
+      DEBUG ((DEBUG_WARN, "Symbol limited patch success kernel\n"));
+    }
+
+    Status = PatcherApplyGenericPatch (&Patcher, &KernelByteLimitPatch);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Failed to apply byte limited patch kernel - %r\n", Status));
+    } else {
+      DEBUG ((DEBUG_WARN, "Byte limited patch success kernel\n"));
+    }
+
+    MachoFreeContext (&Patcher.MachContext);
   } else {
     DEBUG ((DEBUG_WARN, "Failed to find kernel - %r\n", Status));
   }
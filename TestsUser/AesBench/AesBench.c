@@ -0,0 +1,569 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcCryptoLib.h>
+
+#include <Bench.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h AesBench.c ../../Library/OcCryptoLib/Aes.c ../../Library/OcCryptoLib/X64/AesNi.c -o AesBench
+
+ ./AesBench [-s megabytes] [-f filter] > results.json
+
+ Every AES backend supported by the CPU is first checked against FIPS 197
+ and SP 800-38A known answers and against the generic backend for CBC and
+ CTR buffers of up to a few times the pipelined block count, split into
+ random calls, including counter carry across 64-bit halves, for every key
+ size.  Then every mode is timed on a buffer of the given size (64 MB by
+ default) with 128, 192 and 256-bit keys.  Reported per backend and key
+ size:
+   - key_bits          - key size in bits,
+   - status            - 0 on success, 1 for known answer, 2 for cross-check
+                         failure,
+   - cbc_encrypt_mbps  - CBC encryption throughput in megabytes per second,
+   - cbc_decrypt_mbps  - CBC decryption throughput in megabytes per second,
+   - ctr_mbps          - CTR throughput in megabytes per second.
+ Unsupported backends are reported with "supported": false.
+
+ rm -rf AesBench.dSYM AesBench
+*/
+
+#define BENCH_MAX_CHECK_BLOCKS  35
+#define BENCH_MAX_CHECK_SIZE    (BENCH_MAX_CHECK_BLOCKS * AES_BLOCK_SIZE + 5)
+
+typedef struct {
+  CONST CHAR8  *Name;
+  AES_BACKEND  Backend;
+} BENCH_BACKEND;
+
+typedef struct {
+  UINT32  KeySize;
+  UINT8   Key[AES_256_KEY_SIZE];
+  UINT8   CbcIv[AES_BLOCK_SIZE];
+  UINT8   Plaintext[4 * AES_BLOCK_SIZE];
+  UINT8   Cbc[4 * AES_BLOCK_SIZE];
+  UINT8   CtrIv[AES_BLOCK_SIZE];
+  UINT8   Ctr[4 * AES_BLOCK_SIZE];
+  UINT32  CbcSize;
+  UINT32  CtrSize;
+} BENCH_AES_VECTOR;
+
+typedef struct {
+  UINT32   Status;
+  BOOLEAN  Supported;
+  UINT64   CbcEncryptMbps;
+  UINT64   CbcDecryptMbps;
+  UINT64   CtrMbps;
+} BENCH_RESULT;
+
+typedef enum {
+  BenchModeCbcEncrypt,
+  BenchModeCbcDecrypt,
+  BenchModeCtr,
+  BenchModeMax
+} BENCH_MODE;
+
+STATIC
+BENCH_BACKEND
+mBenchBackends[] = {
+  { "aes-generic", AesBackendGeneric },
+  { "aes-ni",      AesBackendAesNi   }
+};
+
+//
+// FIPS 197 Appendix C single block, then SP 800-38A F.2 CBC and F.5 CTR
+// for every key size.
+//
+STATIC
+BENCH_AES_VECTOR
+mAesVectors[] = {
+  {
+    AES_128_KEY_SIZE,
+    {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+    },
+    { 0 },
+    {
+      0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+    },
+    {
+      0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+    },
+    { 0 },
+    { 0 },
+    AES_BLOCK_SIZE,
+    0
+  },
+  {
+    AES_128_KEY_SIZE,
+    {
+      0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+    },
+    {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+    },
+    {
+      0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+      0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+      0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+      0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+    },
+    {
+      0x76, 0x49, 0xAB, 0xAC, 0x81, 0x19, 0xB2, 0x46, 0xCE, 0xE9, 0x8E, 0x9B, 0x12, 0xE9, 0x19, 0x7D,
+      0x50, 0x86, 0xCB, 0x9B, 0x50, 0x72, 0x19, 0xEE, 0x95, 0xDB, 0x11, 0x3A, 0x91, 0x76, 0x78, 0xB2,
+      0x73, 0xBE, 0xD6, 0xB8, 0xE3, 0xC1, 0x74, 0x3B, 0x71, 0x16, 0xE6, 0x9E, 0x22, 0x22, 0x95, 0x16,
+      0x3F, 0xF1, 0xCA, 0xA1, 0x68, 0x1F, 0xAC, 0x09, 0x12, 0x0E, 0xCA, 0x30, 0x75, 0x86, 0xE1, 0xA7
+    },
+    {
+      0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+    },
+    {
+      0x87, 0x4D, 0x61, 0x91, 0xB6, 0x20, 0xE3, 0x26, 0x1B, 0xEF, 0x68, 0x64, 0x99, 0x0D, 0xB6, 0xCE,
+      0x98, 0x06, 0xF6, 0x6B, 0x79, 0x70, 0xFD, 0xFF, 0x86, 0x17, 0x18, 0x7B, 0xB9, 0xFF, 0xFD, 0xFF,
+      0x5A, 0xE4, 0xDF, 0x3E, 0xDB, 0xD5, 0xD3, 0x5E, 0x5B, 0x4F, 0x09, 0x02, 0x0D, 0xB0, 0x3E, 0xAB,
+      0x1E, 0x03, 0x1D, 0xDA, 0x2F, 0xBE, 0x03, 0xD1, 0x79, 0x21, 0x70, 0xA0, 0xF3, 0x00, 0x9C, 0xEE
+    },
+    4 * AES_BLOCK_SIZE,
+    4 * AES_BLOCK_SIZE
+  },
+  {
+    AES_192_KEY_SIZE,
+    {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+      0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17
+    },
+    { 0 },
+    {
+      0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+    },
+    {
+      0xDD, 0xA9, 0x7C, 0xA4, 0x86, 0x4C, 0xDF, 0xE0, 0x6E, 0xAF, 0x70, 0xA0, 0xEC, 0x0D, 0x71, 0x91
+    },
+    { 0 },
+    { 0 },
+    AES_BLOCK_SIZE,
+    0
+  },
+  {
+    AES_192_KEY_SIZE,
+    {
+      0x8E, 0x73, 0xB0, 0xF7, 0xDA, 0x0E, 0x64, 0x52, 0xC8, 0x10, 0xF3, 0x2B, 0x80, 0x90, 0x79, 0xE5,
+      0x62, 0xF8, 0xEA, 0xD2, 0x52, 0x2C, 0x6B, 0x7B
+    },
+    {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+    },
+    {
+      0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+      0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+      0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+      0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+    },
+    {
+      0x4F, 0x02, 0x1D, 0xB2, 0x43, 0xBC, 0x63, 0x3D, 0x71, 0x78, 0x18, 0x3A, 0x9F, 0xA0, 0x71, 0xE8,
+      0xB4, 0xD9, 0xAD, 0xA9, 0xAD, 0x7D, 0xED, 0xF4, 0xE5, 0xE7, 0x38, 0x76, 0x3F, 0x69, 0x14, 0x5A,
+      0x57, 0x1B, 0x24, 0x20, 0x12, 0xFB, 0x7A, 0xE0, 0x7F, 0xA9, 0xBA, 0xAC, 0x3D, 0xF1, 0x02, 0xE0,
+      0x08, 0xB0, 0xE2, 0x79, 0x88, 0x59, 0x88, 0x81, 0xD9, 0x20, 0xA9, 0xE6, 0x4F, 0x56, 0x15, 0xCD
+    },
+    {
+      0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+    },
+    {
+      0x1A, 0xBC, 0x93, 0x24, 0x17, 0x52, 0x1C, 0xA2, 0x4F, 0x2B, 0x04, 0x59, 0xFE, 0x7E, 0x6E, 0x0B,
+      0x09, 0x03, 0x39, 0xEC, 0x0A, 0xA6, 0xFA, 0xEF, 0xD5, 0xCC, 0xC2, 0xC6, 0xF4, 0xCE, 0x8E, 0x94,
+      0x1E, 0x36, 0xB2, 0x6B, 0xD1, 0xEB, 0xC6, 0x70, 0xD1, 0xBD, 0x1D, 0x66, 0x56, 0x20, 0xAB, 0xF7,
+      0x4F, 0x78, 0xA7, 0xF6, 0xD2, 0x98, 0x09, 0x58, 0x5A, 0x97, 0xDA, 0xEC, 0x58, 0xC6, 0xB0, 0x50
+    },
+    4 * AES_BLOCK_SIZE,
+    4 * AES_BLOCK_SIZE
+  },
+  {
+    AES_256_KEY_SIZE,
+    {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+      0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+    },
+    { 0 },
+    {
+      0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+    },
+    {
+      0x8E, 0xA2, 0xB7, 0xCA, 0x51, 0x67, 0x45, 0xBF, 0xEA, 0xFC, 0x49, 0x90, 0x4B, 0x49, 0x60, 0x89
+    },
+    { 0 },
+    { 0 },
+    AES_BLOCK_SIZE,
+    0
+  },
+  {
+    AES_256_KEY_SIZE,
+    {
+      0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+      0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+    },
+    {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+    },
+    {
+      0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+      0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+      0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+      0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+    },
+    {
+      0xF5, 0x8C, 0x4C, 0x04, 0xD6, 0xE5, 0xF1, 0xBA, 0x77, 0x9E, 0xAB, 0xFB, 0x5F, 0x7B, 0xFB, 0xD6,
+      0x9C, 0xFC, 0x4E, 0x96, 0x7E, 0xDB, 0x80, 0x8D, 0x67, 0x9F, 0x77, 0x7B, 0xC6, 0x70, 0x2C, 0x7D,
+      0x39, 0xF2, 0x33, 0x69, 0xA9, 0xD9, 0xBA, 0xCF, 0xA5, 0x30, 0xE2, 0x63, 0x04, 0x23, 0x14, 0x61,
+      0xB2, 0xEB, 0x05, 0xE2, 0xC3, 0x9B, 0xE9, 0xFC, 0xDA, 0x6C, 0x19, 0x07, 0x8C, 0x6A, 0x9D, 0x1B
+    },
+    {
+      0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+    },
+    {
+      0x60, 0x1E, 0xC3, 0x13, 0x77, 0x57, 0x89, 0xA5, 0xB7, 0xA7, 0xF5, 0x04, 0xBB, 0xF3, 0xD2, 0x28,
+      0xF4, 0x43, 0xE3, 0xCA, 0x4D, 0x62, 0xB5, 0x9A, 0xCA, 0x84, 0xE9, 0x90, 0xCA, 0xCA, 0xF5, 0xC5,
+      0x2B, 0x09, 0x30, 0xDA, 0xA2, 0x3D, 0xE9, 0x4C, 0xE8, 0x70, 0x17, 0xBA, 0x2D, 0x84, 0x98, 0x8D,
+      0xDF, 0xC9, 0xC5, 0x8D, 0xB6, 0x7A, 0xAD, 0xA6, 0x13, 0xC2, 0xDD, 0x08, 0x45, 0x79, 0x41, 0xA6
+    },
+    4 * AES_BLOCK_SIZE,
+    4 * AES_BLOCK_SIZE
+  }
+};
+
+/**
+  Process Data with Mode in random sized calls, only the last of which
+  may end in a partial block.
+**/
+STATIC
+VOID
+BenchAesSplit (
+  AES_CONTEXT  *Context,
+  BENCH_MODE   Mode,
+  UINT8        *Data,
+  UINT32       Size,
+  UINT64       *Seed
+  )
+{
+  UINT32  Chunk;
+
+  while (Size > 0) {
+    Chunk = (UINT32) (BenchRandom (Seed) % 12) * AES_BLOCK_SIZE;
+    if (Chunk == 0 || Chunk > Size) {
+      Chunk = Size;
+    }
+
+    switch (Mode) {
+      case BenchModeCbcEncrypt:
+        AesCbcEncryptBuffer (Context, Data, Chunk);
+        break;
+      case BenchModeCbcDecrypt:
+        AESCbcDecryptBuffer (Context, Data, Chunk);
+        break;
+      default:
+        AesCtrXcryptBuffer (Context, Data, Chunk);
+        break;
+    }
+
+    Data += Chunk;
+    Size -= Chunk;
+  }
+}
+
+/**
+  Compare every mode and message size to the generic backend.
+**/
+STATIC
+UINT32
+BenchCrossCheckAes (
+  AES_BACKEND             Backend,
+  CONST BENCH_AES_VECTOR  *Vector,
+  CONST UINT8             *Buffer,
+  UINT64                  *Seed
+  )
+{
+  //
+  // Counters carrying from the low 64-bit half within a pipelined batch,
+  // and wrapping around entirely.
+  //
+  STATIC CONST UINT8 CarryIv[2][AES_BLOCK_SIZE] = {
+    { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFD },
+    { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFA }
+  };
+
+  AES_CONTEXT  Context;
+  AES_CONTEXT  Expected;
+  UINT8        Data[BENCH_MAX_CHECK_SIZE];
+  UINT8        Reference[BENCH_MAX_CHECK_SIZE];
+  UINT32       Index;
+  UINT32       Size;
+  UINT32       Mode;
+
+  for (Mode = 0; Mode < BenchModeMax; Mode++) {
+    for (Size = 0; Size <= BENCH_MAX_CHECK_SIZE; Size++) {
+      if (Mode != BenchModeCtr && Size % AES_BLOCK_SIZE != 0) {
+        continue;
+      }
+
+      for (Index = 0; Index <= (Mode == BenchModeCtr ? ARRAY_SIZE (CarryIv) : 0); Index++) {
+        AesInitCtxIv (
+          &Expected,
+          Vector->Key,
+          Vector->KeySize,
+          Index > 0 ? CarryIv[Index - 1] : &Buffer[Size]
+          );
+        CopyMem (&Context, &Expected, sizeof (Context));
+
+        AesSetBackend (AesBackendGeneric);
+        CopyMem (Reference, Buffer, Size);
+        BenchAesSplit (&Expected, (BENCH_MODE) Mode, Reference, Size, Seed);
+
+        AesSetBackend (Backend);
+        CopyMem (Data, Buffer, Size);
+        BenchAesSplit (&Context, (BENCH_MODE) Mode, Data, Size, Seed);
+
+        if (CompareMem (Data, Reference, Size) != 0
+          || CompareMem (Context.Iv, Expected.Iv, AES_BLOCK_SIZE) != 0) {
+          return 2;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+STATIC
+UINT32
+BenchCheckAes (
+  AES_BACKEND  Backend,
+  CONST UINT8  *Buffer
+  )
+{
+  AES_CONTEXT             Context;
+  CONST BENCH_AES_VECTOR  *Vector;
+  UINT8                   Data[4 * AES_BLOCK_SIZE];
+  UINT64                  Seed;
+  UINT32                  Index;
+  UINT32                  Size;
+  UINT32                  Status;
+
+  AesSetBackend (Backend);
+
+  if (AesInitCtxIv (&Context, mAesVectors[0].Key, AES_128_KEY_SIZE - 1, mAesVectors[0].CbcIv)) {
+    return 1;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mAesVectors); Index++) {
+    Vector = &mAesVectors[Index];
+
+    AesInitCtxIv (&Context, Vector->Key, Vector->KeySize, Vector->CbcIv);
+    CopyMem (Data, Vector->Plaintext, Vector->CbcSize);
+    AesCbcEncryptBuffer (&Context, Data, Vector->CbcSize);
+    if (CompareMem (Data, Vector->Cbc, Vector->CbcSize) != 0) {
+      return 1;
+    }
+
+    AesSetCtxIv (&Context, Vector->CbcIv);
+    AESCbcDecryptBuffer (&Context, Data, Vector->CbcSize);
+    if (CompareMem (Data, Vector->Plaintext, Vector->CbcSize) != 0) {
+      return 1;
+    }
+
+    //
+    // Partial trailing block takes a prefix of the key stream.
+    //
+    for (Size = 0; Size <= Vector->CtrSize; Size += 7) {
+      AesInitCtxIv (&Context, Vector->Key, Vector->KeySize, Vector->CtrIv);
+      CopyMem (Data, Vector->Plaintext, Size);
+      AesCtrXcryptBuffer (&Context, Data, Size);
+      if (CompareMem (Data, Vector->Ctr, Size) != 0) {
+        return 1;
+      }
+    }
+  }
+
+  Seed = 1;
+  for (Index = 0; Index < ARRAY_SIZE (mAesVectors); Index++) {
+    if (Index > 0 && mAesVectors[Index].KeySize == mAesVectors[Index - 1].KeySize) {
+      continue;
+    }
+
+    Status = BenchCrossCheckAes (Backend, &mAesVectors[Index], Buffer, &Seed);
+    if (Status != 0) {
+      return Status;
+    }
+  }
+
+  return 0;
+}
+
+STATIC
+UINT64
+BenchMode (
+  BENCH_MODE  Mode,
+  UINT32      KeySize,
+  UINT8       *Buffer,
+  UINTN       Size
+  )
+{
+  AES_CONTEXT  Context;
+  UINT64       Start;
+  UINT64       Elapsed;
+
+  AesInitCtxIv (&Context, Buffer, KeySize, Buffer);
+
+  Start = BenchTimestamp ();
+  switch (Mode) {
+    case BenchModeCbcEncrypt:
+      AesCbcEncryptBuffer (&Context, Buffer, (UINT32) Size);
+      break;
+    case BenchModeCbcDecrypt:
+      AESCbcDecryptBuffer (&Context, Buffer, (UINT32) Size);
+      break;
+    default:
+      AesCtrXcryptBuffer (&Context, Buffer, (UINT32) Size);
+      break;
+  }
+  Elapsed = BenchTimestamp () - Start;
+
+  return Elapsed > 0 ? (UINT64) Size * 1000ULL / Elapsed : 0;
+}
+
+STATIC
+VOID
+BenchRun (
+  AES_BACKEND   Backend,
+  UINT32        KeySize,
+  UINT8         *Buffer,
+  UINTN         Size,
+  BENCH_RESULT  *Result
+  )
+{
+  ZeroMem (Result, sizeof (*Result));
+
+  Result->Supported = AesSetBackend (Backend);
+  if (!Result->Supported) {
+    return;
+  }
+
+  Result->Status = BenchCheckAes (Backend, Buffer);
+  if (Result->Status != 0) {
+    return;
+  }
+
+  Result->CbcEncryptMbps = BenchMode (BenchModeCbcEncrypt, KeySize, Buffer, Size);
+  Result->CbcDecryptMbps = BenchMode (BenchModeCbcDecrypt, KeySize, Buffer, Size);
+  Result->CtrMbps        = BenchMode (BenchModeCtr, KeySize, Buffer, Size);
+}
+
+STATIC
+VOID
+BenchPrint (
+  FILE          *Output,
+  CONST CHAR8   *Name,
+  UINT32        KeySize,
+  BENCH_RESULT  *Result,
+  BOOLEAN       First
+  )
+{
+  BenchBeginResult (Output, First);
+  fprintf (
+    Output,
+    "{\"name\": \"%s\", \"key_bits\": %u, \"supported\": %s, \"status\": %u, "
+    "\"cbc_encrypt_mbps\": %llu, \"cbc_decrypt_mbps\": %llu, \"ctr_mbps\": %llu}",
+    Name,
+    KeySize * 8,
+    Result->Supported ? "true" : "false",
+    Result->Status,
+    (unsigned long long) Result->CbcEncryptMbps,
+    (unsigned long long) Result->CbcDecryptMbps,
+    (unsigned long long) Result->CtrMbps
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32        Megabytes;
+  CONST CHAR8   *Filter;
+  INT32         Opt;
+  UINT32        Index;
+  UINT32        KeySize;
+  UINT8         *Buffer;
+  UINTN         Size;
+  BENCH_RESULT  Result;
+  BOOLEAN       First;
+  INT32         ExitCode;
+  FILE          *Output;
+
+  Megabytes = 64;
+  Filter    = NULL;
+
+  while ((Opt = getopt (argc, argv, "s:f:")) != -1) {
+    switch (Opt) {
+      case 's':
+        Megabytes = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'f':
+        Filter = optarg;
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-s megabytes] [-f filter]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Megabytes == 0 || Megabytes >= 4096) {
+    fprintf (stderr, "Invalid buffer size\n");
+    return -1;
+  }
+
+  Output = BenchOpenOutput ();
+  if (Output == NULL) {
+    return -1;
+  }
+
+  Size   = (UINTN) Megabytes * BASE_1MB;
+  Buffer = malloc (MAX (Size, BENCH_MAX_CHECK_SIZE + AES_BLOCK_SIZE));
+  if (Buffer == NULL) {
+    fprintf (stderr, "Out of memory\n");
+    return -1;
+  }
+
+  BenchFillRandom (Buffer, Size, 1);
+
+  ExitCode = 0;
+  First    = TRUE;
+  BenchBeginResults (Output, "  \"megabytes\": %u,\n", Megabytes);
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchBackends); Index++) {
+    if (!BenchIsSelected (mBenchBackends[Index].Name, Filter)) {
+      continue;
+    }
+
+    for (KeySize = AES_128_KEY_SIZE; KeySize <= AES_256_KEY_SIZE; KeySize += 8) {
+      BenchRun (mBenchBackends[Index].Backend, KeySize, Buffer, Size, &Result);
+      if (Result.Status != 0) {
+        ExitCode = -1;
+      }
+
+      BenchPrint (Output, mBenchBackends[Index].Name, KeySize, &Result, First);
+      First = FALSE;
+    }
+  }
+
+  BenchEndResults (Output);
+
+  free (Buffer);
+
+  return ExitCode;
+}
@@ -0,0 +1,435 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcAppleChunklistLib.h>
+#include <Library/OcCryptoLib.h>
+
+#include <Bench.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h ChunklistBench.c ../../Library/OcAppleChunklistLib/OcAppleChunklistLib.c ../../Library/OcAppleKeysLib/OcAppleKeysLib.c ../../Library/OcCryptoLib/Rsa2048Sha256.c ../../Library/OcCryptoLib/Sha256.c ../../Library/OcCryptoLib/X64/Sha256Simd.c ../../Library/OcCryptoLib/X64/Sha256MultiBuffer.c -o ChunklistBench
+
+ ./ChunklistBench [-s megabytes] [-c kilobytes] [-p kilobytes] [-f filter] > results.json
+
+ A synthetic image of the given size (256 MB by default) is split into
+ chunks of the given size (10 MB by default, like installer images) with
+ a matching chunklist generated in memory.  For every SHA-256 backend
+ supported by the CPU the image is verified with OcAppleChunklistVerifyData,
+ by hashing the chunks one by one, and streamed in pieces of random size up
+ to twice the given piece size (1 MB by default), then random byte ranges
+ are verified.  The unsigned chunklist must fail signature verification
+ against Apple keys.  Reported per backend:
+   - status          - 0 on success, 1 for a valid image failing verification,
+                       2 for a corrupted and 3 for a truncated one passing it,
+                       4 for a streaming and 5 for a range check failure,
+                       6 for a signature check failure,
+   - sequential_mbps - throughput of per-chunk Sha256,
+   - mbps            - throughput of OcAppleChunklistVerifyData,
+   - stream_mbps     - throughput of OcAppleChunklistStreamUpdate,
+   - signature_us    - OcAppleChunklistVerifySignature time for all Apple keys.
+ Library debug output is discarded, stdout only contains JSON results.
+
+ rm -rf ChunklistBench.dSYM ChunklistBench
+*/
+
+#define BENCH_RANGE_CHECKS  64
+
+typedef struct {
+  CONST CHAR8     *Name;
+  SHA256_BACKEND  Backend;
+} BENCH_BACKEND;
+
+typedef struct {
+  UINT32   Status;
+  BOOLEAN  Supported;
+  UINT64   SequentialMbps;
+  UINT64   Mbps;
+  UINT64   StreamMbps;
+  UINT64   SignatureUs;
+} BENCH_RESULT;
+
+STATIC
+BENCH_BACKEND
+mBenchBackends[] = {
+  { "sha256-generic", Sha256BackendGeneric },
+  { "sha256-ssse3",   Sha256BackendSsse3   },
+  { "sha256-avx2",    Sha256BackendAvx2    },
+  { "sha256-shani",   Sha256BackendShaNi   }
+};
+
+/**
+  Allocate a chunklist for Image split into ChunkSize chunks.
+**/
+STATIC
+UINT8 *
+BenchCreateChunklist (
+  UINT8   *Image,
+  UINTN   Size,
+  UINTN   ChunkSize,
+  UINTN   *ChunklistSize
+  )
+{
+  UINT8                   *Chunklist;
+  APPLE_CHUNKLIST_HEADER  *Header;
+  APPLE_CHUNKLIST_CHUNK   *Chunks;
+  UINTN                   ChunkCount;
+  UINTN                   Index;
+
+  ChunkCount     = (Size + ChunkSize - 1) / ChunkSize;
+  *ChunklistSize = sizeof (*Header) + ChunkCount * sizeof (*Chunks) + sizeof (APPLE_CHUNKLIST_SIG);
+  Chunklist      = calloc (1, *ChunklistSize);
+  if (Chunklist == NULL) {
+    return NULL;
+  }
+
+  Header              = (APPLE_CHUNKLIST_HEADER *) Chunklist;
+  Header->Magic       = APPLE_CHUNKLIST_MAGIC;
+  Header->Length      = sizeof (*Header);
+  Header->FileVersion = APPLE_CHUNKLIST_FILE_VERSION_10;
+  Header->ChunkMethod = APPLE_CHUNKLIST_CHUNK_METHOD_10;
+  Header->SigMethod   = APPLE_CHUNKLIST_SIG_METHOD_10;
+  Header->ChunkCount  = ChunkCount;
+  Header->ChunkOffset = sizeof (*Header);
+  Header->SigOffset   = sizeof (*Header) + ChunkCount * sizeof (*Chunks);
+
+  Chunks = (APPLE_CHUNKLIST_CHUNK *) (Chunklist + Header->ChunkOffset);
+  for (Index = 0; Index < ChunkCount; Index++) {
+    Chunks[Index].Length = (UINT32) MIN (ChunkSize, Size - Index * ChunkSize);
+    Sha256 (Chunks[Index].Checksum, Image + Index * ChunkSize, Chunks[Index].Length);
+  }
+
+  return Chunklist;
+}
+
+/**
+  Verify Size bytes of Image in pieces of random size up to twice PieceSize.
+**/
+STATIC
+EFI_STATUS
+BenchStream (
+  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  UINT8                       *Image,
+  UINTN                       Size,
+  UINTN                       PieceSize,
+  UINT64                      *Seed
+  )
+{
+  OC_APPLE_CHUNKLIST_STREAM  Stream;
+  EFI_STATUS                 Status;
+  UINTN                      Piece;
+
+  OcAppleChunklistStreamInit (Context, &Stream);
+
+  while (Size > 0) {
+    Piece  = (UINTN) (BenchRandom (Seed) % (2 * PieceSize) + 1);
+    Piece  = MIN (Piece, Size);
+    Status = OcAppleChunklistStreamUpdate (&Stream, Image, Piece);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Image += Piece;
+    Size  -= Piece;
+  }
+
+  return OcAppleChunklistStreamFinal (&Stream);
+}
+
+/**
+  Verify chunks covering a byte range of Image.
+**/
+STATIC
+EFI_STATUS
+BenchRange (
+  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  UINT8                       *Image,
+  UINT64                      Offset,
+  UINT64                      Length
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      FirstChunk;
+  UINT64      NumChunks;
+  UINT64      ChunksOffset;
+  UINT64      ChunksLength;
+
+  Status = OcAppleChunklistFindChunks (Context, Offset, Length, &FirstChunk, &NumChunks);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = OcAppleChunklistGetChunkRange (Context, FirstChunk, NumChunks, &ChunksOffset, &ChunksLength);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (ChunksOffset > Offset || ChunksOffset + ChunksLength < Offset + Length) {
+    return EFI_NOT_FOUND;
+  }
+
+  return OcAppleChunklistVerifyChunks (
+    Context,
+    FirstChunk,
+    NumChunks,
+    Image + ChunksOffset,
+    (UINTN) ChunksLength
+    );
+}
+
+STATIC
+VOID
+BenchRun (
+  SHA256_BACKEND              Backend,
+  OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  UINT8                       *Image,
+  UINTN                       Size,
+  UINTN                       PieceSize,
+  BENCH_RESULT                *Result
+  )
+{
+  UINT8       Digest[SHA256_DIGEST_SIZE];
+  UINT8       *Data;
+  UINT64      Index;
+  UINT64      Start;
+  UINT64      Elapsed;
+  UINT64      Seed;
+  UINT64      Offset;
+  UINT64      Length;
+  EFI_STATUS  Status;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  Result->Supported = Sha256SetBackend (Backend);
+  if (!Result->Supported) {
+    return;
+  }
+
+  Data  = Image;
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Context->Header->ChunkCount; Index++) {
+    Sha256 (Digest, Data, Context->Chunks[Index].Length);
+    Data += Context->Chunks[Index].Length;
+  }
+  Elapsed = BenchTimestamp () - Start;
+
+  Result->SequentialMbps = Elapsed > 0 ? (UINT64) Size * 1000ULL / Elapsed : 0;
+
+  Start   = BenchTimestamp ();
+  Status  = OcAppleChunklistVerifyData (Context, Image, Size);
+  Elapsed = BenchTimestamp () - Start;
+  if (Status != EFI_SUCCESS) {
+    Result->Status = 1;
+    return;
+  }
+
+  Result->Mbps = Elapsed > 0 ? (UINT64) Size * 1000ULL / Elapsed : 0;
+
+  //
+  // Corrupt the last byte, then cut it off.
+  //
+  Image[Size - 1] ^= 1;
+  Status = OcAppleChunklistVerifyData (Context, Image, Size);
+  Image[Size - 1] ^= 1;
+  if (Status != EFI_COMPROMISED_DATA) {
+    Result->Status = 2;
+    return;
+  }
+
+  Status = OcAppleChunklistVerifyData (Context, Image, Size - 1);
+  if (Status != EFI_END_OF_FILE) {
+    Result->Status = 3;
+    return;
+  }
+
+  Seed    = 1;
+  Start   = BenchTimestamp ();
+  Status  = BenchStream (Context, Image, Size, PieceSize, &Seed);
+  Elapsed = BenchTimestamp () - Start;
+  if (Status != EFI_SUCCESS) {
+    Result->Status = 4;
+    return;
+  }
+
+  Result->StreamMbps = Elapsed > 0 ? (UINT64) Size * 1000ULL / Elapsed : 0;
+
+  Image[Size / 2] ^= 1;
+  Status = BenchStream (Context, Image, Size, PieceSize, &Seed);
+  Image[Size / 2] ^= 1;
+  if (Status != EFI_COMPROMISED_DATA
+    || BenchStream (Context, Image, Size - 1, PieceSize, &Seed) != EFI_END_OF_FILE) {
+    Result->Status = 4;
+    return;
+  }
+
+  //
+  // Ranges are kept small to only verify a few chunks.
+  //
+  for (Index = 0; Index < BENCH_RANGE_CHECKS; Index++) {
+    Offset = BenchRandom (&Seed) % Size;
+    Length = BenchRandom (&Seed) % PieceSize + 1;
+    Length = MIN (Length, Size - Offset);
+    if (BenchRange (Context, Image, Offset, Length) != EFI_SUCCESS) {
+      Result->Status = 5;
+      return;
+    }
+  }
+
+  Image[Size / 2] ^= 1;
+  Status = BenchRange (Context, Image, Size / 2, 1);
+  Image[Size / 2] ^= 1;
+  if (Status != EFI_COMPROMISED_DATA
+    || BenchRange (Context, Image, Size - 1, 2) != EFI_INVALID_PARAMETER) {
+    Result->Status = 5;
+    return;
+  }
+
+  Start   = BenchTimestamp ();
+  Status  = OcAppleChunklistVerifySignature (Context, NULL);
+  Elapsed = BenchTimestamp () - Start;
+  if (Status != EFI_SECURITY_VIOLATION) {
+    Result->Status = 6;
+    return;
+  }
+
+  Result->SignatureUs = Elapsed / 1000;
+}
+
+STATIC
+VOID
+BenchPrint (
+  FILE          *Output,
+  CONST CHAR8   *Name,
+  BENCH_RESULT  *Result,
+  BOOLEAN       First
+  )
+{
+  BenchBeginResult (Output, First);
+  fprintf (
+    Output,
+    "{\"name\": \"%s\", \"supported\": %s, \"status\": %u, \"sequential_mbps\": %llu, \"mbps\": %llu, \"stream_mbps\": %llu, \"signature_us\": %llu}",
+    Name,
+    Result->Supported ? "true" : "false",
+    Result->Status,
+    (unsigned long long) Result->SequentialMbps,
+    (unsigned long long) Result->Mbps,
+    (unsigned long long) Result->StreamMbps,
+    (unsigned long long) Result->SignatureUs
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32                      Megabytes;
+  UINT32                      Kilobytes;
+  UINT32                      PieceKilobytes;
+  CONST CHAR8                 *Filter;
+  INT32                       Opt;
+  UINTN                       Index;
+  UINT8                       *Image;
+  UINT8                       *Chunklist;
+  UINTN                       Size;
+  UINTN                       ChunklistSize;
+  OC_APPLE_CHUNKLIST_CONTEXT  Context;
+  BENCH_RESULT                Result;
+  BOOLEAN                     First;
+  INT32                       ExitCode;
+  FILE                        *Output;
+
+  Megabytes = 256;
+  Kilobytes      = 10 * 1024;
+  PieceKilobytes = 1024;
+  Filter         = NULL;
+
+  while ((Opt = getopt (argc, argv, "s:c:p:f:")) != -1) {
+    switch (Opt) {
+      case 's':
+        Megabytes = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'c':
+        Kilobytes = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'p':
+        PieceKilobytes = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'f':
+        Filter = optarg;
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-s megabytes] [-c kilobytes] [-p kilobytes] [-f filter]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Megabytes == 0 || Kilobytes == 0 || PieceKilobytes == 0) {
+    fprintf (stderr, "Invalid image, chunk or piece size\n");
+    return -1;
+  }
+
+  Output = BenchOpenOutput ();
+  if (Output == NULL) {
+    return -1;
+  }
+
+  Size  = (UINTN) Megabytes * BASE_1MB;
+  Image = malloc (Size);
+  if (Image == NULL) {
+    fprintf (stderr, "Out of memory\n");
+    return -1;
+  }
+
+  BenchFillRandom (Image, Size, 1);
+
+  Sha256SetBackend (Sha256BackendGeneric);
+  Chunklist = BenchCreateChunklist (Image, Size, (UINTN) Kilobytes * BASE_1KB, &ChunklistSize);
+  if (Chunklist == NULL
+    || OcAppleChunklistInitializeContext (Chunklist, ChunklistSize, &Context) != EFI_SUCCESS) {
+    fprintf (stderr, "Failed to create chunklist\n");
+    return -1;
+  }
+
+  ExitCode = 0;
+  First    = TRUE;
+  BenchBeginResults (
+    Output,
+    "  \"megabytes\": %u,\n  \"chunk_kilobytes\": %u,\n",
+    Megabytes,
+    Kilobytes
+    );
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchBackends); Index++) {
+    if (!BenchIsSelected (mBenchBackends[Index].Name, Filter)) {
+      continue;
+    }
+
+    BenchRun (
+      mBenchBackends[Index].Backend,
+      &Context,
+      Image,
+      Size,
+      (UINTN) PieceKilobytes * BASE_1KB,
+      &Result
+      );
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+
+    BenchPrint (Output, mBenchBackends[Index].Name, &Result, First);
+    First = FALSE;
+  }
+
+  BenchEndResults (Output);
+
+  free (Chunklist);
+  free (Image);
+
+  return ExitCode;
+}
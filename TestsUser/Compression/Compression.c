@@ -0,0 +1,230 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcCompressionLib.h>
+
+#include <Bench.h>
+
+/*
+ clang -g -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h Compression.c ../../Library/OcCompressionLib/lzvn/lzvn.c ../../Library/OcCompressionLib/lzvn/lzvn_encode.c -o Compression
+
+ ./Compression [file...]
+
+ Every buffer is compressed with CompressLZVN into a buffer of
+ OC_LZVN_MAX_COMPRESSED_LENGTH bytes, decompressed with DecompressLZVN and
+ compared with the original.  Generated buffers cover empty and short
+ input, zeroes, random data, text and literal runs alternating with the
+ shortest matches, which grow the most.
+
+ for fuzzing:
+ clang-mp-7.0 -Dmain=__main -g -fsanitize=undefined,address,fuzzer -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h Compression.c ../../Library/OcCompressionLib/lzvn/lzvn.c ../../Library/OcCompressionLib/lzvn/lzvn_encode.c -o Compression
+
+ rm -rf DICT fuzz*.log ; mkdir DICT ; cp /System/Library/Kernels/kernel DICT ; ./Compression -rss_limit_mb=4096M -jobs=4 DICT
+
+ rm -rf Compression.dSYM DICT fuzz*.log Compression
+*/
+
+#define TEST_BUFFER_SIZE  BASE_1MB
+
+uint8_t *readFile(const char *str, uint32_t *size) {
+  FILE *f = fopen(str, "rb");
+
+  if (!f) return NULL;
+
+  fseek(f, 0, SEEK_END);
+  long fsize = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  uint8_t *string = malloc(fsize + 1);
+  fread(string, fsize, 1, f);
+  fclose(f);
+
+  string[fsize] = 0;
+  *size = fsize;
+
+  return string;
+}
+
+typedef enum {
+  TestDataZero,
+  TestDataRandom,
+  TestDataText,
+  TestDataShortMatches
+} TEST_DATA;
+
+typedef struct {
+  CONST CHAR8  *Name;
+  TEST_DATA    Data;
+} TEST_CASE;
+
+STATIC
+TEST_CASE
+mTestCases[] = {
+  { "zero",          TestDataZero         },
+  { "random",        TestDataRandom       },
+  { "text",          TestDataText         },
+  { "short-matches", TestDataShortMatches }
+};
+
+/**
+  Compress and decompress Data, returns compressed size or 0 on mismatch.
+**/
+STATIC
+UINTN
+TestLzvnRoundTrip (
+  IN CONST UINT8  *Data,
+  IN UINTN        Size
+  )
+{
+  UINT8  *Compressed;
+  UINT8  *Decompressed;
+  UINTN  CompressedSize;
+  UINTN  DecompressedSize;
+  UINTN  Result;
+
+  Compressed   = AllocatePool (OC_LZVN_MAX_COMPRESSED_LENGTH (Size));
+  Decompressed = AllocatePool (Size + 1);
+  if (Compressed == NULL || Decompressed == NULL) {
+    abort ();
+  }
+
+  Result         = 0;
+  CompressedSize = CompressLZVN (Compressed, OC_LZVN_MAX_COMPRESSED_LENGTH (Size), Data, Size);
+  if (CompressedSize != 0) {
+    DecompressedSize = DecompressLZVN (Decompressed, Size + 1, Compressed, CompressedSize);
+    if (DecompressedSize == Size && CompareMem (Decompressed, Data, Size) == 0) {
+      Result = CompressedSize;
+    }
+  }
+
+  FreePool (Compressed);
+  FreePool (Decompressed);
+
+  return Result;
+}
+
+STATIC
+VOID
+TestGenerate (
+  IN  TEST_DATA  Data,
+  OUT UINT8      *Buffer,
+  IN  UINTN      Size
+  )
+{
+  STATIC CONST CHAR8  Words[][8] = {
+    "kext", "symbol", "vtable", "segment", "section", "__TEXT", "__DATA", "patch"
+  };
+
+  UINT64  Seed;
+  UINTN   Index;
+  UINTN   Word;
+  UINTN   Length;
+  UINTN   Distance;
+
+  Seed = 1;
+
+  switch (Data) {
+    case TestDataZero:
+      ZeroMem (Buffer, Size);
+      break;
+    case TestDataRandom:
+      BenchFillRandom (Buffer, Size, Seed);
+      break;
+    case TestDataText:
+      for (Index = 0; Index < Size; Index += Length) {
+        Word   = (UINTN) (BenchRandom (&Seed) % ARRAY_SIZE (Words));
+        Length = MIN (AsciiStrLen (Words[Word]) + 1, Size - Index);
+        CopyMem (&Buffer[Index], Words[Word], Length);
+        Buffer[Index + Length - 1] = ' ';
+      }
+      break;
+    case TestDataShortMatches:
+      //
+      // 16 random literals followed by a 4 byte match, alternating distances
+      // so that matches need a full distance encoding.
+      //
+      BenchFillRandom (Buffer, Size, Seed);
+      for (Index = 2048; Index + 20 <= Size; Index += 20) {
+        Distance = (Index / 20) % 2 == 0 ? 1600 : 1620;
+        CopyMem (&Buffer[Index + 16], &Buffer[Index + 16 - Distance], 4);
+      }
+      break;
+  }
+}
+
+int main(int argc, char** argv) {
+  UINT8     *Buffer;
+  UINT8     *File;
+  UINT32    FileSize;
+  UINTN     Index;
+  UINTN     Size;
+  UINTN     CompressedSize;
+  INT32     ExitCode;
+
+  Buffer = AllocatePool (TEST_BUFFER_SIZE);
+  if (Buffer == NULL) {
+    return -1;
+  }
+
+  ExitCode = 0;
+
+  for (Index = 0; Index < ARRAY_SIZE (mTestCases); ++Index) {
+    //
+    // Short buffers test stream boundaries, the longest one tests growth.
+    //
+    for (Size = 0; Size <= TEST_BUFFER_SIZE; Size = Size < 1024 ? Size + 1 : Size * 2) {
+      TestGenerate (mTestCases[Index].Data, Buffer, Size);
+      CompressedSize = TestLzvnRoundTrip (Buffer, Size);
+      if (CompressedSize == 0) {
+        printf ("%s %zu - mismatch\n", mTestCases[Index].Name, Size);
+        ExitCode = -1;
+        break;
+      }
+    }
+
+    if (CompressedSize != 0) {
+      printf ("%s - %u -> %zu\n", mTestCases[Index].Name, TEST_BUFFER_SIZE, CompressedSize);
+    }
+  }
+
+  for (Index = 1; Index < (UINTN) argc; ++Index) {
+    File = readFile (argv[Index], &FileSize);
+    if (File == NULL) {
+      printf ("%s - read fail\n", argv[Index]);
+      ExitCode = -1;
+      continue;
+    }
+
+    CompressedSize = TestLzvnRoundTrip (File, FileSize);
+    if (CompressedSize == 0) {
+      printf ("%s - mismatch\n", argv[Index]);
+      ExitCode = -1;
+    } else {
+      printf ("%s - %u -> %zu\n", argv[Index], FileSize, CompressedSize);
+    }
+
+    free (File);
+  }
+
+  FreePool (Buffer);
+
+  return ExitCode;
+}
+
+INT32 LLVMFuzzerTestOneInput(CONST UINT8 *Data, UINTN Size) {
+  if (Size <= OC_COMPRESSION_MAX_LENGTH && TestLzvnRoundTrip (Data, Size) == 0) {
+    abort ();
+  }
+  return 0;
+}
@@ -0,0 +1,323 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcCryptoLib.h>
+
+#include <Bench.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h CryptoBench.c ../../Library/OcCryptoLib/Sha256.c ../../Library/OcCryptoLib/X64/Sha256Simd.c ../../Library/OcCryptoLib/X64/Sha256MultiBuffer.c -o CryptoBench
+
+ ./CryptoBench [-s megabytes] [-f filter] > results.json
+
+ Every SHA-256 backend supported by the CPU is first checked against FIPS
+ 180-2 known answers and against the generic backend for all message sizes
+ up to a few blocks split into random updates or hashed by Sha256MultiBuffer,
+ then timed on a buffer of the given size (64 MB by default).  Reported per
+ backend:
+   - status  - 0 on success, 1 for known answer, 2 for cross-check failure,
+               3 for multi-buffer cross-check failure,
+   - mbps    - hashing throughput in megabytes per second.
+ Unsupported backends are reported with "supported": false.
+
+ rm -rf CryptoBench.dSYM CryptoBench
+*/
+
+#define BENCH_MAX_CHECK_SIZE  (4 * 64 + 3)
+#define BENCH_MAX_MULTI_COUNT  (2 * SHA256_MULTI_BUFFER_LANES + 3)
+
+typedef struct {
+  CONST CHAR8     *Name;
+  SHA256_BACKEND  Backend;
+} BENCH_BACKEND;
+
+typedef struct {
+  CONST CHAR8  *Message;
+  UINT32       Repeat;
+  UINT8        Digest[SHA256_DIGEST_SIZE];
+} BENCH_SHA256_VECTOR;
+
+typedef struct {
+  UINT32   Status;
+  BOOLEAN  Supported;
+  UINT64   Mbps;
+} BENCH_RESULT;
+
+STATIC
+BENCH_BACKEND
+mBenchBackends[] = {
+  { "sha256-generic", Sha256BackendGeneric },
+  { "sha256-ssse3",   Sha256BackendSsse3   },
+  { "sha256-avx2",    Sha256BackendAvx2    },
+  { "sha256-shani",   Sha256BackendShaNi   }
+};
+
+STATIC
+BENCH_SHA256_VECTOR
+mSha256Vectors[] = {
+  {
+    "", 1,
+    { 0xE3, 0xB0, 0xC4, 0x42, 0x98, 0xFC, 0x1C, 0x14, 0x9A, 0xFB, 0xF4, 0xC8, 0x99, 0x6F, 0xB9, 0x24,
+      0x27, 0xAE, 0x41, 0xE4, 0x64, 0x9B, 0x93, 0x4C, 0xA4, 0x95, 0x99, 0x1B, 0x78, 0x52, 0xB8, 0x55 }
+  },
+  {
+    "abc", 1,
+    { 0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+      0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD }
+  },
+  {
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+    { 0x24, 0x8D, 0x6A, 0x61, 0xD2, 0x06, 0x38, 0xB8, 0xE5, 0xC0, 0x26, 0x93, 0x0C, 0x3E, 0x60, 0x39,
+      0xA3, 0x3C, 0xE4, 0x59, 0x64, 0xFF, 0x21, 0x67, 0xF6, 0xEC, 0xED, 0xD4, 0x19, 0xDB, 0x06, 0xC1 }
+  },
+  {
+    "a", 1000000,
+    { 0xCD, 0xC7, 0x6E, 0x5C, 0x99, 0x14, 0xFB, 0x92, 0x81, 0xA1, 0xC7, 0xE2, 0x84, 0xD7, 0x3E, 0x67,
+      0xF1, 0x80, 0x9A, 0x48, 0xA4, 0x97, 0x20, 0x0E, 0x04, 0x6D, 0x39, 0xCC, 0xC7, 0x11, 0x2C, 0xD0 }
+  }
+};
+
+/**
+  Hash Data in random sized updates.
+**/
+STATIC
+VOID
+BenchSha256Split (
+  UINT8        *Digest,
+  CONST UINT8  *Data,
+  UINTN        Size,
+  UINT64       *Seed
+  )
+{
+  SHA256_CONTEXT  Context;
+  UINTN           Chunk;
+
+  Sha256Init (&Context);
+  while (Size > 0) {
+    Chunk = (UINTN) (BenchRandom (Seed) % 150);
+    Chunk = MIN (Size, Chunk);
+    Sha256Update (&Context, Data, Chunk);
+    Data += Chunk;
+    Size -= Chunk;
+  }
+
+  Sha256Final (&Context, Digest);
+}
+
+STATIC
+UINT32
+BenchCheckSha256 (
+  CONST UINT8  *Expected
+  )
+{
+  SHA256_CONTEXT  Context;
+  UINT8           Digest[SHA256_DIGEST_SIZE];
+  UINT8           Digests[BENCH_MAX_MULTI_COUNT][SHA256_DIGEST_SIZE];
+  CONST UINT8     *Data[BENCH_MAX_MULTI_COUNT];
+  UINTN           Lengths[BENCH_MAX_MULTI_COUNT];
+  UINT64          Seed;
+  UINT32          Index;
+  UINT32          Repeat;
+  UINT32          Size;
+  UINT32          Count;
+
+  for (Index = 0; Index < ARRAY_SIZE (mSha256Vectors); Index++) {
+    Sha256Init (&Context);
+    for (Repeat = 0; Repeat < mSha256Vectors[Index].Repeat; Repeat++) {
+      Sha256Update (
+        &Context,
+        (CONST UINT8 *) mSha256Vectors[Index].Message,
+        AsciiStrLen (mSha256Vectors[Index].Message)
+        );
+    }
+    Sha256Final (&Context, Digest);
+
+    if (CompareMem (Digest, mSha256Vectors[Index].Digest, sizeof (Digest)) != 0) {
+      return 1;
+    }
+  }
+
+  //
+  // Expected holds generic digests of every prefix of the check buffer.
+  //
+  Seed = 1;
+  for (Size = 0; Size <= BENCH_MAX_CHECK_SIZE; Size++) {
+    BenchSha256Split (Digest, &Expected[SHA256_DIGEST_SIZE * (BENCH_MAX_CHECK_SIZE + 1)], Size, &Seed);
+    if (CompareMem (Digest, &Expected[Size * SHA256_DIGEST_SIZE], sizeof (Digest)) != 0) {
+      return 2;
+    }
+  }
+
+  //
+  // Multi-buffer messages are check buffer prefixes, equal sized ones first.
+  //
+  for (Count = 0; Count <= BENCH_MAX_MULTI_COUNT; Count++) {
+    Size = (UINT32) (BenchRandom (&Seed) % (BENCH_MAX_CHECK_SIZE + 1));
+    for (Index = 0; Index < Count; Index++) {
+      Data[Index]    = &Expected[SHA256_DIGEST_SIZE * (BENCH_MAX_CHECK_SIZE + 1)];
+      Lengths[Index] = (Count & 1) != 0 ? Size : (UINTN) (BenchRandom (&Seed) % (BENCH_MAX_CHECK_SIZE + 1));
+    }
+
+    Sha256MultiBuffer (&Digests[0][0], Data, Lengths, Count);
+    for (Index = 0; Index < Count; Index++) {
+      if (CompareMem (Digests[Index], &Expected[Lengths[Index] * SHA256_DIGEST_SIZE], SHA256_DIGEST_SIZE) != 0) {
+        return 3;
+      }
+    }
+  }
+
+  return 0;
+}
+
+STATIC
+VOID
+BenchRun (
+  SHA256_BACKEND  Backend,
+  CONST UINT8     *Expected,
+  CONST UINT8     *Buffer,
+  UINTN           Size,
+  BENCH_RESULT    *Result
+  )
+{
+  UINT8   Digest[SHA256_DIGEST_SIZE];
+  UINT64  Start;
+  UINT64  Elapsed;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  Result->Supported = Sha256SetBackend (Backend);
+  if (!Result->Supported) {
+    return;
+  }
+
+  Result->Status = BenchCheckSha256 (Expected);
+  if (Result->Status != 0) {
+    return;
+  }
+
+  Start   = BenchTimestamp ();
+  Sha256 (Digest, (UINT8 *) Buffer, Size);
+  Elapsed = BenchTimestamp () - Start;
+
+  Result->Mbps = Elapsed > 0 ? (UINT64) Size * 1000ULL / Elapsed : 0;
+}
+
+STATIC
+VOID
+BenchPrint (
+  FILE          *Output,
+  CONST CHAR8   *Name,
+  BENCH_RESULT  *Result,
+  BOOLEAN       First
+  )
+{
+  BenchBeginResult (Output, First);
+  fprintf (
+    Output,
+    "{\"name\": \"%s\", \"supported\": %s, \"status\": %u, \"mbps\": %llu}",
+    Name,
+    Result->Supported ? "true" : "false",
+    Result->Status,
+    (unsigned long long) Result->Mbps
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32        Megabytes;
+  CONST CHAR8   *Filter;
+  INT32         Opt;
+  UINT32        Index;
+  UINT8         *Buffer;
+  UINT8         *Expected;
+  UINTN         Size;
+  BENCH_RESULT  Result;
+  BOOLEAN       First;
+  INT32         ExitCode;
+  FILE          *Output;
+
+  Megabytes = 64;
+  Filter    = NULL;
+
+  while ((Opt = getopt (argc, argv, "s:f:")) != -1) {
+    switch (Opt) {
+      case 's':
+        Megabytes = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'f':
+        Filter = optarg;
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-s megabytes] [-f filter]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Megabytes == 0) {
+    fprintf (stderr, "Invalid buffer size\n");
+    return -1;
+  }
+
+  Output = BenchOpenOutput ();
+  if (Output == NULL) {
+    return -1;
+  }
+
+  Size     = (UINTN) Megabytes * BASE_1MB;
+  Buffer   = malloc (Size);
+  Expected = malloc (SHA256_DIGEST_SIZE * (BENCH_MAX_CHECK_SIZE + 1) + BENCH_MAX_CHECK_SIZE);
+  if (Buffer == NULL || Expected == NULL) {
+    fprintf (stderr, "Out of memory\n");
+    return -1;
+  }
+
+  BenchFillRandom (Buffer, Size, 1);
+
+  //
+  // Reference digests of every check buffer prefix, the buffer follows them.
+  //
+  CopyMem (&Expected[SHA256_DIGEST_SIZE * (BENCH_MAX_CHECK_SIZE + 1)], Buffer, BENCH_MAX_CHECK_SIZE);
+  Sha256SetBackend (Sha256BackendGeneric);
+  for (Index = 0; Index <= BENCH_MAX_CHECK_SIZE; Index++) {
+    Sha256 (
+      &Expected[Index * SHA256_DIGEST_SIZE],
+      &Expected[SHA256_DIGEST_SIZE * (BENCH_MAX_CHECK_SIZE + 1)],
+      Index
+      );
+  }
+
+  ExitCode = 0;
+  First    = TRUE;
+  BenchBeginResults (Output, "  \"megabytes\": %u,\n", Megabytes);
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchBackends); Index++) {
+    if (!BenchIsSelected (mBenchBackends[Index].Name, Filter)) {
+      continue;
+    }
+
+    BenchRun (mBenchBackends[Index].Backend, Expected, Buffer, Size, &Result);
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+
+    BenchPrint (Output, mBenchBackends[Index].Name, &Result, First);
+    First = FALSE;
+  }
+
+  BenchEndResults (Output);
+
+  free (Buffer);
+  free (Expected);
+
+  return ExitCode;
+}
@@ -0,0 +1,642 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcAppleImageVerificationLib.h>
+#include <Library/OcAppleKeysLib.h>
+#include <Library/OcCryptoLib.h>
+#include <Library/OcFileLib.h>
+#include <Guid/AppleCertificate.h>
+
+#include <Bench.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h ImageVerificationBench.c ../../Library/OcAppleImageVerificationLib/OcAppleImageVerification.c ../../Library/OcAppleKeysLib/OcAppleKeysLib.c ../../Library/OcFileLib/FileProtocol.c ../../Library/OcCryptoLib/Rsa2048Sha256.c ../../Library/OcCryptoLib/Sha256.c ../../Library/OcCryptoLib/X64/Sha256Simd.c ../../Library/OcCryptoLib/X64/Sha256MultiBuffer.c -o ImageVerificationBench
+
+ ./ImageVerificationBench [-n verifications] > results.json
+
+ Synthetic PE32+ images the size of boot.efi and of a small driver are
+ signed with a test key, which is the only entry of the key database of a
+ reusable verifier.  Every image is verified the given number of times
+ (1000 by default) in a row with VerifyApplePeImage, its PE hash and RSA
+ signature are timed separately, and the remainder is reported as per-image
+ overhead.  A tampered image must fail verification and the test key must
+ be rejected by VerifyApplePeImageSignature, which only trusts Apple keys.
+ Images are then streamed in pieces of random size, and read from an
+ in-memory file either completely before verification or with
+ VerifyApplePeImageFile hashing them while they are read.
+ Reported per image:
+   - status          - 0 on success, 1 for a valid image failing verification,
+                       2 for a tampered one passing it, 3 for an unknown key
+                       not being rejected, 4 for a streaming failure or
+                       an empty file not being rejected,
+   - kilobytes       - image size,
+   - verify_ns       - VerifyApplePeImage time per image,
+   - hash_ns         - GetApplePeImageSha256 time per image,
+   - rsa_ns          - RsaVerify time per image,
+   - overhead_ns     - verify_ns without hash_ns and rsa_ns,
+   - reject_ns       - VerifyApplePeImageSignature time for the unknown key,
+   - read_verify_ns  - file read followed by VerifyApplePeImage,
+   - file_verify_ns  - VerifyApplePeImageFile time per image.
+ Library debug output is discarded, stdout only contains JSON results.
+
+ rm -rf ImageVerificationBench.dSYM ImageVerificationBench
+*/
+
+#define BENCH_IMAGE_ALIGNMENT  0x200U
+#define BENCH_IMAGE_SECTIONS   4U
+#define BENCH_STREAM_PIECE     0x1000U
+
+typedef struct {
+  CONST CHAR8  *Name;
+  UINT32       PayloadSize;
+  UINT16       Subsystem;
+  CONST UINT8  *Signature;
+} BENCH_IMAGE;
+
+typedef struct {
+  UINT32  Status;
+  UINT64  Kilobytes;
+  UINT64  VerifyNs;
+  UINT64  HashNs;
+  UINT64  RsaNs;
+  UINT64  RejectNs;
+  UINT64  ReadVerifyNs;
+  UINT64  FileVerifyNs;
+} BENCH_RESULT;
+
+typedef struct {
+  EFI_FILE_PROTOCOL  Protocol;
+  CONST UINT8        *Data;
+  UINT64             Size;
+  UINT64             Position;
+} BENCH_FILE;
+
+EFI_GUID gAppleEfiCertificateGuid;
+EFI_GUID gEfiCertTypeRsa2048Sha256Guid;
+EFI_GUID gEfiFileInfoGuid;
+
+//
+// Test RSA-2048 key with exponent 65537 in pre-processed form.
+//
+STATIC
+UINT8
+mBenchTestKey[RSA_PUBLIC_KEY_SIZE (2048)] = {
+    0x40, 0x00, 0x00, 0x00, 0xE1, 0xE2, 0x38, 0x06, 0xDF, 0x1E, 0x5C, 0x81,
+    0xD6, 0x56, 0xC0, 0x4D, 0xAB, 0xE2, 0xD7, 0xEF, 0x92, 0x56, 0x17, 0xB2,
+    0x5D, 0x9B, 0x9C, 0x1F, 0xD1, 0x70, 0x0E, 0xF4, 0x4F, 0x69, 0xEC, 0x74,
+    0xDF, 0x9E, 0x80, 0xD1, 0xFF, 0x91, 0x76, 0x25, 0x49, 0xF1, 0x88, 0xDA,
+    0x49, 0xC0, 0x54, 0x80, 0x81, 0xAE, 0x7C, 0xB3, 0x0B, 0x0D, 0x22, 0x4D,
+    0xB1, 0x11, 0xEC, 0xE1, 0xBB, 0x24, 0x44, 0x56, 0xE6, 0x8C, 0x01, 0x5A,
+    0x8C, 0x29, 0x83, 0x22, 0xCE, 0x19, 0xD2, 0x78, 0xD7, 0x3C, 0xBE, 0x13,
+    0x83, 0x4F, 0xBE, 0xE4, 0x5F, 0xCD, 0x6E, 0x67, 0x0A, 0xE5, 0x4A, 0x5A,
+    0x9D, 0x09, 0x5F, 0x84, 0x7D, 0x86, 0x4B, 0x33, 0xDF, 0x67, 0xB6, 0xB6,
+    0xB3, 0xF2, 0xAB, 0xBE, 0xB6, 0x95, 0x9D, 0xE1, 0x36, 0x95, 0x50, 0x95,
+    0x9C, 0xD1, 0x21, 0xCE, 0x9D, 0x25, 0x73, 0xDE, 0x53, 0xAF, 0x27, 0xD6,
+    0x10, 0x7D, 0xCA, 0x46, 0x73, 0x4A, 0xD8, 0xA0, 0x42, 0x7A, 0x1B, 0xF4,
+    0xAA, 0xB4, 0x19, 0x2B, 0xAE, 0xBD, 0x32, 0x21, 0x41, 0x25, 0x90, 0x8E,
+    0x69, 0x96, 0x5B, 0x35, 0x68, 0xBA, 0x77, 0x5F, 0x6C, 0xA7, 0xD0, 0x19,
+    0x9E, 0x88, 0xA8, 0x94, 0xFB, 0xBC, 0xEC, 0x35, 0x51, 0x4C, 0x43, 0x31,
+    0x6E, 0x60, 0x39, 0xB7, 0x38, 0x37, 0x2F, 0xCD, 0x27, 0x99, 0x49, 0x54,
+    0x43, 0x63, 0x59, 0x65, 0x3F, 0x56, 0x0C, 0x98, 0xEE, 0x6E, 0x10, 0x75,
+    0xF4, 0xFC, 0xBB, 0x60, 0x9D, 0xE9, 0x45, 0x37, 0x14, 0x16, 0xD7, 0x0D,
+    0x7E, 0x4A, 0x7F, 0xA0, 0x0B, 0x6D, 0x8F, 0x2B, 0x01, 0x25, 0xB4, 0xF3,
+    0x72, 0x84, 0xBF, 0xDA, 0x8A, 0xEB, 0xE6, 0x49, 0xB2, 0x68, 0xDC, 0xD2,
+    0x43, 0x4E, 0xF2, 0x7B, 0xBE, 0x2C, 0x2E, 0x74, 0xC0, 0xED, 0x22, 0x8B,
+    0x9C, 0x97, 0x52, 0x0D, 0xBD, 0x00, 0x9F, 0xE7, 0x56, 0xC4, 0x7A, 0xB9,
+    0x21, 0x15, 0x8B, 0x94, 0x80, 0x23, 0x83, 0x82, 0xDA, 0x83, 0xC6, 0x5F,
+    0x51, 0xC3, 0x36, 0xBF, 0x51, 0xCB, 0x90, 0x23, 0x7A, 0x36, 0xDE, 0x0C,
+    0xB9, 0xF5, 0xFB, 0xE2, 0x23, 0x80, 0x3D, 0x69, 0x7C, 0x7E, 0x27, 0x7E,
+    0xB1, 0x80, 0x57, 0x69, 0xF6, 0xCF, 0x64, 0x45, 0xA4, 0xD0, 0xB6, 0xD5,
+    0x94, 0xC2, 0xB2, 0x64, 0xB6, 0x94, 0xF9, 0x85, 0x85, 0xAA, 0xFE, 0x60,
+    0x5B, 0x6A, 0x19, 0x31, 0x27, 0xC4, 0xC2, 0xB9, 0xDA, 0x4A, 0x90, 0x44,
+    0x20, 0xB8, 0x03, 0xB6, 0xBD, 0x8D, 0x1C, 0x42, 0xC0, 0x59, 0x5B, 0x41,
+    0x48, 0xF4, 0x5D, 0x58, 0x58, 0xB1, 0x42, 0x72, 0x9F, 0x90, 0x6E, 0xE0,
+    0x9C, 0x05, 0x53, 0xCF, 0xE0, 0x29, 0x80, 0x55, 0x7D, 0x6D, 0x75, 0x1D,
+    0x9A, 0xDA, 0xDF, 0xC5, 0xEB, 0x50, 0xCC, 0x76, 0x9E, 0x4D, 0x18, 0xEA,
+    0xAD, 0xD4, 0xA7, 0xF9, 0x80, 0x72, 0x9E, 0xAA, 0x95, 0x0B, 0x39, 0x47,
+    0x82, 0xB0, 0x55, 0x45, 0xD0, 0x5B, 0xBC, 0xCA, 0xFF, 0x76, 0x49, 0x23,
+    0x44, 0xAB, 0x5B, 0xA4, 0x77, 0xC6, 0x31, 0x60, 0x4A, 0x02, 0xF4, 0x02,
+    0x00, 0xE7, 0xD4, 0xA2, 0x7E, 0xA6, 0x95, 0xA1, 0xD7, 0x32, 0x56, 0x23,
+    0x24, 0xF7, 0xBC, 0x9B, 0x7A, 0x4E, 0x32, 0xD2, 0x9A, 0xCE, 0x30, 0xCB,
+    0xD7, 0x7F, 0x18, 0x64, 0x2A, 0x24, 0xBD, 0x1C, 0xAD, 0x52, 0xF2, 0x8D,
+    0xFB, 0xA6, 0x33, 0x3D, 0xCA, 0x8C, 0xA5, 0x3B, 0x2E, 0x38, 0x8B, 0x5C,
+    0x58, 0x03, 0x6B, 0x29, 0x11, 0x5B, 0x42, 0x21, 0x28, 0xB3, 0xFE, 0xE7,
+    0x4A, 0xF2, 0xB9, 0xE2, 0x8B, 0xF3, 0xA0, 0x88, 0x5D, 0x48, 0x83, 0x66,
+    0x41, 0x7B, 0x7A, 0xA2, 0x61, 0x70, 0x48, 0x7C, 0xF4, 0x7B, 0xAA, 0xFB,
+    0xE1, 0x89, 0x3D, 0x0F, 0x46, 0x2D, 0x9A, 0xF7, 0x5D, 0x39, 0x6E, 0x9D,
+    0x64, 0x8A, 0x33, 0x88
+};
+
+//
+// Little endian test key signatures of the images built by
+// BenchCreateImage for mBenchImages.
+//
+STATIC
+CONST UINT8
+mBenchBootSignature[256] = {
+    0x7B, 0x0C, 0x56, 0xB7, 0xB3, 0x9D, 0x25, 0x08, 0x15, 0x84, 0x68, 0x83,
+    0x6D, 0xC4, 0x13, 0xCD, 0xFE, 0x2A, 0xFE, 0x79, 0xE7, 0x7B, 0xDC, 0x5A,
+    0x64, 0x08, 0x8E, 0x16, 0x1B, 0xA3, 0x70, 0x97, 0xDD, 0x1A, 0xA1, 0x5E,
+    0x8E, 0x37, 0x32, 0xCD, 0xC2, 0x79, 0x16, 0xE7, 0x89, 0x63, 0xD6, 0x79,
+    0x9C, 0x7F, 0x9D, 0xAD, 0x53, 0x86, 0xCC, 0x2B, 0x52, 0xDD, 0xF4, 0xD9,
+    0x2D, 0x0F, 0x35, 0xE9, 0x1B, 0x2E, 0xB8, 0x3E, 0x30, 0xDC, 0x32, 0x7A,
+    0x99, 0x51, 0xE0, 0xA3, 0xAC, 0x7F, 0x61, 0x73, 0x1D, 0x67, 0xC8, 0x70,
+    0xA0, 0xE1, 0xCD, 0x5F, 0xF3, 0x1B, 0xEA, 0x3E, 0xB4, 0xC1, 0x52, 0x53,
+    0x69, 0xAE, 0xE5, 0xAA, 0x6A, 0x48, 0xA7, 0xB3, 0xEF, 0x78, 0xC2, 0xD2,
+    0x82, 0xE5, 0x13, 0x51, 0xDD, 0xA9, 0x68, 0x0D, 0x98, 0xCC, 0x9B, 0xD4,
+    0xE7, 0x9F, 0x97, 0x65, 0x52, 0xF4, 0x5F, 0xF1, 0xC3, 0x95, 0x79, 0x1D,
+    0xEC, 0x86, 0x78, 0x1F, 0xE5, 0x6C, 0x70, 0x43, 0x8D, 0xB1, 0xC5, 0xA5,
+    0x49, 0xA3, 0xAA, 0xEF, 0x68, 0x8E, 0x11, 0xC6, 0xBC, 0x98, 0xEF, 0x68,
+    0x08, 0xDD, 0x6F, 0xCC, 0xB6, 0x95, 0xBD, 0xE4, 0x89, 0x0E, 0xD9, 0xD6,
+    0x5E, 0xB0, 0x7B, 0xAC, 0x13, 0x68, 0x54, 0x85, 0x55, 0x11, 0xC7, 0x12,
+    0x67, 0x2A, 0x2E, 0xF2, 0xB5, 0x1F, 0x0A, 0xE7, 0x32, 0xCD, 0x3F, 0x18,
+    0x2D, 0xE0, 0xC5, 0xE9, 0xDB, 0x1B, 0x16, 0x7C, 0x4C, 0x68, 0x02, 0xD2,
+    0x6B, 0xA1, 0x15, 0x17, 0x62, 0xBD, 0xE2, 0x74, 0x07, 0xC2, 0x0D, 0xE5,
+    0x84, 0xE9, 0xC5, 0x25, 0x01, 0x9E, 0x36, 0xFF, 0xF9, 0xD9, 0x91, 0xD6,
+    0x8F, 0x37, 0x0E, 0x43, 0x28, 0x11, 0x2B, 0x8F, 0xC9, 0x7B, 0xD0, 0x7B,
+    0xE7, 0x33, 0x76, 0x30, 0x2B, 0x48, 0x8D, 0xBD, 0x86, 0x2F, 0xC4, 0x31,
+    0x63, 0x4A, 0x04, 0x25
+};
+
+STATIC
+CONST UINT8
+mBenchDriverSignature[256] = {
+    0x06, 0x1B, 0x4C, 0xD1, 0xD0, 0x60, 0x04, 0xF7, 0xCF, 0x1A, 0xBC, 0xC5,
+    0x26, 0x31, 0x00, 0x01, 0x29, 0x00, 0x64, 0x10, 0xEC, 0x56, 0x77, 0xA1,
+    0xA5, 0xC2, 0x7E, 0xB6, 0x2F, 0x81, 0x07, 0x51, 0xFD, 0xDF, 0x82, 0x5E,
+    0xCF, 0xC5, 0x44, 0xFB, 0x15, 0x96, 0x53, 0x3B, 0x70, 0x44, 0x16, 0x5F,
+    0x5C, 0xAA, 0xAB, 0x45, 0x4C, 0xBA, 0x1E, 0x7A, 0x93, 0xB2, 0x1C, 0x5F,
+    0xE5, 0x55, 0x18, 0x18, 0x95, 0xD7, 0x95, 0x8D, 0xA1, 0x7B, 0x7F, 0xC7,
+    0x1C, 0xAA, 0xF4, 0xC9, 0xCB, 0xAA, 0x16, 0x24, 0x01, 0x15, 0x1A, 0x2F,
+    0x6E, 0x40, 0xDB, 0x31, 0x96, 0x03, 0xE9, 0xCD, 0x7A, 0x03, 0x20, 0x6D,
+    0x53, 0x4A, 0xA8, 0x16, 0xB3, 0xC1, 0x13, 0xBE, 0x54, 0x78, 0x99, 0x84,
+    0xF1, 0xEC, 0x9D, 0xF8, 0xB8, 0xF7, 0xBB, 0xBD, 0x34, 0xC4, 0x1F, 0x66,
+    0x9B, 0x42, 0xDD, 0x6C, 0xF3, 0xC1, 0xAB, 0xA4, 0x8E, 0x44, 0x80, 0xAC,
+    0xBC, 0x9B, 0x96, 0xA7, 0x44, 0x90, 0x00, 0xD7, 0xFE, 0x93, 0x3F, 0xED,
+    0x67, 0xE1, 0x6B, 0x06, 0xCE, 0x7A, 0x57, 0x59, 0xBA, 0xEF, 0xEA, 0x52,
+    0x3D, 0xB2, 0xD9, 0x8A, 0x24, 0x7B, 0x73, 0x8E, 0x19, 0xF2, 0xE4, 0x8E,
+    0x0B, 0xCA, 0x9A, 0x97, 0x06, 0xD2, 0x06, 0x27, 0xA9, 0x34, 0x0D, 0xD7,
+    0xFB, 0x1C, 0x4C, 0x1E, 0x4A, 0xCC, 0x8A, 0x22, 0x1F, 0x14, 0x97, 0xAB,
+    0x23, 0x2C, 0xDF, 0x80, 0x51, 0xF8, 0x6C, 0x3F, 0x84, 0xD6, 0xD9, 0x9E,
+    0x36, 0x42, 0x78, 0x12, 0x22, 0x50, 0xB7, 0xFB, 0xD1, 0xEB, 0x27, 0x12,
+    0x46, 0x31, 0x27, 0xD8, 0x53, 0x91, 0x79, 0xEA, 0x82, 0x8D, 0x31, 0x1D,
+    0x9E, 0xC3, 0x99, 0x80, 0xFB, 0x78, 0xE1, 0xA7, 0xC4, 0x1A, 0x19, 0xE1,
+    0x44, 0x49, 0xEF, 0x89, 0x3B, 0x05, 0x3A, 0x53, 0xEE, 0xBE, 0x5A, 0xD6,
+    0x77, 0x55, 0x93, 0x32
+};
+
+STATIC
+BENCH_IMAGE
+mBenchImages[] = {
+  { "boot",   0x80000, EFI_IMAGE_SUBSYSTEM_EFI_APPLICATION,         mBenchBootSignature   },
+  { "driver", 0x4000,  EFI_IMAGE_SUBSYSTEM_EFI_BOOT_SERVICE_DRIVER, mBenchDriverSignature }
+};
+
+STATIC
+CONST CHAR8 *
+mBenchSectionNames[BENCH_IMAGE_SECTIONS] = {
+  ".text", ".data", ".rdata", ".reloc"
+};
+
+STATIC
+EFI_STATUS
+EFIAPI
+BenchFileRead (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  BENCH_FILE  *File;
+
+  File        = (BENCH_FILE *) This;
+  *BufferSize = (UINTN) MIN (*BufferSize, File->Size - File->Position);
+  CopyMem (Buffer, File->Data + File->Position, *BufferSize);
+  File->Position += *BufferSize;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BenchFileSetPosition (
+  IN EFI_FILE_PROTOCOL  *This,
+  IN UINT64             Position
+  )
+{
+  BENCH_FILE  *File;
+
+  File           = (BENCH_FILE *) This;
+  File->Position = MIN (Position, File->Size);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+BenchFileGetPosition (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT UINT64             *Position
+  )
+{
+  *Position = ((BENCH_FILE *) This)->Position;
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate a PE32+ image with PayloadSize bytes of sections followed by
+  an Apple signature made with the test key.
+**/
+STATIC
+UINT8 *
+BenchCreateImage (
+  CONST BENCH_IMAGE  *BenchImage,
+  UINTN              *ImageSize
+  )
+{
+  UINT8                       *Image;
+  EFI_IMAGE_DOS_HEADER        *DosHdr;
+  EFI_IMAGE_NT_HEADERS64      *PeHdr;
+  EFI_IMAGE_SECTION_HEADER    *Sections;
+  APPLE_EFI_CERTIFICATE_INFO  *CertInfo;
+  APPLE_EFI_CERTIFICATE       *Cert;
+  UINT32                      CertInfoOffset;
+  UINT32                      SectionSize;
+  UINT32                      Index;
+
+  CertInfoOffset = BENCH_IMAGE_ALIGNMENT + BenchImage->PayloadSize;
+  *ImageSize     = CertInfoOffset + sizeof (*CertInfo) + sizeof (*Cert);
+  Image          = calloc (1, *ImageSize);
+  if (Image == NULL) {
+    return NULL;
+  }
+
+  DosHdr           = (EFI_IMAGE_DOS_HEADER *) Image;
+  DosHdr->e_magic  = EFI_IMAGE_DOS_SIGNATURE;
+  DosHdr->e_lfanew = sizeof (*DosHdr);
+
+  PeHdr = (EFI_IMAGE_NT_HEADERS64 *) (Image + DosHdr->e_lfanew);
+  PeHdr->Signature                                = EFI_IMAGE_NT_SIGNATURE;
+  PeHdr->FileHeader.Machine                       = IMAGE_FILE_MACHINE_X64;
+  PeHdr->FileHeader.NumberOfSections              = BENCH_IMAGE_SECTIONS;
+  PeHdr->FileHeader.SizeOfOptionalHeader          = sizeof (PeHdr->OptionalHeader);
+  PeHdr->FileHeader.Characteristics               = EFI_IMAGE_FILE_EXECUTABLE_IMAGE;
+  PeHdr->OptionalHeader.Magic                     = EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+  PeHdr->OptionalHeader.AddressOfEntryPoint       = BENCH_IMAGE_ALIGNMENT;
+  PeHdr->OptionalHeader.SectionAlignment          = BENCH_IMAGE_ALIGNMENT;
+  PeHdr->OptionalHeader.FileAlignment             = BENCH_IMAGE_ALIGNMENT;
+  PeHdr->OptionalHeader.SizeOfImage               = CertInfoOffset;
+  PeHdr->OptionalHeader.SizeOfHeaders             = BENCH_IMAGE_ALIGNMENT;
+  PeHdr->OptionalHeader.Subsystem                 = BenchImage->Subsystem;
+  PeHdr->OptionalHeader.NumberOfRvaAndSizes       = EFI_IMAGE_NUMBER_OF_DIRECTORY_ENTRIES;
+  PeHdr->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY].VirtualAddress = CertInfoOffset;
+  PeHdr->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY].Size           = APPLE_SIGNATURE_SECENTRY_SIZE;
+
+  Sections    = (EFI_IMAGE_SECTION_HEADER *) (PeHdr + 1);
+  SectionSize = BenchImage->PayloadSize / BENCH_IMAGE_SECTIONS;
+  for (Index = 0; Index < BENCH_IMAGE_SECTIONS; Index++) {
+    CopyMem (Sections[Index].Name, mBenchSectionNames[Index], AsciiStrLen (mBenchSectionNames[Index]));
+    Sections[Index].Misc.VirtualSize   = SectionSize;
+    Sections[Index].VirtualAddress     = BENCH_IMAGE_ALIGNMENT + Index * SectionSize;
+    Sections[Index].SizeOfRawData      = SectionSize;
+    Sections[Index].PointerToRawData   = BENCH_IMAGE_ALIGNMENT + Index * SectionSize;
+    Sections[Index].Characteristics    = EFI_IMAGE_SCN_MEM_READ;
+  }
+
+  for (Index = BENCH_IMAGE_ALIGNMENT; Index < CertInfoOffset; Index++) {
+    Image[Index] = (UINT8) ((Index * 2654435761U) >> 24U);
+  }
+
+  CertInfo             = (APPLE_EFI_CERTIFICATE_INFO *) (Image + CertInfoOffset);
+  CertInfo->CertOffset = CertInfoOffset + sizeof (*CertInfo);
+  CertInfo->CertSize   = sizeof (*Cert);
+
+  Cert           = (APPLE_EFI_CERTIFICATE *) (Image + CertInfo->CertOffset);
+  Cert->CertSize = sizeof (*Cert);
+  Cert->CertType = APPLE_EFI_CERTIFICATE_TYPE;
+  CopyGuid (&Cert->AppleSignatureGuid, &gAppleEfiCertificateGuid);
+  CopyGuid (&Cert->CertData.HashType, &gEfiCertTypeRsa2048Sha256Guid);
+  //
+  // Pre-processed key modulus is stored as little endian words.
+  //
+  CopyMem (Cert->CertData.PublicKey, ((RSA_PUBLIC_KEY *) mBenchTestKey)->Data, sizeof (Cert->CertData.PublicKey));
+  CopyMem (Cert->CertData.Signature, BenchImage->Signature, sizeof (Cert->CertData.Signature));
+
+  return Image;
+}
+
+/**
+  Verify a copy of Image streamed in pieces of random size up to twice
+  BENCH_STREAM_PIECE, small enough to split the headers.
+**/
+STATIC
+EFI_STATUS
+BenchStream (
+  APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  CONST UINT8              *Image,
+  UINTN                    ImageSize,
+  UINT64                   *Seed
+  )
+{
+  APPLE_PE_IMAGE_STREAM  Stream;
+  EFI_STATUS             Status;
+  UINT8                  *Copy;
+  UINTN                  Offset;
+  UINTN                  Piece;
+
+  Copy = malloc (ImageSize);
+  if (Copy == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = ApplePeImageStreamInit (Verifier, &Stream, Copy, ImageSize);
+  if (EFI_ERROR (Status)) {
+    free (Copy);
+    return Status;
+  }
+
+  for (Offset = 0; Offset < ImageSize; Offset += Piece) {
+    Piece = (UINTN) (BenchRandom (Seed) % (2 * BENCH_STREAM_PIECE) + 1);
+    Piece = MIN (Piece, ImageSize - Offset);
+    CopyMem (Copy + Offset, Image + Offset, Piece);
+    Status = ApplePeImageStreamUpdate (&Stream, Piece);
+    if (EFI_ERROR (Status)) {
+      free (Copy);
+      return Status;
+    }
+  }
+
+  Status = ApplePeImageStreamFinal (&Stream, &Offset);
+  free (Copy);
+  return Status;
+}
+
+STATIC
+VOID
+BenchRunStream (
+  APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  UINT8                    *Image,
+  UINTN                    ImageSize,
+  UINT32                   Verifications,
+  BENCH_RESULT             *Result
+  )
+{
+  BENCH_FILE  File;
+  UINT8       *Buffer;
+  UINTN       Size;
+  UINT64      Seed;
+  UINT64      Start;
+  UINT32      Index;
+
+  Seed = 1;
+  for (Index = 0; Index < 16; Index++) {
+    if (BenchStream (Verifier, Image, ImageSize, &Seed) != EFI_SUCCESS) {
+      Result->Status = 4;
+      return;
+    }
+  }
+
+  Image[ImageSize / 2] ^= 1;
+  if (BenchStream (Verifier, Image, ImageSize, &Seed) != EFI_SECURITY_VIOLATION) {
+    Result->Status = 4;
+    return;
+  }
+  Image[ImageSize / 2] ^= 1;
+
+  ZeroMem (&File, sizeof (File));
+  File.Protocol.Read        = BenchFileRead;
+  File.Protocol.SetPosition = BenchFileSetPosition;
+  File.Protocol.GetPosition = BenchFileGetPosition;
+  File.Data                 = Image;
+  File.Size                 = 0;
+
+  //
+  // Empty files must be rejected.
+  //
+  if (VerifyApplePeImageFile (Verifier, &File.Protocol, (VOID **) &Buffer, &Size) != EFI_INVALID_PARAMETER) {
+    Result->Status = 4;
+    return;
+  }
+
+  File.Size = ImageSize;
+
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    Buffer = malloc (ImageSize);
+    if (Buffer == NULL
+      || ReadFileData (&File.Protocol, 0, (UINT32) ImageSize, Buffer) != EFI_SUCCESS) {
+      Result->Status = 4;
+      free (Buffer);
+      return;
+    }
+
+    Size = ImageSize;
+    if (VerifyApplePeImage (Verifier, Buffer, &Size) != EFI_SUCCESS) {
+      Result->Status = 1;
+      free (Buffer);
+      return;
+    }
+    free (Buffer);
+  }
+  Result->ReadVerifyNs = (BenchTimestamp () - Start) / Verifications;
+
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    if (VerifyApplePeImageFile (Verifier, &File.Protocol, (VOID **) &Buffer, &Size) != EFI_SUCCESS) {
+      Result->Status = 4;
+      return;
+    }
+    FreePool (Buffer);
+  }
+  Result->FileVerifyNs = (BenchTimestamp () - Start) / Verifications;
+}
+
+STATIC
+VOID
+BenchRun (
+  CONST BENCH_IMAGE        *BenchImage,
+  APPLE_PE_IMAGE_VERIFIER  *Verifier,
+  UINT32                   Verifications,
+  BENCH_RESULT             *Result
+  )
+{
+  UINT8                               *Image;
+  UINTN                               ImageSize;
+  UINTN                               Size;
+  APPLE_PE_COFF_LOADER_IMAGE_CONTEXT  Context;
+  APPLE_SIGNATURE_CONTEXT             SignatureContext;
+  UINT64                              Start;
+  UINT32                              Index;
+  BOOLEAN                             Valid;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  Image = BenchCreateImage (BenchImage, &ImageSize);
+  if (Image == NULL) {
+    Result->Status = 1;
+    return;
+  }
+
+  Result->Kilobytes = ImageSize / BASE_1KB;
+
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    Size = ImageSize;
+    if (VerifyApplePeImage (Verifier, Image, &Size) != EFI_SUCCESS) {
+      Result->Status = 1;
+      free (Image);
+      return;
+    }
+  }
+  Result->VerifyNs = (BenchTimestamp () - Start) / Verifications;
+
+  //
+  // Time hashing and RSA on their own with the contexts of the last image.
+  //
+  CopyMem (&Context, &Verifier->PeContext, sizeof (Context));
+  CopyMem (&SignatureContext, &Verifier->SignatureContext, sizeof (SignatureContext));
+
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    GetApplePeImageSha256 (Image, &Context);
+  }
+  Result->HashNs = (BenchTimestamp () - Start) / Verifications;
+
+  Valid = TRUE;
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    Valid &= RsaVerify (
+      (RSA_PUBLIC_KEY *) mBenchTestKey,
+      SignatureContext.Signature,
+      sizeof (SignatureContext.Signature),
+      Context.PeImageHash,
+      Verifier->WorkBuf64
+      );
+  }
+  Result->RsaNs = (BenchTimestamp () - Start) / Verifications;
+
+  if (!Valid) {
+    Result->Status = 1;
+    free (Image);
+    return;
+  }
+
+  Image[ImageSize / 2] ^= 1;
+  Size = ImageSize;
+  if (VerifyApplePeImage (Verifier, Image, &Size) != EFI_SECURITY_VIOLATION) {
+    Result->Status = 2;
+    free (Image);
+    return;
+  }
+  Image[ImageSize / 2] ^= 1;
+
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    Size = ImageSize;
+    if (VerifyApplePeImageSignature (Image, &Size, NULL) != EFI_UNSUPPORTED) {
+      Result->Status = 3;
+      free (Image);
+      return;
+    }
+  }
+  Result->RejectNs = (BenchTimestamp () - Start) / Verifications;
+
+  BenchRunStream (Verifier, Image, ImageSize, Verifications, Result);
+
+  free (Image);
+}
+
+STATIC
+VOID
+BenchPrint (
+  FILE          *Output,
+  CONST CHAR8   *Name,
+  BENCH_RESULT  *Result,
+  BOOLEAN       First
+  )
+{
+  UINT64  OverheadNs;
+
+  OverheadNs = Result->VerifyNs - MIN (Result->VerifyNs, Result->HashNs + Result->RsaNs);
+
+  BenchBeginResult (Output, First);
+  fprintf (
+    Output,
+    "{\"name\": \"%s\", \"status\": %u, \"kilobytes\": %llu, \"verify_ns\": %llu, \"hash_ns\": %llu, "
+    "\"rsa_ns\": %llu, \"overhead_ns\": %llu, \"reject_ns\": %llu, \"read_verify_ns\": %llu, \"file_verify_ns\": %llu}",
+    Name,
+    Result->Status,
+    (unsigned long long) Result->Kilobytes,
+    (unsigned long long) Result->VerifyNs,
+    (unsigned long long) Result->HashNs,
+    (unsigned long long) Result->RsaNs,
+    (unsigned long long) OverheadNs,
+    (unsigned long long) Result->RejectNs,
+    (unsigned long long) Result->ReadVerifyNs,
+    (unsigned long long) Result->FileVerifyNs
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32                   Verifications;
+  INT32                    Opt;
+  UINT32                   Index;
+  APPLE_PK_ENTRY           Key;
+  APPLE_PE_IMAGE_VERIFIER  Verifier;
+  BENCH_RESULT             Result;
+  FILE                     *Output;
+  INT32                    ExitCode;
+
+  Verifications = 1000;
+
+  while ((Opt = getopt (argc, argv, "n:")) != -1) {
+    switch (Opt) {
+      case 'n':
+        Verifications = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-n verifications]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Verifications == 0) {
+    fprintf (stderr, "Invalid verification count\n");
+    return -1;
+  }
+
+  Output = BenchOpenOutput ();
+  if (Output == NULL) {
+    return -1;
+  }
+
+  CopyMem (Key.PublicKey, mBenchTestKey, sizeof (Key.PublicKey));
+  Sha256 (Key.Hash, (UINT8 *) ((RSA_PUBLIC_KEY *) mBenchTestKey)->Data, 256);
+  InitializeApplePeImageVerifier (&Verifier, &Key, 1);
+
+  ExitCode = 0;
+  BenchBeginResults (Output, "  \"verifications\": %u,\n", Verifications);
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchImages); Index++) {
+    BenchRun (&mBenchImages[Index], &Verifier, Verifications, &Result);
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+    BenchPrint (Output, mBenchImages[Index].Name, &Result, Index == 0);
+  }
+
+  BenchEndResults (Output);
+
+  return ExitCode;
+}
@@ -206,6 +206,7 @@ struct _LIST_ENTRY {
 #define RETURN_CRC_ERROR             ENCODE_ERROR (27)
 #define RETURN_END_OF_MEDIA          ENCODE_ERROR (28)
 #define RETURN_END_OF_FILE           ENCODE_ERROR (31)
+#define RETURN_COMPROMISED_DATA      ENCODE_ERROR (33)
 
 #define EFI_SUCCESS               RETURN_SUCCESS
 #define EFI_LOAD_ERROR            RETURN_LOAD_ERROR
@@ -237,6 +238,7 @@ struct _LIST_ENTRY {
 #define EFI_CRC_ERROR             RETURN_CRC_ERROR
 #define EFI_END_OF_MEDIA          RETURN_END_OF_MEDIA
 #define EFI_END_OF_FILE           RETURN_END_OF_FILE
+#define EFI_COMPROMISED_DATA      RETURN_COMPROMISED_DATA
 
 #define EFI_WARN_UNKNOWN_GLYPH    RETURN_WARN_UNKNOWN_GLYPH
 #define EFI_WARN_DELETE_FAILURE   RETURN_WARN_DELETE_FAILURE
@@ -491,6 +493,7 @@ struct _LIST_ENTRY {
 #define UnicodeSPrint(...) assert(false)
 #define CompareGuid(a, b) (memcmp((a), (b), sizeof (EFI_GUID)) == 0)
 #define CopyGuid(a, b) memcpy((a), (b), sizeof (EFI_GUID))
+#define SwapBytes32(x) __builtin_bswap32(x)
 
 EFI_STATUS EfiGetSystemConfigurationTable (EFI_GUID *TableGuid, OUT VOID **Table);
 
@@ -705,17 +708,6 @@ AsmWriteMsr64 (
 {
 }
 
-STATIC
-UINT64
-EFIAPI
-GetPerformanceCounterProperties (
-  UINT64  *StartValue,
-  UINT64  *EndValue
-  )
-{
-  return 0;
-}
-
 STATIC
 UINTN
 StrLen (
@@ -1048,7 +1040,7 @@ ReadUnaligned32 (
   LowerBytes  = ReadUnaligned16 ((UINT16*) Buffer);
   HigherBytes = ReadUnaligned16 ((UINT16*) Buffer + 1);
 
-  return (UINT32) (LowerBytes | (HigherBytes << 16));
+  return (UINT32) (LowerBytes | ((UINT32) HigherBytes << 16));
 }
 
 STATIC
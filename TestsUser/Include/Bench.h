@@ -0,0 +1,168 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <time.h>
+#include <unistd.h>
+
+//
+// Helpers shared by the userspace benchmarks.  Every benchmark prints its
+// results as JSON of the form:
+//
+// {
+//   "parameter": value,
+//   "results": [
+//     {"name": "case", "status": 0, ...},
+//     ...
+//   ]
+// }
+//
+
+/**
+  Return monotonic time in nanoseconds.
+**/
+STATIC
+inline
+UINT64
+BenchTimestamp (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  clock_gettime (CLOCK_MONOTONIC, &Time);
+  return (UINT64) Time.tv_sec * 1000000000ULL + (UINT64) Time.tv_nsec;
+}
+
+/**
+  Return the next value of a reproducible pseudo-random sequence.
+**/
+STATIC
+inline
+UINT64
+BenchRandom (
+  UINT64  *Seed
+  )
+{
+  *Seed = *Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *Seed >> 16;
+}
+
+/**
+  Fill Buffer with the pseudo-random sequence starting at Seed.
+**/
+STATIC
+inline
+VOID
+BenchFillRandom (
+  UINT8   *Buffer,
+  UINTN   Size,
+  UINT64  Seed
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Size; Index++) {
+    Buffer[Index] = (UINT8) BenchRandom (&Seed);
+  }
+}
+
+/**
+  Return whether case Name is selected by Filter, NULL selects every case.
+**/
+STATIC
+inline
+BOOLEAN
+BenchIsSelected (
+  CONST CHAR8  *Name,
+  CONST CHAR8  *Filter
+  )
+{
+  return Filter == NULL || strstr (Name, Filter) != NULL;
+}
+
+/**
+  Return a stream for the results.  Library DEBUG output goes to stdout,
+  which is redirected to keep it out of the results.
+**/
+STATIC
+inline
+FILE *
+BenchOpenOutput (
+  VOID
+  )
+{
+  FILE  *Output;
+
+  Output = fdopen (dup (STDOUT_FILENO), "w");
+  if (Output == NULL || freopen ("/dev/null", "w", stdout) == NULL) {
+    fprintf (stderr, "Failed to redirect output\n");
+    return NULL;
+  }
+
+  return Output;
+}
+
+/**
+  Start the results, Format prints the parameter lines preceding them.
+**/
+STATIC
+inline
+VOID
+BenchBeginResults (
+  FILE         *Output,
+  CONST CHAR8  *Format,
+  ...
+  )
+{
+  va_list  Args;
+
+  fprintf (Output, "{\n");
+  va_start (Args, Format);
+  vfprintf (Output, Format, Args);
+  va_end (Args);
+  fprintf (Output, "  \"results\": [\n");
+}
+
+/**
+  Start a result line, results but the First are separated by commas.
+**/
+STATIC
+inline
+VOID
+BenchBeginResult (
+  FILE     *Output,
+  BOOLEAN  First
+  )
+{
+  fprintf (Output, "%s    ", First ? "" : ",\n");
+}
+
+/**
+  Finish the results and close Output.
+**/
+STATIC
+inline
+VOID
+BenchEndResults (
+  FILE  *Output
+  )
+{
+  fprintf (Output, "\n  ]\n}\n");
+  fclose (Output);
+}
+
+#endif // BENCH_H
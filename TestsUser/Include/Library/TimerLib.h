@@ -0,0 +1,57 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef TIMER_LIB_H
+#define TIMER_LIB_H
+
+#include <time.h>
+
+STATIC
+UINT64
+EFIAPI
+GetPerformanceCounterProperties (
+  UINT64  *StartValue,
+  UINT64  *EndValue
+  )
+{
+  return 0;
+}
+
+//
+// Host performance counter ticks are nanoseconds.
+//
+STATIC
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  clock_gettime (CLOCK_MONOTONIC, &Time);
+  return (UINT64) Time.tv_sec * 1000000000ULL + (UINT64) Time.tv_nsec;
+}
+
+STATIC
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  UINT64  Ticks
+  )
+{
+  return Ticks;
+}
+
+#endif // TIMER_LIB_H
@@ -0,0 +1,902 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <IndustryStandard/AppleCompressedBinaryImage.h>
+
+#include <Library/OcAppleKernelLib.h>
+#include <Library/OcCompressionLib.h>
+#include <Library/OcFileLib.h>
+#include <Library/OcMachoLib.h>
+#include <Library/OcXmlLib.h>
+
+#include <dirent.h>
+
+/*
+ clang -O2 -g -Wno-incompatible-pointer-types-discards-qualifiers -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h KernelBuilder.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMachoLib/CxxSymbols.c ../../Library/OcMachoLib/Header.c ../../Library/OcMachoLib/Relocations.c ../../Library/OcMachoLib/Symbols.c ../../Library/OcAppleKernelLib/PrelinkedContext.c ../../Library/OcAppleKernelLib/PrelinkedKext.c ../../Library/OcAppleKernelLib/KernelTiming.c ../../Library/OcAppleKernelLib/PrelinkedSymbolCache.c ../../Library/OcAppleKernelLib/KextPatcher.c ../../Library/OcMiscLib/DataPatcher.c ../../Library/OcAppleKernelLib/Prelinker.c ../../Library/OcAppleKernelLib/Link.c ../../Library/OcAppleKernelLib/Dependencies.c ../../Library/OcAppleKernelLib/Vtables.c ../../Library/OcCompressionLib/lzss/lzss.c ../../Library/OcCompressionLib/lzvn/lzvn.c ../../Library/OcCompressionLib/lzvn/lzvn_encode.c -o KernelBuilder
+
+ ./KernelBuilder jobs.txt
+
+ Every job line consists of 4 space separated fields, '-' skips an input:
+   <prelinkedkernel> <kext directory> <patch list> <output>
+ Prelinkedkernel may be uncompressed or compressed with LZSS or LZVN, output
+ is always compressed with LZVN.  Kext directory contains *.kext bundles,
+ which are injected in one batch.  Patch list lines look like:
+   <kernel or kext identifier> <find hex> <replace hex> [count [skip]]
+ Lines starting with '#' are ignored in both files.
+
+ Inputs are loaded and parsed once per invocation, so jobs sharing a kernel,
+ kexts or patches only pay for them once.  Linked symbol tables of a kernel
+ are exported after its first job and attached to the next ones.
+
+ rm -rf KernelBuilder.dSYM KernelBuilder
+*/
+
+#define BUILDER_MAX_LINE  4096
+
+typedef enum {
+  BuilderEntryFile,
+  BuilderEntryKernel,
+  BuilderEntryKexts,
+  BuilderEntryPatches
+} BUILDER_ENTRY_KIND;
+
+typedef struct {
+  //
+  // Kernel or kext identifier.
+  //
+  CHAR8                  *Target;
+  PATCHER_GENERIC_PATCH  Patch;
+} BUILDER_PATCH;
+
+//
+// Cached input, shared between the jobs.
+//
+typedef struct BUILDER_ENTRY_ BUILDER_ENTRY;
+struct BUILDER_ENTRY_ {
+  BUILDER_ENTRY       *Next;
+  BUILDER_ENTRY_KIND  Kind;
+  CHAR8               *Path;
+  //
+  // File contents, decompressed kernel, PRELINKED_KEXT_REQUEST or BUILDER_PATCH array.
+  //
+  VOID                *Data;
+  //
+  // Data size for files and kernels, number of entries otherwise.
+  //
+  UINT32              Size;
+  //
+  // Kexts reserved size for BuilderEntryKexts, symbol cache size for BuilderEntryKernel.
+  //
+  UINT32              ExtraSize;
+  //
+  // Exported symbol cache for BuilderEntryKernel.
+  //
+  VOID                *SymbolCache;
+};
+
+STATIC BUILDER_ENTRY  *mBuilderEntries;
+
+//
+// Symbol cache files are not loaded from UEFI file systems here.
+//
+VOID *
+ReadFile (
+  IN  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem,
+  IN  CONST CHAR16                     *FilePath,
+  OUT UINTN                            *FileSize OPTIONAL
+  )
+{
+  return NULL;
+}
+
+STATIC
+BUILDER_ENTRY *
+BuilderFindEntry (
+  IN BUILDER_ENTRY_KIND  Kind,
+  IN CONST CHAR8         *Path
+  )
+{
+  BUILDER_ENTRY  *Entry;
+
+  for (Entry = mBuilderEntries; Entry != NULL; Entry = Entry->Next) {
+    if (Entry->Kind == Kind && AsciiStrCmp (Entry->Path, Path) == 0) {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
+STATIC
+BUILDER_ENTRY *
+BuilderAddEntry (
+  IN BUILDER_ENTRY_KIND  Kind,
+  IN CONST CHAR8         *Path
+  )
+{
+  BUILDER_ENTRY  *Entry;
+
+  Entry = AllocateZeroPool (sizeof (*Entry));
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  Entry->Path = strdup (Path);
+  if (Entry->Path == NULL) {
+    FreePool (Entry);
+    return NULL;
+  }
+
+  Entry->Kind     = Kind;
+  Entry->Next     = mBuilderEntries;
+  mBuilderEntries = Entry;
+  return Entry;
+}
+
+STATIC
+BUILDER_ENTRY *
+BuilderLoadFile (
+  IN CONST CHAR8  *Path
+  )
+{
+  BUILDER_ENTRY  *Entry;
+  FILE           *File;
+  long           FileSize;
+  UINT8          *Buffer;
+
+  Entry = BuilderFindEntry (BuilderEntryFile, Path);
+  if (Entry != NULL) {
+    return Entry;
+  }
+
+  File = fopen (Path, "rb");
+  if (File == NULL) {
+    return NULL;
+  }
+
+  fseek (File, 0, SEEK_END);
+  FileSize = ftell (File);
+  fseek (File, 0, SEEK_SET);
+
+  Buffer = NULL;
+  if (FileSize > 0 && FileSize <= OC_COMPRESSION_MAX_LENGTH) {
+    //
+    // Terminate text inputs for parsing.
+    //
+    Buffer = AllocatePool (FileSize + 1);
+  }
+
+  if (Buffer != NULL && fread (Buffer, FileSize, 1, File) != 1) {
+    FreePool (Buffer);
+    Buffer = NULL;
+  }
+
+  fclose (File);
+
+  if (Buffer == NULL) {
+    return NULL;
+  }
+
+  Buffer[FileSize] = '\0';
+
+  Entry = BuilderAddEntry (BuilderEntryFile, Path);
+  if (Entry == NULL) {
+    FreePool (Buffer);
+    return NULL;
+  }
+
+  Entry->Data = Buffer;
+  Entry->Size = (UINT32) FileSize;
+  return Entry;
+}
+
+STATIC
+BUILDER_ENTRY *
+BuilderLoadKernel (
+  IN CONST CHAR8  *Path
+  )
+{
+  BUILDER_ENTRY     *Entry;
+  BUILDER_ENTRY     *File;
+  MACH_COMP_HEADER  *CompHeader;
+  UINT8             *Kernel;
+  UINT32            KernelSize;
+  UINT32            CompressedSize;
+  UINT32            DecompressedSize;
+
+  Entry = BuilderFindEntry (BuilderEntryKernel, Path);
+  if (Entry != NULL) {
+    return Entry;
+  }
+
+  File = BuilderLoadFile (Path);
+  if (File == NULL || File->Size < sizeof (MACH_COMP_HEADER)) {
+    printf ("Failed to read kernel %s\n", Path);
+    return NULL;
+  }
+
+  if (*(UINT32 *) File->Data == MACH_COMPRESSED_BINARY_INVERT_SIGNATURE) {
+    CompHeader       = (MACH_COMP_HEADER *) File->Data;
+    CompressedSize   = SwapBytes32 (CompHeader->Compressed);
+    DecompressedSize = SwapBytes32 (CompHeader->Decompressed);
+
+    if (CompressedSize > File->Size - sizeof (MACH_COMP_HEADER)
+      || DecompressedSize > OC_COMPRESSION_MAX_LENGTH) {
+      printf ("Invalid compressed kernel %s\n", Path);
+      return NULL;
+    }
+
+    Kernel = AllocatePool (DecompressedSize);
+    if (Kernel == NULL) {
+      return NULL;
+    }
+
+    KernelSize = 0;
+    if (CompHeader->Compression == MACH_COMPRESSED_BINARY_INVERT_LZVN) {
+      KernelSize = (UINT32) DecompressLZVN (Kernel, DecompressedSize, (UINT8 *) (CompHeader + 1), CompressedSize);
+    } else if (CompHeader->Compression == MACH_COMPRESSED_BINARY_INVERT_LZSS) {
+      KernelSize = DecompressLZSS (Kernel, DecompressedSize, (UINT8 *) (CompHeader + 1), CompressedSize);
+    }
+
+    if (KernelSize != DecompressedSize) {
+      printf ("Failed to decompress kernel %s\n", Path);
+      FreePool (Kernel);
+      return NULL;
+    }
+  } else if (*(UINT32 *) File->Data == MACH_HEADER_64_SIGNATURE) {
+    Kernel     = File->Data;
+    KernelSize = File->Size;
+  } else {
+    printf ("Unsupported kernel %s\n", Path);
+    return NULL;
+  }
+
+  Entry = BuilderAddEntry (BuilderEntryKernel, Path);
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  Entry->Data = Kernel;
+  Entry->Size = KernelSize;
+  return Entry;
+}
+
+STATIC
+CHAR8 *
+BuilderGetBundleExecutable (
+  IN BUILDER_ENTRY  *InfoPlist
+  )
+{
+  XML_DOCUMENT  *Document;
+  XML_NODE      *Root;
+  CHAR8         *Buffer;
+  CONST CHAR8   *Key;
+  XML_NODE      *Value;
+  CHAR8         *Executable;
+  UINT32        Index;
+  UINT32        Count;
+
+  Buffer = AllocateCopyPool (InfoPlist->Size, InfoPlist->Data);
+  if (Buffer == NULL) {
+    return NULL;
+  }
+
+  Executable = NULL;
+  Document   = XmlDocumentParse (Buffer, InfoPlist->Size, FALSE);
+  Root       = Document != NULL ? PlistNodeCast (PlistDocumentRoot (Document), PLIST_NODE_TYPE_DICT) : NULL;
+
+  if (Root != NULL) {
+    Count = PlistDictChildren (Root);
+    for (Index = 0; Index < Count; ++Index) {
+      Key = PlistKeyValue (PlistDictChild (Root, Index, &Value));
+      if (Key != NULL && AsciiStrCmp (Key, "CFBundleExecutable") == 0
+        && PlistNodeCast (Value, PLIST_NODE_TYPE_STRING) != NULL
+        && XmlNodeContent (Value) != NULL) {
+        Executable = strdup (XmlNodeContent (Value));
+        break;
+      }
+    }
+  }
+
+  if (Document != NULL) {
+    XmlDocumentFree (Document);
+  }
+
+  FreePool (Buffer);
+  return Executable;
+}
+
+STATIC
+VOID
+BuilderFreeKextRequest (
+  IN OUT PRELINKED_KEXT_REQUEST  *Request
+  )
+{
+  free ((CHAR8 *) Request->BundlePath);
+  free ((CHAR8 *) Request->ExecutablePath);
+  Request->BundlePath     = NULL;
+  Request->ExecutablePath = NULL;
+}
+
+STATIC
+VOID
+BuilderFreeKextRequests (
+  IN PRELINKED_KEXT_REQUEST  *Requests,
+  IN UINT32                  NumRequests
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < NumRequests; ++Index) {
+    BuilderFreeKextRequest (&Requests[Index]);
+  }
+
+  FreePool (Requests);
+}
+
+STATIC
+BUILDER_ENTRY *
+BuilderLoadKexts (
+  IN CONST CHAR8  *Path
+  )
+{
+  BUILDER_ENTRY           *Entry;
+  BUILDER_ENTRY           *InfoPlist;
+  BUILDER_ENTRY           *Executable;
+  PRELINKED_KEXT_REQUEST  *Requests;
+  PRELINKED_KEXT_REQUEST  *Request;
+  struct dirent           **Names;
+  CHAR8                   *ExecutableName;
+  CHAR8                   FilePath[BUILDER_MAX_LINE];
+  UINT32                  NumRequests;
+  UINT32                  ReservedSize;
+  UINT32                  KextSize;
+  UINTN                   NameLength;
+  INT32                   NumNames;
+  INT32                   Index;
+
+  Entry = BuilderFindEntry (BuilderEntryKexts, Path);
+  if (Entry != NULL) {
+    return Entry;
+  }
+
+  //
+  // Sorted names keep injection order and the result reproducible.
+  //
+  NumNames = scandir (Path, &Names, NULL, alphasort);
+  if (NumNames < 0) {
+    printf ("Failed to open kext directory %s\n", Path);
+    return NULL;
+  }
+
+  Requests     = AllocateZeroPool (MAX (NumNames, 1) * sizeof (*Requests));
+  NumRequests  = 0;
+
+  for (Index = 0; Index < NumNames; ++Index) {
+    NameLength = AsciiStrLen (Names[Index]->d_name);
+    if (Requests == NULL || NameLength < 5
+      || AsciiStrCmp (&Names[Index]->d_name[NameLength - 5], ".kext") != 0) {
+      continue;
+    }
+
+    snprintf (FilePath, sizeof (FilePath), "%s/%s/Contents/Info.plist", Path, Names[Index]->d_name);
+    InfoPlist = BuilderLoadFile (FilePath);
+    if (InfoPlist == NULL) {
+      printf ("Skipping %s without Info.plist\n", Names[Index]->d_name);
+      continue;
+    }
+
+    Request = &Requests[NumRequests];
+    ZeroMem (Request, sizeof (*Request));
+
+    Request->InfoPlist     = InfoPlist->Data;
+    Request->InfoPlistSize = InfoPlist->Size;
+
+    snprintf (FilePath, sizeof (FilePath), "/Library/Extensions/%s", Names[Index]->d_name);
+    Request->BundlePath = strdup (FilePath);
+
+    ExecutableName = BuilderGetBundleExecutable (InfoPlist);
+    if (ExecutableName != NULL) {
+      snprintf (FilePath, sizeof (FilePath), "%s/%s/Contents/MacOS/%s", Path, Names[Index]->d_name, ExecutableName);
+      Executable = BuilderLoadFile (FilePath);
+      if (Executable == NULL) {
+        printf ("Skipping %s without executable %s\n", Names[Index]->d_name, ExecutableName);
+        free (ExecutableName);
+        BuilderFreeKextRequest (Request);
+        continue;
+      }
+
+      snprintf (FilePath, sizeof (FilePath), "Contents/MacOS/%s", ExecutableName);
+      free (ExecutableName);
+      Request->ExecutablePath = strdup (FilePath);
+      Request->Executable     = Executable->Data;
+      Request->ExecutableSize = Executable->Size;
+    }
+
+    KextSize = 0;
+    if (EFI_ERROR (PrelinkedReserveKextSize (&KextSize, Request->InfoPlistSize, Request->ExecutableSize))) {
+      printf ("Skipping %s with too large size\n", Names[Index]->d_name);
+      BuilderFreeKextRequest (Request);
+      continue;
+    }
+
+    ++NumRequests;
+  }
+
+  for (Index = 0; Index < NumNames; ++Index) {
+    free (Names[Index]);
+  }
+
+  free (Names);
+
+  if (Requests == NULL) {
+    return NULL;
+  }
+
+  if (EFI_ERROR (PrelinkedReserveKextsSize (&ReservedSize, Requests, NumRequests))) {
+    printf ("Kexts in %s are too large\n", Path);
+    BuilderFreeKextRequests (Requests, NumRequests);
+    return NULL;
+  }
+
+  Entry = BuilderAddEntry (BuilderEntryKexts, Path);
+  if (Entry == NULL) {
+    BuilderFreeKextRequests (Requests, NumRequests);
+    return NULL;
+  }
+
+  Entry->Data      = Requests;
+  Entry->Size      = NumRequests;
+  Entry->ExtraSize = ReservedSize;
+  return Entry;
+}
+
+STATIC
+UINT8 *
+BuilderParseHex (
+  IN  CONST CHAR8  *Hex,
+  OUT UINT32       *Size
+  )
+{
+  UINT8   *Buffer;
+  UINTN   Length;
+  UINTN   Index;
+  UINT32  Byte;
+
+  Length = AsciiStrLen (Hex);
+  if (Length == 0 || Length % 2 != 0) {
+    return NULL;
+  }
+
+  Buffer = AllocatePool (Length / 2);
+  if (Buffer == NULL) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < Length / 2; ++Index) {
+    if (sscanf (&Hex[Index * 2], "%2x", &Byte) != 1) {
+      FreePool (Buffer);
+      return NULL;
+    }
+
+    Buffer[Index] = (UINT8) Byte;
+  }
+
+  *Size = (UINT32) (Length / 2);
+  return Buffer;
+}
+
+STATIC
+VOID
+BuilderFreePatch (
+  IN OUT BUILDER_PATCH  *Patch
+  )
+{
+  if (Patch->Patch.Find != NULL) {
+    FreePool ((UINT8 *) Patch->Patch.Find);
+  }
+
+  if (Patch->Patch.Replace != NULL) {
+    FreePool ((UINT8 *) Patch->Patch.Replace);
+  }
+
+  free (Patch->Target);
+  ZeroMem (Patch, sizeof (*Patch));
+}
+
+STATIC
+BUILDER_ENTRY *
+BuilderLoadPatches (
+  IN CONST CHAR8  *Path
+  )
+{
+  BUILDER_ENTRY  *Entry;
+  BUILDER_ENTRY  *File;
+  BUILDER_PATCH  *Patches;
+  BUILDER_PATCH  *Patch;
+  CHAR8          *Lines;
+  CHAR8          *Line;
+  CHAR8          *Next;
+  CHAR8          Target[BUILDER_MAX_LINE];
+  CHAR8          Find[BUILDER_MAX_LINE];
+  CHAR8          Replace[BUILDER_MAX_LINE];
+  UINT32         FindSize;
+  UINT32         ReplaceSize;
+  UINT32         NumPatches;
+  UINT32         NumLines;
+  UINT32         Index;
+  INT32          NumFields;
+
+  Entry = BuilderFindEntry (BuilderEntryPatches, Path);
+  if (Entry != NULL) {
+    return Entry;
+  }
+
+  File = BuilderLoadFile (Path);
+  if (File == NULL) {
+    printf ("Failed to read patch list %s\n", Path);
+    return NULL;
+  }
+
+  NumLines = 1;
+  for (Line = File->Data; *Line != '\0'; ++Line) {
+    NumLines += *Line == '\n';
+  }
+
+  Patches = AllocateZeroPool (NumLines * sizeof (*Patches));
+  if (Patches == NULL) {
+    return NULL;
+  }
+
+  //
+  // Work on a copy to keep the file usable as is.
+  //
+  Lines      = strdup (File->Data);
+  NumPatches = 0;
+
+  for (Line = Lines; Line != NULL && *Line != '\0'; Line = Next) {
+    Next = strchr (Line, '\n');
+    if (Next != NULL) {
+      *Next++ = '\0';
+    }
+
+    if (*Line == '#' || *Line == '\0' || *Line == '\r') {
+      continue;
+    }
+
+    Patch = &Patches[NumPatches];
+    ZeroMem (Patch, sizeof (*Patch));
+
+    NumFields = sscanf (
+      Line,
+      "%4095s %4095s %4095s %u %u",
+      Target,
+      Find,
+      Replace,
+      &Patch->Patch.Count,
+      &Patch->Patch.Skip
+      );
+
+    if (NumFields < 3) {
+      printf ("Skipping malformed patch %s\n", Line);
+      continue;
+    }
+
+    Patch->Patch.Find    = BuilderParseHex (Find, &FindSize);
+    Patch->Patch.Replace = BuilderParseHex (Replace, &ReplaceSize);
+    if (Patch->Patch.Find == NULL || Patch->Patch.Replace == NULL || FindSize != ReplaceSize) {
+      printf ("Skipping patch with invalid data %s\n", Line);
+      BuilderFreePatch (Patch);
+      continue;
+    }
+
+    Patch->Target     = strdup (Target);
+    Patch->Patch.Size = FindSize;
+    ++NumPatches;
+  }
+
+  free (Lines);
+
+  Entry = BuilderAddEntry (BuilderEntryPatches, Path);
+  if (Entry == NULL) {
+    for (Index = 0; Index < NumPatches; ++Index) {
+      BuilderFreePatch (&Patches[Index]);
+    }
+
+    FreePool (Patches);
+    return NULL;
+  }
+
+  Entry->Data = Patches;
+  Entry->Size = NumPatches;
+  return Entry;
+}
+
+STATIC
+VOID
+BuilderApplyPatches (
+  IN     BUILDER_ENTRY      *Patches,
+  IN OUT PRELINKED_CONTEXT  *Context  OPTIONAL,
+  IN OUT UINT8              *Kernel,
+  IN     UINT32             KernelSize
+  )
+{
+  EFI_STATUS             Status;
+  PATCHER_CONTEXT        Patcher;
+  PATCHER_PATCH_REQUEST  *Requests;
+  BUILDER_PATCH          *Patch;
+  UINT32                 NumRequests;
+  UINT32                 Index;
+  BOOLEAN                IsKernel;
+
+  //
+  // Kernel patches apply before prelinked context creation, kext patches after.
+  //
+  if (Context == NULL) {
+    Status = PatcherInitContextFromBuffer (&Patcher, Kernel, KernelSize);
+    if (EFI_ERROR (Status)) {
+      printf ("Failed to patch kernel - %zx\n", Status);
+      return;
+    }
+  }
+
+  Requests    = AllocatePool (MAX (Patches->Size, 1) * sizeof (*Requests));
+  NumRequests = 0;
+
+  for (Index = 0; Index < Patches->Size; ++Index) {
+    Patch    = &((BUILDER_PATCH *) Patches->Data)[Index];
+    IsKernel = AsciiStrCmp (Patch->Target, "kernel") == 0;
+
+    if (IsKernel != (Context == NULL)) {
+      continue;
+    }
+
+    if (IsKernel) {
+      Status = PatcherApplyGenericPatch (&Patcher, &Patch->Patch);
+      if (EFI_ERROR (Status)) {
+        printf ("Failed to patch %s - %zx\n", Patch->Target, Status);
+      }
+    } else if (Requests != NULL) {
+      Requests[NumRequests].Identifier = Patch->Target;
+      Requests[NumRequests].Patch      = &Patch->Patch;
+      ++NumRequests;
+    }
+  }
+
+  if (Context == NULL) {
+    MachoFreeContext (&Patcher.MachContext);
+  } else if (NumRequests > 0) {
+    //
+    // Kext patches are grouped so that every kext is looked up once.
+    //
+    PatcherApplyGenericPatches (Context, Requests, NumRequests);
+    for (Index = 0; Index < NumRequests; ++Index) {
+      if (EFI_ERROR (Requests[Index].Status)) {
+        printf ("Failed to patch %s - %zx\n", Requests[Index].Identifier, Requests[Index].Status);
+      }
+    }
+  }
+
+  if (Requests != NULL) {
+    FreePool (Requests);
+  }
+}
+
+STATIC
+EFI_STATUS
+BuilderWriteCompressed (
+  IN CONST CHAR8  *Path,
+  IN UINT8        *Kernel,
+  IN UINT32       KernelSize
+  )
+{
+  MACH_COMP_HEADER  *CompHeader;
+  UINT8             *Buffer;
+  UINTN             BufferSize;
+  UINTN             CompressedSize;
+  FILE              *File;
+  BOOLEAN           Written;
+
+  BufferSize = sizeof (MACH_COMP_HEADER) + OC_LZVN_MAX_COMPRESSED_LENGTH ((UINTN) KernelSize);
+  Buffer     = AllocateZeroPool (BufferSize);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CompHeader     = (MACH_COMP_HEADER *) Buffer;
+  CompressedSize = CompressLZVN (
+    (UINT8 *) (CompHeader + 1),
+    BufferSize - sizeof (MACH_COMP_HEADER),
+    Kernel,
+    KernelSize
+    );
+
+  if (CompressedSize == 0) {
+    FreePool (Buffer);
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *(UINT32 *) CompHeader   = MACH_COMPRESSED_BINARY_INVERT_SIGNATURE;
+  CompHeader->Compression  = MACH_COMPRESSED_BINARY_INVERT_LZVN;
+  CompHeader->Hash         = SwapBytes32 (Adler32 (Kernel, (INT32) KernelSize));
+  CompHeader->Decompressed = SwapBytes32 (KernelSize);
+  CompHeader->Compressed   = SwapBytes32 ((UINT32) CompressedSize);
+
+  Written = FALSE;
+  File    = fopen (Path, "wb");
+  if (File != NULL) {
+    Written = fwrite (Buffer, sizeof (MACH_COMP_HEADER) + CompressedSize, 1, File) == 1;
+    Written = fclose (File) == 0 && Written;
+  }
+
+  FreePool (Buffer);
+
+  return Written ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+}
+
+STATIC
+EFI_STATUS
+BuilderRunJob (
+  IN CONST CHAR8  *KernelPath,
+  IN CONST CHAR8  *KextsPath,
+  IN CONST CHAR8  *PatchesPath,
+  IN CONST CHAR8  *OutputPath
+  )
+{
+  EFI_STATUS         Status;
+  BUILDER_ENTRY      *Kernel;
+  BUILDER_ENTRY      *Kexts;
+  BUILDER_ENTRY      *Patches;
+  PRELINKED_CONTEXT  Context;
+  UINT8              *Prelinked;
+  UINT32             AllocSize;
+  VOID               *SymbolCache;
+  UINT32             SymbolCacheSize;
+
+  Kernel  = BuilderLoadKernel (KernelPath);
+  Kexts   = AsciiStrCmp (KextsPath, "-") != 0 ? BuilderLoadKexts (KextsPath) : NULL;
+  Patches = AsciiStrCmp (PatchesPath, "-") != 0 ? BuilderLoadPatches (PatchesPath) : NULL;
+
+  if (Kernel == NULL
+    || (Kexts == NULL && AsciiStrCmp (KextsPath, "-") != 0)
+    || (Patches == NULL && AsciiStrCmp (PatchesPath, "-") != 0)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Prelinked grows on demand when the planned reserve is not enough.
+  //
+  AllocSize = PRELINKED_ALIGN (Kernel->Size);
+  if (Kexts != NULL) {
+    AllocSize += Kexts->ExtraSize;
+  }
+
+  Prelinked = AllocatePool (AllocSize);
+  if (Prelinked == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (Prelinked, Kernel->Data, Kernel->Size);
+
+  if (Patches != NULL) {
+    BuilderApplyPatches (Patches, NULL, Prelinked, Kernel->Size);
+  }
+
+  Status = PrelinkedContextInit (&Context, Prelinked, Kernel->Size, AllocSize);
+  if (EFI_ERROR (Status)) {
+    printf ("Context creation error %zx for %s\n", Status, KernelPath);
+    FreePool (Prelinked);
+    return Status;
+  }
+
+  Context.PrelinkedGrowable = TRUE;
+
+  //
+  // Reuse linked symbol tables from the previous job with the same kernel.
+  //
+  if (Kernel->SymbolCache != NULL) {
+    SymbolCache = AllocateCopyPool (Kernel->ExtraSize, Kernel->SymbolCache);
+    if (SymbolCache != NULL
+      && EFI_ERROR (PrelinkedAttachSymbolCache (&Context, SymbolCache, Kernel->ExtraSize))) {
+      FreePool (SymbolCache);
+    }
+  }
+
+  if (Patches != NULL) {
+    BuilderApplyPatches (Patches, &Context, Prelinked, Kernel->Size);
+  }
+
+  if (Kexts != NULL && Kexts->Size > 0) {
+    Status = PrelinkedInjectPrepare (&Context);
+    if (!EFI_ERROR (Status)) {
+      Status = PrelinkedInjectKexts (&Context, Kexts->Data, Kexts->Size);
+      if (EFI_ERROR (Status)) {
+        printf ("Not all kexts were injected into %s - %zx\n", OutputPath, Status);
+      }
+
+      Status = PrelinkedInjectComplete (&Context);
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = BuilderWriteCompressed (OutputPath, Context.Prelinked, Context.PrelinkedSize);
+  }
+
+  if (!EFI_ERROR (Status) && Kernel->SymbolCache == NULL
+    && !EFI_ERROR (PrelinkedExportSymbolCache (&Context, &SymbolCache, &SymbolCacheSize))) {
+    Kernel->SymbolCache = SymbolCache;
+    Kernel->ExtraSize   = SymbolCacheSize;
+  }
+
+  printf (
+    "%s - %zx, symbol table builds %u, saved %u\n",
+    OutputPath,
+    Status,
+    Context.LinkedSymbolTableBuilds,
+    Context.LinkedSymbolTableReuses
+    );
+
+  PrelinkedContextFree (&Context);
+  FreePool (Context.Prelinked);
+
+  return Status;
+}
+
+int main(int argc, char** argv) {
+  FILE        *Jobs;
+  CHAR8       Line[BUILDER_MAX_LINE];
+  CHAR8       KernelPath[BUILDER_MAX_LINE];
+  CHAR8       KextsPath[BUILDER_MAX_LINE];
+  CHAR8       PatchesPath[BUILDER_MAX_LINE];
+  CHAR8       OutputPath[BUILDER_MAX_LINE];
+  UINT32      NumJobs;
+  UINT32      NumFailed;
+
+  if (argc != 2) {
+    printf ("Usage: %s jobs.txt\n", argv[0]);
+    return -1;
+  }
+
+  Jobs = fopen (argv[1], "r");
+  if (Jobs == NULL) {
+    printf ("Failed to open %s\n", argv[1]);
+    return -1;
+  }
+
+  NumJobs   = 0;
+  NumFailed = 0;
+
+  while (fgets (Line, sizeof (Line), Jobs) != NULL) {
+    if (Line[0] == '#') {
+      continue;
+    }
+
+    if (sscanf (Line, "%4095s %4095s %4095s %4095s", KernelPath, KextsPath, PatchesPath, OutputPath) != 4) {
+      continue;
+    }
+
+    ++NumJobs;
+    if (EFI_ERROR (BuilderRunJob (KernelPath, KextsPath, PatchesPath, OutputPath))) {
+      ++NumFailed;
+    }
+  }
+
+  fclose (Jobs);
+
+  printf ("Built %u of %u jobs\n", NumJobs - NumFailed, NumJobs);
+
+  KernelTimingPrintReport ();
+
+  return NumFailed == 0 ? 0 : 1;
+}
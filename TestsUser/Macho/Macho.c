@@ -290,6 +290,8 @@ static int FeedMacho(void *file, uint32_t size) {
     }
   }
 
+  MachoFreeContext (&Context);
+
   return code != 963;
 }
 
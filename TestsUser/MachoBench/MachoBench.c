@@ -0,0 +1,379 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcMachoLib.h>
+#include <Library/OcMiscLib.h>
+
+#include <Bench.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h -I../../../EfiPkg/Include/ MachoBench.c ../../Library/OcMachoLib/CxxSymbols.c ../../Library/OcMachoLib/Header.c ../../Library/OcMachoLib/Relocations.c ../../Library/OcMachoLib/Symbols.c ../../Library/OcStringLib/OcAsciiLib.c -o MachoBench
+
+ ./MachoBench [-n lookups] [-f filter] [-i kernel] > results.json
+
+ Every benchmark case is a kernel-like Mach-O generated in memory with the
+ given number of segments and sections per segment, -i adds an extra case for
+ an uncompressed Mach-O image (e.g. a kernel).  Reported timings:
+   - sort_us   - first MachoGetSectionByAddress64 call building the table,
+   - sorted_ns - average MachoGetSectionByAddress64 lookup,
+   - linear_ns - average lookup with the section table disabled.
+ Lookup addresses are pseudo-random and cover section gaps as well.
+
+ rm -rf MachoBench.dSYM MachoBench
+*/
+
+#define BENCH_BASE_ADDRESS   0xFFFFFF8000200000ULL
+#define BENCH_SEGMENT_SIZE   BASE_4KB
+#define BENCH_COMMANDS_SIZE  BASE_64KB
+
+typedef struct {
+  CONST CHAR8  *Name;
+  UINT32       NumSegments;
+  UINT32       NumSections;
+} BENCH_CASE;
+
+typedef struct {
+  UINT32  Status;
+  UINT32  NumSections;
+  BOOLEAN Sorted;
+  UINT64  SortUs;
+  UINT64  SortedNs;
+  UINT64  LinearNs;
+  UINT32  Hits;
+} BENCH_RESULT;
+
+STATIC
+BENCH_CASE
+mBenchCases[] = {
+  { "kext-3x4",      3,  4 },
+  { "kernel-12x8",  12,  8 },
+  { "kernel-24x10", 24, 10 },
+  { "kernel-32x8",  32,  8 },
+  { "kernel-32x16", 32, 16 }
+};
+
+STATIC
+UINT8 *
+BenchGenerate (
+  BENCH_CASE  *Case,
+  UINT32      *Size
+  )
+{
+  UINT8                    *Buffer;
+  MACH_HEADER_64           *Header;
+  MACH_SEGMENT_COMMAND_64  *Segment;
+  MACH_SECTION_64          *Section;
+  UINT32                   SegmentIndex;
+  UINT32                   SectionIndex;
+  UINT32                   SectionSize;
+  UINT64                   Address;
+
+  *Size  = BENCH_COMMANDS_SIZE + Case->NumSegments * BENCH_SEGMENT_SIZE;
+  Buffer = aligned_alloc (BASE_4KB, *Size);
+  if (Buffer == NULL) {
+    return NULL;
+  }
+
+  ZeroMem (Buffer, *Size);
+
+  Header = (MACH_HEADER_64 *) Buffer;
+  Header->Signature = MACH_HEADER_64_SIGNATURE;
+  Header->CpuType   = MachCpuTypeX8664;
+  Header->FileType  = MachHeaderFileTypeExecute;
+
+  //
+  // Leave a gap after every section, so that lookups may miss.
+  //
+  SectionSize = BENCH_SEGMENT_SIZE / Case->NumSections / 2;
+  Segment     = (MACH_SEGMENT_COMMAND_64 *) &Header->Commands[0];
+
+  for (SegmentIndex = 0; SegmentIndex < Case->NumSegments; SegmentIndex++) {
+    Segment->CommandType    = MACH_LOAD_COMMAND_SEGMENT_64;
+    Segment->CommandSize    = sizeof (*Segment) + Case->NumSections * sizeof (*Section);
+    Segment->VirtualAddress = BENCH_BASE_ADDRESS + SegmentIndex * BENCH_SEGMENT_SIZE;
+    Segment->Size           = BENCH_SEGMENT_SIZE;
+    Segment->FileOffset     = BENCH_COMMANDS_SIZE + SegmentIndex * BENCH_SEGMENT_SIZE;
+    Segment->FileSize       = BENCH_SEGMENT_SIZE;
+    Segment->NumSections    = Case->NumSections;
+    AsciiSPrint (Segment->SegmentName, sizeof (Segment->SegmentName), "__SEG%u", SegmentIndex);
+
+    Address = Segment->VirtualAddress;
+    for (SectionIndex = 0; SectionIndex < Case->NumSections; SectionIndex++) {
+      Section          = &Segment->Sections[SectionIndex];
+      Section->Address = Address;
+      Section->Size    = SectionSize;
+      Section->Offset  = (UINT32) (Segment->FileOffset + (Address - Segment->VirtualAddress));
+      CopyMem (Section->SegmentName, Segment->SegmentName, sizeof (Section->SegmentName));
+      AsciiSPrint (Section->SectionName, sizeof (Section->SectionName), "__sect%u", SectionIndex);
+      Address += 2 * SectionSize;
+    }
+
+    Header->NumCommands++;
+    Header->CommandsSize += Segment->CommandSize;
+    Segment = (MACH_SEGMENT_COMMAND_64 *) NEXT_MACH_LOAD_COMMAND (Segment);
+  }
+
+  return Buffer;
+}
+
+STATIC
+UINT8 *
+BenchReadFile (
+  CONST CHAR8  *Path,
+  UINT32       *Size
+  )
+{
+  FILE   *File;
+  long   FileSize;
+  UINT8  *Buffer;
+
+  File = fopen (Path, "rb");
+  if (File == NULL) {
+    return NULL;
+  }
+
+  fseek (File, 0, SEEK_END);
+  FileSize = ftell (File);
+  fseek (File, 0, SEEK_SET);
+
+  Buffer = NULL;
+  if (FileSize > 0 && FileSize <= MAX_UINT32) {
+    Buffer = aligned_alloc (BASE_4KB, ALIGN_VALUE (FileSize, BASE_4KB));
+  }
+
+  if (Buffer != NULL && fread (Buffer, FileSize, 1, File) != 1) {
+    free (Buffer);
+    Buffer = NULL;
+  }
+
+  fclose (File);
+  *Size = (UINT32) FileSize;
+  return Buffer;
+}
+
+STATIC
+VOID
+BenchRun (
+  UINT8         *Buffer,
+  UINT32        Size,
+  UINT32        Lookups,
+  BENCH_RESULT  *Result
+  )
+{
+  OC_MACHO_CONTEXT  Sorted;
+  OC_MACHO_CONTEXT  Linear;
+  UINT64            First;
+  UINT64            Last;
+  UINT64            Seed;
+  UINT64            Address;
+  UINT64            Start;
+  UINT64            Span;
+  UINT32            Index;
+  UINT32            LinearHits;
+  MACH_SECTION_64   *Section;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  if (!MachoInitializeContext (&Sorted, Buffer, Size)) {
+    Result->Status = 1;
+    return;
+  }
+
+  CopyMem (&Linear, &Sorted, sizeof (Linear));
+  Linear.SectionsSorted = TRUE;
+
+  Start = BenchTimestamp ();
+  MachoGetSectionByAddress64 (&Sorted, 0);
+  Result->SortUs      = (BenchTimestamp () - Start) / 1000ULL;
+  Result->Sorted      = Sorted.SortedSections != NULL;
+  Result->NumSections = Sorted.NumSortedSections;
+
+  First = MAX_UINT64;
+  Last  = 0;
+  for (Index = 0; (Section = MachoGetSectionByIndex64 (&Sorted, Index)) != NULL; Index++) {
+    First = MIN (First, Section->Address);
+    Last  = MAX (Last, Section->Address + Section->Size);
+  }
+
+  if (First >= Last) {
+    MachoFreeContext (&Sorted);
+    Result->Status = 2;
+    return;
+  }
+
+  Span       = Last - First;
+  LinearHits = 0;
+
+  Seed  = 1;
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Lookups; Index++) {
+    Seed    = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    Address = First + (Seed >> 16) % Span;
+    if (MachoGetSectionByAddress64 (&Sorted, Address) != NULL) {
+      Result->Hits++;
+    }
+  }
+  Result->SortedNs = (BenchTimestamp () - Start) / Lookups;
+
+  Seed  = 1;
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Lookups; Index++) {
+    Seed    = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    Address = First + (Seed >> 16) % Span;
+    if (MachoGetSectionByAddress64 (&Linear, Address) != NULL) {
+      LinearHits++;
+    }
+  }
+  Result->LinearNs = (BenchTimestamp () - Start) / Lookups;
+
+  if (LinearHits != Result->Hits) {
+    Result->Status = 3;
+  }
+
+  //
+  // Both lookups must also agree around every section boundary.
+  //
+  for (Index = 0; (Section = MachoGetSectionByIndex64 (&Sorted, Index)) != NULL; Index++) {
+    for (Address = Section->Address - 1; Address <= Section->Address + 1; Address++) {
+      if (MachoGetSectionByAddress64 (&Linear, Address) != MachoGetSectionByAddress64 (&Sorted, Address)) {
+        Result->Status = 3;
+      }
+    }
+
+    for (Address = Section->Address + Section->Size - 1; Address <= Section->Address + Section->Size + 1; Address++) {
+      if (MachoGetSectionByAddress64 (&Linear, Address) != MachoGetSectionByAddress64 (&Sorted, Address)) {
+        Result->Status = 3;
+      }
+    }
+  }
+
+  MachoFreeContext (&Sorted);
+}
+
+STATIC
+VOID
+BenchPrint (
+  FILE          *Output,
+  CONST CHAR8   *Name,
+  BENCH_RESULT  *Result,
+  BOOLEAN       First
+  )
+{
+  BenchBeginResult (Output, First);
+  fprintf (
+    Output,
+    "{\"name\": \"%s\", \"status\": %u, \"sorted\": %s, \"sections\": %u, "
+    "\"hits\": %u, \"sort_us\": %llu, \"sorted_ns\": %llu, \"linear_ns\": %llu}",
+    Name,
+    Result->Status,
+    Result->Sorted ? "true" : "false",
+    Result->NumSections,
+    Result->Hits,
+    (unsigned long long) Result->SortUs,
+    (unsigned long long) Result->SortedNs,
+    (unsigned long long) Result->LinearNs
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32        Lookups;
+  CONST CHAR8   *Filter;
+  CONST CHAR8   *Image;
+  INT32         Opt;
+  UINT32        Index;
+  UINT8         *Buffer;
+  UINT32        Size;
+  BENCH_RESULT  Result;
+  BOOLEAN       First;
+  INT32         ExitCode;
+  FILE          *Output;
+
+  Lookups = 1000000;
+  Filter  = NULL;
+  Image   = NULL;
+
+  while ((Opt = getopt (argc, argv, "n:f:i:")) != -1) {
+    switch (Opt) {
+      case 'n':
+        Lookups = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'f':
+        Filter = optarg;
+        break;
+      case 'i':
+        Image = optarg;
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-n lookups] [-f filter] [-i kernel]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Lookups == 0) {
+    fprintf (stderr, "Invalid lookup count\n");
+    return -1;
+  }
+
+  Output = BenchOpenOutput ();
+  if (Output == NULL) {
+    return -1;
+  }
+
+  ExitCode = 0;
+  First    = TRUE;
+  BenchBeginResults (Output, "  \"lookups\": %u,\n", Lookups);
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchCases); Index++) {
+    if (!BenchIsSelected (mBenchCases[Index].Name, Filter)) {
+      continue;
+    }
+
+    ZeroMem (&Result, sizeof (Result));
+    Buffer = BenchGenerate (&mBenchCases[Index], &Size);
+    if (Buffer != NULL) {
+      BenchRun (Buffer, Size, Lookups, &Result);
+      free (Buffer);
+    } else {
+      Result.Status = 4;
+    }
+
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+
+    BenchPrint (Output, mBenchCases[Index].Name, &Result, First);
+    First = FALSE;
+  }
+
+  if (Image != NULL) {
+    ZeroMem (&Result, sizeof (Result));
+    Buffer = BenchReadFile (Image, &Size);
+    if (Buffer != NULL) {
+      BenchRun (Buffer, Size, Lookups, &Result);
+      free (Buffer);
+    } else {
+      Result.Status = 4;
+    }
+
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+
+    BenchPrint (Output, Image, &Result, First);
+  }
+
+  BenchEndResults (Output);
+
+  return ExitCode;
+}
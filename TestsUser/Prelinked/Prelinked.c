@@ -18,17 +18,34 @@
 #include <Library/OcAppleKernelLib.h>
 
 #include <sys/time.h>
+#include <pthread.h>
 
 /*
- clang -g -fsanitize=undefined,address -Wno-incompatible-pointer-types-discards-qualifiers -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Prelinked.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcTemplateLib/OcTemplateLib.c ../../Library/OcSerializeLib/OcSerializeLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMachoLib/CxxSymbols.c ../../Library/OcMachoLib/Header.c ../../Library/OcMachoLib/Relocations.c ../../Library/OcMachoLib/Symbols.c ../../Library/OcAppleKernelLib/PrelinkedContext.c ../../Library/OcAppleKernelLib/PrelinkedKext.c ../../Library/OcAppleKernelLib/KextPatcher.c ../../Library/OcMiscLib/DataPatcher.c ../../Library/OcAppleKernelLib/Prelinker.c ../../Library/OcAppleKernelLib/Link.c ../../Library/OcAppleKernelLib/Dependencies.c ../../Library/OcAppleKernelLib/Vtables.c -o Prelinked
+ clang -g -fsanitize=undefined,address -Wno-incompatible-pointer-types-discards-qualifiers -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h -pthread Prelinked.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcTemplateLib/OcTemplateLib.c ../../Library/OcSerializeLib/OcSerializeLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMachoLib/CxxSymbols.c ../../Library/OcMachoLib/Header.c ../../Library/OcMachoLib/Relocations.c ../../Library/OcMachoLib/Symbols.c ../../Library/OcAppleKernelLib/PrelinkedContext.c ../../Library/OcAppleKernelLib/PrelinkedKext.c ../../Library/OcAppleKernelLib/KernelTiming.c ../../Library/OcAppleKernelLib/PrelinkedSymbolCache.c ../../Library/OcAppleKernelLib/KextPatcher.c ../../Library/OcMiscLib/DataPatcher.c ../../Library/OcAppleKernelLib/Prelinker.c ../../Library/OcAppleKernelLib/Link.c ../../Library/OcAppleKernelLib/Dependencies.c ../../Library/OcAppleKernelLib/Vtables.c -o Prelinked
 
  for fuzzing:
- clang-mp-7.0 -Dmain=__main -g -fsanitize=undefined,address,fuzzer -Wno-incompatible-pointer-types-discards-qualifiers -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Prelinked.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcTemplateLib/OcTemplateLib.c ../../Library/OcSerializeLib/OcSerializeLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMachoLib/CxxSymbols.c ../../Library/OcMachoLib/Header.c ../../Library/OcMachoLib/Relocations.c ../../Library/OcMachoLib/Symbols.c ../../Library/OcAppleKernelLib/PrelinkedContext.c ../../Library/OcAppleKernelLib/PrelinkedKext.c ../../Library/OcAppleKernelLib/KextPatcher.c ../../Library/OcMiscLib/DataPatcher.c ../../Library/OcAppleKernelLib/Prelinker.c ../../Library/OcAppleKernelLib/Link.c ../../Library/OcAppleKernelLib/Dependencies.c ../../Library/OcAppleKernelLib/Vtables.c -o Prelinked
+ clang-mp-7.0 -Dmain=__main -g -fsanitize=undefined,address,fuzzer -Wno-incompatible-pointer-types-discards-qualifiers -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h -pthread Prelinked.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcTemplateLib/OcTemplateLib.c ../../Library/OcSerializeLib/OcSerializeLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMachoLib/CxxSymbols.c ../../Library/OcMachoLib/Header.c ../../Library/OcMachoLib/Relocations.c ../../Library/OcMachoLib/Symbols.c ../../Library/OcAppleKernelLib/PrelinkedContext.c ../../Library/OcAppleKernelLib/PrelinkedKext.c ../../Library/OcAppleKernelLib/KernelTiming.c ../../Library/OcAppleKernelLib/PrelinkedSymbolCache.c ../../Library/OcAppleKernelLib/KextPatcher.c ../../Library/OcMiscLib/DataPatcher.c ../../Library/OcAppleKernelLib/Prelinker.c ../../Library/OcAppleKernelLib/Link.c ../../Library/OcAppleKernelLib/Dependencies.c ../../Library/OcAppleKernelLib/Vtables.c -o Prelinked
  rm -rf DICT fuzz*.log ; mkdir DICT ; cp Prelinked.plist DICT ; ./Prelinked -jobs=4 DICT
 
+ ./Prelinked [prelinkedkernel.unpack [threads]] uses the given number of threads
+ for independent work during batch kext injection.
+
  rm -rf Prelinked.dSYM DICT fuzz*.log Prelinked
 */
 
+//
+// Symbol cache files are not loaded from UEFI file systems here.
+//
+VOID *
+ReadFile (
+  IN  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem,
+  IN  CONST CHAR16                     *FilePath,
+  OUT UINTN                            *FileSize OPTIONAL
+  )
+{
+  return NULL;
+}
+
 STATIC CHAR8 KextInfoPlistData[] = {
   0x3C, 0x3F, 0x78, 0x6D, 0x6C, 0x20, 0x76, 0x65,
   0x72, 0x73, 0x69, 0x6F, 0x6E, 0x3D, 0x22, 0x31,
@@ -13033,6 +13050,35 @@ KernelPatch = {
   .Skip    = 0
 };
 
+//
+// Bounded searches for the return written by KernelPatch.
+//
+STATIC
+PATCHER_GENERIC_PATCH
+KernelSymbolLimitPatch = {
+  .Base    = "_IOLog",
+  .Find    = DisableKernelLog,
+  .Mask    = NULL,
+  .Replace = DisableKernelLog,
+  .Size    = sizeof (DisableKernelLog),
+  .Count   = 1,
+  .Skip    = 0,
+  .Limit   = PATCHER_LIMIT_SYMBOL
+};
+
+STATIC
+PATCHER_GENERIC_PATCH
+KernelByteLimitPatch = {
+  .Base    = "_IOLog",
+  .Find    = DisableKernelLog,
+  .Mask    = NULL,
+  .Replace = DisableKernelLog,
+  .Size    = sizeof (DisableKernelLog),
+  .Count   = 1,
+  .Skip    = 0,
+  .Limit   = sizeof (DisableKernelLog)
+};
+
 STATIC
 VOID
 ApplyKextPatches (
@@ -13134,16 +13180,104 @@ ApplyKernelPatches (
     } else {
       DEBUG ((DEBUG_WARN, "Patch success kernel\n"));
     }
+
+    Status = PatcherApplyGenericPatch (&Patcher, &KernelSymbolLimitPatch);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Failed to apply symbol limited patch kernel - %r\n", Status));
+    } else {
+      DEBUG ((DEBUG_WARN, "Symbol limited patch success kernel\n"));
+    }
+
+    Status = PatcherApplyGenericPatch (&Patcher, &KernelByteLimitPatch);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Failed to apply byte limited patch kernel - %r\n", Status));
+    } else {
+      DEBUG ((DEBUG_WARN, "Byte limited patch success kernel\n"));
+    }
+
+    MachoFreeContext (&Patcher.MachContext);
   } else {
     DEBUG ((DEBUG_WARN, "Failed to find kernel - %r\n", Status));
   }
 }
 
+#define MAX_PARALLEL_THREADS 64
+
+typedef struct {
+  UINT32                     NumThreads;
+  UINT32                     NumItems;
+  UINT32                     NextItem;
+  PRELINKED_PARALLEL_WORKER  Worker;
+  VOID                       *WorkerContext;
+} PARALLEL_FOR_CONTEXT;
+
+STATIC
+VOID *
+ParallelForThread (
+  IN VOID  *Arg
+  )
+{
+  PARALLEL_FOR_CONTEXT  *Context;
+  UINT32                Index;
+
+  Context = (PARALLEL_FOR_CONTEXT *) Arg;
+
+  //
+  // Every item touches its own memory, so the order does not matter.
+  //
+  while ((Index = __atomic_fetch_add (&Context->NextItem, 1, __ATOMIC_RELAXED)) < Context->NumItems) {
+    Context->Worker (Context->WorkerContext, Index);
+  }
+
+  return NULL;
+}
+
+STATIC
+VOID
+ParallelFor (
+  IN VOID                       *ParallelContext,
+  IN UINT32                     NumItems,
+  IN PRELINKED_PARALLEL_WORKER  Worker,
+  IN VOID                       *WorkerContext
+  )
+{
+  PARALLEL_FOR_CONTEXT  *Context;
+  pthread_t             Threads[MAX_PARALLEL_THREADS];
+  UINT32                NumThreads;
+  UINT32                Index;
+
+  Context                = (PARALLEL_FOR_CONTEXT *) ParallelContext;
+  Context->NumItems      = NumItems;
+  Context->NextItem      = 0;
+  Context->Worker        = Worker;
+  Context->WorkerContext = WorkerContext;
+
+  NumThreads = MIN (Context->NumThreads, NumItems);
+  for (Index = 0; Index < NumThreads; ++Index) {
+    if (pthread_create (&Threads[Index], NULL, ParallelForThread, Context) != 0) {
+      break;
+    }
+  }
+
+  NumThreads = Index;
+
+  //
+  // Process the rest on the calling thread, this also covers thread creation failures.
+  //
+  ParallelForThread (Context);
+
+  for (Index = 0; Index < NumThreads; ++Index) {
+    pthread_join (Threads[Index], NULL);
+  }
+}
+
 int main(int argc, char** argv) {
   UINT32 Size;
   UINT32 AllocSize;
   UINT8  *Prelinked;
   PRELINKED_CONTEXT Context;
+  PRELINKED_KEXT_REQUEST Requests[2];
+  PARALLEL_FOR_CONTEXT ParallelContext;
   if ((Prelinked = readFile(argc > 1 ? argv[1] : "prelinkedkernel.unpack", &Size)) == NULL) {
     printf("Read fail\n");
     return -1;
@@ -13163,6 +13297,13 @@ int main(int argc, char** argv) {
   EFI_STATUS Status = PrelinkedContextInit (&Context, Prelinked, Size, AllocSize);
 
   if (!EFI_ERROR (Status)) {
+    ParallelContext.NumThreads = argc > 2 ? (UINT32) atoi (argv[2]) : 1;
+    if (ParallelContext.NumThreads > 1) {
+      ParallelContext.NumThreads = MIN (ParallelContext.NumThreads, MAX_PARALLEL_THREADS);
+      Context.ParallelFor        = ParallelFor;
+      Context.ParallelForContext = &ParallelContext;
+    }
+
     ApplyKextPatches (&Context);
 
     Status = PrelinkedInjectPrepare (&Context);
@@ -13170,29 +13311,30 @@ int main(int argc, char** argv) {
       printf("Prelink inject prepare error %zx\n", Status);
     }
 
-    Status = PrelinkedInjectKext (
-      &Context,
-      "/Library/Extensions/TestDriver.kext",
-      KextInfoPlistData,
-      sizeof (KextInfoPlistData),
-      NULL,
-      NULL,
-      0
-      );
+    Requests[0].BundlePath     = "/Library/Extensions/TestDriver.kext";
+    Requests[0].InfoPlist      = KextInfoPlistData;
+    Requests[0].InfoPlistSize  = sizeof (KextInfoPlistData);
+    Requests[0].ExecutablePath = NULL;
+    Requests[0].Executable     = NULL;
+    Requests[0].ExecutableSize = 0;
 
-    DEBUG ((DEBUG_WARN, "TestDriver.kext injected - %zx\n", Status));
+    Requests[1].BundlePath     = "/Library/Extensions/Lilu.kext";
+    Requests[1].InfoPlist      = LiluKextInfoPlistData;
+    Requests[1].InfoPlistSize  = sizeof (LiluKextInfoPlistData);
+    Requests[1].ExecutablePath = "Contents/MacOS/Lilu";
+    Requests[1].Executable     = LiluKextData;
+    Requests[1].ExecutableSize = sizeof (LiluKextData);
 
-    Status = PrelinkedInjectKext (
-        &Context,
-        "/Library/Extensions/Lilu.kext",
-        LiluKextInfoPlistData,
-        sizeof (LiluKextInfoPlistData),
-        "Contents/MacOS/Lilu",
-        LiluKextData,
-        sizeof (LiluKextData)
-        );
+    PrelinkedInjectKexts (&Context, Requests, ARRAY_SIZE (Requests));
 
-    DEBUG ((DEBUG_WARN, "Lilu.kext injected - %zx\n", Status));
+    DEBUG ((DEBUG_WARN, "TestDriver.kext injected - %zx\n", Requests[0].Status));
+    DEBUG ((DEBUG_WARN, "Lilu.kext injected - %zx\n", Requests[1].Status));
+    DEBUG ((
+      DEBUG_WARN,
+      "Symbol table builds %u, saved %u\n",
+      Context.LinkedSymbolTableBuilds,
+      Context.LinkedSymbolTableReuses
+      ));
 
     Status = PrelinkedInjectComplete (&Context);
 
@@ -13218,6 +13360,8 @@ int main(int argc, char** argv) {
     printf("Context creation error %zx\n", Status);
   }
 
+  KernelTimingPrintReport ();
+
   free(Prelinked);
 
   return 0;
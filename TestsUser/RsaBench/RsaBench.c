@@ -0,0 +1,571 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcAppleKeysLib.h>
+#include <Library/OcCryptoLib.h>
+
+#include <Bench.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h RsaBench.c ../../Library/OcAppleKeysLib/OcAppleKeysLib.c ../../Library/OcCryptoLib/Rsa2048Sha256.c ../../Library/OcCryptoLib/Sha256.c ../../Library/OcCryptoLib/X64/Sha256Simd.c ../../Library/OcCryptoLib/X64/Sha256MultiBuffer.c -o RsaBench
+
+ ./RsaBench [-n verifications] > results.json
+
+ RsaVerify is first checked against signatures made with 2048, 3072 and
+ 4096-bit test keys, then every Apple key and test key verify a
+ pseudo-random signature the given number of times (1000 by default).  Verification time does not
+ depend on the signature being valid.  Reported per key:
+   - key_bits          - key size in bits,
+   - status            - 0 on success, 1 for a valid signature failing
+                         verification, 2 for an invalid one passing it,
+   - verifies_per_sec  - RsaVerify calls per second.
+
+ rm -rf RsaBench.dSYM RsaBench
+*/
+
+typedef struct {
+  UINT32  Status;
+  UINT64  VerifiesPerSec;
+} BENCH_RESULT;
+
+//
+// Test RSA-2048 key with exponent 65537 in pre-processed form.
+//
+STATIC
+UINT8
+mBenchTestKey2048[RSA_PUBLIC_KEY_SIZE (2048)] = {
+    0x40, 0x00, 0x00, 0x00, 0xA5, 0x34, 0x3F, 0x05, 0xD3, 0x6C, 0x4A, 0xAF,
+    0x43, 0x89, 0x4A, 0x0F, 0xC5, 0xA0, 0xF6, 0x24, 0x6D, 0x37, 0x61, 0x7B,
+    0x38, 0x9F, 0xAD, 0x0D, 0xA4, 0x20, 0xB4, 0xC4, 0x33, 0x17, 0x59, 0xB9,
+    0x71, 0x0D, 0xF6, 0xA9, 0x76, 0x8B, 0xFD, 0x7C, 0xC9, 0x65, 0x7D, 0xF4,
+    0xDE, 0x17, 0xC3, 0x33, 0xB3, 0x6E, 0x54, 0xDB, 0xF6, 0xBE, 0xA1, 0x42,
+    0x09, 0x26, 0xDF, 0x76, 0xE3, 0x03, 0x17, 0x46, 0x56, 0x72, 0x80, 0xBC,
+    0x48, 0x60, 0xB9, 0x22, 0x90, 0x05, 0xC3, 0x57, 0xA9, 0x8C, 0xEA, 0xDB,
+    0x21, 0x3F, 0x89, 0x67, 0x08, 0xD0, 0xE6, 0x24, 0x2C, 0x38, 0xDB, 0x19,
+    0x9D, 0x9A, 0xCF, 0x5A, 0x9E, 0xD8, 0x58, 0xA2, 0x04, 0x9A, 0xCE, 0x73,
+    0x0A, 0xAD, 0x00, 0x78, 0x95, 0xEE, 0xA6, 0x1B, 0x00, 0xD8, 0xD9, 0xE1,
+    0x61, 0x98, 0xF7, 0x30, 0x2E, 0x17, 0xB2, 0x6A, 0xFE, 0x06, 0x75, 0xA9,
+    0xC6, 0xF8, 0x47, 0xE4, 0xBA, 0xDA, 0x08, 0x6C, 0x35, 0x04, 0xA6, 0x8F,
+    0x2C, 0x19, 0xCA, 0x2D, 0x74, 0x03, 0x62, 0x6F, 0xDA, 0x4E, 0xE5, 0xF6,
+    0xF5, 0x98, 0x2A, 0x12, 0x18, 0x4A, 0x20, 0xA4, 0xB0, 0x01, 0x2D, 0x1C,
+    0x2B, 0x03, 0xDA, 0x97, 0x45, 0x5A, 0x6E, 0xE3, 0x3A, 0x38, 0xFC, 0x46,
+    0x08, 0x3A, 0x68, 0x48, 0xAC, 0x6E, 0xE8, 0xAE, 0xF1, 0xBB, 0xF4, 0x65,
+    0x01, 0xBD, 0x1F, 0x0F, 0xE7, 0x5F, 0x13, 0x16, 0xA1, 0xA9, 0xBE, 0x2D,
+    0x0C, 0x6D, 0xE2, 0x2B, 0x54, 0xDA, 0x21, 0x9D, 0x5F, 0x33, 0x44, 0x9C,
+    0x85, 0x44, 0x35, 0xDF, 0xBD, 0x9F, 0x53, 0x53, 0xCA, 0xE7, 0x45, 0xC2,
+    0xC7, 0xBF, 0x9C, 0xFA, 0xDC, 0x4C, 0x58, 0x93, 0xD2, 0xCE, 0x4B, 0x96,
+    0xD8, 0x36, 0x7D, 0x4D, 0x3F, 0xA4, 0xDD, 0xF9, 0x36, 0xC3, 0x39, 0x09,
+    0x60, 0x6C, 0xD7, 0xED, 0x31, 0x57, 0xE9, 0x46, 0x4A, 0xA1, 0xED, 0xC6,
+    0x94, 0x86, 0xEE, 0xDE, 0xB7, 0x0F, 0xD6, 0x3D, 0x7E, 0x83, 0x38, 0xD7,
+    0xC8, 0xD0, 0x8A, 0xEA, 0x3A, 0x42, 0xFE, 0x7F, 0x6F, 0xFD, 0x5A, 0x31,
+    0xF5, 0x76, 0x56, 0x65, 0xB5, 0xE1, 0x43, 0x61, 0x71, 0x2A, 0xAB, 0x17,
+    0xA3, 0x0A, 0x33, 0xE7, 0xF7, 0x2D, 0x4C, 0x57, 0x7B, 0xD8, 0x5D, 0xDB,
+    0xD9, 0x78, 0x75, 0x74, 0xB9, 0x6F, 0x09, 0xA8, 0xBD, 0xA2, 0xA7, 0xDF,
+    0xCE, 0x49, 0xCF, 0xEB, 0xE4, 0xE3, 0x6F, 0xAA, 0x77, 0x7E, 0xF4, 0xF2,
+    0x63, 0xDF, 0x09, 0x3C, 0xF0, 0x41, 0x81, 0xAF, 0x82, 0x86, 0x0A, 0x03,
+    0xD7, 0x51, 0x14, 0x25, 0x1E, 0xF9, 0x96, 0xC5, 0x38, 0x3A, 0x90, 0x08,
+    0x43, 0xF5, 0xDD, 0x65, 0x1C, 0x9D, 0x5B, 0xC3, 0x7A, 0xDD, 0xB5, 0x1F,
+    0x72, 0x76, 0xA7, 0x46, 0xA8, 0xEB, 0x52, 0x03, 0x06, 0xE9, 0x10, 0xE4,
+    0x9E, 0x75, 0xE3, 0xBD, 0x40, 0xCF, 0x27, 0xA2, 0xBC, 0x54, 0xF0, 0xBA,
+    0x11, 0x7A, 0x9A, 0xCA, 0xE3, 0x50, 0xF3, 0x14, 0x80, 0x96, 0x7D, 0x9C,
+    0xE7, 0x03, 0x54, 0x4E, 0xB2, 0xF8, 0xDC, 0xC3, 0x26, 0x45, 0xFA, 0x9B,
+    0xDB, 0x23, 0xA8, 0x49, 0x0F, 0x93, 0xB9, 0xAD, 0x62, 0x77, 0x82, 0xEA,
+    0xF6, 0x71, 0x4E, 0x37, 0xB9, 0xEC, 0xD6, 0x7F, 0x77, 0x8B, 0x06, 0x20,
+    0x6B, 0x25, 0xDE, 0xA9, 0x7C, 0x1A, 0xB6, 0x35, 0x43, 0x94, 0x8E, 0x22,
+    0x90, 0x7C, 0xBD, 0xC2, 0x57, 0x15, 0xB6, 0x23, 0x4A, 0x69, 0x68, 0x59,
+    0xE5, 0x00, 0x6A, 0xF3, 0xEA, 0x3F, 0x93, 0x29, 0x0C, 0x75, 0x58, 0xFC,
+    0x57, 0xF0, 0x30, 0xC0, 0x5E, 0xC4, 0x5D, 0xBE, 0xEB, 0x0A, 0x8A, 0xCB,
+    0x61, 0x93, 0x49, 0x26, 0x40, 0x99, 0x0E, 0x2E, 0x3E, 0x3A, 0x4C, 0x53,
+    0xA8, 0x8D, 0x7C, 0xAF, 0xA0, 0x6A, 0x4C, 0x0B, 0xBD, 0xC8, 0x5F, 0xFA,
+    0x3A, 0xEA, 0x9F, 0xA3
+};
+
+//
+// Test RSA-2048 key signature of SHA-256 of "abc".
+//
+STATIC
+UINT8
+mBenchTestSignature2048[2048 / 8] = {
+    0x61, 0x7C, 0xCA, 0xA2, 0x9B, 0xA7, 0x42, 0x19, 0x39, 0x90, 0xBD, 0xDC,
+    0x84, 0x5F, 0x7C, 0x07, 0xBA, 0x36, 0xC0, 0xDA, 0x81, 0xFB, 0x24, 0x78,
+    0x99, 0xE3, 0x9A, 0x8E, 0x31, 0x1D, 0x54, 0xF0, 0xF7, 0x7A, 0xA8, 0x28,
+    0xD6, 0x22, 0xB5, 0xDA, 0x5F, 0x55, 0x20, 0x68, 0x0C, 0x1C, 0x6F, 0xFF,
+    0x57, 0x43, 0xD6, 0x85, 0xBA, 0x34, 0x94, 0x87, 0xAA, 0xB5, 0x72, 0x84,
+    0xFC, 0x4A, 0xBC, 0xCE, 0xAD, 0x89, 0xCD, 0x22, 0xA5, 0xA7, 0xB9, 0xBA,
+    0x75, 0xBC, 0x0D, 0x88, 0x63, 0x46, 0x3F, 0x79, 0xE2, 0x05, 0xC4, 0x19,
+    0xE5, 0xA4, 0xF4, 0x20, 0x45, 0xA7, 0xD2, 0x93, 0x87, 0x19, 0x57, 0xC8,
+    0x08, 0xF6, 0x27, 0xA8, 0xAE, 0xE5, 0x79, 0x9E, 0xA1, 0xA1, 0x72, 0x01,
+    0x4B, 0x94, 0xD3, 0x29, 0x31, 0x6F, 0xCC, 0x65, 0x9E, 0x87, 0x06, 0x78,
+    0x4A, 0x9E, 0xED, 0xB9, 0x82, 0x8A, 0xC2, 0xFE, 0x2B, 0x25, 0x71, 0x6A,
+    0x21, 0xAD, 0x9F, 0x9D, 0x37, 0x3D, 0xEE, 0x47, 0xB8, 0xF9, 0x3C, 0x7D,
+    0xC9, 0xBC, 0x5D, 0xB8, 0x94, 0x9C, 0xFA, 0xE5, 0xAF, 0xAC, 0x16, 0x09,
+    0xF7, 0xE3, 0x57, 0x96, 0x5D, 0x37, 0xDE, 0xD5, 0xA8, 0xB9, 0x08, 0x8F,
+    0xD6, 0xC0, 0xF7, 0x79, 0x51, 0x56, 0x76, 0xE6, 0x9A, 0xB3, 0x2E, 0x93,
+    0x14, 0x53, 0x8C, 0x7F, 0x59, 0xB1, 0x82, 0xD3, 0xD3, 0x00, 0x7C, 0x63,
+    0x94, 0x12, 0xE9, 0x37, 0x01, 0x33, 0x93, 0xD8, 0x37, 0x9A, 0xE5, 0x3B,
+    0x1E, 0x46, 0x63, 0x37, 0x6A, 0x07, 0xF0, 0xFA, 0xDA, 0xFA, 0x95, 0x13,
+    0x4A, 0x62, 0xA7, 0x94, 0x34, 0xAA, 0x53, 0xB7, 0xC5, 0x25, 0x5A, 0x89,
+    0xE1, 0x8E, 0x43, 0xFF, 0x38, 0xB2, 0x01, 0x06, 0xB8, 0x7F, 0xF0, 0x4E,
+    0x7D, 0xEC, 0xD1, 0x91, 0xA1, 0x9D, 0x25, 0xE5, 0x31, 0xA5, 0xA2, 0x4B,
+    0x7B, 0x83, 0xEF, 0xC0
+};
+
+//
+// Test RSA-3072 key with exponent 65537 in pre-processed form.
+//
+STATIC
+UINT8
+mBenchTestKey3072[RSA_PUBLIC_KEY_SIZE (3072)] = {
+    0x60, 0x00, 0x00, 0x00, 0x4D, 0x16, 0x89, 0x65, 0x7B, 0xED, 0xF1, 0x0B,
+    0x12, 0x48, 0x3F, 0xBB, 0x5E, 0xF2, 0x84, 0xCF, 0x44, 0x0A, 0x49, 0x84,
+    0x7A, 0x58, 0x5F, 0x50, 0xF3, 0x70, 0xF9, 0x22, 0xAD, 0x2F, 0xB4, 0x6E,
+    0xDE, 0x20, 0x52, 0xBF, 0xAD, 0x81, 0xD1, 0xEB, 0xD9, 0x1E, 0x15, 0x70,
+    0x88, 0x83, 0x35, 0xE5, 0xC5, 0x0C, 0xF0, 0xF8, 0x64, 0x50, 0x31, 0xE4,
+    0x62, 0x7E, 0x13, 0xC2, 0x99, 0x85, 0x96, 0x10, 0xF4, 0x74, 0xFF, 0xAE,
+    0xEB, 0x86, 0x98, 0x76, 0x38, 0x16, 0xE6, 0xFD, 0xDC, 0x7E, 0x9C, 0x7B,
+    0xEA, 0xEC, 0x68, 0x83, 0x1A, 0xCA, 0xE1, 0xFA, 0xC2, 0x83, 0x20, 0x7B,
+    0xE7, 0xD5, 0xB3, 0x78, 0xD3, 0x21, 0x10, 0x21, 0xF8, 0xC5, 0xE0, 0x23,
+    0xDF, 0x89, 0x3F, 0xED, 0xFC, 0x49, 0x87, 0x0E, 0xD3, 0xF3, 0x11, 0xEB,
+    0x4A, 0x09, 0x23, 0xCE, 0xD1, 0x33, 0x59, 0xAC, 0xED, 0x20, 0xC6, 0x69,
+    0xD1, 0x45, 0xED, 0xC6, 0xB9, 0xA1, 0x82, 0x43, 0xE7, 0xAD, 0x23, 0x9F,
+    0x4F, 0x57, 0xE1, 0x63, 0x08, 0x0E, 0x35, 0x1C, 0x56, 0xC5, 0x26, 0x92,
+    0xDE, 0x06, 0xD7, 0x2B, 0xA1, 0xFD, 0x01, 0x71, 0x70, 0xFC, 0x6A, 0x14,
+    0x21, 0x57, 0xEE, 0xB1, 0xEA, 0x79, 0xCE, 0xA0, 0x04, 0x7E, 0xF2, 0x89,
+    0xBC, 0x10, 0xD2, 0x92, 0x0F, 0x8D, 0xA6, 0xBF, 0x80, 0x0B, 0xBA, 0x24,
+    0xB4, 0x55, 0x99, 0xD3, 0xF2, 0xB4, 0x42, 0x13, 0xA8, 0x33, 0xBB, 0x9D,
+    0x96, 0xCE, 0x4E, 0x5E, 0x63, 0x44, 0xE0, 0xAF, 0x60, 0x02, 0x93, 0x57,
+    0x46, 0x58, 0xF8, 0x12, 0xE7, 0x13, 0x52, 0xC7, 0x4F, 0x96, 0x69, 0x02,
+    0xF8, 0xDF, 0xA0, 0xC5, 0xE3, 0x96, 0x8A, 0x67, 0xEA, 0xE2, 0x13, 0x58,
+    0xAD, 0x82, 0x1C, 0x54, 0xC3, 0x25, 0xAC, 0x7D, 0xEF, 0xE6, 0x7E, 0xDB,
+    0x94, 0x7A, 0x77, 0x3B, 0x2F, 0x62, 0xCA, 0x67, 0xC9, 0xCB, 0x3D, 0x5B,
+    0x6C, 0xB7, 0x14, 0x7E, 0xA5, 0x1B, 0xBF, 0x83, 0xAA, 0x67, 0x74, 0xCF,
+    0x34, 0xE6, 0xDD, 0xE5, 0x1B, 0x99, 0x8E, 0xC9, 0x71, 0x20, 0x8F, 0x61,
+    0x82, 0x25, 0x64, 0x9A, 0xEA, 0x81, 0xD5, 0x85, 0xFC, 0xF1, 0xBD, 0x1C,
+    0xCE, 0x08, 0x49, 0xBD, 0x8F, 0x23, 0xE7, 0xF8, 0x6F, 0xC5, 0x83, 0x41,
+    0x53, 0xBD, 0x24, 0x93, 0xE6, 0x82, 0x26, 0xFA, 0xE1, 0x77, 0x66, 0xE8,
+    0x52, 0x41, 0x55, 0x9F, 0xFF, 0xD7, 0x67, 0x5E, 0x63, 0x39, 0xD7, 0x29,
+    0x4E, 0xB7, 0xAA, 0x68, 0x65, 0x90, 0x37, 0x79, 0x38, 0xF6, 0xA2, 0x4D,
+    0xE6, 0xBB, 0xE7, 0x9E, 0x96, 0xFD, 0x9D, 0xA8, 0xA5, 0xC7, 0xBB, 0x21,
+    0x96, 0xF7, 0xE6, 0x43, 0xB6, 0x92, 0xC2, 0x9D, 0x7F, 0x07, 0x83, 0x14,
+    0x25, 0xA6, 0x28, 0x21, 0xA1, 0x0A, 0xF2, 0xB6, 0x40, 0x8E, 0xE4, 0xF4,
+    0x5E, 0x40, 0xBA, 0x3A, 0xB7, 0x16, 0x11, 0xB7, 0x4B, 0x28, 0x28, 0x7E,
+    0x8E, 0x18, 0x5A, 0xFA, 0x05, 0x8E, 0xD6, 0x23, 0xF2, 0xBF, 0x0F, 0xAB,
+    0x0C, 0x67, 0x31, 0x65, 0x7F, 0x2E, 0xB0, 0xCA, 0x16, 0x5D, 0x3E, 0xF0,
+    0xB3, 0xC9, 0x2D, 0x10, 0xAD, 0x8E, 0x4F, 0x22, 0x96, 0x3A, 0xC6, 0x74,
+    0xC1, 0x30, 0x80, 0x42, 0x42, 0xC9, 0xA2, 0xDD, 0x61, 0x30, 0xCF, 0xEA,
+    0x11, 0x6D, 0xC7, 0x62, 0xE6, 0xF3, 0x31, 0xB3, 0x8D, 0x31, 0x73, 0x91,
+    0xCD, 0x8D, 0x3A, 0x53, 0x77, 0xEA, 0xB8, 0x1C, 0x0E, 0xB3, 0x56, 0x17,
+    0x42, 0xFB, 0x00, 0x1D, 0x33, 0x0D, 0x7E, 0x88, 0x29, 0x0C, 0xE8, 0xDB,
+    0x86, 0x35, 0x00, 0xD6, 0x52, 0x96, 0x0E, 0xD8, 0x74, 0xC2, 0x4A, 0x8B,
+    0x9D, 0x14, 0xF4, 0xCA, 0x83, 0x4B, 0x62, 0x54, 0x15, 0x34, 0x91, 0x29,
+    0x50, 0x0B, 0x9C, 0x39, 0xF6, 0xF1, 0x09, 0x7A, 0x5B, 0x89, 0xB0, 0xD3,
+    0xB3, 0x9B, 0x33, 0xA2, 0x16, 0x96, 0x7F, 0xD8, 0xD6, 0xE3, 0xDE, 0xE9,
+    0xFB, 0x7E, 0x70, 0x4F, 0xD8, 0x3B, 0x2F, 0x3D, 0xF7, 0x39, 0x5A, 0xCC,
+    0x47, 0xF1, 0x9E, 0x7F, 0x9F, 0xA0, 0x79, 0x33, 0xC6, 0x89, 0xFB, 0x8A,
+    0xCD, 0x81, 0x9C, 0xFB, 0xC1, 0x20, 0xE0, 0x5E, 0x9C, 0xAC, 0x88, 0x96,
+    0x7E, 0x21, 0x50, 0xB4, 0x2C, 0x9A, 0x4C, 0x07, 0xD8, 0x06, 0x66, 0x6F,
+    0x90, 0x65, 0xC2, 0x2D, 0x64, 0xBD, 0xAC, 0x35, 0x0D, 0xC4, 0xD3, 0xED,
+    0x6F, 0x5F, 0xB8, 0xAD, 0x32, 0xC7, 0x75, 0x40, 0x35, 0x3C, 0x47, 0xB9,
+    0xD2, 0x3A, 0x95, 0xBF, 0x73, 0xED, 0x44, 0xE6, 0xB2, 0xE4, 0x5E, 0x9D,
+    0x5F, 0x0C, 0x7C, 0x9E, 0xAA, 0x1B, 0xEE, 0x27, 0x2B, 0x31, 0x72, 0x8E,
+    0x26, 0xF9, 0xCC, 0x19, 0x40, 0x3F, 0xC9, 0xE0, 0x3B, 0x7C, 0x70, 0x64,
+    0x90, 0xC4, 0x0E, 0x28, 0x1C, 0x6E, 0xB4, 0xC3, 0xCC, 0x72, 0x94, 0x93,
+    0x19, 0x92, 0x4A, 0xC9, 0x8E, 0xB2, 0xEB, 0x1D, 0xD5, 0x84, 0x50, 0x0D,
+    0xFC, 0xFC, 0xC8, 0x1E, 0x4B, 0x7E, 0x7A, 0x8D, 0x61, 0x7B, 0xA8, 0xF8,
+    0xFB, 0x5B, 0x29, 0xB7, 0xF7, 0xEB, 0xF1, 0x78, 0x85, 0x0B, 0xA5, 0x85,
+    0x0B, 0x3E, 0xCC, 0xB9, 0xF5, 0x1A, 0xDA, 0x39, 0xC0, 0x71, 0x9C, 0x29,
+    0x47, 0xE6, 0x7A, 0xC6, 0xD4, 0xA2, 0x37, 0x8B, 0x11, 0xFA, 0x9A, 0x56,
+    0x98, 0x80, 0x2B, 0x90, 0x88, 0xAB, 0x16, 0xF8, 0xA4, 0x06, 0x4C, 0x5D,
+    0x9F, 0xBA, 0x9D, 0x93, 0xEA, 0x94, 0x86, 0x66, 0x20, 0x78, 0x04, 0xAE,
+    0x82, 0x7F, 0x39, 0x1D, 0x64, 0x15, 0xE6, 0xB1, 0x29, 0xFD, 0xAA, 0x19,
+    0x33, 0x70, 0x5D, 0xDA, 0x01, 0x19, 0x20, 0x21, 0x69, 0xEB, 0xE9, 0xAE,
+    0xFD, 0x36, 0xDC, 0x8B, 0x93, 0x4F, 0x2E, 0x6F, 0x09, 0x94, 0x69, 0x09,
+    0xBD, 0xB2, 0xD6, 0x2F, 0x87, 0x37, 0x86, 0x84
+};
+
+//
+// Test RSA-3072 key signature of SHA-256 of "abc".
+//
+STATIC
+UINT8
+mBenchTestSignature3072[3072 / 8] = {
+    0x6C, 0xE5, 0x4F, 0x86, 0xBF, 0xD9, 0xFB, 0x19, 0xD7, 0xB1, 0x0D, 0x16,
+    0xE1, 0x27, 0xB6, 0xB6, 0x6B, 0xC5, 0x57, 0x74, 0x2B, 0x2D, 0x6A, 0xC1,
+    0xBF, 0xDF, 0xD8, 0x73, 0xFE, 0xD1, 0x39, 0x40, 0xFD, 0x19, 0xE6, 0xFC,
+    0x82, 0x22, 0x18, 0xAB, 0x1D, 0xA0, 0xF4, 0x6C, 0x23, 0x25, 0x5C, 0x57,
+    0xE8, 0x32, 0xB3, 0xAA, 0xBC, 0xED, 0xB9, 0xD7, 0x14, 0xAE, 0x39, 0xD8,
+    0xB4, 0xE8, 0x6A, 0x7A, 0x5F, 0x12, 0x22, 0xF0, 0x39, 0xA7, 0x58, 0xC1,
+    0xF3, 0xEE, 0x05, 0x20, 0x5B, 0x4A, 0xAD, 0x7E, 0x9F, 0x18, 0x0E, 0xB6,
+    0x88, 0xED, 0x65, 0xF8, 0x5F, 0x48, 0x81, 0xAA, 0x9E, 0xBC, 0xA5, 0xE6,
+    0xDA, 0x84, 0x01, 0xC4, 0xA2, 0x6E, 0x8C, 0x9A, 0x7B, 0xCE, 0x1A, 0x23,
+    0x8A, 0x6B, 0xA9, 0x73, 0x4C, 0xE1, 0xA9, 0x62, 0xCC, 0xB7, 0x62, 0x18,
+    0x2E, 0xA4, 0xD8, 0xFE, 0xB5, 0x42, 0xA3, 0xF4, 0x38, 0x07, 0xAC, 0x73,
+    0xAF, 0x75, 0xA0, 0x52, 0x47, 0x65, 0x6E, 0x8D, 0x9D, 0x30, 0x42, 0x5D,
+    0xA8, 0x60, 0xB3, 0x34, 0xE3, 0x78, 0xFE, 0x66, 0xF9, 0xCD, 0xCD, 0x56,
+    0xE3, 0xFB, 0x01, 0x4F, 0xD5, 0x0E, 0xC4, 0xF0, 0x23, 0x4D, 0xCE, 0x8A,
+    0xDE, 0xE7, 0x87, 0x84, 0x77, 0x24, 0xCB, 0xFD, 0x8C, 0xF4, 0x1A, 0xBA,
+    0xC9, 0x54, 0x55, 0xA9, 0x35, 0x05, 0xD3, 0xDE, 0x63, 0x5E, 0x13, 0xB2,
+    0x87, 0xAB, 0xA2, 0xC3, 0x23, 0x9C, 0x84, 0x2B, 0xC0, 0xBD, 0xBF, 0x1A,
+    0xE9, 0xC9, 0xAD, 0xE1, 0xBE, 0xCC, 0x43, 0xC5, 0x63, 0xDB, 0x81, 0x16,
+    0x27, 0x41, 0x91, 0x9D, 0x43, 0xFB, 0x6F, 0x72, 0x00, 0x96, 0x0E, 0x44,
+    0xAC, 0x53, 0x05, 0x92, 0x43, 0x89, 0x72, 0x9E, 0x4E, 0xC1, 0x53, 0x4B,
+    0xC4, 0x68, 0x10, 0x4D, 0x8F, 0x0E, 0x45, 0x25, 0x18, 0x6D, 0xB1, 0xEC,
+    0x47, 0xCC, 0x4C, 0x53, 0x03, 0x46, 0x94, 0x67, 0x09, 0x28, 0xB4, 0xC1,
+    0xB7, 0x9A, 0xED, 0xD1, 0x18, 0x6D, 0x27, 0xAC, 0x17, 0x0F, 0x59, 0xC8,
+    0x3A, 0x0F, 0x87, 0xCE, 0x1A, 0x39, 0xDE, 0x40, 0x4A, 0x87, 0x08, 0xEF,
+    0x42, 0x8A, 0x3C, 0xBE, 0x3F, 0xEE, 0x1C, 0xCD, 0xAD, 0x98, 0xE8, 0xB0,
+    0x8D, 0x2D, 0x29, 0xF1, 0x20, 0xD6, 0x49, 0x7C, 0x96, 0x16, 0x5D, 0x68,
+    0xC4, 0x6B, 0xFF, 0xF3, 0x25, 0xCE, 0x22, 0x1E, 0xAD, 0xA1, 0x08, 0xC8,
+    0x4D, 0xC7, 0xCC, 0xBE, 0x40, 0x17, 0x55, 0x7B, 0xF6, 0x23, 0x47, 0xF6,
+    0xA8, 0xF0, 0xD1, 0x7D, 0xDB, 0xAF, 0x1A, 0x44, 0xBB, 0x03, 0x42, 0x32,
+    0xD9, 0xCC, 0x98, 0xA3, 0xA5, 0x68, 0x0D, 0x16, 0x55, 0x82, 0x77, 0x04,
+    0x4E, 0x51, 0x0C, 0x13, 0x2E, 0x52, 0x21, 0xC3, 0x39, 0x89, 0x61, 0x32,
+    0x21, 0xC7, 0x92, 0x1F, 0xF4, 0xA9, 0x3A, 0x80, 0x39, 0x96, 0x0F, 0xFD
+};
+
+//
+// Test RSA-4096 key with exponent 65537 in pre-processed form.
+//
+STATIC
+UINT8
+mBenchTestKey4096[RSA_PUBLIC_KEY_SIZE (4096)] = {
+    0x80, 0x00, 0x00, 0x00, 0x51, 0x75, 0x05, 0xCF, 0x4F, 0x0C, 0x81, 0x5E,
+    0xC3, 0x5F, 0xEE, 0xEB, 0xE3, 0x98, 0x99, 0x7B, 0x4F, 0xF4, 0x86, 0x34,
+    0x40, 0xA4, 0x44, 0xB6, 0xF5, 0xA6, 0x87, 0x64, 0xF5, 0x56, 0xCC, 0x7F,
+    0x34, 0x90, 0x44, 0x47, 0x08, 0xF6, 0x56, 0x9B, 0x08, 0x54, 0x65, 0x41,
+    0x7D, 0x44, 0xCB, 0x04, 0xE3, 0x12, 0x0C, 0x84, 0x3D, 0xDF, 0x14, 0xEA,
+    0xD1, 0xE9, 0xD8, 0x53, 0x3E, 0xA0, 0xC4, 0x1F, 0x0E, 0xBB, 0x62, 0x46,
+    0x88, 0xE0, 0xB7, 0xB5, 0x1E, 0x6A, 0x0F, 0x7E, 0x65, 0x54, 0x3E, 0x47,
+    0xF1, 0x6D, 0x3D, 0x8D, 0x2B, 0x5D, 0x0B, 0x93, 0xF9, 0x2B, 0xD6, 0x92,
+    0x75, 0xEC, 0xE6, 0xB4, 0x8E, 0x2A, 0x28, 0xCD, 0xE0, 0x3A, 0x3F, 0xF6,
+    0xC5, 0x91, 0xA0, 0xF9, 0x27, 0x03, 0x71, 0x43, 0xED, 0x04, 0xAB, 0xB7,
+    0xF7, 0xC6, 0x14, 0x48, 0x28, 0x74, 0xAD, 0x75, 0xBF, 0x5A, 0x15, 0x0E,
+    0x94, 0x07, 0xD2, 0xD3, 0x88, 0x15, 0xD6, 0x08, 0x41, 0xF8, 0x79, 0x0D,
+    0x70, 0x5A, 0xC6, 0x07, 0xE3, 0xEA, 0x3D, 0xAC, 0x50, 0x5F, 0x3A, 0x35,
+    0x94, 0xD6, 0x09, 0x43, 0xEE, 0x47, 0x78, 0x6C, 0x7C, 0x3D, 0xB8, 0xE3,
+    0x66, 0xB9, 0xDE, 0x20, 0xA1, 0xB4, 0x6D, 0x71, 0xAD, 0xD6, 0x4D, 0x37,
+    0x38, 0x3E, 0x7E, 0xCE, 0x67, 0x62, 0xB8, 0xCB, 0x90, 0x82, 0xB0, 0x67,
+    0x27, 0x19, 0x9A, 0x1A, 0xBC, 0x95, 0xED, 0x30, 0x62, 0xEF, 0xDC, 0x1C,
+    0x38, 0xB3, 0x76, 0x12, 0x18, 0x5C, 0x6F, 0x4A, 0x81, 0x37, 0x04, 0x91,
+    0x9E, 0x48, 0xAE, 0x5A, 0xED, 0x7C, 0x1B, 0x8B, 0x1F, 0x43, 0x01, 0xCC,
+    0x39, 0x72, 0xAB, 0x06, 0xE5, 0xDB, 0x73, 0x3E, 0xB4, 0xA2, 0x13, 0x2F,
+    0x65, 0xFC, 0x6E, 0xC1, 0x5A, 0x9C, 0xF9, 0x4C, 0xBD, 0x78, 0x09, 0xD3,
+    0xCE, 0x80, 0xDC, 0x30, 0x2F, 0x99, 0x29, 0x72, 0xE4, 0xAB, 0xD1, 0xD4,
+    0x3E, 0x58, 0x8D, 0x82, 0x2C, 0xE5, 0xEC, 0xA7, 0x64, 0x49, 0x13, 0x5A,
+    0xD8, 0x7A, 0xAF, 0x94, 0xAA, 0xE0, 0x82, 0x60, 0x39, 0x91, 0xE3, 0x77,
+    0x47, 0x8E, 0x7E, 0xC8, 0xAD, 0x0A, 0xFE, 0xC0, 0xD7, 0x7F, 0x2C, 0xE0,
+    0x7C, 0xCB, 0xE9, 0x97, 0x05, 0x63, 0x74, 0xE6, 0x14, 0x1F, 0xC1, 0x46,
+    0x14, 0x38, 0xE7, 0xEF, 0x89, 0xE4, 0xA7, 0x9C, 0xC9, 0x6E, 0x31, 0x82,
+    0xEB, 0x90, 0x8C, 0xFF, 0x13, 0xCC, 0x74, 0x2C, 0xE6, 0xB7, 0xA0, 0x24,
+    0x83, 0x7B, 0xB1, 0xFF, 0xE3, 0x10, 0xF9, 0xFD, 0xC4, 0xFA, 0xAC, 0x5A,
+    0x6D, 0x14, 0xB9, 0xFD, 0xE5, 0x98, 0x03, 0x62, 0x97, 0x9E, 0x03, 0xCD,
+    0xAA, 0xC3, 0xB4, 0x83, 0x9D, 0xEB, 0x40, 0x74, 0xCA, 0xE5, 0x92, 0x56,
+    0xDC, 0x61, 0x57, 0xA8, 0x6C, 0x7E, 0x67, 0x2A, 0x6B, 0x72, 0xCE, 0x98,
+    0xD4, 0xDD, 0x3D, 0x1A, 0xFD, 0x1C, 0xAE, 0x9E, 0x06, 0x3B, 0x57, 0x57,
+    0xB3, 0xE2, 0x19, 0xA1, 0xC3, 0x2C, 0xE0, 0xC7, 0x54, 0xAF, 0x02, 0x34,
+    0x63, 0x47, 0x09, 0x53, 0x8C, 0x5F, 0xAF, 0x08, 0x47, 0x43, 0x4D, 0x97,
+    0x44, 0xEB, 0xB4, 0xFE, 0x28, 0x40, 0xFD, 0x98, 0x48, 0x60, 0x1B, 0xB9,
+    0x2B, 0xD0, 0xFA, 0xD6, 0x1D, 0x08, 0xAB, 0xBD, 0x8C, 0x31, 0x52, 0x77,
+    0xE7, 0x74, 0x77, 0x26, 0xC2, 0x51, 0xB8, 0xC1, 0x0E, 0x12, 0x6A, 0x35,
+    0x6B, 0x75, 0x83, 0x9D, 0x80, 0xCF, 0x85, 0xBC, 0x14, 0x2B, 0x29, 0xC0,
+    0x77, 0x28, 0x55, 0xAB, 0xD9, 0x74, 0xB1, 0x27, 0x11, 0xA7, 0xC0, 0x82,
+    0x6C, 0xC8, 0x5D, 0x71, 0x21, 0xBA, 0x02, 0x84, 0x2C, 0x60, 0x3E, 0xDC,
+    0xB7, 0x57, 0x14, 0x7D, 0x10, 0x8D, 0xCC, 0x2E, 0xDC, 0xD1, 0x88, 0xFF,
+    0x7F, 0x27, 0xC7, 0x38, 0x8D, 0xB1, 0x1E, 0xA7, 0x4B, 0x69, 0xFD, 0xAB,
+    0xF0, 0x3C, 0x3B, 0xA8, 0x73, 0xF0, 0x3A, 0x83, 0xFE, 0x5F, 0x9B, 0x64,
+    0x6C, 0xEB, 0x6F, 0x14, 0xFC, 0x8D, 0x4C, 0x71, 0xA1, 0xDC, 0xAE, 0x6D,
+    0x52, 0x7D, 0xA8, 0x7C, 0x0F, 0x02, 0xB6, 0x96, 0xCD, 0xC8, 0x76, 0x85,
+    0xEE, 0xEF, 0x0A, 0xB4, 0x9E, 0xBF, 0xF5, 0xF6, 0xDD, 0xD4, 0x28, 0x0B,
+    0xB2, 0xD3, 0x9A, 0x8F, 0x2D, 0xDB, 0xDF, 0x77, 0x9C, 0x33, 0x8C, 0xA7,
+    0x8D, 0xB3, 0xD1, 0x0E, 0x17, 0x9B, 0x08, 0xC7, 0x48, 0x85, 0x6B, 0x2B,
+    0x57, 0x90, 0x7E, 0xF3, 0x8E, 0x7E, 0xB4, 0xD6, 0xF3, 0xE3, 0xCE, 0x8E,
+    0xD9, 0x7C, 0x2A, 0x52, 0xF9, 0xEA, 0xC7, 0x22, 0x1D, 0xC5, 0xCB, 0xFC,
+    0x6D, 0x04, 0x1B, 0xCE, 0x19, 0x3A, 0x3E, 0xDB, 0x30, 0x63, 0x9F, 0xF3,
+    0x04, 0x39, 0x6F, 0x56, 0xDE, 0xB4, 0x12, 0x00, 0xA0, 0x3C, 0x97, 0x04,
+    0x3C, 0x32, 0xFE, 0x53, 0x36, 0xE0, 0x13, 0xF8, 0xFC, 0xE9, 0x01, 0x29,
+    0xBA, 0xD1, 0xA1, 0xF7, 0x21, 0x02, 0xC1, 0x95, 0x95, 0x49, 0x78, 0x00,
+    0xDD, 0xFC, 0x4A, 0x2D, 0x7F, 0xC8, 0xDA, 0x49, 0x4B, 0x45, 0x80, 0x4E,
+    0x12, 0xBD, 0xC9, 0xB7, 0x9C, 0xBD, 0x62, 0xF8, 0x59, 0x80, 0x32, 0x53,
+    0xFF, 0x5A, 0x9F, 0x06, 0x62, 0x14, 0xFC, 0x98, 0xF8, 0x5D, 0x37, 0x9D,
+    0xA5, 0x68, 0x88, 0xF0, 0x65, 0x08, 0xA3, 0xF5, 0x83, 0x61, 0x7F, 0x1C,
+    0xE5, 0x4D, 0x30, 0x47, 0x00, 0x5C, 0xD7, 0xAB, 0x99, 0x95, 0x51, 0x81,
+    0x61, 0x5C, 0x8E, 0x4F, 0x79, 0x0F, 0x33, 0x1F, 0x90, 0x50, 0xB4, 0x0E,
+    0x1F, 0x93, 0x8B, 0x48, 0x0D, 0x44, 0x9C, 0xD2, 0x58, 0x55, 0xB8, 0x62,
+    0xD2, 0x1F, 0xB1, 0x3E, 0xEE, 0x97, 0xB4, 0x45, 0x05, 0xBE, 0xFC, 0x4B,
+    0x50, 0x1F, 0xCB, 0x39, 0xDB, 0x06, 0x15, 0x40, 0x0B, 0xF7, 0x13, 0x48,
+    0xE8, 0x1F, 0x71, 0xB8, 0xF8, 0x61, 0x57, 0x20, 0x6E, 0xF7, 0x00, 0x75,
+    0x59, 0x5A, 0x2F, 0x83, 0xAB, 0xC0, 0xAE, 0x06, 0x43, 0xBC, 0x34, 0xF1,
+    0x9E, 0xCB, 0x13, 0x7E, 0x06, 0x07, 0x2D, 0x09, 0xA9, 0x25, 0x8F, 0x91,
+    0xBE, 0xF7, 0xB3, 0x6E, 0x8D, 0x28, 0x50, 0xFF, 0xA7, 0xE0, 0x03, 0xBE,
+    0x10, 0xCC, 0xD0, 0x66, 0x88, 0xFD, 0x84, 0xC5, 0x67, 0x71, 0x17, 0xC1,
+    0xE7, 0x68, 0xB7, 0x88, 0xAE, 0x6F, 0x99, 0xE2, 0x58, 0x91, 0x28, 0x23,
+    0xD8, 0xF2, 0x81, 0x6C, 0x49, 0x63, 0xE0, 0x20, 0xDD, 0x21, 0x49, 0x9C,
+    0x73, 0xA6, 0x9B, 0x70, 0xF8, 0x56, 0x75, 0xC9, 0x32, 0x89, 0x15, 0xC1,
+    0x9B, 0x86, 0x97, 0x18, 0x8F, 0xEA, 0x6E, 0x57, 0x91, 0x44, 0x83, 0x47,
+    0x9F, 0xED, 0xD0, 0xFC, 0x85, 0xB8, 0x7C, 0xAD, 0x7A, 0x6F, 0x64, 0x5A,
+    0xA7, 0x5E, 0x3D, 0xEB, 0xA8, 0xAB, 0x35, 0x52, 0x5A, 0x46, 0x98, 0xE8,
+    0x4B, 0xC2, 0x11, 0x98, 0x3C, 0x00, 0x43, 0xC5, 0x7F, 0xCA, 0xA8, 0xC4,
+    0xB0, 0x40, 0xBD, 0xA7, 0xF1, 0xF4, 0xC7, 0x41, 0xCD, 0x9C, 0xA5, 0xD6,
+    0x4C, 0x11, 0x31, 0xE7, 0xD5, 0xF4, 0x02, 0x22, 0x51, 0xC5, 0x4E, 0x43,
+    0x3E, 0xEC, 0x55, 0xE7, 0x54, 0x97, 0x54, 0x50, 0x5B, 0x8B, 0x3F, 0xEE,
+    0x01, 0x44, 0x7B, 0xB0, 0x62, 0x53, 0xE3, 0x4F, 0x47, 0x65, 0x1B, 0x0D,
+    0x7A, 0x78, 0x4A, 0x61, 0xA9, 0xC2, 0xB2, 0xB0, 0xCF, 0x8E, 0x2D, 0x91,
+    0xF9, 0xFB, 0x29, 0x0D, 0xD5, 0x03, 0xF7, 0x06, 0xB3, 0x84, 0xFD, 0x5D,
+    0xA1, 0xF4, 0xAA, 0xCF, 0xB8, 0x0B, 0xC9, 0x9D, 0x87, 0x23, 0x45, 0x55,
+    0xC6, 0xAA, 0xE9, 0x43, 0x38, 0x30, 0xAB, 0x59, 0xC9, 0xF7, 0x25, 0xD6,
+    0x96, 0x45, 0x6C, 0xAB, 0x0F, 0xEA, 0x52, 0x92, 0xED, 0xB2, 0xAD, 0x24,
+    0x13, 0x95, 0x6C, 0x8F, 0x15, 0xAC, 0x3E, 0xF8, 0x0B, 0x7F, 0x2E, 0x5C
+};
+
+//
+// Test RSA-4096 key signature of SHA-256 of "abc".
+//
+STATIC
+UINT8
+mBenchTestSignature4096[4096 / 8] = {
+    0x8A, 0xD7, 0xA4, 0xF8, 0x28, 0xC6, 0x18, 0x87, 0x7D, 0xFF, 0xF1, 0x6C,
+    0xD8, 0x6B, 0x02, 0xF6, 0xD0, 0x6F, 0x0F, 0x07, 0x1C, 0xCB, 0xB2, 0xD5,
+    0x0F, 0xC5, 0x57, 0x24, 0xFE, 0x57, 0x5D, 0xE0, 0x03, 0xE8, 0x90, 0x57,
+    0xC9, 0x67, 0xB7, 0x7E, 0x0B, 0xDC, 0xAD, 0x7C, 0x6E, 0x6D, 0x7D, 0x9B,
+    0x5B, 0xCB, 0xCC, 0x94, 0x83, 0xA0, 0x91, 0x51, 0xC5, 0x26, 0xC7, 0x96,
+    0x45, 0x54, 0x89, 0x86, 0x57, 0xD2, 0x2E, 0x92, 0x48, 0xAF, 0xC2, 0xDE,
+    0xCE, 0xE3, 0xEA, 0xEF, 0x63, 0x6E, 0x7C, 0xD8, 0xCF, 0xE1, 0xBF, 0x96,
+    0x17, 0x22, 0x86, 0xAA, 0x16, 0xA2, 0x57, 0xBE, 0x66, 0xC8, 0x23, 0xFD,
+    0xF5, 0xD8, 0x56, 0x5F, 0x95, 0xD0, 0x75, 0xD0, 0xAE, 0x4A, 0xFF, 0xD4,
+    0xED, 0x29, 0xC6, 0xC6, 0xCD, 0xF1, 0x77, 0x12, 0x8C, 0x28, 0xE2, 0x02,
+    0xF6, 0x8F, 0x2D, 0xAC, 0xEF, 0x8E, 0x07, 0x2F, 0x53, 0x7D, 0x89, 0xD2,
+    0xC3, 0x61, 0x0F, 0xF3, 0x59, 0x52, 0xD3, 0x33, 0xCC, 0x9A, 0x61, 0xBF,
+    0xC7, 0xB2, 0xC5, 0x2B, 0xDA, 0xB6, 0xA6, 0x1F, 0x07, 0x68, 0xED, 0xDC,
+    0xFD, 0x8E, 0x37, 0x61, 0xFB, 0x37, 0xB1, 0x1E, 0x60, 0x59, 0x69, 0x86,
+    0xCF, 0x77, 0xF2, 0x58, 0xCC, 0xBD, 0x75, 0x07, 0xC4, 0xB9, 0x8E, 0x63,
+    0x08, 0x9A, 0x95, 0xFB, 0xA0, 0x7C, 0xA6, 0x2A, 0xF7, 0x42, 0xDD, 0xD8,
+    0xD9, 0xF1, 0x7B, 0xAE, 0x02, 0xF3, 0x40, 0x3B, 0xEB, 0xEB, 0x86, 0x8A,
+    0x9D, 0xDF, 0xEC, 0xB7, 0x6D, 0x24, 0x84, 0xF7, 0x56, 0x9F, 0x86, 0xC8,
+    0x10, 0x95, 0x00, 0x1F, 0x8D, 0x88, 0xC5, 0x0A, 0x95, 0xAC, 0x31, 0x6B,
+    0x30, 0x3C, 0x92, 0x54, 0x73, 0x0F, 0x6E, 0xAE, 0x65, 0x5B, 0x76, 0xBB,
+    0x75, 0xEE, 0xF0, 0x8F, 0xC8, 0xAA, 0xA9, 0xAE, 0xF7, 0xF6, 0x20, 0x12,
+    0x95, 0x5C, 0x72, 0x95, 0xC4, 0x2E, 0x80, 0x3A, 0x03, 0xC9, 0xD5, 0x64,
+    0x37, 0x7F, 0x58, 0x8F, 0x78, 0x18, 0x67, 0x7E, 0xCD, 0xF6, 0x35, 0xC2,
+    0x04, 0x5A, 0x71, 0xFD, 0x88, 0xAA, 0xD6, 0x25, 0xD6, 0x2D, 0x4C, 0xB0,
+    0xBB, 0x24, 0x20, 0xE2, 0x02, 0x4F, 0xF9, 0x4A, 0x37, 0x86, 0x45, 0xE3,
+    0x4C, 0xA7, 0xC4, 0xF8, 0xB0, 0xAA, 0x9A, 0x97, 0xF0, 0xCA, 0x41, 0xD1,
+    0xD6, 0xDF, 0xB4, 0xB3, 0xA7, 0xA2, 0xED, 0x27, 0x78, 0xB9, 0xC1, 0x04,
+    0x09, 0x13, 0x31, 0xFC, 0x9B, 0x61, 0xD3, 0xE7, 0xE0, 0x2E, 0xA9, 0xDA,
+    0x43, 0xA7, 0x24, 0x96, 0xA7, 0x99, 0x51, 0x2C, 0x1C, 0x49, 0x6A, 0xC6,
+    0x55, 0x06, 0x24, 0x6D, 0x81, 0xE0, 0x73, 0x52, 0x71, 0x2F, 0x80, 0x92,
+    0x55, 0x14, 0x77, 0x3B, 0x48, 0x88, 0x9E, 0x2C, 0x1D, 0xC4, 0xDE, 0xE1,
+    0x9E, 0x87, 0x54, 0x51, 0xC2, 0x86, 0xB0, 0xCE, 0x30, 0xA3, 0x9D, 0xE2,
+    0xC4, 0xBE, 0x83, 0x80, 0x1F, 0x7B, 0x95, 0x91, 0x2E, 0x11, 0x38, 0xC1,
+    0xDD, 0x2C, 0x48, 0x66, 0xAD, 0xD2, 0x3A, 0xEB, 0x96, 0xB7, 0x65, 0x6E,
+    0x71, 0x16, 0xA2, 0x38, 0xBD, 0xFA, 0xFC, 0x3D, 0x25, 0xD3, 0x0F, 0x03,
+    0x55, 0x79, 0x79, 0x7D, 0x1C, 0x76, 0xB8, 0xCC, 0x46, 0x52, 0x8B, 0x3E,
+    0x90, 0x13, 0xEA, 0x2A, 0x80, 0x83, 0x9E, 0x08, 0x25, 0x8A, 0xBE, 0x08,
+    0xF2, 0x9D, 0x16, 0x89, 0xF4, 0x8B, 0xD3, 0x7F, 0x84, 0xCC, 0x17, 0x67,
+    0x65, 0x24, 0x16, 0xF2, 0x15, 0x5E, 0x98, 0x04, 0x37, 0xEE, 0x1F, 0xEC,
+    0xC3, 0xAD, 0xBC, 0x70, 0xEC, 0x58, 0x01, 0x1B, 0xC5, 0x67, 0x14, 0x23,
+    0x14, 0xDF, 0xAC, 0x41, 0x45, 0x66, 0x69, 0x7B, 0xCD, 0xAD, 0x4C, 0xB8,
+    0x96, 0xFD, 0xD1, 0x09, 0x20, 0x24, 0x55, 0xA4, 0xA3, 0x0C, 0x53, 0xE0,
+    0x67, 0x91, 0xFF, 0x75, 0x4D, 0x38, 0xED, 0xC9
+};
+
+typedef struct {
+  UINT32       Bits;
+  CONST UINT8  *Key;
+  CONST UINT8  *Signature;
+} BENCH_TEST_KEY;
+
+STATIC
+BENCH_TEST_KEY
+mBenchTestKeys[] = {
+  { 2048, mBenchTestKey2048, mBenchTestSignature2048 },
+  { 3072, mBenchTestKey3072, mBenchTestSignature3072 },
+  { 4096, mBenchTestKey4096, mBenchTestSignature4096 }
+};
+
+STATIC
+UINT32
+BenchCheck (
+  CONST BENCH_TEST_KEY  *TestKey
+  )
+{
+  RSA_PUBLIC_KEY  *Key;
+  UINT64          WorkBuf64[RSA_WORKBUF64_SIZE];
+  UINT8           Signature[RSANUMBYTES];
+  UINT8           Digest[SHA256_DIGEST_SIZE];
+  UINT32          Size;
+
+  Key  = (RSA_PUBLIC_KEY *) TestKey->Key;
+  Size = TestKey->Bits / 8;
+
+  Sha256 (Digest, (UINT8 *) "abc", 3);
+  CopyMem (Signature, TestKey->Signature, Size);
+
+  if (!RsaVerify (Key, Signature, Size, Digest, WorkBuf64)) {
+    return 1;
+  }
+
+  if (RsaVerify (Key, Signature, Size - 1, Digest, WorkBuf64)) {
+    return 2;
+  }
+
+  Signature[Size / 2] ^= 1;
+  if (RsaVerify (Key, Signature, Size, Digest, WorkBuf64)) {
+    return 2;
+  }
+
+  Signature[Size / 2] ^= 1;
+  Digest[0] ^= 1;
+  if (RsaVerify (Key, Signature, Size, Digest, WorkBuf64)) {
+    return 2;
+  }
+
+  return 0;
+}
+
+STATIC
+VOID
+BenchRun (
+  RSA_PUBLIC_KEY  *Key,
+  UINT32          Verifications,
+  BENCH_RESULT    *Result
+  )
+{
+  UINT64  WorkBuf64[RSA_WORKBUF64_SIZE];
+  UINT8   Signature[RSANUMBYTES];
+  UINT8   Digest[SHA256_DIGEST_SIZE];
+  UINT64  Seed;
+  UINT64  Start;
+  UINT64  Elapsed;
+  UINT32  Index;
+  UINT32  Size;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchTestKeys); Index++) {
+    Result->Status = BenchCheck (&mBenchTestKeys[Index]);
+    if (Result->Status != 0) {
+      return;
+    }
+  }
+
+  Size = Key->Size * sizeof (UINT32);
+  Seed = 1;
+  for (Index = 0; Index < Size; Index++) {
+    Signature[Index] = (UINT8) BenchRandom (&Seed);
+  }
+  ZeroMem (Digest, sizeof (Digest));
+
+  //
+  // Keep the signature below any modulus of this size.
+  //
+  Signature[0] = 0;
+
+  Start = BenchTimestamp ();
+  for (Index = 0; Index < Verifications; Index++) {
+    if (RsaVerify (Key, Signature, Size, Digest, WorkBuf64)) {
+      Result->Status = 2;
+      return;
+    }
+  }
+  Elapsed = BenchTimestamp () - Start;
+
+  Result->VerifiesPerSec = Elapsed > 0 ? (UINT64) Verifications * 1000000000ULL / Elapsed : 0;
+}
+
+STATIC
+VOID
+BenchPrint (
+  FILE          *Output,
+  CONST CHAR8   *Name,
+  UINT32        Index,
+  UINT32        Bits,
+  BENCH_RESULT  *Result,
+  BOOLEAN       First
+  )
+{
+  BenchBeginResult (Output, First);
+  fprintf (
+    Output,
+    "{\"name\": \"%s-%u\", \"key_bits\": %u, \"status\": %u, \"verifies_per_sec\": %llu}",
+    Name,
+    Index,
+    Bits,
+    Result->Status,
+    (unsigned long long) Result->VerifiesPerSec
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32        Verifications;
+  INT32         Opt;
+  UINT32        Index;
+  BENCH_RESULT  Result;
+  INT32         ExitCode;
+  FILE          *Output;
+
+  Verifications = 1000;
+
+  while ((Opt = getopt (argc, argv, "n:")) != -1) {
+    switch (Opt) {
+      case 'n':
+        Verifications = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-n verifications]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Verifications == 0) {
+    fprintf (stderr, "Invalid verification count\n");
+    return -1;
+  }
+
+  Output = BenchOpenOutput ();
+  if (Output == NULL) {
+    return -1;
+  }
+
+  ExitCode = 0;
+  BenchBeginResults (
+    Output,
+    "  \"verifications\": %u,\n  \"limb_bits\": %u,\n",
+    Verifications,
+#if defined (MDE_CPU_X64)
+    64
+#else
+    32
+#endif
+    );
+
+  for (Index = 0; Index < NUM_OF_PK; Index++) {
+    BenchRun ((RSA_PUBLIC_KEY *) PkDataBase[Index].PublicKey, Verifications, &Result);
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+    BenchPrint (Output, "apple", Index, 2048, &Result, Index == 0);
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchTestKeys); Index++) {
+    BenchRun ((RSA_PUBLIC_KEY *) mBenchTestKeys[Index].Key, Verifications, &Result);
+    if (Result.Status != 0) {
+      ExitCode = -1;
+    }
+    BenchPrint (Output, "test", Index, mBenchTestKeys[Index].Bits, &Result, FALSE);
+  }
+
+  BenchEndResults (Output);
+
+  return ExitCode;
+}
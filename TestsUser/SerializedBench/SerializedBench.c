@@ -0,0 +1,630 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcTemplateLib.h>
+#include <Library/OcSerializeLib.h>
+#include <Library/OcMiscLib.h>
+
+#include <Bench.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/*
+ clang -O2 -g -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h SerializedBench.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcTemplateLib/OcTemplateLib.c ../../Library/OcSerializeLib/OcSerializeLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcStringLib/OcAsciiLib.c -o SerializedBench
+
+ ./SerializedBench [-j jobs] [-n iterations] [-f filter] > results.json
+
+ Every benchmark case is generated in memory and measured in a separate
+ forked process, so that peak memory (maximum RSS) is reported per case.
+ Up to <jobs> cases run concurrently (defaults to 1 for stable timings).
+ Timings are the best of <iterations> runs in microseconds:
+   - parse       - XmlDocumentParse and plist root lookup,
+   - deserialize - ParseSerializedDict over the root schema,
+   - destruct    - XmlDocumentFree and configuration destructor.
+ Library debug output is discarded, stdout only contains JSON results.
+
+ rm -rf SerializedBench.dSYM SerializedBench
+*/
+
+#define BENCH_KEYS_PER_DEVICE  256
+#define BENCH_MAX_ITERATIONS   1000
+
+#define KEXT_MODIFICATION_FIELDS(_, __)  \
+  _(OC_STRING, Identifier , , OC_STRING_CONSTR ("", _, __), OC_DESTR (OC_STRING) ) \
+  _(OC_STRING, Symbol     , , OC_STRING_CONSTR ("", _, __), OC_DESTR (OC_STRING) ) \
+  _(OC_DATA  , Find       , , OC_DATA_CONSTR ({0}, _, __) , OC_DESTR (OC_DATA)   ) \
+  _(OC_DATA  , Mask       , , OC_DATA_CONSTR ({0}, _, __) , OC_DESTR (OC_DATA)   ) \
+  _(OC_DATA  , Replace    , , OC_DATA_CONSTR ({0}, _, __) , OC_DESTR (OC_DATA)   ) \
+  _(UINT32   , Count      , , 0                           , ()                   ) \
+  _(UINT32   , Skip       , , 0                           , ()                   )
+  OC_DECLARE (KEXT_MODIFICATION)
+
+#define KEXT_MOD_ARRAY_FIELDS(_, __) \
+  OC_ARRAY (KEXT_MODIFICATION, _, __)
+  OC_DECLARE (KEXT_MOD_ARRAY)
+
+#define DEVICE_PROP_MAP_FIELDS(_, __) \
+  OC_MAP (OC_STRING, OC_ASSOC, _, __)
+  OC_DECLARE (DEVICE_PROP_MAP)
+
+#define BENCH_CONFIGURATION_FIELDS(_, __) \
+  _(DEVICE_PROP_MAP , DeviceProperties , , OC_CONSTR (DEVICE_PROP_MAP, _, __) , OC_DESTR (DEVICE_PROP_MAP)) \
+  _(KEXT_MOD_ARRAY  , KextMods         , , OC_CONSTR (KEXT_MOD_ARRAY, _, __)  , OC_DESTR (KEXT_MOD_ARRAY)) \
+  _(UINT32          , Level            , , 0                                  , ()) \
+  _(OC_ASSOC        , NvramVariables   , , OC_CONSTR (OC_ASSOC, _, __)        , OC_DESTR (OC_ASSOC))
+  OC_DECLARE (BENCH_CONFIGURATION)
+
+OC_STRUCTORS (KEXT_MODIFICATION, ())
+OC_ARRAY_STRUCTORS (KEXT_MOD_ARRAY)
+OC_MAP_STRUCTORS (DEVICE_PROP_MAP)
+OC_STRUCTORS (BENCH_CONFIGURATION, ())
+
+//
+// Schema, sorted by key name.
+//
+
+STATIC
+OC_SCHEMA
+mDevicePropertiesEntrySchema = OC_SCHEMA_MDATA (NULL);
+
+STATIC
+OC_SCHEMA
+mDevicePropertiesSchema = OC_SCHEMA_MAP (NULL, OC_ASSOC, &mDevicePropertiesEntrySchema);
+
+STATIC
+OC_SCHEMA
+mKextModConfigurationSchema[] = {
+  OC_SCHEMA_INTEGER_IN   ("Count", KEXT_MODIFICATION, Count),
+  OC_SCHEMA_DATA_IN      ("Find", KEXT_MODIFICATION, Find),
+  OC_SCHEMA_STRING_IN    ("Identifier", KEXT_MODIFICATION, Identifier),
+  OC_SCHEMA_DATA_IN      ("Mask", KEXT_MODIFICATION, Mask),
+  OC_SCHEMA_DATA_IN      ("Replace", KEXT_MODIFICATION, Replace),
+  OC_SCHEMA_INTEGER_IN   ("Skip", KEXT_MODIFICATION, Skip),
+  OC_SCHEMA_STRING_IN    ("Symbol", KEXT_MODIFICATION, Symbol)
+};
+
+STATIC
+OC_SCHEMA
+mKextModSchema = OC_SCHEMA_DICT (NULL, mKextModConfigurationSchema);
+
+STATIC
+OC_SCHEMA
+mNvramVariableSchema = OC_SCHEMA_MDATA (NULL);
+
+//
+// Nested dictionaries refer to the same schema, which lets us
+// exercise arbitrary nesting depth with a single declaration.
+//
+STATIC
+OC_SCHEMA
+mNestedSchema[2] = {
+  OC_SCHEMA_INTEGER_IN ("Level", BENCH_CONFIGURATION, Level),
+  OC_SCHEMA_DICT       ("Nested", mNestedSchema)
+};
+
+STATIC
+OC_SCHEMA
+mRootConfigurationNodes[] = {
+  OC_SCHEMA_MAP_IN   ("DeviceProperties", BENCH_CONFIGURATION, DeviceProperties, &mDevicePropertiesSchema),
+  OC_SCHEMA_ARRAY_IN ("Kext", BENCH_CONFIGURATION, KextMods, &mKextModSchema),
+  OC_SCHEMA_INTEGER_IN ("Level", BENCH_CONFIGURATION, Level),
+  OC_SCHEMA_MAP_IN   ("NVRAM", BENCH_CONFIGURATION, NvramVariables, &mNvramVariableSchema),
+  OC_SCHEMA_DICT     ("Nested", mNestedSchema)
+};
+
+STATIC
+OC_SCHEMA_INFO
+mRootConfigurationInfo = {
+  .Dict = {mRootConfigurationNodes, ARRAY_SIZE (mRootConfigurationNodes)}
+};
+
+//
+// Benchmark case description.
+//
+typedef enum {
+  BenchKindKeys,
+  BenchKindArray,
+  BenchKindNesting,
+  BenchKindBlobs
+} BENCH_KIND;
+
+typedef struct {
+  CONST CHAR8  *Name;
+  BENCH_KIND   Kind;
+  UINT32       Count;
+  UINT32       Size;
+} BENCH_CASE;
+
+STATIC
+BENCH_CASE
+mBenchCases[] = {
+  {"keys-10",        BenchKindKeys,    10,     0},
+  {"keys-100",       BenchKindKeys,    100,    0},
+  {"keys-1000",      BenchKindKeys,    1000,   0},
+  {"keys-10000",     BenchKindKeys,    10000,  0},
+  {"keys-100000",    BenchKindKeys,    100000, 0},
+  {"array-10",       BenchKindArray,   10,     0},
+  {"array-1000",     BenchKindArray,   1000,   0},
+  {"array-10000",    BenchKindArray,   10000,  0},
+  {"nesting-4",      BenchKindNesting, 4,      0},
+  {"nesting-16",     BenchKindNesting, 16,     0},
+  {"nesting-30",     BenchKindNesting, 30,     0},
+  {"blobs-64x4k",    BenchKindBlobs,   64,     4096},
+  {"blobs-16x64k",   BenchKindBlobs,   16,     65536},
+  {"blobs-4x1m",     BenchKindBlobs,   4,      1048576}
+};
+
+//
+// Result passed from the worker process through a pipe.
+//
+typedef struct {
+  UINT32   Status;
+  UINT32   Iterations;
+  UINT32   PlistSize;
+  UINT32   Entries;
+  UINT64   ParseUs;
+  UINT64   DeserializeUs;
+  UINT64   DestructUs;
+  UINT64   TotalUs;
+  UINT64   PeakRssKb;
+} BENCH_RESULT;
+
+typedef struct {
+  CHAR8   *Data;
+  UINT32  Size;
+  UINT32  Allocated;
+} BENCH_BUFFER;
+
+STATIC
+VOID
+BenchAppend (
+  BENCH_BUFFER  *Buffer,
+  CONST CHAR8   *Format,
+  ...
+  )
+{
+  va_list  Args;
+  INT32    Length;
+  UINT32   NewSize;
+
+  while (TRUE) {
+    va_start (Args, Format);
+    Length = vsnprintf (Buffer->Data + Buffer->Size, Buffer->Allocated - Buffer->Size, Format, Args);
+    va_end (Args);
+
+    if (Length < 0) {
+      abort ();
+    }
+
+    if (Buffer->Size + (UINT32) Length < Buffer->Allocated) {
+      Buffer->Size += (UINT32) Length;
+      return;
+    }
+
+    NewSize = MAX (Buffer->Allocated * 2, Buffer->Size + (UINT32) Length + 1);
+    Buffer->Data = realloc (Buffer->Data, NewSize);
+    if (Buffer->Data == NULL) {
+      abort ();
+    }
+    Buffer->Allocated = NewSize;
+  }
+}
+
+STATIC
+VOID
+BenchAppendBase64 (
+  BENCH_BUFFER  *Buffer,
+  UINT32        Size,
+  UINT32        Seed
+  )
+{
+  STATIC CONST CHAR8 Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  UINT32  Index;
+  UINT32  Length;
+
+  //
+  // Emit Size bytes worth of base64, wrapped at 68 columns like plutil does.
+  //
+  Length = (Size + 2) / 3 * 4;
+  for (Index = 0; Index < Length; Index++) {
+    if (Index > 0 && Index % 68 == 0) {
+      BenchAppend (Buffer, "\n\t\t");
+    }
+    Seed = Seed * 1103515245U + 12345U;
+    BenchAppend (Buffer, "%c", Alphabet[(Seed >> 16U) & 63U]);
+  }
+}
+
+STATIC
+UINT32
+BenchGenerate (
+  BENCH_CASE    *Case,
+  BENCH_BUFFER  *Buffer
+  )
+{
+  UINT32  Index;
+  UINT32  Entries;
+
+  Entries = 0;
+
+  BenchAppend (
+    Buffer,
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n"
+    "<plist version=\"1.0\">\n<dict>\n"
+    );
+
+  switch (Case->Kind) {
+    case BenchKindKeys:
+      //
+      // Dictionaries are limited to XML_PARSER_NODE_COUNT children,
+      // so split the keys into devices, like real DeviceProperties.
+      //
+      BenchAppend (Buffer, "\t<key>DeviceProperties</key>\n\t<dict>\n");
+      for (Index = 0; Index < Case->Count; Index++) {
+        if (Index % BENCH_KEYS_PER_DEVICE == 0) {
+          if (Index > 0) {
+            BenchAppend (Buffer, "\t\t</dict>\n");
+          }
+          BenchAppend (Buffer, "\t\t<key>PciRoot(0x0)/Pci(0x%x,0x0)</key>\n\t\t<dict>\n", Index / BENCH_KEYS_PER_DEVICE);
+        }
+        switch (Index % 4) {
+          case 0:
+            BenchAppend (Buffer, "\t\t\t<key>prop-%u</key>\n\t\t\t<data>AQAAAA==</data>\n", Index);
+            break;
+          case 1:
+            BenchAppend (Buffer, "\t\t\t<key>prop-%u</key>\n\t\t\t<string>value-%u</string>\n", Index, Index);
+            break;
+          case 2:
+            BenchAppend (Buffer, "\t\t\t<key>prop-%u</key>\n\t\t\t<integer>%u</integer>\n", Index, Index);
+            break;
+          default:
+            BenchAppend (Buffer, "\t\t\t<key>prop-%u</key>\n\t\t\t<true/>\n", Index);
+            break;
+        }
+        Entries++;
+      }
+      if (Case->Count > 0) {
+        BenchAppend (Buffer, "\t\t</dict>\n");
+      }
+      BenchAppend (Buffer, "\t</dict>\n");
+      break;
+
+    case BenchKindArray:
+      BenchAppend (Buffer, "\t<key>Kext</key>\n\t<array>\n");
+      for (Index = 0; Index < Case->Count; Index++) {
+        BenchAppend (
+          Buffer,
+          "\t\t<dict>\n"
+          "\t\t\t<key>Count</key>\n\t\t\t<integer>1</integer>\n"
+          "\t\t\t<key>Find</key>\n\t\t\t<data>SIXAdAM=</data>\n"
+          "\t\t\t<key>Identifier</key>\n\t\t\t<string>com.apple.driver.Kext%u</string>\n"
+          "\t\t\t<key>Mask</key>\n\t\t\t<data></data>\n"
+          "\t\t\t<key>Replace</key>\n\t\t\t<data>SIXA6wM=</data>\n"
+          "\t\t\t<key>Skip</key>\n\t\t\t<integer>%u</integer>\n"
+          "\t\t\t<key>Symbol</key>\n\t\t\t<string>__ZN4Kext%u5startEP9IOService</string>\n"
+          "\t\t</dict>\n",
+          Index,
+          Index % 3,
+          Index
+          );
+        Entries += 7;
+      }
+      BenchAppend (Buffer, "\t</array>\n");
+      break;
+
+    case BenchKindNesting:
+      for (Index = 0; Index < Case->Count; Index++) {
+        BenchAppend (Buffer, "<key>Level</key><integer>%u</integer>\n<key>Nested</key>\n<dict>\n", Index);
+        Entries += 2;
+      }
+      BenchAppend (Buffer, "<key>Level</key><integer>%u</integer>\n", Case->Count);
+      Entries++;
+      for (Index = 0; Index < Case->Count; Index++) {
+        BenchAppend (Buffer, "</dict>\n");
+      }
+      break;
+
+    case BenchKindBlobs:
+      BenchAppend (Buffer, "\t<key>NVRAM</key>\n\t<dict>\n");
+      for (Index = 0; Index < Case->Count; Index++) {
+        BenchAppend (Buffer, "\t\t<key>blob-%u</key>\n\t\t<data>\n\t\t", Index);
+        BenchAppendBase64 (Buffer, Case->Size, Index);
+        BenchAppend (Buffer, "\n\t\t</data>\n");
+        Entries++;
+      }
+      BenchAppend (Buffer, "\t</dict>\n");
+      break;
+  }
+
+  BenchAppend (Buffer, "</dict>\n</plist>\n");
+
+  return Entries;
+}
+
+STATIC
+VOID
+BenchRun (
+  BENCH_CASE    *Case,
+  UINT32        Iterations,
+  BENCH_RESULT  *Result
+  )
+{
+  BENCH_BUFFER         Buffer;
+  CHAR8                *Work;
+  XML_DOCUMENT         *Document;
+  XML_NODE             *RootDict;
+  BENCH_CONFIGURATION  Config;
+  UINT32               Index;
+  UINT64               Start;
+  UINT64               Parsed;
+  UINT64               Deserialized;
+  UINT64               Destructed;
+
+  ZeroMem (Result, sizeof (*Result));
+  ZeroMem (&Buffer, sizeof (Buffer));
+
+  Result->Entries    = BenchGenerate (Case, &Buffer);
+  Result->PlistSize  = Buffer.Size;
+  Result->Iterations = Iterations;
+  Result->ParseUs    = MAX_UINT64;
+  Result->DeserializeUs = MAX_UINT64;
+  Result->DestructUs = MAX_UINT64;
+
+  //
+  // Parsing modifies the buffer, so every iteration works on a fresh copy.
+  //
+  Work = AllocatePool (Buffer.Size);
+  if (Work == NULL) {
+    Result->Status = 1;
+    free (Buffer.Data);
+    return;
+  }
+
+  for (Index = 0; Index < Iterations; Index++) {
+    CopyMem (Work, Buffer.Data, Buffer.Size);
+    BENCH_CONFIGURATION_CONSTRUCT (&Config, sizeof (Config));
+
+    Start    = BenchTimestamp ();
+    Document = XmlDocumentParse (Work, Buffer.Size, FALSE);
+    RootDict = NULL;
+    if (Document != NULL) {
+      RootDict = PlistNodeCast (PlistDocumentRoot (Document), PLIST_NODE_TYPE_DICT);
+    }
+    Parsed = BenchTimestamp ();
+
+    if (RootDict == NULL) {
+      Result->Status = 2;
+      if (Document != NULL) {
+        XmlDocumentFree (Document);
+      }
+      BENCH_CONFIGURATION_DESTRUCT (&Config, sizeof (Config));
+      break;
+    }
+
+    ParseSerializedDict (&Config, RootDict, &mRootConfigurationInfo);
+    Deserialized = BenchTimestamp ();
+
+    XmlDocumentFree (Document);
+    BENCH_CONFIGURATION_DESTRUCT (&Config, sizeof (Config));
+    Destructed = BenchTimestamp ();
+
+    Result->ParseUs       = MIN (Result->ParseUs, (Parsed - Start) / 1000ULL);
+    Result->DeserializeUs = MIN (Result->DeserializeUs, (Deserialized - Parsed) / 1000ULL);
+    Result->DestructUs    = MIN (Result->DestructUs, (Destructed - Deserialized) / 1000ULL);
+    Result->TotalUs      += Destructed - Start;
+  }
+
+  //
+  // Total time is summed in nanoseconds and averaged in microseconds.
+  //
+  if (Result->Status == 0) {
+    Result->TotalUs /= (UINT64) Iterations * 1000ULL;
+  }
+
+  FreePool (Work);
+  free (Buffer.Data);
+}
+
+STATIC
+pid_t
+BenchSpawn (
+  BENCH_CASE  *Case,
+  UINT32      Iterations,
+  INT32       *ReadFd
+  )
+{
+  INT32         Fds[2];
+  pid_t         Pid;
+  BENCH_RESULT  Result;
+
+  if (pipe (Fds) != 0) {
+    return -1;
+  }
+
+  Pid = fork ();
+  if (Pid < 0) {
+    close (Fds[0]);
+    close (Fds[1]);
+    return -1;
+  }
+
+  if (Pid == 0) {
+    close (Fds[0]);
+    //
+    // Library DEBUG output goes to stdout, keep it out of the results.
+    //
+    if (freopen ("/dev/null", "w", stdout) == NULL) {
+      _exit (1);
+    }
+    BenchRun (Case, Iterations, &Result);
+    if (write (Fds[1], &Result, sizeof (Result)) != (ssize_t) sizeof (Result)) {
+      _exit (1);
+    }
+    close (Fds[1]);
+    _exit (0);
+  }
+
+  close (Fds[1]);
+  *ReadFd = Fds[0];
+  return Pid;
+}
+
+STATIC
+VOID
+BenchCollect (
+  pid_t         Pid,
+  INT32         ReadFd,
+  BENCH_RESULT  *Result
+  )
+{
+  INT32          Status;
+  struct rusage  Usage;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  if (read (ReadFd, Result, sizeof (*Result)) != (ssize_t) sizeof (*Result)) {
+    Result->Status = 3;
+  }
+  close (ReadFd);
+
+  if (wait4 (Pid, &Status, 0, &Usage) != Pid || !WIFEXITED (Status) || WEXITSTATUS (Status) != 0) {
+    Result->Status = 4;
+    return;
+  }
+
+#ifdef __APPLE__
+  Result->PeakRssKb = (UINT64) Usage.ru_maxrss / 1024;
+#else
+  Result->PeakRssKb = (UINT64) Usage.ru_maxrss;
+#endif
+}
+
+int main(int argc, char** argv) {
+  UINT32        Jobs;
+  UINT32        Iterations;
+  CONST CHAR8   *Filter;
+  INT32         Opt;
+  UINT32        Index;
+  UINT32        Collected;
+  UINT32        Running;
+  pid_t         Pids[ARRAY_SIZE (mBenchCases)];
+  INT32         Fds[ARRAY_SIZE (mBenchCases)];
+  BENCH_RESULT  Results[ARRAY_SIZE (mBenchCases)];
+  BOOLEAN       Selected[ARRAY_SIZE (mBenchCases)];
+  BOOLEAN       First;
+  INT32         ExitCode;
+
+  Jobs       = 1;
+  Iterations = 5;
+  Filter     = NULL;
+
+  while ((Opt = getopt (argc, argv, "j:n:f:")) != -1) {
+    switch (Opt) {
+      case 'j':
+        Jobs = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'n':
+        Iterations = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      case 'f':
+        Filter = optarg;
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-j jobs] [-n iterations] [-f filter]\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (Jobs == 0 || Iterations == 0 || Iterations > BENCH_MAX_ITERATIONS) {
+    fprintf (stderr, "Invalid job or iteration count\n");
+    return -1;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchCases); Index++) {
+    Selected[Index] = BenchIsSelected (mBenchCases[Index].Name, Filter);
+    Pids[Index]     = -1;
+  }
+
+  //
+  // Spawn cases in order, keeping at most Jobs workers alive,
+  // and always collect the oldest one to keep output deterministic.
+  //
+  Collected = 0;
+  Running   = 0;
+  for (Index = 0; Index < ARRAY_SIZE (mBenchCases); Index++) {
+    if (!Selected[Index]) {
+      continue;
+    }
+
+    while (Running >= Jobs) {
+      while (Pids[Collected] < 0) {
+        Collected++;
+      }
+      BenchCollect (Pids[Collected], Fds[Collected], &Results[Collected]);
+      Pids[Collected] = -1;
+      Running--;
+    }
+
+    fflush (stdout);
+    Pids[Index] = BenchSpawn (&mBenchCases[Index], Iterations, &Fds[Index]);
+    if (Pids[Index] < 0) {
+      ZeroMem (&Results[Index], sizeof (Results[Index]));
+      Results[Index].Status = 5;
+    } else {
+      Running++;
+    }
+  }
+
+  for (Index = Collected; Index < ARRAY_SIZE (mBenchCases); Index++) {
+    if (Pids[Index] >= 0) {
+      BenchCollect (Pids[Index], Fds[Index], &Results[Index]);
+    }
+  }
+
+  ExitCode = 0;
+  First    = TRUE;
+  printf ("{\n  \"iterations\": %u,\n  \"jobs\": %u,\n  \"results\": [\n", Iterations, Jobs);
+  for (Index = 0; Index < ARRAY_SIZE (mBenchCases); Index++) {
+    if (!Selected[Index]) {
+      continue;
+    }
+
+    if (Results[Index].Status != 0) {
+      ExitCode = -1;
+    }
+
+    printf (
+      "%s    {\"name\": \"%s\", \"status\": %u, \"plist_bytes\": %u, \"entries\": %u, "
+      "\"parse_us\": %llu, \"deserialize_us\": %llu, \"destruct_us\": %llu, "
+      "\"avg_total_us\": %llu, \"peak_rss_kb\": %llu}",
+      First ? "" : ",\n",
+      mBenchCases[Index].Name,
+      Results[Index].Status,
+      Results[Index].PlistSize,
+      Results[Index].Entries,
+      (unsigned long long) Results[Index].ParseUs,
+      (unsigned long long) Results[Index].DeserializeUs,
+      (unsigned long long) Results[Index].DestructUs,
+      (unsigned long long) Results[Index].TotalUs,
+      (unsigned long long) Results[Index].PeakRssKb
+      );
+    First = FALSE;
+  }
+  printf ("\n  ]\n}\n");
+
+  return ExitCode;
+}